@@ -0,0 +1,368 @@
+/* ************************************************************************** */
+/** Descriptive File Name
+
+  @Company
+    Digilent
+
+  @File Name
+    spidma_host.c
+
+  @Description
+        This file implements a host computer check of the SPIDMA module, outside of the SDK application sources.
+        The module is built with its SPIDMA_HOST stand-in, which plays the compiled output words through a pin model:
+        the program models an SPI slave on these pins and checks, for write and read transactions of the DMM
+        and of the EPROM, that the chip select and the clock follow the transaction, that MOSI only changes while
+        the clock is low, that the slave receives the command and the data bits, and that the bytes sent by the slave
+        are decoded. It then shifts the captured words, as a capture channel running ahead or behind the output channel,
+        and reports the largest shift that SPIDMA_Decode tolerates: SPIDMA_WORDS_PER_PHASE / 2 words are expected,
+        the slave model changing MISO on the clock rising edge.
+        Build and run from this folder (-iquote keeps the system headers ahead of the ones of the application):
+            gcc -O2 -Wall -DSPIDMA_HOST=1 -iquote ../src spidma_host.c ../src/spidma.c -o spidma_host && ./spidma_host
+        The program returns 0 when no error was detected.
+
+ */
+/* ************************************************************************** */
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Included Files                                                    */
+/* ************************************************************************** */
+#include <stdio.h>
+#include <string.h>
+#include "stdint.h"
+#include "spidma.h"
+#include "errors.h"
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Constants                                                         */
+/* ************************************************************************** */
+// output pins of the SPIDMA host build, and chip select pins of the check
+#define SPIDMA_HOST_CLK         4
+#define SPIDMA_HOST_MOSI        8
+#define SPIDMA_HOST_MISO        1
+#define SPIDMA_HOST_CSDMM       0x10    // active low, as CS_DMM
+#define SPIDMA_HOST_CSEPROM     0x20    // active high, as CS_EPROM
+#define SPIDMA_HOST_OTHERPINS   0x300   // other output pins, they must keep their level
+
+#define SPIDMA_HOST_MAXBITS     (16 + 1 + 8 * SPIDMA_MAXBYTES)
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+// Section: Local functions prototypes                                        */
+/* ************************************************************************** */
+/* ************************************************************************** */
+uint32_t SPIDMA_HostPins(uint32_t dwOut);
+void SPIDMA_HostDone(SPI_XFER *pXfer);
+void SPIDMA_HostInitXfer(SPI_XFER *pXfer, uint8_t fEprom, uint8_t fRead, uint8_t *pbData, int cbData);
+void SPIDMA_HostRun(uint8_t fEprom, uint8_t fRead, int cbData);
+int SPIDMA_HostMaxShift();
+void SPIDMA_HostCheck(int fCond, const char *szMsg);
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Global Variables                                                  */
+/* ************************************************************************** */
+/* ************************************************************************** */
+static uint32_t cErrors = 0;
+
+// state of the slave model
+static SPI_XFER *pXferSlave;            // transaction expected by the slave
+static uint32_t dwPrevOut;              // previous output word
+static int cSelects;                    // number of chip select activations
+static int cEdges;                      // number of clock rising edges while selected
+static uint8_t rgbitMosi[SPIDMA_HOST_MAXBITS];      // MOSI bits received on the rising edges
+static uint8_t rgbSlaveData[SPIDMA_MAXBYTES];       // bytes sent by the slave during the data bits
+static uint8_t fMiso;                   // MISO level, set by the slave on the rising edges
+static uint8_t fMosiChangedHigh;        // MOSI changed while the clock was high
+static uint8_t fOtherChanged;           // an output pin outside of the transaction changed
+static int cDone;                       // number of completion calls
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+// Section: Local Functions                                                   */
+/* ************************************************************************** */
+/* ************************************************************************** */
+
+/***	SPIDMA_HostPins
+**
+**	Parameters:
+**		uint32_t dwOut  - the output word written to the GPIO output data register
+**
+**	Return Value:
+**		uint32_t    - the input data register, MISO
+**
+**	Description:
+**		This function is the pin model of the SPI slave. While the chip select is active, on each clock rising edge
+**      it records MOSI and sets MISO to the next bit of rgbSlaveData, once the command bits and the read clock are done.
+**
+*/
+uint32_t SPIDMA_HostPins(uint32_t dwOut)
+{
+    uint32_t dwCsMask = pXferSlave->dwCsMask;
+    uint8_t fSel = ((dwOut & dwCsMask) != 0) == pXferSlave->bCsActive;
+    uint8_t fPrevSel = ((dwPrevOut & dwCsMask) != 0) == pXferSlave->bCsActive;
+    int idxData;
+    if(fSel && !fPrevSel)
+    {
+        cSelects++;
+    }
+    if((dwOut ^ dwPrevOut) & SPIDMA_HOST_OTHERPINS)
+    {
+        fOtherChanged = 1;
+    }
+    if((dwOut & SPIDMA_HOST_CLK) && (dwPrevOut & SPIDMA_HOST_CLK) && ((dwOut ^ dwPrevOut) & SPIDMA_HOST_MOSI))
+    {
+        fMosiChangedHigh = 1;
+    }
+    if(fSel && (dwOut & SPIDMA_HOST_CLK) && !(dwPrevOut & SPIDMA_HOST_CLK))
+    {
+        if(cEdges < SPIDMA_HOST_MAXBITS)
+        {
+            rgbitMosi[cEdges] = (dwOut & SPIDMA_HOST_MOSI) ? 1 : 0;
+        }
+        idxData = cEdges - pXferSlave->cbCmdBits - (pXferSlave->fReadClock ? 1 : 0);
+        fMiso = (idxData >= 0 && idxData < 8 * SPIDMA_MAXBYTES) ? (rgbSlaveData[idxData / 8] >> (7 - idxData % 8)) & 1 : 0;
+        cEdges++;
+    }
+    dwPrevOut = dwOut;
+    return fMiso ? SPIDMA_HOST_MISO : 0;
+}
+
+/***	SPIDMA_HostDone
+**
+**	Parameters:
+**		SPI_XFER *pXfer     - the finished transaction
+**
+**	Return Value:
+**		none
+**
+**	Description:
+**		This function is the completion function of the transactions, it counts the calls.
+**
+*/
+void SPIDMA_HostDone(SPI_XFER *pXfer)
+{
+    SPIDMA_HostCheck(pXfer == pXferSlave, "The completion function received another transaction");
+    cDone++;
+}
+
+/***	SPIDMA_HostInitXfer
+**
+**	Parameters:
+**		SPI_XFER *pXfer     - the transaction to be initialized
+**		uint8_t fEprom      - 1 for an EPROM transaction (active high chip select, 10 command bits),
+**                            0 for a DMM transaction (active low chip select, 8 command bits and the read clock)
+**		uint8_t fRead       - 1 to receive the data bytes, 0 to transmit them
+**		uint8_t *pbData     - the data bytes
+**		int cbData          - the number of data bytes
+**
+**	Return Value:
+**		none
+**
+**	Description:
+**		This function fills a transaction the way the DMM and EPROM modules do.
+**
+*/
+void SPIDMA_HostInitXfer(SPI_XFER *pXfer, uint8_t fEprom, uint8_t fRead, uint8_t *pbData, int cbData)
+{
+    memset(pXfer, 0, sizeof(SPI_XFER));
+    pXfer->dwCsMask = fEprom ? SPIDMA_HOST_CSEPROM : SPIDMA_HOST_CSDMM;
+    pXfer->bCsActive = fEprom;
+    pXfer->cTicksCs = fEprom ? 1 : 10;
+    pXfer->wCmd = fEprom ? 0x2A5 : 0xC3;
+    pXfer->cbCmdBits = fEprom ? 10 : 8;
+    pXfer->fReadClock = fRead && !fEprom;
+    pXfer->fRead = fRead;
+    pXfer->pbData = pbData;
+    pXfer->cbData = cbData;
+}
+
+/***	SPIDMA_HostRun
+**
+**	Parameters:
+**		uint8_t fEprom      - 1 for an EPROM transaction, 0 for a DMM transaction
+**		uint8_t fRead       - 1 for a read transaction, 0 for a write transaction
+**		int cbData          - the number of data bytes
+**
+**	Return Value:
+**		none
+**
+**	Description:
+**		This function plays a transaction through the stand-in and checks the pins seen by the slave model
+**      and the received bytes.
+**
+*/
+void SPIDMA_HostRun(uint8_t fEprom, uint8_t fRead, int cbData)
+{
+    SPI_XFER xfer;
+    uint8_t rgbData[SPIDMA_MAXBYTES];
+    uint32_t dwBase;
+    int i, idxBit;
+    char szMsg[100];
+
+    for(i = 0; i < SPIDMA_MAXBYTES; i++)
+    {
+        rgbSlaveData[i] = (uint8_t)(0x5A ^ (i * 37) ^ cbData);
+        rgbData[i] = fRead ? 0 : (uint8_t)(0xC6 ^ (i * 11));
+    }
+    SPIDMA_HostInitXfer(&xfer, fEprom, fRead, rgbData, cbData);
+    // idle levels: chip select inactive, clock and MOSI low, other pins set
+    dwBase = SPIDMA_HOST_OTHERPINS | (fEprom ? 0 : SPIDMA_HOST_CSDMM);
+    pXferSlave = &xfer;
+    dwPrevOut = dwBase;
+    cSelects = cEdges = cDone = 0;
+    fMiso = fMosiChangedHigh = fOtherChanged = 0;
+
+    sprintf(szMsg, "%s %s of %d bytes", fEprom ? "EPROM" : "DMM", fRead ? "read" : "write", cbData);
+    SPIDMA_HostCheck(SPIDMA_Start(&xfer, dwBase, SPIDMA_HostDone) == ERRVAL_SUCCESS, szMsg);
+    SPIDMA_HostCheck(cDone == 1, "The completion function was not called once");
+    SPIDMA_HostCheck(cSelects == 1, "The chip select was not activated once");
+    SPIDMA_HostCheck(dwPrevOut == dwBase, "The pins are not back to their idle levels");
+    SPIDMA_HostCheck(!fMosiChangedHigh, "MOSI changed while the clock was high");
+    SPIDMA_HostCheck(!fOtherChanged, "An output pin outside of the transaction changed");
+    SPIDMA_HostCheck(cEdges == xfer.cbCmdBits + xfer.fReadClock + 8 * cbData, "Wrong number of clocks");
+    for(idxBit = 0; idxBit < xfer.cbCmdBits; idxBit++)
+    {
+        SPIDMA_HostCheck(rgbitMosi[idxBit] == ((xfer.wCmd >> (xfer.cbCmdBits - idxBit - 1)) & 1), "Wrong command bit");
+    }
+    idxBit += xfer.fReadClock;
+    for(i = 0; i < cbData; i++)
+    {
+        if(fRead)
+        {
+            SPIDMA_HostCheck(rgbData[i] == rgbSlaveData[i], "Wrong received byte");
+        }
+        else
+        {
+            uint8_t bRx = 0;
+            int j;
+            for(j = 0; j < 8; j++)
+            {
+                bRx = (bRx << 1) | rgbitMosi[idxBit + 8 * i + j];
+            }
+            SPIDMA_HostCheck(bRx == rgbData[i], "Wrong transmitted byte");
+        }
+    }
+}
+
+/***	SPIDMA_HostMaxShift
+**
+**	Parameters:
+**		none
+**
+**	Return Value:
+**		int     - the largest shift of the captured words (in words, both directions) still decoded correctly
+**
+**	Description:
+**		This function compiles a DMM read transaction, builds the MISO capture of the ideal interleaving of the channels,
+**      then decodes it shifted by an increasing number of words, as a capture channel running ahead of
+**      or behind the output channel.
+**
+*/
+int SPIDMA_HostMaxShift()
+{
+    static uint32_t rgwWave[SPIDMA_MAXWORDS], rgwCapture[SPIDMA_MAXWORDS], rgwShifted[SPIDMA_MAXWORDS];
+    SPI_XFER xfer;
+    uint8_t rgbData[SPIDMA_MAXBYTES];
+    int cw, i, idxShift, idxSrc, cbData = 8;
+    uint8_t fOk;
+
+    for(i = 0; i < cbData; i++)
+    {
+        rgbSlaveData[i] = (uint8_t)(0x96 ^ (i * 29));
+    }
+    SPIDMA_HostInitXfer(&xfer, 0, 1, rgbData, cbData);
+    pXferSlave = &xfer;
+    dwPrevOut = SPIDMA_HOST_CSDMM;
+    cSelects = cEdges = 0;
+    fMiso = 0;
+    cw = SPIDMA_Compile(&xfer, SPIDMA_HOST_CSDMM, rgwWave, SPIDMA_MAXWORDS);
+    for(i = 0; i < cw; i++)
+    {
+        rgwCapture[i] = SPIDMA_HostPins(rgwWave[i]);
+    }
+    for(idxShift = 0; idxShift <= SPIDMA_WORDS_PER_PHASE; idxShift++)
+    {
+        fOk = 1;
+        for(i = -1; i <= 1 && fOk; i += 2)
+        {
+            // a capture channel ahead (i = -1) reads each input word earlier than the output word of the same index
+            for(idxSrc = 0; idxSrc < cw; idxSrc++)
+            {
+                int idxFrom = idxSrc + i * idxShift;
+                rgwShifted[idxSrc] = rgwCapture[(idxFrom < 0) ? 0 : ((idxFrom >= cw) ? cw - 1 : idxFrom)];
+            }
+            memset(rgbData, 0, sizeof(rgbData));
+            SPIDMA_Decode(&xfer, rgwShifted);
+            fOk = !memcmp(rgbData, rgbSlaveData, cbData);
+        }
+        if(!fOk)
+        {
+            return idxShift - 1;
+        }
+    }
+    return SPIDMA_WORDS_PER_PHASE;
+}
+
+/***	SPIDMA_HostCheck
+**
+**	Parameters:
+**		int fCond           - the condition to be checked
+**		const char *szMsg   - the message displayed when the condition is false
+**
+**	Return Value:
+**		none
+**
+**	Description:
+**		This function counts and displays the failed checks.
+**
+*/
+void SPIDMA_HostCheck(int fCond, const char *szMsg)
+{
+    if(!fCond)
+    {
+        cErrors++;
+        printf("%s\n", szMsg);
+    }
+}
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+// Section: Main                                                              */
+/* ************************************************************************** */
+/* ************************************************************************** */
+int main()
+{
+    SPI_XFER xfer;
+    uint8_t rgbData[SPIDMA_MAXBYTES + 1];
+    int cbData, cShift;
+
+    SPIDMA_HostCheck(SPIDMA_Init() == ERRVAL_SUCCESS, "SPIDMA_Init failed");
+    SPIDMA_HostSetPins(SPIDMA_HostPins);
+    for(cbData = 0; cbData <= SPIDMA_MAXBYTES; cbData++)
+    {
+        SPIDMA_HostRun(0, 0, cbData);
+        SPIDMA_HostRun(0, 1, cbData);
+        SPIDMA_HostRun(1, 0, cbData);
+        SPIDMA_HostRun(1, 1, cbData);
+    }
+
+    // the transactions that do not fit are refused
+    SPIDMA_HostInitXfer(&xfer, 0, 1, rgbData, SPIDMA_MAXBYTES + 1);
+    SPIDMA_HostCheck(SPIDMA_Start(&xfer, 0, SPIDMA_HostDone) == ERRVAL_SPI_ASYNC, "A transaction too long was accepted");
+    SPIDMA_HostInitXfer(&xfer, 0, 1, rgbData, 1);
+    xfer.cTicksCs = SPIDMA_MAXCSTICKS + 1;
+    SPIDMA_HostCheck(SPIDMA_Start(&xfer, 0, SPIDMA_HostDone) == ERRVAL_SPI_ASYNC, "A chip select setup too long was accepted");
+
+    cShift = SPIDMA_HostMaxShift();
+    SPIDMA_HostCheck(cShift == SPIDMA_WORDS_PER_PHASE / 2, "Unexpected tolerance of the capture shift");
+
+    printf("%d transactions, capture shift tolerated: %d words of %d per phase, %u errors\n",
+            4 * (SPIDMA_MAXBYTES + 1), cShift, SPIDMA_WORDS_PER_PHASE, (unsigned)cErrors);
+    return cErrors ? 1: 0;
+}
+
+/* *****************************************************************************
+ End of File
+ */
@@ -0,0 +1,168 @@
+/* ************************************************************************** */
+/** Descriptive File Name
+
+  @Company
+    Digilent
+
+  @File Name
+    spscq_host.c
+
+  @Description
+        This file implements a host computer check of the SPSCQ module, outside of the SDK application sources.
+        A producer thread pushes SPSCQ_HOST_CNTITEMS numbered items in the queue, while the main thread pops them:
+        the consumer checks that every item is received once, in order and not partially written.
+        The threads are not paced, so both the full and the empty queue cases are exercised; the program reports their counts.
+        Build and run from this folder (-iquote keeps the system sched.h ahead of the one of the SCHED module):
+            gcc -O2 -Wall -DSPSCQ_HOST -iquote ../src spscq_host.c ../src/spscq.c -lpthread -o spscq_host && ./spscq_host
+        The program returns 0 when no error was detected.
+
+ */
+/* ************************************************************************** */
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Included Files                                                    */
+/* ************************************************************************** */
+#include <stdio.h>
+#include <pthread.h>
+#include <sched.h>
+#include "stdint.h"
+#include "spscq.h"
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Constants                                                         */
+/* ************************************************************************** */
+#define SPSCQ_HOST_CNTITEMS     2000000     // number of items passed from the producer to the consumer
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+// Section: Local functions prototypes                                        */
+/* ************************************************************************** */
+/* ************************************************************************** */
+void SPSCQ_HostFill(SPSCQ_SAMPLE *pSample, uint32_t dwSeq);
+void *SPSCQ_HostProducer(void *pArg);
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Global Variables                                                  */
+/* ************************************************************************** */
+/* ************************************************************************** */
+static SPSCQ queue;
+static volatile uint32_t cFull;     // number of times the producer found the queue full
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+// Section: Local Functions                                                   */
+/* ************************************************************************** */
+/* ************************************************************************** */
+
+/***	SPSCQ_HostFill
+**
+**	Parameters:
+**		SPSCQ_SAMPLE *pSample   - the item to be filled
+**		uint32_t dwSeq          - the sequence number of the item
+**
+**	Return Value:
+**		none
+**
+**	Description:
+**		This function fills all the fields of an item from its sequence number,
+**      so that the consumer can detect an item that was partially written.
+**
+*/
+void SPSCQ_HostFill(SPSCQ_SAMPLE *pSample, uint32_t dwSeq)
+{
+    pSample->dVal = dwSeq * 0.5;
+    pSample->dwSeq = dwSeq;
+    pSample->idxScale = (int16_t)(dwSeq % 27);
+    pSample->bErr = (uint8_t)dwSeq;
+    pSample->fRaw = (uint8_t)(dwSeq & 1);
+    pSample->fPeakMin = -(float)(dwSeq & 0xFFFF);
+    pSample->fPeakMax = (float)(dwSeq & 0xFFFF);
+}
+
+/***	SPSCQ_HostProducer
+**
+**	Parameters:
+**		void *pArg      - not used
+**
+**	Return Value:
+**		null
+**
+**	Description:
+**		This function is the producer thread: it pushes SPSCQ_HOST_CNTITEMS numbered items, yielding when the queue is full.
+**
+*/
+void *SPSCQ_HostProducer(void *pArg)
+{
+    SPSCQ_SAMPLE sample;
+    uint32_t dwSeq = 0;
+    (void)pArg;
+    while(dwSeq < SPSCQ_HOST_CNTITEMS)
+    {
+        SPSCQ_HostFill(&sample, dwSeq);
+        if(SPSCQ_Push(&queue, &sample))
+        {
+            dwSeq++;
+        }
+        else
+        {
+            cFull++;
+            sched_yield();
+        }
+    }
+    return 0;
+}
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+// Section: Main                                                              */
+/* ************************************************************************** */
+/* ************************************************************************** */
+int main()
+{
+    pthread_t thProducer;
+    SPSCQ_SAMPLE sample, sampleExp;
+    uint32_t dwSeq = 0, cErrors = 0, cEmpty = 0;
+
+    SPSCQ_Init(&queue);
+    if(pthread_create(&thProducer, 0, SPSCQ_HostProducer, 0))
+    {
+        printf("Cannot create the producer thread\n");
+        return 1;
+    }
+    while(dwSeq < SPSCQ_HOST_CNTITEMS)
+    {
+        if(!SPSCQ_Pop(&queue, &sample))
+        {
+            cEmpty++;
+            sched_yield();
+            continue;
+        }
+        SPSCQ_HostFill(&sampleExp, dwSeq);
+        if(sample.dwSeq != sampleExp.dwSeq || sample.dVal != sampleExp.dVal || sample.idxScale != sampleExp.idxScale ||
+           sample.bErr != sampleExp.bErr || sample.fRaw != sampleExp.fRaw ||
+           sample.fPeakMin != sampleExp.fPeakMin || sample.fPeakMax != sampleExp.fPeakMax)
+        {
+            if(cErrors++ < 10)
+            {
+                printf("Item %u: received sequence %u\n", (unsigned)dwSeq, (unsigned)sample.dwSeq);
+            }
+        }
+        dwSeq++;
+    }
+    pthread_join(thProducer, 0);
+    if(SPSCQ_Count(&queue))
+    {
+        printf("Queue not empty after the last item\n");
+        cErrors++;
+    }
+    printf("%u items, %u errors, queue full %u times, empty %u times\n",
+            (unsigned)dwSeq, (unsigned)cErrors, (unsigned)cFull, (unsigned)cEmpty);
+    return cErrors ? 1: 0;
+}
+
+/* *****************************************************************************
+ End of File
+ */
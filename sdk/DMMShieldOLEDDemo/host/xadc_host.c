@@ -0,0 +1,168 @@
+/* ************************************************************************** */
+/** Descriptive File Name
+
+  @Company
+    Digilent
+
+  @File Name
+    xadc_host.c
+
+  @Description
+        This file implements a host computer check of the XADC module, outside of the SDK application sources.
+        The module is built with its XADC_HOST stand-in, and the program drives XADC_Tick with the temperatures
+        set by XADC_HostSetTemp: it checks that the temperature is unknown before the first reading, that the first
+        reading is reported, that the filter converges to a temperature step, and that XADC_Tick reports a change
+        only when the filtered temperature moved by XADC_TEMP_STEP.
+        Build and run from this folder (-iquote keeps the system headers ahead of the ones of the application):
+            gcc -O2 -Wall -DXADC_HOST=1 -iquote ../src xadc_host.c ../src/xadc.c -lm -o xadc_host && ./xadc_host
+        The program returns 0 when no error was detected.
+
+ */
+/* ************************************************************************** */
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Included Files                                                    */
+/* ************************************************************************** */
+#include <stdio.h>
+#include <math.h>
+#include "stdint.h"
+#include "xadc.h"
+#include "errors.h"
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Constants                                                         */
+/* ************************************************************************** */
+#define XADC_HOST_TEMPSTART     25.0    // temperature of the first readings (Celsius)
+#define XADC_HOST_TEMPSTEP      10.0    // temperature step applied after the first readings (Celsius)
+#define XADC_HOST_CNTREADS      200     // number of readings after the step, enough for the filter to converge
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+// Section: Local functions prototypes                                        */
+/* ************************************************************************** */
+/* ************************************************************************** */
+uint8_t XADC_HostRead(int *pcReported);
+void XADC_HostCheck(int fCond, const char *szMsg);
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Global Variables                                                  */
+/* ************************************************************************** */
+/* ************************************************************************** */
+static uint32_t cErrors = 0;
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+// Section: Local Functions                                                   */
+/* ************************************************************************** */
+/* ************************************************************************** */
+
+/***	XADC_HostRead
+**
+**	Parameters:
+**		int *pcReported     - pointer to the counter of the reported changes, incremented when a change is reported
+**
+**	Return Value:
+**		uint8_t     - the value returned by the XADC_Tick call that collected the reading
+**
+**	Description:
+**		This function performs one complete reading: the stand-in answers immediately,
+**      so the first XADC_Tick queues the read and the second one collects it.
+**      The first call is checked not to report a change.
+**
+*/
+uint8_t XADC_HostRead(int *pcReported)
+{
+    uint8_t fChanged;
+    XADC_HostCheck(!XADC_Tick(), "XADC_Tick reported a change while queuing the read");
+    fChanged = XADC_Tick();
+    if(fChanged)
+    {
+        (*pcReported)++;
+    }
+    return fChanged;
+}
+
+/***	XADC_HostCheck
+**
+**	Parameters:
+**		int fCond           - the condition to be checked
+**		const char *szMsg   - the message displayed when the condition is false
+**
+**	Return Value:
+**		none
+**
+**	Description:
+**		This function counts and displays the failed checks.
+**
+*/
+void XADC_HostCheck(int fCond, const char *szMsg)
+{
+    if(!fCond)
+    {
+        cErrors++;
+        printf("%s\n", szMsg);
+    }
+}
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+// Section: Main                                                              */
+/* ************************************************************************** */
+/* ************************************************************************** */
+int main()
+{
+    int i, cReported = 0, cExpected;
+    double dTemp, dPrevReported;
+
+    XADC_HostCheck(!XADC_Tick(), "XADC_Tick reported a change before XADC_Init");
+    XADC_HostCheck(XADC_Init() == ERRVAL_SUCCESS, "XADC_Init failed");
+    XADC_HostCheck(isnan(XADC_GetTemp()), "The temperature is known before the first reading");
+
+    // the first reading is reported, and the filter starts from it
+    XADC_HostSetTemp(XADC_HOST_TEMPSTART);
+    XADC_HostCheck(XADC_HostRead(&cReported), "The first reading was not reported");
+    XADC_HostCheck(XADC_GetTemp() == XADC_HOST_TEMPSTART, "The first reading is not the filtered temperature");
+
+    // a constant temperature is never reported again
+    for(i = 0; i < XADC_HOST_CNTREADS; i++)
+    {
+        XADC_HostRead(&cReported);
+    }
+    XADC_HostCheck(cReported == 1, "A constant temperature was reported as a change");
+
+    // a step is followed by the filter, each reported change is at least XADC_TEMP_STEP from the previous one
+    XADC_HostSetTemp(XADC_HOST_TEMPSTART + XADC_HOST_TEMPSTEP);
+    dPrevReported = XADC_HOST_TEMPSTART;
+    for(i = 0; i < XADC_HOST_CNTREADS; i++)
+    {
+        if(XADC_HostRead(&cReported))
+        {
+            dTemp = XADC_GetTemp();
+            XADC_HostCheck(dTemp - dPrevReported >= XADC_TEMP_STEP, "A change smaller than XADC_TEMP_STEP was reported");
+            dPrevReported = dTemp;
+        }
+        else
+        {
+            XADC_HostCheck(XADC_GetTemp() - dPrevReported < XADC_TEMP_STEP, "A change of XADC_TEMP_STEP was not reported");
+        }
+    }
+    dTemp = XADC_GetTemp();
+    XADC_HostCheck(fabs(dTemp - (XADC_HOST_TEMPSTART + XADC_HOST_TEMPSTEP)) < 1e-6, "The filter did not converge to the step");
+    cExpected = 1 + (int)(XADC_HOST_TEMPSTEP / XADC_TEMP_STEP);
+    XADC_HostCheck(cReported > 1 && cReported <= cExpected, "The number of reported changes does not match the step");
+
+    // XADC_Init restarts the filter
+    XADC_HostCheck(XADC_Init() == ERRVAL_SUCCESS, "XADC_Init failed");
+    XADC_HostCheck(isnan(XADC_GetTemp()), "XADC_Init did not clear the temperature");
+
+    printf("%d changes reported for a %.1f C step, final temperature %.3f C, %u errors\n",
+            cReported - 1, XADC_HOST_TEMPSTEP, dTemp, (unsigned)cErrors);
+    return cErrors ? 1: 0;
+}
+
+/* *****************************************************************************
+ End of File
+ */
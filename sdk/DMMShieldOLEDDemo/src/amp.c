@@ -0,0 +1,421 @@
+/* ************************************************************************** */
+/** Descriptive File Name
+
+  @Company
+    Digilent
+
+  @File Name
+    amp.c
+
+  @Description
+        This file groups the functions that implement the AMP (asymmetric multiprocessing) module.
+        In the AMP configuration CPU1 performs the repeated acquisition (DMM_DGetValue) and pushes the values into 
+        a lock free queue (SPSCQ module) placed in the high OCM, while CPU0 performs command parsing, UART and PmodOLED.
+        This way the timing critical bit banged SPI is never stalled by sprintf, UART or OLED_Update.
+        The DMMShield (DMM, EPROM and switches) is accessed by one core at a time:
+        CPU0 sends AMP_CMD_PAUSE and waits for the acknowledge before accessing the DMMShield (configuration, 
+        calibration, EPROM), then it sends AMP_CMD_RUN to restart the acquisition on the configured scale.
+        The CPU1 application is the same source code, built with AMP_CPU1 defined, using the ps7_cortexa9_1 standalone BSP
+        (built with USE_AMP=1) and a linker script placing it at AMP_CPU1_START_ADDR, in a DDR area not used by CPU0.
+        The "CPU0 functions" section groups functions called by the CPU0 application.
+        The "CPU1 functions" section groups functions called by the CPU1 application.
+        The module uses errors defined in the ERRORS module.
+        The AMP functions are called from DMMCMD module and main.c.
+
+ */
+/* ************************************************************************** */
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Included Files                                                    */
+/* ************************************************************************** */
+#include <string.h>
+#include "stdint.h"
+#include "xil_io.h"
+#include "xil_mmu.h"
+#include "xpseudo_asm.h"
+#include "amp.h"
+#include "dmm.h"
+#include "calib.h"
+#include "gpio.h"
+#include "errors.h"
+#include "utils.h"
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+// Section: Local functions prototypes                                        */
+/* ************************************************************************** */
+/* ************************************************************************** */
+uint8_t AMP_SendCmd(uint32_t dwCmd);
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Global Variables                                                  */
+/* ************************************************************************** */
+/* ************************************************************************** */
+extern CALIBDATA calib; // defined in calib.c
+
+AMPSHARED * const pAmpShared = (AMPSHARED *)AMP_SHARED_ADDR;
+// the build fails (negative array size) if the shared data outgrows its OCM area
+typedef char AMP_SHARED_FITS[(sizeof(AMPSHARED) <= AMP_SHARED_SIZE) ? 1 : -1];
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+// Section: CPU0 functions                                                    */
+/* ************************************************************************** */
+/* ************************************************************************** */
+
+/***	AMP_Init
+**
+**	Parameters:
+**      <none>
+**
+**	Return Value:
+**		none
+**
+**	Description:
+**		This function initializes the data shared with CPU1: it sets the shared OCM area as non cacheable, 
+**      initializes the queue and the command data.
+**      It must be called by CPU0 before AMP_StartCpu1.
+**            
+*/
+void AMP_Init()
+{
+    Xil_SetTlbAttributes(AMP_SHARED_ADDR, AMP_SHARED_TLBATTR);
+    pAmpShared->dwMagic = 0;
+    pAmpShared->dwCmd = AMP_CMD_PAUSE;
+    pAmpShared->dwSeqCmd = 0;
+    pAmpShared->dwSeqAck = 0;
+    pAmpShared->dwState = AMP_STATE_NOTSTARTED;
+    pAmpShared->idxScale = -1;
+    pAmpShared->fRaw = 0;
+    pAmpShared->fPeakDetect = 0;
+    pAmpShared->cntDropped = 0;
+    SPSCQ_Init(&pAmpShared->queue);
+    dmb();
+    pAmpShared->dwMagic = AMP_MAGIC_NO;
+    dsb();
+}
+
+/***	AMP_StartCpu1
+**
+**	Parameters:
+**      <none>
+**
+**	Return Value:
+**		none
+**
+**	Description:
+**		This function starts CPU1, which waits in the boot ROM loop after reset.
+**      It writes the CPU1 application entry point (AMP_CPU1_START_ADDR) in the CPU1 start address register 
+**      and wakes up CPU1 using the SEV instruction.
+**      CPU1 starts in the paused state, the acquisition starts when CPU0 calls AMP_RunAcquisition.
+**            
+*/
+void AMP_StartCpu1()
+{
+    Xil_Out32(AMP_CPU1_STARTREG, AMP_CPU1_START_ADDR);
+    dsb();
+    sev();
+}
+
+/***	AMP_PauseAcquisition
+**
+**	Parameters:
+**      <none>
+**
+**	Return Value:
+**		uint8_t 
+**          ERRVAL_SUCCESS                  0       // success
+**          ERRVAL_AMP_TIMEOUT              0xED    // CPU1 did not acknowledge the command
+**
+**	Description:
+**		This function stops the acquisition performed by CPU1. CPU1 finishes the current acquisition and 
+**      stops accessing the DMMShield.
+**      After this function returns ERRVAL_SUCCESS, CPU0 can access the DMMShield (DMM, EPROM).
+**      The values already in the queue remain available for AMP_GetSample.
+**      The function returns ERRVAL_AMP_TIMEOUT if CPU1 does not acknowledge the command, 
+**      in this case CPU0 must not access the DMMShield.
+**            
+*/
+uint8_t AMP_PauseAcquisition()
+{
+    uint8_t bResult = AMP_SendCmd(AMP_CMD_PAUSE);
+    if(bResult == ERRVAL_SUCCESS)
+    {
+        // CPU1 might have changed the GPIO outputs
+        GPIO_SyncOutputValue();
+    }
+    return bResult;
+}
+
+/***	AMP_RunAcquisition
+**
+**	Parameters:
+**      int idxScale        - the scale, already configured by CPU0 using DMM_SetScale
+**      uint8_t fRaw        - 1 if the calibration must not be applied
+**
+**	Return Value:
+**		uint8_t 
+**          ERRVAL_SUCCESS                  0       // success
+**          ERRVAL_DMM_IDXCONFIG            0xFC    // wrong scale index
+**          ERRVAL_AMP_TIMEOUT              0xED    // CPU1 did not acknowledge the command
+**
+**	Description:
+**		This function starts the acquisition on CPU1, for the specified scale.
+**      The scale must be configured by CPU0 (DMM_SetScale) while the acquisition is paused. CPU1 uses 
+**      the scale index, the calibration coefficients, the correction and the temperature compensation factor of the scale, 
+**      provided in the shared data.
+**      The queue is emptied, so AMP_GetSample only returns values acquired after this call.
+**      After this function is called, CPU0 must not access the DMMShield until AMP_PauseAcquisition is called.
+**            
+*/
+uint8_t AMP_RunAcquisition(int idxScale, uint8_t fRaw)
+{
+    const CORR *pCorr;
+    if(idxScale < 0 || idxScale >= DMM_CNTSCALES)
+    {
+        return ERRVAL_DMM_IDXCONFIG;
+    }
+    pAmpShared->idxScale = idxScale;
+    pAmpShared->fRaw = fRaw;
+    pAmpShared->calibScale.Mult = calib.Dmm[idxScale].Mult;
+    pAmpShared->calibScale.Add = calib.Dmm[idxScale].Add;
+    pAmpShared->fTempFactor = CALIB_GetTempFactor(idxScale);
+    pCorr = CORR_GetScale(idxScale);
+    if(pCorr)
+    {
+        memcpy(&pAmpShared->corrScale, pCorr, sizeof(CORR));
+    }
+    else
+    {
+        pAmpShared->corrScale.bType = CORR_TYPE_NONE;
+    }
+    pAmpShared->cntDropped = 0;
+    // CPU1 is paused, the consumer can empty the queue
+    SPSCQ_Flush(&pAmpShared->queue);
+    return AMP_SendCmd(AMP_CMD_RUN);
+}
+
+/***	AMP_GetSample
+**
+**	Parameters:
+**      SPSCQ_SAMPLE *pSample   - pointer to a variable to get the value
+**
+**	Return Value:
+**		1 if a value was extracted from the queue.
+**		0 if the queue is empty.
+**
+**	Description:
+**		This function extracts the oldest value acquired by CPU1. It never waits.
+**            
+*/
+uint8_t AMP_GetSample(SPSCQ_SAMPLE *pSample)
+{
+    return SPSCQ_Pop(&pAmpShared->queue, pSample);
+}
+
+/***	AMP_GetDroppedCount
+**
+**	Parameters:
+**      <none>
+**
+**	Return Value:
+**		uint32_t
+**          the number of values lost since the last AMP_RunAcquisition call
+**
+**	Description:
+**		This function returns the number of values that CPU1 could not push because the queue was full.
+**            
+*/
+uint32_t AMP_GetDroppedCount()
+{
+    return pAmpShared->cntDropped;
+}
+
+/***	AMP_SetTempFactor
+**
+**	Parameters:
+**      float fFactor       - the temperature compensation factor of the acquired scale
+**
+**	Return Value:
+**		none
+**
+**	Description:
+**		This function updates the temperature compensation factor used by CPU1, without pausing the acquisition.
+**      It is called when the die temperature changed. CPU1 checks the factor between two acquisitions;
+**      a single word is written, so CPU1 never gets a partial value.
+**            
+*/
+void AMP_SetTempFactor(float fFactor)
+{
+    pAmpShared->fTempFactor = fFactor;
+}
+
+/***	AMP_SetPeakDetect
+**
+**	Parameters:
+**      uint8_t f       - 1 if the peak registers should be converted, see DMM_SetPeakDetect
+**
+**	Return Value:
+**		none
+**
+**	Description:
+**		This function enables or disables the peak detection on CPU1, without pausing the acquisition.
+**      CPU1 checks the flag between two acquisitions, and places the peak values in each queued value.
+**            
+*/
+void AMP_SetPeakDetect(uint8_t f)
+{
+    pAmpShared->fPeakDetect = f;
+}
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+// Section: CPU1 functions                                                    */
+/* ************************************************************************** */
+/* ************************************************************************** */
+
+/***	AMP_Cpu1Loop
+**
+**	Parameters:
+**      <none>
+**
+**	Return Value:
+**		none, the function never returns
+**
+**	Description:
+**		This function implements the CPU1 acquisition loop. It must be called by the CPU1 application after 
+**      GPIO_Init and DMM_Init.
+**      It waits for CPU0 to initialize the shared data, then it executes the commands sent by CPU0:
+**      - AMP_CMD_RUN: uses the scale index, calibration coefficients, correction and temperature compensation factor 
+**      provided by CPU0 and starts the acquisition.
+**      - AMP_CMD_PAUSE: stops the acquisition.
+**      The commands are checked between two acquisitions and acknowledged after they are executed.
+**      While running, each value returned by DMM_DGetValue is pushed into the queue. If the queue is full, the value is 
+**      dropped and counted. The temperature compensation factor updated by AMP_SetTempFactor is applied to the next values,
+**      and the peak detection enabled by AMP_SetPeakDetect adds the peak values to the next values.
+**      While paused, the core waits for events (WFE), CPU0 sends an event after each command.
+**            
+*/
+void AMP_Cpu1Loop()
+{
+    uint32_t dwSeqCmd, dwSeqSample = 0;
+    int idxScale;
+    float fTempFactor = 1;
+    uint8_t fPeakDetect = 0;
+    double dPeakMin, dPeakMax;
+    SPSCQ_SAMPLE sample;
+    Xil_SetTlbAttributes(AMP_SHARED_ADDR, AMP_SHARED_TLBATTR);
+    while(pAmpShared->dwMagic != AMP_MAGIC_NO)
+    {
+        // wait for CPU0 to initialize the shared data
+    }
+    dmb();
+    pAmpShared->dwState = AMP_STATE_PAUSED;
+    while(1)
+    {
+        dwSeqCmd = pAmpShared->dwSeqCmd;
+        if(dwSeqCmd != pAmpShared->dwSeqAck)
+        {
+            // new command
+            dmb();
+            if(pAmpShared->dwCmd == AMP_CMD_RUN)
+            {
+                // CPU0 configured the scale and changed the GPIO outputs
+                GPIO_SyncOutputValue();
+                idxScale = pAmpShared->idxScale;
+                calib.Dmm[idxScale].Mult = pAmpShared->calibScale.Mult;
+                calib.Dmm[idxScale].Add = pAmpShared->calibScale.Add;
+                CORR_SetScale(idxScale, &pAmpShared->corrScale);
+                DMM_SetScaleIdx(idxScale);
+                fTempFactor = pAmpShared->fTempFactor;
+                DMM_SetTempFactor(fTempFactor);
+                DMM_SetUseCalib(!pAmpShared->fRaw);
+                pAmpShared->dwState = AMP_STATE_RUNNING;
+            }
+            else
+            {
+                pAmpShared->dwState = AMP_STATE_PAUSED;
+            }
+            dmb();
+            pAmpShared->dwSeqAck = dwSeqCmd;
+        }
+        if(pAmpShared->dwState == AMP_STATE_RUNNING)
+        {
+            if(pAmpShared->fTempFactor != fTempFactor)
+            {
+                fTempFactor = pAmpShared->fTempFactor;
+                DMM_SetTempFactor(fTempFactor);
+            }
+            if(pAmpShared->fPeakDetect != fPeakDetect)
+            {
+                fPeakDetect = pAmpShared->fPeakDetect;
+                DMM_SetPeakDetect(fPeakDetect);
+            }
+            sample.dVal = DMM_DGetValue(&sample.bErr);
+            sample.dwSeq = dwSeqSample++;
+            sample.idxScale = DMM_GetCurrentScale();
+            sample.fRaw = pAmpShared->fRaw;
+            DMM_GetPeaks(&dPeakMin, &dPeakMax);
+            sample.fPeakMin = dPeakMin;
+            sample.fPeakMax = dPeakMax;
+            if(!SPSCQ_Push(&pAmpShared->queue, &sample))
+            {
+                pAmpShared->cntDropped++;
+            }
+        }
+        else
+        {
+            wfe();
+        }
+    }
+}
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+// Section: Local Functions                                                   */
+/* ************************************************************************** */
+/* ************************************************************************** */
+
+/***	AMP_SendCmd
+**
+**	Parameters:
+**      uint32_t dwCmd      - the command: AMP_CMD_PAUSE or AMP_CMD_RUN
+**
+**	Return Value:
+**		uint8_t 
+**          ERRVAL_SUCCESS                  0       // success
+**          ERRVAL_AMP_TIMEOUT              0xED    // CPU1 did not acknowledge the command
+**
+**	Description:
+**		This function sends a command to CPU1 and waits until CPU1 acknowledges it.
+**      The command parameters must be set in the shared data before calling this function.
+**      CPU1 checks the commands between acquisitions, so the function waits at most AMP_CNTTIMEOUT x 10 us, 
+**      which covers the longest DMM_DGetValue call.
+**            
+*/
+uint8_t AMP_SendCmd(uint32_t dwCmd)
+{
+    uint32_t dwSeqCmd, cntWait;
+    pAmpShared->dwCmd = dwCmd;
+    dmb();
+    dwSeqCmd = pAmpShared->dwSeqCmd + 1;
+    pAmpShared->dwSeqCmd = dwSeqCmd;
+    dsb();
+    sev();
+    for(cntWait = 0; cntWait < AMP_CNTTIMEOUT; cntWait++)
+    {
+        if(pAmpShared->dwSeqAck == dwSeqCmd)
+        {
+            dmb();
+            return ERRVAL_SUCCESS;
+        }
+        DelayAprox10Us(1);
+    }
+    return ERRVAL_AMP_TIMEOUT;
+}
+
+/* *****************************************************************************
+ End of File
+ */
@@ -0,0 +1,102 @@
+/* ************************************************************************** */
+/** Descriptive File Name
+
+  @Company
+ Digilent
+
+  @File Name
+    amp.h
+
+  @Description
+        This file contains the declarations for the AMP module functions.
+        The AMP functions are defined in amp.c source file.
+
+ */
+/* ************************************************************************** */
+
+#ifndef _AMP_H    /* Guard against multiple inclusion */
+#define _AMP_H
+
+#include "stdint.h"
+#include "dmm.h"
+#include "spscq.h"
+#include "corr.h"
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Constants                                                         */
+/* ************************************************************************** */
+// AMP configuration
+//  AMP_ENABLE 0 - the application runs on CPU0 only
+//  AMP_ENABLE 1 - CPU0 starts CPU1, which performs the repeated acquisition
+// The CPU1 application is built from the same sources, with AMP_CPU1 defined (-DAMP_CPU1) and the
+// ps7_cortexa9_1 standalone BSP (USE_AMP=1), linked at AMP_CPU1_START_ADDR. Its linker script declares ps7_ram_1
+// as lscript.ld does (0xFFFF0000 - 0xFFFF7FFF), so that neither application is linked over AMP_SHARED_ADDR.
+#ifndef AMP_ENABLE
+#define AMP_ENABLE              0
+#endif
+
+#define AMP_CPU1_START_ADDR     0x10000000  // entry point of the CPU1 application, the DDR above it is not used by CPU0 (lscript.ld)
+#define AMP_CPU1_STARTREG       0xFFFFFFF0  // CPU1 waits in the boot ROM for an address written here, then a SEV
+#define AMP_SHARED_ADDR         0xFFFF8000  // shared data in the high OCM, above ps7_ram_1 (lscript.ld of both CPUs: 0xFFFF0000 - 0xFFFF7FFF)
+#define AMP_SHARED_SIZE         0x7E00      // up to 0xFFFFFE00, the top of the OCM holds AMP_CPU1_STARTREG
+#define AMP_SHARED_TLBATTR      0x14DE2     // normal memory, shareable, non cacheable (the whole 1 MB section of AMP_SHARED_ADDR)
+#define AMP_CNTTIMEOUT          300000      // number of 10 us polls waiting for CPU1 to acknowledge a command (3 s)
+
+// commands sent by CPU0 to CPU1
+#define AMP_CMD_PAUSE           0       // stop the acquisition, CPU0 accesses the DMMShield
+#define AMP_CMD_RUN             1       // acquire values and push them in the queue
+
+// CPU1 states
+#define AMP_STATE_NOTSTARTED    0
+#define AMP_STATE_PAUSED        1
+#define AMP_STATE_RUNNING       2
+
+#define AMP_MAGIC_NO            0x414D5031  // "AMP1", shared data initialized by CPU0
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Data Types
+// *****************************************************************************
+// *****************************************************************************
+
+// data shared by the two cores, placed at AMP_SHARED_ADDR
+typedef struct _AMPSHARED{
+    volatile uint32_t dwMagic;      // AMP_MAGIC_NO when initialized
+    volatile uint32_t dwCmd;        // AMP_CMD_ value, written by CPU0
+    volatile uint32_t dwSeqCmd;     // incremented by CPU0 for each command
+    volatile uint32_t dwSeqAck;     // set by CPU1 to dwSeqCmd when the command was executed
+    volatile uint32_t dwState;      // AMP_STATE_ value, written by CPU1
+    volatile int32_t idxScale;      // the scale configured by CPU0, used by AMP_CMD_RUN
+    volatile uint32_t fRaw;         // 1 if the calibration must not be applied, used by AMP_CMD_RUN
+    volatile CALIB calibScale;      // calibration coefficients of the scale, used by AMP_CMD_RUN
+    CORR corrScale;                 // nonlinearity correction of the scale, used by AMP_CMD_RUN
+    volatile float fTempFactor;     // temperature compensation factor of the scale, set by AMP_CMD_RUN and AMP_SetTempFactor
+    volatile uint32_t fPeakDetect;  // 1 if the peak registers are converted, set by AMP_SetPeakDetect
+    volatile uint32_t cntDropped;   // number of values lost because the queue was full
+    SPSCQ queue;                    // acquired values, CPU1 is the producer, CPU0 is the consumer
+} AMPSHARED;
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Interface Functions
+// *****************************************************************************
+// *****************************************************************************
+// CPU0 functions
+void AMP_Init();
+void AMP_StartCpu1();
+uint8_t AMP_PauseAcquisition();
+uint8_t AMP_RunAcquisition(int idxScale, uint8_t fRaw);
+uint8_t AMP_GetSample(SPSCQ_SAMPLE *pSample);
+uint32_t AMP_GetDroppedCount();
+void AMP_SetTempFactor(float fFactor);
+void AMP_SetPeakDetect(uint8_t f);
+
+// CPU1 function
+void AMP_Cpu1Loop();
+
+#endif /* _AMP_H */
+
+/* *****************************************************************************
+ End of File
+ */
@@ -0,0 +1,381 @@
+/* ************************************************************************** */
+/** Descriptive File Name
+
+  @Company
+    Digilent
+
+  @File Name
+    bigfont.c
+
+  @Description
+        This file groups the functions that implement the BIGFONT module, the large digits font of the PmodOLED value row.
+        The glyphs are 16 pixels high (2 pages): digits, sign, decimal point, space, the SI prefixes and the units
+        used by DMM_FormatValue. Each glyph is written below as 16 rows of pixels, and the BIGFONT_GLYPH macro converts
+        the rows to the column bytes of the frame buffer at compile time, so the glyphs are copied directly in the frame buffer.
+        The value is right aligned, so that the digits keep their position while the value changes, and
+        BIGFONT_DrawValue redraws only the glyphs that changed since the previous call.
+
+ */
+/* ************************************************************************** */
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Included Files                                                    */
+/* ************************************************************************** */
+#include <string.h>
+#include "stdint.h"
+#include "bigfont.h"
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Glyph Conversion Macros                                           */
+/* ************************************************************************** */
+/* ************************************************************************** */
+// pixel of row r (most significant bit - first column) at column x, placed at bit i of the column byte
+#define BIGFONT_BIT(r, x, i)    ((((r) >> (BIGFONT_MAXWIDTH - 1 - (x))) & 1) << (i))
+// column byte of a page, from its 8 rows (the first row is the least significant bit)
+#define BIGFONT_COL(x, r0, r1, r2, r3, r4, r5, r6, r7) \
+                                (BIGFONT_BIT(r0, x, 0) | BIGFONT_BIT(r1, x, 1) | BIGFONT_BIT(r2, x, 2) | BIGFONT_BIT(r3, x, 3) | \
+                                 BIGFONT_BIT(r4, x, 4) | BIGFONT_BIT(r5, x, 5) | BIGFONT_BIT(r6, x, 6) | BIGFONT_BIT(r7, x, 7))
+#define BIGFONT_PAGE(r0, r1, r2, r3, r4, r5, r6, r7) \
+                                {BIGFONT_COL(0, r0, r1, r2, r3, r4, r5, r6, r7),\
+                                 BIGFONT_COL(1, r0, r1, r2, r3, r4, r5, r6, r7),\
+                                 BIGFONT_COL(2, r0, r1, r2, r3, r4, r5, r6, r7),\
+                                 BIGFONT_COL(3, r0, r1, r2, r3, r4, r5, r6, r7),\
+                                 BIGFONT_COL(4, r0, r1, r2, r3, r4, r5, r6, r7),\
+                                 BIGFONT_COL(5, r0, r1, r2, r3, r4, r5, r6, r7),\
+                                 BIGFONT_COL(6, r0, r1, r2, r3, r4, r5, r6, r7),\
+                                 BIGFONT_COL(7, r0, r1, r2, r3, r4, r5, r6, r7),\
+                                 BIGFONT_COL(8, r0, r1, r2, r3, r4, r5, r6, r7),\
+                                 BIGFONT_COL(9, r0, r1, r2, r3, r4, r5, r6, r7)}
+#define BIGFONT_GLYPH(r0, r1, r2, r3, r4, r5, r6, r7, r8, r9, r10, r11, r12, r13, r14, r15) \
+                                {BIGFONT_PAGE(r0, r1, r2, r3, r4, r5, r6, r7), BIGFONT_PAGE(r8, r9, r10, r11, r12, r13, r14, r15)}
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+// Section: Local functions prototypes                                        */
+/* ************************************************************************** */
+/* ************************************************************************** */
+int BIGFONT_FindGlyph(const char **ppch);
+void BIGFONT_Blit(uint8_t *pbFrame, int idxPage, const BIGFONT_CELL *pCell);
+void BIGFONT_Clear(uint8_t *pbFrame, int idxPage, int xFirst, int xEnd);
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Global Variables                                                  */
+/* ************************************************************************** */
+/* ************************************************************************** */
+// the font, each glyph is 16 rows of BIGFONT_MAXWIDTH pixels (the narrow glyphs use the first cx columns)
+static const BIGFONT_GLYPH rgGlyphs[] = {
+    // '0'
+    {'0', 10, BIGFONT_GLYPH(
+        0b0000000000, 0b0011110000, 0b0111111000, 0b1100001100,
+        0b1100011100, 0b1100111100, 0b1101101100, 0b1111001100,
+        0b1110001100, 0b1100001100, 0b1100001100, 0b1100001100,
+        0b0111111000, 0b0011110000, 0b0000000000, 0b0000000000)},
+    // '1'
+    {'1', 10, BIGFONT_GLYPH(
+        0b0000000000, 0b0001100000, 0b0011100000, 0b0111100000,
+        0b1101100000, 0b0001100000, 0b0001100000, 0b0001100000,
+        0b0001100000, 0b0001100000, 0b0001100000, 0b0001100000,
+        0b1111111100, 0b1111111100, 0b0000000000, 0b0000000000)},
+    // '2'
+    {'2', 10, BIGFONT_GLYPH(
+        0b0000000000, 0b0011110000, 0b0111111000, 0b1100001100,
+        0b0000001100, 0b0000001100, 0b0000011000, 0b0000110000,
+        0b0001100000, 0b0011000000, 0b0110000000, 0b1100000000,
+        0b1111111100, 0b1111111100, 0b0000000000, 0b0000000000)},
+    // '3'
+    {'3', 10, BIGFONT_GLYPH(
+        0b0000000000, 0b0111111000, 0b1111111100, 0b0000001100,
+        0b0000001100, 0b0000011000, 0b0011110000, 0b0011111000,
+        0b0000001100, 0b0000001100, 0b0000001100, 0b1100001100,
+        0b0111111000, 0b0011110000, 0b0000000000, 0b0000000000)},
+    // '4'
+    {'4', 10, BIGFONT_GLYPH(
+        0b0000000000, 0b0000011000, 0b0000111000, 0b0001111000,
+        0b0011011000, 0b0110011000, 0b1100011000, 0b1100011000,
+        0b1111111100, 0b1111111100, 0b0000011000, 0b0000011000,
+        0b0000011000, 0b0000011000, 0b0000000000, 0b0000000000)},
+    // '5'
+    {'5', 10, BIGFONT_GLYPH(
+        0b0000000000, 0b1111111100, 0b1111111100, 0b1100000000,
+        0b1100000000, 0b1111110000, 0b1111111000, 0b0000001100,
+        0b0000001100, 0b0000001100, 0b0000001100, 0b1100001100,
+        0b0111111000, 0b0011110000, 0b0000000000, 0b0000000000)},
+    // '6'
+    {'6', 10, BIGFONT_GLYPH(
+        0b0000000000, 0b0001111000, 0b0011000000, 0b0110000000,
+        0b1100000000, 0b1100000000, 0b1111110000, 0b1111111000,
+        0b1100001100, 0b1100001100, 0b1100001100, 0b1100001100,
+        0b0111111000, 0b0011110000, 0b0000000000, 0b0000000000)},
+    // '7'
+    {'7', 10, BIGFONT_GLYPH(
+        0b0000000000, 0b1111111100, 0b1111111100, 0b0000001100,
+        0b0000011000, 0b0000011000, 0b0000110000, 0b0000110000,
+        0b0001100000, 0b0001100000, 0b0011000000, 0b0011000000,
+        0b0011000000, 0b0011000000, 0b0000000000, 0b0000000000)},
+    // '8'
+    {'8', 10, BIGFONT_GLYPH(
+        0b0000000000, 0b0011110000, 0b0111111000, 0b1100001100,
+        0b1100001100, 0b1100001100, 0b0111111000, 0b0111111000,
+        0b1100001100, 0b1100001100, 0b1100001100, 0b1100001100,
+        0b0111111000, 0b0011110000, 0b0000000000, 0b0000000000)},
+    // '9'
+    {'9', 10, BIGFONT_GLYPH(
+        0b0000000000, 0b0011110000, 0b0111111000, 0b1100001100,
+        0b1100001100, 0b1100001100, 0b1100001100, 0b0111111100,
+        0b0011111100, 0b0000001100, 0b0000001100, 0b0000011000,
+        0b0000110000, 0b0111100000, 0b0000000000, 0b0000000000)},
+    // '-' minus
+    {'-', 10, BIGFONT_GLYPH(
+        0b0000000000, 0b0000000000, 0b0000000000, 0b0000000000,
+        0b0000000000, 0b0000000000, 0b0000000000, 0b1111111100,
+        0b1111111100, 0b0000000000, 0b0000000000, 0b0000000000,
+        0b0000000000, 0b0000000000, 0b0000000000, 0b0000000000)},
+    // '.' decimal point
+    {'.', 4, BIGFONT_GLYPH(
+        0b0000000000, 0b0000000000, 0b0000000000, 0b0000000000,
+        0b0000000000, 0b0000000000, 0b0000000000, 0b0000000000,
+        0b0000000000, 0b0000000000, 0b0000000000, 0b0000000000,
+        0b1100000000, 0b1100000000, 0b0000000000, 0b0000000000)},
+    // ' ' space
+    {' ', 4, BIGFONT_GLYPH(
+        0b0000000000, 0b0000000000, 0b0000000000, 0b0000000000,
+        0b0000000000, 0b0000000000, 0b0000000000, 0b0000000000,
+        0b0000000000, 0b0000000000, 0b0000000000, 0b0000000000,
+        0b0000000000, 0b0000000000, 0b0000000000, 0b0000000000)},
+    // 'M'
+    {'M', 10, BIGFONT_GLYPH(
+        0b0000000000, 0b1100001100, 0b1110011100, 0b1111111100,
+        0b1101101100, 0b1101101100, 0b1100001100, 0b1100001100,
+        0b1100001100, 0b1100001100, 0b1100001100, 0b1100001100,
+        0b1100001100, 0b1100001100, 0b0000000000, 0b0000000000)},
+    // 'k'
+    {'k', 10, BIGFONT_GLYPH(
+        0b0000000000, 0b1100000000, 0b1100000000, 0b1100000000,
+        0b1100000000, 0b1100011000, 0b1100110000, 0b1101100000,
+        0b1111000000, 0b1111000000, 0b1101100000, 0b1100110000,
+        0b1100011000, 0b1100001100, 0b0000000000, 0b0000000000)},
+    // 'm'
+    {'m', 10, BIGFONT_GLYPH(
+        0b0000000000, 0b0000000000, 0b0000000000, 0b0000000000,
+        0b0000000000, 0b1110110000, 0b1111111100, 0b1101101100,
+        0b1101101100, 0b1101101100, 0b1101101100, 0b1101101100,
+        0b1101101100, 0b1101101100, 0b0000000000, 0b0000000000)},
+    // 'u' micro
+    {'u', 10, BIGFONT_GLYPH(
+        0b0000000000, 0b0000000000, 0b0000000000, 0b0000000000,
+        0b0000000000, 0b1100001100, 0b1100001100, 0b1100001100,
+        0b1100001100, 0b1100001100, 0b1100001100, 0b1100011100,
+        0b0111111100, 0b0011101100, 0b0000000000, 0b0000000000)},
+    // 'V'
+    {'V', 10, BIGFONT_GLYPH(
+        0b0000000000, 0b1100001100, 0b1100001100, 0b1100001100,
+        0b1100001100, 0b1100001100, 0b1100001100, 0b0110011000,
+        0b0110011000, 0b0110011000, 0b0011110000, 0b0011110000,
+        0b0001100000, 0b0001100000, 0b0000000000, 0b0000000000)},
+    // 'A'
+    {'A', 10, BIGFONT_GLYPH(
+        0b0000000000, 0b0001100000, 0b0011110000, 0b0110011000,
+        0b1100001100, 0b1100001100, 0b1100001100, 0b1100001100,
+        0b1111111100, 0b1111111100, 0b1100001100, 0b1100001100,
+        0b1100001100, 0b1100001100, 0b0000000000, 0b0000000000)},
+    // Ohm (omega)
+    {BIGFONT_CH_OHM, 10, BIGFONT_GLYPH(
+        0b0000000000, 0b0011110000, 0b0111111000, 0b1100001100,
+        0b1100001100, 0b1100001100, 0b1100001100, 0b1100001100,
+        0b1100001100, 0b0110011000, 0b0010010000, 0b0010010000,
+        0b1110011100, 0b1110011100, 0b0000000000, 0b0000000000)}
+};
+
+// glyphs currently drawn in the frame buffer
+static BIGFONT_CELL rgCellsShown[BIGFONT_MAXCELLS];
+static int cCellsShown = 0;
+static int idxPageShown = -1;           // first page of the drawn value, -1 if nothing is drawn
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+// Section: Interface Functions                                               */
+/* ************************************************************************** */
+/* ************************************************************************** */
+
+/***	BIGFONT_DrawValue
+**
+**	Parameters:
+**		uint8_t *pbFrame        - the PmodOLED driver frame buffer
+**		int idxPage             - the first of the 2 pages used by the value row
+**		const char *pszVal      - the value information, as formatted by DMM_FormatValue
+**
+**	Return Value:
+**		int     - the number of glyphs drawn, or -1 if the value information cannot be displayed with the large font
+**
+**	Description:
+**		This function draws the value information with the large digits font, right aligned on the 2 pages.
+**      The glyph positions are compared from the right end with the glyphs drawn by the previous call, and only the
+**      glyphs whose character or position changed are copied in the frame buffer. The columns left of the value are cleared.
+**      The function returns -1, without changing the frame buffer, when the text contains a character without glyph
+**      (for example "OVERLOAD") or does not fit in the row; then the caller displays it with the regular font.
+**
+*/
+int BIGFONT_DrawValue(uint8_t *pbFrame, int idxPage, const char *pszVal)
+{
+    BIGFONT_CELL rgCells[BIGFONT_MAXCELLS];
+    int cCells = 0, cxTotal = 0, idxGlyph, idxCell, idxShown, xStart, xShownStart, cDrawn = 0;
+    const char *pch = pszVal;
+    // layout
+    while(*pch)
+    {
+        idxGlyph = BIGFONT_FindGlyph(&pch);
+        if(idxGlyph < 0 || cCells == BIGFONT_MAXCELLS)
+        {
+            return -1;
+        }
+        rgCells[cCells++].idxGlyph = idxGlyph;
+        cxTotal += rgGlyphs[idxGlyph].cx;
+    }
+    if(cxTotal > BIGFONT_COLUMNS)
+    {
+        return -1;
+    }
+    xStart = BIGFONT_COLUMNS - cxTotal;
+    for(idxCell = 0, cxTotal = xStart; idxCell < cCells; idxCell++)
+    {
+        rgCells[idxCell].x = cxTotal;
+        cxTotal += rgGlyphs[rgCells[idxCell].idxGlyph].cx;
+    }
+
+    if(idxPage != idxPageShown)
+    {
+        BIGFONT_Clear(pbFrame, idxPage, 0, BIGFONT_COLUMNS);
+        cCellsShown = 0;
+    }
+    xShownStart = cCellsShown ? rgCellsShown[0].x : BIGFONT_COLUMNS;
+    if(xShownStart < xStart)
+    {
+        // the value became shorter
+        BIGFONT_Clear(pbFrame, idxPage, xShownStart, xStart);
+    }
+    // each column right of xStart belongs to one glyph: the unchanged glyphs are already drawn there
+    for(idxCell = cCells - 1, idxShown = cCellsShown - 1; idxCell >= 0; idxCell--, idxShown--)
+    {
+        if(idxShown < 0 || rgCellsShown[idxShown].idxGlyph != rgCells[idxCell].idxGlyph || rgCellsShown[idxShown].x != rgCells[idxCell].x)
+        {
+            BIGFONT_Blit(pbFrame, idxPage, &rgCells[idxCell]);
+            cDrawn++;
+        }
+    }
+    memcpy(rgCellsShown, rgCells, cCells * sizeof(rgCells[0]));
+    cCellsShown = cCells;
+    idxPageShown = idxPage;
+    return cDrawn;
+}
+
+/***	BIGFONT_Invalidate
+**
+**	Parameters:
+**		none
+**
+**	Return Value:
+**		none
+**
+**	Description:
+**		This function forgets the drawn glyphs, so that the next BIGFONT_DrawValue clears the value row and draws all the glyphs.
+**      It must be called when the value row of the frame buffer is changed by other functions.
+**
+*/
+void BIGFONT_Invalidate()
+{
+    idxPageShown = -1;
+    cCellsShown = 0;
+}
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+// Section: Local Functions                                                   */
+/* ************************************************************************** */
+/* ************************************************************************** */
+
+/***	BIGFONT_FindGlyph
+**
+**	Parameters:
+**		const char **ppch       - pointer to the current position in the text, advanced after the found glyph
+**
+**	Return Value:
+**		int     - the index of the glyph in the font table, -1 if the character has no glyph
+**
+**	Description:
+**		This function finds the glyph of the character at the current position. The "Ohm" unit is represented by one glyph.
+**
+*/
+int BIGFONT_FindGlyph(const char **ppch)
+{
+    int idxGlyph;
+    char ch = **ppch;
+    if(!strncmp(*ppch, "Ohm", 3))
+    {
+        ch = BIGFONT_CH_OHM;
+        *ppch += 2;
+    }
+    (*ppch)++;
+    for(idxGlyph = 0; idxGlyph < sizeof(rgGlyphs) / sizeof(rgGlyphs[0]); idxGlyph++)
+    {
+        if(rgGlyphs[idxGlyph].ch == ch)
+        {
+            return idxGlyph;
+        }
+    }
+    return -1;
+}
+
+/***	BIGFONT_Blit
+**
+**	Parameters:
+**		uint8_t *pbFrame            - the frame buffer
+**		int idxPage                 - the first page of the value row
+**		const BIGFONT_CELL *pCell   - the glyph and its position
+**
+**	Return Value:
+**		none
+**
+**	Description:
+**		This function copies the column bytes of a glyph in the frame buffer.
+**
+*/
+void BIGFONT_Blit(uint8_t *pbFrame, int idxPage, const BIGFONT_CELL *pCell)
+{
+    int idxPg;
+    const BIGFONT_GLYPH *pGlyph = &rgGlyphs[pCell->idxGlyph];
+    for(idxPg = 0; idxPg < BIGFONT_PAGES; idxPg++)
+    {
+        memcpy(pbFrame + (idxPage + idxPg) * BIGFONT_COLUMNS + pCell->x, pGlyph->rgb[idxPg], pGlyph->cx);
+    }
+}
+
+/***	BIGFONT_Clear
+**
+**	Parameters:
+**		uint8_t *pbFrame        - the frame buffer
+**		int idxPage             - the first page of the value row
+**		int xFirst              - the first column to be cleared
+**		int xEnd                - the column after the last column to be cleared
+**
+**	Return Value:
+**		none
+**
+**	Description:
+**		This function clears a range of columns of the value row.
+**
+*/
+void BIGFONT_Clear(uint8_t *pbFrame, int idxPage, int xFirst, int xEnd)
+{
+    int idxPg;
+    for(idxPg = 0; idxPg < BIGFONT_PAGES; idxPg++)
+    {
+        memset(pbFrame + (idxPage + idxPg) * BIGFONT_COLUMNS + xFirst, 0, xEnd - xFirst);
+    }
+}
+
+/* *****************************************************************************
+ End of File
+ */
@@ -0,0 +1,62 @@
+/* ************************************************************************** */
+/** Descriptive File Name
+
+  @Company
+ Digilent
+
+  @File Name
+    bigfont.h
+
+  @Description
+        This file contains the declarations for the BIGFONT module functions.
+        The BIGFONT functions are defined in bigfont.c source file.
+
+ */
+/* ************************************************************************** */
+
+#ifndef _BIGFONT_H    /* Guard against multiple inclusion */
+#define _BIGFONT_H
+
+#include "stdint.h"
+#include "PmodOLED.h"
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Constants                                                         */
+/* ************************************************************************** */
+#define BIGFONT_PAGES           2               // glyph height in pages (16 pixel rows)
+#define BIGFONT_MAXWIDTH        10              // width of the widest glyph (columns), including the spacing
+#define BIGFONT_COLUMNS         ccolOledMax     // number of columns of the frame buffer
+#define BIGFONT_MAXCELLS        (BIGFONT_COLUMNS / 4)   // maximum number of glyphs on a row (the narrowest glyph has 4 columns)
+#define BIGFONT_CH_OHM          '\x01'          // glyph code of the Ohm unit, written "Ohm" in the value information
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Data Types
+// *****************************************************************************
+// *****************************************************************************
+typedef struct _BIGFONT_GLYPH{
+    char ch;                                            // character represented by the glyph
+    uint8_t cx;                                         // glyph width (columns)
+    uint8_t rgb[BIGFONT_PAGES][BIGFONT_MAXWIDTH];       // column bytes of each page, in frame buffer format
+} BIGFONT_GLYPH;
+
+// glyph drawn at a position of the value row
+typedef struct _BIGFONT_CELL{
+    uint8_t idxGlyph;           // index of the glyph in the font table
+    uint8_t x;                  // first column
+} BIGFONT_CELL;
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Interface Functions
+// *****************************************************************************
+// *****************************************************************************
+int BIGFONT_DrawValue(uint8_t *pbFrame, int idxPage, const char *pszVal);
+void BIGFONT_Invalidate();
+
+#endif /* _BIGFONT_H */
+
+/* *****************************************************************************
+ End of File
+ */
@@ -39,9 +39,11 @@
 #include "eprom.h"
 #include "uart.h"
 #include "math.h"
+#include <string.h>
 #include "calib.h"
 #include "errors.h"
 #include "utils.h"
+#include "xadc.h"
 
 /* ************************************************************************** */
 /* ************************************************************************** */
@@ -51,14 +53,29 @@
 /* ************************************************************************** */
 
 uint8_t CALIB_MeasureForCalibZeroVal(double *pMeasuredVal);
+uint8_t CALIB_MeasureForCalibVal(uint8_t bType, double *pMeasuredVal);
 void CALIB_InitPartCalibData();
-uint8_t CALIB_WriteAllCalibsToEPROM_Raw(uint8_t baseAddr);
-uint8_t CALIB_ReadAllCalibsFromEPROM_Raw(CALIBDATA *pCalib, uint8_t baseAddr);
+uint8_t CALIB_WriteAllCalibsToEPROM_Raw(EPROM_CALLBACK pfnDone);
+uint8_t CALIB_ReadAllCalibsFromEPROM_Raw(CALIBDATA *pCalib, CALIBHDR *pHdr, uint8_t baseAddr);
 uint8_t CALIB_VerifyEPROM_Raw(CALIBDATA *pCalib, uint8_t baseAddr);
 uint8_t CALIB_ExportCalibs_Raw(char *pSzCalibs, uint8_t baseAddr);
 uint8_t CALIB_ERR_CheckDoubleVal(double dVal);
 uint8_t CALIB_CheckCompleteCalib();
 uint8_t CALIB_CntCalibDirty();
+void CALIB_SetAllCalibDirty();
+void CALIB_SaveStart();
+uint8_t CALIB_SaveStep(uint8_t fAsync);
+void CALIB_SaveNext(uint8_t bResult);
+uint8_t CALIB_ReplayJournal();
+void CALIB_GetScaleWords(int idxScale, uint8_t *rgfCheck);
+uint8_t CALIB_WriteWords_Raw(uint8_t bAddress, uint16_t *pwNew, uint8_t *rgfCheck, int cwVals, uint8_t fAsync, EPROM_CALLBACK pfnDone);
+uint16_t CALIB_GetCalibCrc16(CALIBDATA *pCalib, CALIBHDR *pHdr);
+void CALIB_AddMeasureSample(double dVal);
+uint8_t CALIB_CheckMeasureSamples(int idxScale);
+uint8_t CALIB_UpdateCalibTemp(int idxScale);
+void CALIB_ReadTempCoeffFromEPROM();
+void CALIB_SetCalibDirty(int idxScale);
+void CALIB_SaveDone(uint8_t bResult);
 
 /* ************************************************************************** */
 /* ************************************************************************** */
@@ -67,6 +84,7 @@ uint8_t CALIB_CntCalibDirty();
 /* ************************************************************************** */
 /* ************************************************************************** */
 uint8_t EPROM_WriteWords_Raw(uint8_t bAddress, uint16_t *prgVals, int cwVals);
+uint8_t EPROM_WriteWordsAsync_Raw(uint8_t bAddress, uint16_t *prgVals, int cwVals, EPROM_CALLBACK pfnDone);
 // configuration functions
 uint8_t DMM_FACScale(int idxScale);
 uint8_t DMM_FDCScale(int idxScale);
@@ -84,9 +102,43 @@ uint8_t DMM_IsNotANumber(double dVal);
 /* ************************************************************************** */
 /* ************************************************************************** */
 CALIBDATA calib;    // global variable - also visible in dmm.c (where declared as extern)
+CALIBHDR calibHdr;          // header of the user calibration: die temperature and CRC-16
 
 // global variables - local to this module
 PARTCALIBDATA partCalib;    // partCalib is used to store calibration related values, until all the needed calibration data is present and calibration can be finalized.
+uint8_t bMeasureType;       // type of the measurement started by CALIB_MeasureForCalibStart
+
+// statistics of the measurement for calibration (CALIB_MeasureForCalibStart / CALIB_MeasureForCalibStep)
+static int cMeasureSamples;         // number of values
+static double dMeasureMean;         // running mean of the values (Welford)
+static double dMeasureM2;           // running sum of the squared deviations from the mean (Welford)
+static double dMeasureFirst;        // first value, the drift sums are relative to it to keep the precision
+static double dMeasureSumD;         // sum of the values relative to the first one
+static double dMeasureSumID;        // sum of the values relative to the first one, multiplied by the value index
+
+// Student t values for the 95% two sided confidence interval, for 1 to 19 degrees of freedom
+static const double rgdStudentT95[] = {12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+                                        2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093};
+#define CNT_STUDENTT95  ((int)(sizeof(rgdStudentT95) / sizeof(rgdStudentT95[0])))
+
+// temperature coefficients of the scales, in the EPROM record format; a scale without coefficient is not compensated
+static TEMPCOEFFDATA tempCoeff;
+
+// scales calibrated at the calibration temperature (bit idxScale), all the scales when it was read from EPROM
+static uint32_t dwCalibTempScales;
+
+// background save (CALIB_WriteAllCalibsToEPROM_UserAsync): scales whose dirty flag is cleared when it completes, completion callback
+static uint32_t dwSaveScales;
+static EPROM_CALLBACK pfnSaveDone = 0;
+
+// save of the user calibration (CALIB_SaveStart, CALIB_SaveStep)
+#define CALIB_SAVE_JOURNAL  0       // the record is valid, the scales are saved one by one through the journal
+#define CALIB_SAVE_MIGRATE  1       // the record is in the CRC-8 or the legacy format, it is converted to format 3 first
+#define CALIB_SAVE_FULL     2       // the record is not valid, it is written at once
+static uint8_t bSaveMode;
+static uint32_t dwSavePending;      // scales not saved yet (bit idxScale)
+static CALIBDATA calibSave;         // content of the user calibration area after the steps already written
+static CALIBHDR hdrSave;
 
 /* ************************************************************************** */
 /* ************************************************************************** */
@@ -108,6 +160,9 @@ PARTCALIBDATA partCalib;    // partCalib is used to store calibration related va
 **		This function initializes the calibration related data. 
 **      It initializes the EPROM module, the partial calibration data 
 **      and reads all the calibration values from user calibration area of EPROM.
+**      If the user calibration is missing or invalid (for example a save interrupted by a power loss), the factory calibration 
+**      is used instead and all the scales are marked as dirty, so that the next save writes the whole user calibration.
+**      If the factory calibration is invalid too, the calibration coefficients are cleared (no correction).
 **      The return values are related to errors when calibration is read from user calibration area of EPROM.
 **      The function returns ERRVAL_SUCCESS when success. 
 **      The function returns ERRVAL_EPROM_MAGICNO when a wrong magic number was detected in the data read from EPROM. 
@@ -122,9 +177,16 @@ uint8_t CALIB_Init()
 
     // initialize partial calibration data
     CALIB_InitPartCalibData();
+    CALIB_CntCalibDirty();      // clear the dirty flags, the calibration data is read from EPROM
     
 
+    CALIB_ReadTempCoeffFromEPROM();
     bResult = CALIB_ReadAllCalibsFromEPROM_User();
+    if(bResult != ERRVAL_SUCCESS && CALIB_ReadAllCalibsFromEPROM_Factory() != ERRVAL_SUCCESS)
+    {
+        // neither the user nor the factory calibration is valid
+        memset(calib.Dmm, 0, sizeof(calib.Dmm));
+    }
     return bResult;   
 }
 
@@ -153,7 +215,7 @@ uint8_t CALIB_Init()
 uint8_t CALIB_WriteAllCalibsToEPROM_User()
 {
     uint8_t bResult = 0;
-    bResult = CALIB_WriteAllCalibsToEPROM_Raw((uint8_t)ADR_EPROM_CALIB);  // write calibration to EPROM        
+    bResult = CALIB_WriteAllCalibsToEPROM_Raw(0);  // write calibration to EPROM        
     if(bResult == ERRVAL_SUCCESS)
     {
         bResult = CALIB_CntCalibDirty();
@@ -162,6 +224,43 @@ uint8_t CALIB_WriteAllCalibsToEPROM_User()
     return bResult;
 }
 
+/***	CALIB_WriteAllCalibsToEPROM_UserAsync
+**
+**	Parameters:
+**      EPROM_CALLBACK pfnDone  - called when the calibration data is written in EPROM, or the write failed
+**
+**	Return Value:
+**		uint8_t 
+**          value <  27                             // number of modified calibration since last save
+**
+**	Description:
+**		This function saves the calibration data in the user calibration area of EPROM in background, like CALIB_WriteAllCalibsToEPROM_User,
+**      using the background write queue of the EPROM module (EPROM_AsyncTick must be called periodically).
+**      The first save step is queued and the function returns, so the measurements can continue during the EPROM write:
+**      the next steps are queued when the previous one is written (see CALIB_SaveNext).
+**      pfnDone is called from EPROM_AsyncTick with ERRVAL_SUCCESS or ERRVAL_EPROM_WRTIMEOUT. When the asynchronous SPI engine
+**      is not initialized, the data is written before returning. A previous background save still in progress is finished first.
+**      The dirty flags of the saved scales are cleared only when the write completes (see CALIB_SaveDone): 
+**      if it fails, the next save writes these scales again.
+**      The partial calibration values are initialized, and the function returns the number of configurations 
+**      that were modified since last save. Unlike CALIB_WriteAllCalibsToEPROM_User, the calibration data is not read back from EPROM.
+**
+**            
+*/
+uint8_t CALIB_WriteAllCalibsToEPROM_UserAsync(EPROM_CALLBACK pfnDone)
+{
+    uint8_t cDirty = 0;
+    int idxScale;
+    // the count is taken before the write, the dirty flags are cleared before returning when the write is synchronous
+    for(idxScale = 0; idxScale < DMM_CNTSCALES; idxScale++)
+    {
+        cDirty += partCalib.DmmPartCalib[idxScale].fCalibDirty;
+    }
+    CALIB_WriteAllCalibsToEPROM_Raw(pfnDone);
+    CALIB_InitPartCalibData();
+    return cDirty;
+}
+
 /***	CALIB_ReadAllCalibsFromEPROM_User
 **
 **	Parameters:
@@ -179,11 +278,27 @@ uint8_t CALIB_WriteAllCalibsToEPROM_User()
 **      The function returns ERRVAL_SUCCESS for success. 
 **      The function returns ERRVAL_EPROM_MAGICNO when a wrong magic number was detected in the data read from EPROM. 
 **      The function returns ERRVAL_EPROM_CRC when the checksum is wrong for the data read from EPROM. 
+**      The die temperature of the user calibration is read from the calibration header too, 
+**      it is unknown (CALIB_TEMP_NONE) for a calibration in the CRC-8 or the legacy format.
+**      If the calibration fails its check, a save interrupted by a power loss is finished from the journal (see CALIB_ReplayJournal).
 **                    
 */
 uint8_t CALIB_ReadAllCalibsFromEPROM_User()
 {
-    return CALIB_ReadAllCalibsFromEPROM_Raw(&calib, (uint8_t)ADR_EPROM_CALIB);
+    uint8_t bResult;
+    bResult = CALIB_ReadAllCalibsFromEPROM_Raw(&calib, &calibHdr, (uint8_t)ADR_EPROM_CALIB);
+    if(bResult == ERRVAL_EPROM_CRC && calib.magic == EPROM_MAGIC_CRC16 && CALIB_ReplayJournal() == ERRVAL_SUCCESS)
+    {
+        bResult = ERRVAL_SUCCESS;
+    }
+    if(bResult != ERRVAL_SUCCESS)
+    {
+        calibHdr.temp = CALIB_TEMP_NONE;
+    }
+    // the scales calibrated at this temperature are not recorded
+    dwCalibTempScales = (calibHdr.temp == CALIB_TEMP_NONE) ? 0: (1ul << DMM_CNTSCALES) - 1;
+    DMM_UpdateCorrection();
+    return bResult;
 }
 
 
@@ -204,11 +319,19 @@ uint8_t CALIB_ReadAllCalibsFromEPROM_User()
 **      The function returns ERRVAL_SUCCESS for success. 
 **      The function returns ERRVAL_EPROM_MAGICNO when a wrong magic number was detected in the data read from EPROM. 
 **      The function returns ERRVAL_EPROM_CRC when the checksum is wrong for the data read from EPROM. 
+**      All the scales are marked as dirty, as the calibration data may now differ from the user calibration area of EPROM.
+**      The die temperature of the factory calibration is not stored, so the calibration temperature becomes unknown
+**      and the temperature compensation is disabled.
 **                    
 */
 uint8_t CALIB_ReadAllCalibsFromEPROM_Factory()
 {
-    return CALIB_ReadAllCalibsFromEPROM_Raw(&calib, (uint8_t)ADR_EPROM_FACTCALIB);
+    uint8_t bResult = CALIB_ReadAllCalibsFromEPROM_Raw(&calib, &calibHdr, (uint8_t)ADR_EPROM_FACTCALIB);
+    CALIB_SetAllCalibDirty();
+    calibHdr.temp = CALIB_TEMP_NONE;
+    dwCalibTempScales = 0;
+    DMM_UpdateCorrection();
+    return bResult;
 }
 
 /***	CALIB_RestoreAllCalibsFromEPROM_Factory
@@ -355,10 +478,11 @@ float CALIB_ComputeAdd(int idxScale)
 **          ERRVAL_SUCCESS                  0       // success
 **          ERRVAL_DMM_IDXCONFIG            0xFC    // wrong scale index
 **          ERRVAL_DMM_VALIDDATATIMEOUT     0xFA    // valid data DMM timeout
+**          ERRVAL_CALIB_UNSTABLE           0xE6    // the reference is too noisy or drifting
 **
 **	Description:
 **		This function performs the measurement for calibration on zero, for the currently selected scale.
-**      The function calls the DMM_DGetAvgValue function in order to acquire the measured value without the calibration correction being applied.     
+**      The function runs the CALIB_MeasureForCalibStart / CALIB_MeasureForCalibStep state machine in order to acquire the measured value without the calibration correction being applied.     
 **      When success, the measured value is stored in the Calib_Ms_Zero field of partCalibData, and it's set as measured value.
 **      If there is no valid current configuration selected, the function returns ERRVAL_DMM_IDXCONFIG and the measured value is set to NAN. 
 **      If a valid measurement cannot be performed, the function returns ERRVAL_DMM_VALIDDATATIMEOUT and the measured value is set to NAN. 
@@ -367,32 +491,7 @@ float CALIB_ComputeAdd(int idxScale)
 */
 uint8_t CALIB_MeasureForCalibZeroVal(double *pMeasuredVal)
 {
-    double dVal;
-    int idxScale = DMM_GetCurrentScale();
-	uint8_t bResult = DMM_ERR_CheckIdxCalib(idxScale);
-    if(bResult == ERRVAL_SUCCESS)
-    {
-        DMM_SetUseCalib(0);
-        dVal = DMM_DGetAvgValue(MEASURE_CNT_AVG, &bResult);   // compute average value
-        DMM_SetUseCalib(1);
-
-        if(bResult == ERRVAL_SUCCESS)
-        {
-            // store the measured value
-            partCalib.DmmPartCalib[idxScale].Calib_Ms_Zero = dVal;
-        }
-    }
-    if(bResult != ERRVAL_SUCCESS)
-    {
-        dVal = NAN;
-    }
-
-    if(pMeasuredVal)
-    {
-        *pMeasuredVal = dVal;
-    }
-
-    return bResult;
+    return CALIB_MeasureForCalibVal(CALIB_MEASURE_ZERO, pMeasuredVal);
 }
 
 /***	CALIB_CalibOnZero
@@ -409,12 +508,13 @@ uint8_t CALIB_MeasureForCalibZeroVal(double *pMeasuredVal)
 **          ERRVAL_SUCCESS                  0       // success
 **          ERRVAL_DMM_IDXCONFIG            0xFC    // wrong scale index
 **          ERRVAL_DMM_VALIDDATATIMEOUT     0xFA    // valid data DMM timeout
+**          ERRVAL_CALIB_UNSTABLE           0xE6    // the reference is too noisy or drifting
 **          ERRVAL_DMM_MEASUREDISPERSION    0xF1    // The calibration measurement dispersion exceeds accepted range
 **
 **	Description:
 **		This function implements the calibration on zero procedure, for the currently selected scale.
 **      The function calls the CALIB_MeasureForCalibZeroVal local function in order to perform the measurement and provide the measured value.     
-**      When success, the function calls local function CALIB_CheckCompleteCalib, to check if the calibration process is complete.
+**      When success, the function calls CALIB_FinalizeCalibOnZero, which checks the dispersion and the complete calibration.
 **      The dispersion is computed as the difference between the measured and reference values, divided by the scale range. 
 **      The dispersion is checked to be in the accepted range using the DMM_CheckAcceptedMeasurementDispersion function.
 **      If parameter fIgnoreDispersion is non 0, the dispersion check is skipped, meaning that all the values are accepted and ERRVAL_DMM_MEASUREDISPERSION error is never returned.
@@ -435,65 +535,178 @@ uint8_t CALIB_CalibOnZero(double *pMeasuredVal, double *pDispersion, uint8_t fIg
 
         if(bResult == ERRVAL_SUCCESS)
         {
-            if(!fIgnoreDispersion)
-            {
-                // check if the measurement dispersion is within accepted range
-                bResult = DMM_CheckAcceptedMeasurementDispersion(*pMeasuredVal, DMM_FResistorScale(idxScale)? CALIB_RES_ZERO_REFVAL: 0, pDispersion);
-            }
-            if(bResult == ERRVAL_SUCCESS)
-            {                        
-                // check if the calibration data is complete
-                CALIB_CheckCompleteCalib(idxScale);  
-            }
-            else
-            {
-                // remove the measurement data
-                partCalib.DmmPartCalib[idxScale].Calib_Ms_Zero = NAN;
-            }
+            bResult = CALIB_FinalizeCalibOnZero(pMeasuredVal, pDispersion, fIgnoreDispersion);
         }
     }
     return bResult;
 }
 
-/***	CALIB_MeasureForCalibPositiveVal
+/***	CALIB_FinalizeCalibOnZero
 **
 **	Parameters:
-**		double *pMeasuredVal    - Pointer to a double variable that will store the measured value
+**		double *pMeasuredVal            - Pointer to a double variable that will store the measured value
+**      double *pDispersion             - Pointer to receive the measured value dispersion 
+**      uint8_t fIgnoreDispersion - Flag used to request the dispersion check to be ignored.
+**                      non 0       - Skip the dispersion check.
+**                      0           - Perform the dispersion check. 
 **
 **	Return Value:
 **		uint8_t 
 **          ERRVAL_SUCCESS                  0       // success
 **          ERRVAL_DMM_IDXCONFIG            0xFC    // wrong scale index
-**          ERRVAL_DMM_VALIDDATATIMEOUT     0xFA    // valid data DMM timeout
+**          ERRVAL_DMM_MEASUREDISPERSION    0xF1    // The calibration measurement dispersion exceeds accepted range
+**          ERRVAL_CALIB_MISSINGMEASUREMENT 0xF0    // A measurement must be performed before calling the finalize calibration.
 **
 **	Description:
-**		This function performs the measurement for the calibration on positive value procedure, for the currently selected scale.
-**      The function calls the DMM_DGetAvgValue function in order to acquire the measured value without the calibration correction being applied.     
-**      When success, the measured value is stored in the Calib_Ms_ValP field of partCalibData structure, and it's set as measured value.
-**      If there is no valid current configuration selected, the function returns ERRVAL_DMM_IDXCONFIG and the measured value is set to NAN. 
-**      If a valid measurement cannot be performed, the function returns ERRVAL_DMM_VALIDDATATIMEOUT and the measured value is set to NAN. 
-**      This function can be called by CALIB_CalibOnPositive or can be called directly, before CALIB_CalibOnPositive (this is considered early measurement).
-**     
+**		This function finalizes the calibration on zero procedure, for the currently selected scale, 
+**      using the value measured by a previous CALIB_MeasureForCalibZeroVal or CALIB_MeasureForCalibStart / Step call.
+**      If Calib_Ms_Zero is not valid, the function returns ERRVAL_CALIB_MISSINGMEASUREMENT.
+**      The dispersion is checked the same way as in CALIB_CalibOnZero. If it is not in the accepted range 
+**      the measurement data is removed and ERRVAL_DMM_MEASUREDISPERSION is returned.
+**      When success, the function calls local function CALIB_CheckCompleteCalib, to check if the calibration process is complete.
 **                
 */
-uint8_t CALIB_MeasureForCalibPositiveVal(double *pMeasuredVal)
+uint8_t CALIB_FinalizeCalibOnZero(double *pMeasuredVal, double *pDispersion, uint8_t fIgnoreDispersion)
 {
-    double dVal;
     int idxScale = DMM_GetCurrentScale();
 	uint8_t bResult = DMM_ERR_CheckIdxCalib(idxScale);
+    double dMeasuredVal;
+    if(bResult == ERRVAL_SUCCESS)
+    {
+        dMeasuredVal = partCalib.DmmPartCalib[idxScale].Calib_Ms_Zero;
+        if(pMeasuredVal)
+        {
+            *pMeasuredVal = dMeasuredVal;
+        }
+        if(DMM_IsNotANumber(dMeasuredVal))
+        {
+            bResult = ERRVAL_CALIB_MISSINGMEASUREMENT;
+        }
+    }
+    if(bResult == ERRVAL_SUCCESS)
+    {
+        if(!fIgnoreDispersion)
+        {
+            // check if the measurement dispersion is within accepted range
+            bResult = DMM_CheckAcceptedMeasurementDispersion(dMeasuredVal, DMM_FResistorScale(idxScale)? CALIB_RES_ZERO_REFVAL: 0, pDispersion);
+        }
+        if(bResult == ERRVAL_SUCCESS)
+        {                        
+            // check if the calibration data is complete
+            CALIB_CheckCompleteCalib(idxScale);  
+        }
+        else
+        {
+            // remove the measurement data
+            partCalib.DmmPartCalib[idxScale].Calib_Ms_Zero = NAN;
+        }
+    }
+    return bResult;
+}
+
+/***	CALIB_MeasureForCalibStart
+**
+**	Parameters:
+**		uint8_t bType    - The measurement type:
+**                  CALIB_MEASURE_ZERO      0   - measurement for calibration on zero
+**                  CALIB_MEASURE_POSITIVE  1   - measurement for calibration on positive value
+**                  CALIB_MEASURE_NEGATIVE  2   - measurement for calibration on negative value
+**
+**	Return Value:
+**		uint8_t 
+**          ERRVAL_SUCCESS                  0       // success
+**          ERRVAL_DMM_IDXCONFIG            0xFC    // wrong scale index
+**
+**	Description:
+**		This function starts the resumable measurement for calibration, for the currently selected scale.
+**      It disables the calibration correction and starts acquiring the values, up to MEASURE_CNT_AVG of them.
+**      The measurement is performed by the following calls of CALIB_MeasureForCalibStep.
+**      If there is no valid current configuration selected, the function returns ERRVAL_DMM_IDXCONFIG. 
+**                
+*/
+uint8_t CALIB_MeasureForCalibStart(uint8_t bType)
+{
+	uint8_t bResult = DMM_ERR_CheckIdxCalib(DMM_GetCurrentScale());
     if(bResult == ERRVAL_SUCCESS)
     {
+        bMeasureType = bType;
         DMM_SetUseCalib(0);
-        dVal = DMM_DGetAvgValue(MEASURE_CNT_AVG, &bResult);   // compute and get average value
-        DMM_SetUseCalib(1);
+        cMeasureSamples = 0;
+        dMeasureMean = 0;
+        dMeasureM2 = 0;
+        dMeasureSumD = 0;
+        dMeasureSumID = 0;
+        DMM_DGetValueStart();
+    }
+    return bResult;
+}
 
-        if(bResult == ERRVAL_SUCCESS)
+/***	CALIB_MeasureForCalibStep
+**
+**	Parameters:
+**		double *pMeasuredVal    - Pointer to a double variable that will store the measured value
+**
+**	Return Value:
+**		uint8_t 
+**          ERRVAL_SUCCESS                  0       // success
+**          ERRVAL_DMM_PENDING              0xEC    // the measurement is not finished, call again
+**          ERRVAL_DMM_IDXCONFIG            0xFC    // wrong scale index
+**          ERRVAL_DMM_VALIDDATATIMEOUT     0xFA    // valid data DMM timeout
+**          ERRVAL_CALIB_UNSTABLE           0xE6    // the reference is too noisy or drifting
+**
+**	Description:
+**		This function performs one step of the measurement for calibration started by CALIB_MeasureForCalibStart.
+**      Each value is added to the measurement statistics, checked by CALIB_CheckMeasureSamples: the measurement ends
+**      as soon as the mean is precise enough compared to the accepted dispersion of the scale, or after MEASURE_CNT_AVG values,
+**      and it fails early with ERRVAL_CALIB_UNSTABLE when the reference is too noisy or drifting.
+**      The measured value is the mean of the values, or their RMS (quadratic mean) for the AC scales.
+**      When the measurement is finished, the calibration correction is enabled again and, when success, 
+**      the measured value is stored in the Calib_Ms_Zero, Calib_Ms_ValP or Calib_Ms_ValN field of partCalibData, 
+**      according to the measurement type, and it's set as measured value.
+**      If a valid measurement cannot be performed, the measured value is set to NAN. 
+**      The measured value is not set while ERRVAL_DMM_PENDING is returned.
+**                
+*/
+uint8_t CALIB_MeasureForCalibStep(double *pMeasuredVal)
+{
+    double dVal;
+    int idxScale = DMM_GetCurrentScale();
+	uint8_t bResult = DMM_DGetValueStep(&dVal);
+    if(bResult == ERRVAL_DMM_PENDING)
+    {
+        return bResult;
+    }
+    // values outside the convertor range end the measurement and are returned as they are
+    if(bResult == ERRVAL_SUCCESS && dVal != INFINITY && dVal != -INFINITY && !DMM_IsNotANumber(dVal))
+    {
+        CALIB_AddMeasureSample(dVal);
+        bResult = CALIB_CheckMeasureSamples(idxScale);
+        if(bResult == ERRVAL_DMM_PENDING)
         {
-			// store the measured value
-			partCalib.DmmPartCalib[idxScale].Calib_Ms_ValP = dVal;             
+            DMM_DGetValueStart();
+            return bResult;
         }
+        // use RMS (Quadratic mean) value for AC, normal (Arithmetic mean) value for other that AC.
+        dVal = DMM_FACScale(idxScale) ? sqrt(dMeasureMean * dMeasureMean + dMeasureM2 / cMeasureSamples): dMeasureMean;
     }
-    if(bResult != ERRVAL_SUCCESS)
+    DMM_SetUseCalib(1);
+    if(bResult == ERRVAL_SUCCESS)
+    {
+        // store the measured value
+        switch(bMeasureType)
+        {
+            case CALIB_MEASURE_ZERO:
+                partCalib.DmmPartCalib[idxScale].Calib_Ms_Zero = dVal;
+                break;
+            case CALIB_MEASURE_POSITIVE:
+                partCalib.DmmPartCalib[idxScale].Calib_Ms_ValP = dVal;
+                break;
+            default:
+                partCalib.DmmPartCalib[idxScale].Calib_Ms_ValN = dVal;
+                break;
+        }
+    }
+    else
     {
         dVal = NAN;
     }
@@ -504,6 +717,33 @@ uint8_t CALIB_MeasureForCalibPositiveVal(double *pMeasuredVal)
     return bResult;
 }
 
+/***	CALIB_MeasureForCalibPositiveVal
+**
+**	Parameters:
+**		double *pMeasuredVal    - Pointer to a double variable that will store the measured value
+**
+**	Return Value:
+**		uint8_t 
+**          ERRVAL_SUCCESS                  0       // success
+**          ERRVAL_DMM_IDXCONFIG            0xFC    // wrong scale index
+**          ERRVAL_DMM_VALIDDATATIMEOUT     0xFA    // valid data DMM timeout
+**          ERRVAL_CALIB_UNSTABLE           0xE6    // the reference is too noisy or drifting
+**
+**	Description:
+**		This function performs the measurement for the calibration on positive value procedure, for the currently selected scale.
+**      The function runs the CALIB_MeasureForCalibStart / CALIB_MeasureForCalibStep state machine in order to acquire the measured value without the calibration correction being applied.     
+**      When success, the measured value is stored in the Calib_Ms_ValP field of partCalibData structure, and it's set as measured value.
+**      If there is no valid current configuration selected, the function returns ERRVAL_DMM_IDXCONFIG and the measured value is set to NAN. 
+**      If a valid measurement cannot be performed, the function returns ERRVAL_DMM_VALIDDATATIMEOUT and the measured value is set to NAN. 
+**      This function can be called by CALIB_CalibOnPositive or can be called directly, before CALIB_CalibOnPositive (this is considered early measurement).
+**     
+**                
+*/
+uint8_t CALIB_MeasureForCalibPositiveVal(double *pMeasuredVal)
+{
+    return CALIB_MeasureForCalibVal(CALIB_MEASURE_POSITIVE, pMeasuredVal);
+}
+
 /***	CALIB_CalibOnPositive
 **
 **	Parameters:
@@ -520,6 +760,7 @@ uint8_t CALIB_MeasureForCalibPositiveVal(double *pMeasuredVal)
 **          ERRVAL_SUCCESS                  0       // success
 **          ERRVAL_DMM_IDXCONFIG            0xFC    // wrong scale index
 **          ERRVAL_DMM_VALIDDATATIMEOUT     0xFA    // valid data DMM timeout
+**          ERRVAL_CALIB_UNSTABLE           0xE6    // the reference is too noisy or drifting
 **          ERRVAL_DMM_MEASUREDISPERSION    0xF1    // The calibration measurement dispersion exceeds accepted range
 **          ERRVAL_CALIB_MISSINGMEASUREMENT 0xF0    // A measurement must be performed before calling the finalize calibration function.
 **
@@ -600,10 +841,11 @@ uint8_t CALIB_CalibOnPositive(double dRefVal, double *pMeasuredVal, uint8_t bEar
 **          ERRVAL_SUCCESS                  0       // success
 **          ERRVAL_DMM_IDXCONFIG            0xFC    // wrong scale index
 **          ERRVAL_DMM_VALIDDATATIMEOUT     0xFA    // valid data DMM timeout
+**          ERRVAL_CALIB_UNSTABLE           0xE6    // the reference is too noisy or drifting
 **
 **	Description:
 **		This function performs the measurement for the calibration on negative value procedure, for the currently selected scale.
-**      The function calls the DMM_DGetAvgValue function in order to acquire the measured value without the calibration correction being applied.     
+**      The function runs the CALIB_MeasureForCalibStart / CALIB_MeasureForCalibStep state machine in order to acquire the measured value without the calibration correction being applied.     
 **      When success, the measured value is stored in the Calib_Ms_ValN field of partCalibData, and it's set as measured value.
 **      If there is no valid current configuration selected, the function returns ERRVAL_DMM_IDXCONFIG and the measured value is set to NAN. 
 **      If a valid measurement cannot be performed, the function returns ERRVAL_DMM_VALIDDATATIMEOUT and the measured value is set to NAN. 
@@ -611,31 +853,7 @@ uint8_t CALIB_CalibOnPositive(double dRefVal, double *pMeasuredVal, uint8_t bEar
 */
 uint8_t CALIB_MeasureForCalibNegativeVal(double *pMeasuredVal)
 {
-    double dVal;
-    int idxScale = DMM_GetCurrentScale();
-	uint8_t bResult = DMM_ERR_CheckIdxCalib(idxScale);
-    if(bResult == ERRVAL_SUCCESS)
-    {
-        DMM_SetUseCalib(0);
-        dVal = DMM_DGetAvgValue(20, &bResult);   // aquire average value
-        DMM_SetUseCalib(1);
-
-        if(bResult == ERRVAL_SUCCESS)
-        {
-			// store the measured value
-			partCalib.DmmPartCalib[idxScale].Calib_Ms_ValN = dVal;          
-        }
-    }
-    if(bResult != ERRVAL_SUCCESS)
-    {
-        dVal = NAN;
-    }
-
-    if(pMeasuredVal)
-    {
-        *pMeasuredVal = dVal;
-    }
-   return bResult;
+    return CALIB_MeasureForCalibVal(CALIB_MEASURE_NEGATIVE, pMeasuredVal);
 }
 
 /***	CALIB_CalibOnNegative
@@ -654,6 +872,7 @@ uint8_t CALIB_MeasureForCalibNegativeVal(double *pMeasuredVal)
 **          ERRVAL_SUCCESS                  0       // success
 **          ERRVAL_DMM_IDXCONFIG            0xFC    // wrong scale index
 **          ERRVAL_DMM_VALIDDATATIMEOUT     0xFA    // valid data DMM timeout
+**          ERRVAL_CALIB_UNSTABLE           0xE6    // the reference is too noisy or drifting
 **          ERRVAL_DMM_MEASUREDISPERSION    0xF1    // The calibration measurement dispersion exceeds accepted range
 **          ERRVAL_CALIB_MISSINGMEASUREMENT 0xF0    // A measurement must be performed before calling the finalize calibration.
 **
@@ -806,7 +1025,7 @@ uint8_t CALIB_ImportCalibCoefficients(int idxScale, float fMult, float fAdd)
     {
         calib.Dmm[idxScale].Mult = fMult;
         calib.Dmm[idxScale].Add = fAdd;
-        partCalib.DmmPartCalib[idxScale].fCalibDirty = 1;   // needs to be written to EPROM  
+        CALIB_SetCalibDirty(idxScale);      // needs to be written to EPROM  
     }
     return bResult;
 }
@@ -843,86 +1062,764 @@ uint8_t CALIB_VerifyEPROM()
     return CALIB_VerifyEPROM_Raw(&calib, (uint8_t)ADR_EPROM_CALIB);
 }
 
-/* ************************************************************************** */
-/* ************************************************************************** */
-// Section: Local Functions                                                   */
-/* ************************************************************************** */
-/* ************************************************************************** */
-
-/***	CALIB_InitPartCalibData()
+/***	CALIB_GetCalibTemp
 **
 **	Parameters:
 **		none
 **
 **	Return Value:
-**		none
+**		double  - the die temperature (Celsius) of the user calibration, NAN if it is unknown
 **
 **	Description:
-**		This function initializes the partCalib data, used to store calibration  
-**      values, to be used when all the needed calibration will be present.
-**      It also clears the dirty flags, used to mark configurations that were calibrated since last save to EPROM.
-**      This function is intended to be called when the application starts 
-**      and every time the calibration data is saved to user space in EPROM
-**          
+**		This function returns the die temperature recorded when the calibrations were finalized (see CALIB_UpdateCalibTemp).
+**      It is unknown when the calibration was done before the temperature was recorded or restored from the factory calibration.
+**                
 */
-void CALIB_InitPartCalibData()
+double CALIB_GetCalibTemp()
 {
-    int idxScale;
-    for(idxScale = 0; idxScale < DMM_CNTSCALES; idxScale++)
-    {
-        partCalib.DmmPartCalib[idxScale].Calib_Ms_Zero = NAN;
-        partCalib.DmmPartCalib[idxScale].Calib_Ms_ValN  = NAN;
-        partCalib.DmmPartCalib[idxScale].Calib_Ref_ValN = NAN;
-        partCalib.DmmPartCalib[idxScale].Calib_Ms_ValP  = NAN;
-        partCalib.DmmPartCalib[idxScale].Calib_Ref_ValP = NAN;
-        partCalib.DmmPartCalib[idxScale].fCalibDirty = 0;
-    }
+    return (calibHdr.temp == CALIB_TEMP_NONE) ? NAN: calibHdr.temp / 100.0;
 }
 
-/***	CALIB_WriteAllCalibsToEPROM_Raw
+/***	CALIB_SetTempCoeff
 **
 **	Parameters:
-**      uint8_t baseAddr		- the address where the calibration data  will be written in EPROM
+**		int idxScale    - the scale index
+**		float fPpm      - the temperature coefficient of the scale (ppm / Celsius), 0 disables the compensation
 **
 **	Return Value:
 **		uint8_t 
 **          ERRVAL_SUCCESS                  0       // success
-**          ERRVAL_EPROM_WRTIMEOUT          0xFF    // EPROM write data ready timeout
+**          ERRVAL_DMM_IDXCONFIG            0xFC    // wrong scale index
+**          ERRVAL_TEMPCOEFF_FORMAT         0xE0    // the temperature coefficient is out of range
+**          ERRVAL_TEMPCOEFF_FULL           0xE1    // all the temperature coefficient slots are used
 **
 **	Description:
-**		This function is a system function that writes calibration data to a specific location in EPROM.
-**      The payload consists of the bytes for the calibration coefficients for all scales and a signature byte called magic number (0x23).
-**      The calibration data to be written in EPROM consists of the payload bytes and a checksum byte computed for the payload bytes.
-**      This function is called by CALIB_WriteAllCalibsToEPROM_User, which provides proper address in EPROM for user calibration area.
-**      This function shouldn't be called by user, instead, the user should call CALIB_WriteAllCalibsToEPROM_User. 
-**      The function returns ERRVAL_SUCCESS for success or ERRVAL_EPROM_WRTIMEOUT. 
-**      when calibration data write in EPROM is not properly performed. 
-**            
+**		This function sets the temperature coefficient of a scale: the relative change of the values acquired 
+**      on the scale for one Celsius increase of the die temperature. 
+**      The coefficient is rounded to 0.01 ppm / Celsius, and up to CALIB_TEMPCOEFF_CNTSLOTS scales have a coefficient:
+**      the slot of the scale is reused, otherwise a free slot is used. A 0 coefficient frees the slot of the scale.
+**      The coefficients are stored in EPROM with the user calibration (CALIB_WriteAllCalibsToEPROM_User).
+**                
 */
-uint8_t CALIB_WriteAllCalibsToEPROM_Raw(uint8_t baseAddr)
+uint8_t CALIB_SetTempCoeff(int idxScale, float fPpm)
 {
-    uint8_t bResult;
-    EPROM_WriteEnable();
-    calib.magic = EPROM_MAGIC_NO;
-    calib.crc = 0;  // neutral value for the checksum
-    calib.crc = GetBufferChecksum((uint8_t *)&calib, sizeof(calib));     
-
-    // write calibration structure
-    bResult = EPROM_WriteWords_Raw(baseAddr, (uint16_t *)&calib, sizeof(calib)/2);
-    EPROM_WriteDisable();
-    return bResult;
+    uint8_t bResult = DMM_ERR_CheckIdxCalib(idxScale);
+    TEMPCOEFF *pSlot = NULL, *pFree = NULL;
+    int16_t coeff;
+    int i;
+    if(bResult != ERRVAL_SUCCESS)
+    {
+        return bResult;
+    }
+    if(!(fabs(fPpm) <= INT16_MAX / 100.0))
+    {
+        return ERRVAL_TEMPCOEFF_FORMAT;
+    }
+    coeff = (int16_t)round(fPpm * 100);
+    for(i = 0; i < CALIB_TEMPCOEFF_CNTSLOTS; i++)
+    {
+        if(tempCoeff.rgCoeffs[i].idxScale == idxScale)
+        {
+            pSlot = &tempCoeff.rgCoeffs[i];
+        }
+        else if(tempCoeff.rgCoeffs[i].idxScale < 0 && !pFree)
+        {
+            pFree = &tempCoeff.rgCoeffs[i];
+        }
+    }
+    if(!coeff)
+    {
+        if(pSlot)
+        {
+            pSlot->idxScale = -1;
+            pSlot->coeff = 0;
+        }
+    }
+    else
+    {
+        pSlot = pSlot ? pSlot : pFree;
+        if(!pSlot)
+        {
+            return ERRVAL_TEMPCOEFF_FULL;
+        }
+        pSlot->idxScale = idxScale;
+        pSlot->coeff = coeff;
+    }
+    DMM_UpdateCorrection();
+    return ERRVAL_SUCCESS;
 }
 
-/***	CALIB_ReadAllCalibsFromEPROM_Raw
+/***	CALIB_GetTempCoeff
 **
 **	Parameters:
-**      CALIBDATA *pCalib   - pointer to CALIB structure where data will be read from EPROM
-**      uint8_t baseAddr	- the EPROM address from where the calibration data read
-**                  This will distinguish between user and factory calibration areas
-**      
+**		int idxScale    - the scale index
 **
 **	Return Value:
-**		uint8_t 
+**		float   - the temperature coefficient of the scale (ppm / Celsius), 0 if the scale has no coefficient
+**
+**	Description:
+**		This function returns the temperature coefficient of a scale, set by CALIB_SetTempCoeff.
+**                
+*/
+float CALIB_GetTempCoeff(int idxScale)
+{
+    int i;
+    for(i = 0; i < CALIB_TEMPCOEFF_CNTSLOTS; i++)
+    {
+        if(tempCoeff.rgCoeffs[i].idxScale >= 0 && tempCoeff.rgCoeffs[i].idxScale == idxScale)
+        {
+            return tempCoeff.rgCoeffs[i].coeff / 100.0f;
+        }
+    }
+    return 0;
+}
+
+/***	CALIB_ReadTempCoeffFromEPROM
+**
+**	Parameters:
+**		none
+**
+**	Return Value:
+**		none
+**
+**	Description:
+**		This function reads the temperature coefficients from EPROM (ADR_EPROM_TEMPCOEFF). 
+**      If the record is missing or invalid, no scale has a coefficient: the temperature compensation is disabled.
+**                
+*/
+void CALIB_ReadTempCoeffFromEPROM()
+{
+    int i;
+    EPROM_ReadWords((uint8_t)ADR_EPROM_TEMPCOEFF, (uint16_t *)&tempCoeff, sizeof(TEMPCOEFFDATA)/2);
+    if(tempCoeff.magic != EPROM_MAGIC_CRC16 || EPROM_CheckRecord((uint8_t *)&tempCoeff, sizeof(TEMPCOEFFDATA)) != ERRVAL_SUCCESS)
+    {
+        memset(&tempCoeff, 0, sizeof(tempCoeff));
+        for(i = 0; i < CALIB_TEMPCOEFF_CNTSLOTS; i++)
+        {
+            tempCoeff.rgCoeffs[i].idxScale = -1;
+        }
+    }
+}
+
+/***	CALIB_GetTempFactor
+**
+**	Parameters:
+**		int idxScale    - the scale index
+**
+**	Return Value:
+**		double  - the factor to be applied on the calibrated values of the scale
+**
+**	Description:
+**		This function computes the temperature compensation factor of a scale, from its temperature coefficient 
+**      and the difference between the current die temperature (XADC_GetTemp) and the calibration temperature:
+**      1 / (1 + coefficient * (temperature - calibration temperature)).
+**      The factor is 1 when the coefficient is 0, or when one of the temperatures is unknown.
+**      It is called by DMM_UpdateCorrection, when the temperature or the coefficients change, not for each value.
+**                
+*/
+double CALIB_GetTempFactor(int idxScale)
+{
+    double dTemp = XADC_GetTemp();
+    double dCalibTemp = CALIB_GetCalibTemp();
+    float fPpm = CALIB_GetTempCoeff(idxScale);
+    if(fPpm == 0 || isnan(dTemp) || isnan(dCalibTemp))
+    {
+        return 1;
+    }
+    return 1.0 / (1.0 + fPpm * 1e-6 * (dTemp - dCalibTemp));
+}
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+// Section: Local Functions                                                   */
+/* ************************************************************************** */
+/* ************************************************************************** */
+
+/***	CALIB_MeasureForCalibVal
+**
+**	Parameters:
+**		uint8_t bType           - The measurement type (CALIB_MEASURE_ZERO, CALIB_MEASURE_POSITIVE or CALIB_MEASURE_NEGATIVE)
+**		double *pMeasuredVal    - Pointer to a double variable that will store the measured value
+**
+**	Return Value:
+**		uint8_t 
+**          ERRVAL_SUCCESS                  0       // success
+**          ERRVAL_DMM_IDXCONFIG            0xFC    // wrong scale index
+**          ERRVAL_DMM_VALIDDATATIMEOUT     0xFA    // valid data DMM timeout
+**          ERRVAL_CALIB_UNSTABLE           0xE6    // the reference is too noisy or drifting
+**
+**	Description:
+**		This function performs the complete measurement for calibration by calling CALIB_MeasureForCalibStart 
+**      and then CALIB_MeasureForCalibStep until the measurement is finished.
+**      If the measurement cannot be started, the measured value is set to NAN.
+**                
+*/
+uint8_t CALIB_MeasureForCalibVal(uint8_t bType, double *pMeasuredVal)
+{
+	uint8_t bResult = CALIB_MeasureForCalibStart(bType);
+    if(bResult == ERRVAL_SUCCESS)
+    {
+        while((bResult = CALIB_MeasureForCalibStep(pMeasuredVal)) == ERRVAL_DMM_PENDING);
+    }
+    else if(pMeasuredVal)
+    {
+        *pMeasuredVal = NAN;
+    }
+    return bResult;
+}
+
+/***	CALIB_AddMeasureSample
+**
+**	Parameters:
+**		double dVal     - The value acquired for the measurement for calibration
+**
+**	Return Value:
+**		none
+**
+**	Description:
+**		This function adds a value to the statistics of the measurement for calibration.
+**      The mean and the squared deviations are updated using the Welford method, which keeps the precision
+**      when the noise is small compared to the value. The drift sums are relative to the first value for the same reason.
+**                
+*/
+void CALIB_AddMeasureSample(double dVal)
+{
+    double dDelta = dVal - dMeasureMean;
+    if(!cMeasureSamples)
+    {
+        dMeasureFirst = dVal;
+    }
+    cMeasureSamples++;
+    dMeasureMean += dDelta / cMeasureSamples;
+    dMeasureM2 += dDelta * (dVal - dMeasureMean);
+    dMeasureSumD += dVal - dMeasureFirst;
+    dMeasureSumID += (cMeasureSamples - 1) * (dVal - dMeasureFirst);
+}
+
+/***	CALIB_CheckMeasureSamples
+**
+**	Parameters:
+**		int idxScale    - The scale being measured
+**
+**	Return Value:
+**		uint8_t 
+**          ERRVAL_SUCCESS                  0       // the measurement is finished
+**          ERRVAL_DMM_PENDING              0xEC    // more values are needed
+**          ERRVAL_CALIB_UNSTABLE           0xE6    // the reference is too noisy or drifting
+**
+**	Description:
+**		This function decides, from the statistics of the values acquired so far, if the measurement for calibration is finished.
+**      The limits are relative to the accepted dispersion of the scale (DMM_GetCalibAcceptance). After MEASURE_CNT_MIN values:
+**      - the drift is the least squares slope of the values over the acquired values. If it exceeds CALIB_DRIFT_MAX
+**      of the accepted dispersion even at the low end of its 95% confidence interval (n - 2 degrees of freedom), the measurement fails.
+**      - if even MEASURE_CNT_AVG values could not bring the 95% confidence interval half width of the mean below
+**      CALIB_NOISE_MAX of the accepted dispersion, the reference is too noisy and the measurement fails.
+**      - if the 95% confidence interval half width of the mean is below CALIB_CI_TARGET of the accepted dispersion
+**      and the drift is not significant, the measurement is finished.
+**      The measurement is finished anyway after MEASURE_CNT_AVG values, the dispersion check decides then.
+**      When the measurement fails, the error message is set to last error string in ERRORS module.
+**                
+*/
+uint8_t CALIB_CheckMeasureSamples(int idxScale)
+{
+    int n = cMeasureSamples;
+    double dAccept = DMM_GetCalibAcceptance(idxScale);
+    double dT, dTSlope, dTMax, dStdDev, dSxx, dSxy, dSlope, dResVar, dDrift, dDriftCI;
+    char szVal[20];
+    char szDev[20];
+    char szMax[20];
+    if(n < MEASURE_CNT_MIN && n < MEASURE_CNT_AVG)
+    {
+        return ERRVAL_DMM_PENDING;
+    }
+    if(n < 2)
+    {
+        return ERRVAL_SUCCESS;
+    }
+    // the mean has n - 1 degrees of freedom, the slope n - 2 (rgdStudentT95 starts at 1 degree of freedom)
+    dT = rgdStudentT95[(n - 2 < CNT_STUDENTT95) ? n - 2: CNT_STUDENTT95 - 1];
+    dStdDev = sqrt(dMeasureM2 / (n - 1));
+
+    // drift: least squares slope of the values over the value index
+    dSxx = n * ((double)n * n - 1) / 12;
+    dSxy = dMeasureSumID - (n - 1) * dMeasureSumD / 2;
+    dSlope = dSxy / dSxx;
+    dResVar = (n > 2) ? (dMeasureM2 - dSxy * dSlope) / (n - 2): 0;
+    dDrift = dSlope * (n - 1);
+    dTSlope = (n > 2) ? rgdStudentT95[(n - 3 < CNT_STUDENTT95) ? n - 3: CNT_STUDENTT95 - 1]: 0;
+    dDriftCI = (dResVar > 0) ? dTSlope * sqrt(dResVar / dSxx) * (n - 1): 0;
+    if(fabs(dDrift) - dDriftCI > CALIB_DRIFT_MAX * dAccept)
+    {
+        DMM_FormatValue(dDrift, szDev, 1);
+        DMM_FormatValue(CALIB_DRIFT_MAX * dAccept, szMax, 1);
+        sprintf(ERRORS_GetszLastError(), "Calibration reference drifting: Drift %s over %d samples, Max. drift: %s", szDev, n, szMax);
+        return ERRVAL_CALIB_UNSTABLE;
+    }
+
+    // noise: the confidence interval of the complete measurement would be too wide
+    dTMax = rgdStudentT95[(MEASURE_CNT_AVG - 2 < CNT_STUDENTT95) ? MEASURE_CNT_AVG - 2: CNT_STUDENTT95 - 1];
+    if(dTMax * dStdDev > CALIB_NOISE_MAX * dAccept * sqrt(MEASURE_CNT_AVG))
+    {
+        DMM_FormatValue(dMeasureMean, szVal, 1);
+        DMM_FormatValue(dStdDev, szDev, 1);
+        DMM_FormatValue(CALIB_NOISE_MAX * dAccept * sqrt(MEASURE_CNT_AVG) / dTMax, szMax, 1);
+        sprintf(ERRORS_GetszLastError(), "Calibration reference noisy: Mean %s, Std. deviation %s, Max. std. deviation: %s", szVal, szDev, szMax);
+        return ERRVAL_CALIB_UNSTABLE;
+    }
+
+    if(n >= MEASURE_CNT_AVG || (dT * dStdDev <= CALIB_CI_TARGET * dAccept * sqrt(n) && fabs(dDrift) <= dDriftCI))
+    {
+        return ERRVAL_SUCCESS;
+    }
+    return ERRVAL_DMM_PENDING;
+}
+
+/***	CALIB_InitPartCalibData()
+**
+**	Parameters:
+**		none
+**
+**	Return Value:
+**		none
+**
+**	Description:
+**		This function initializes the partCalib data, used to store calibration  
+**      values, to be used when all the needed calibration will be present.
+**      The dirty flags, used to mark configurations that were calibrated since last save to EPROM, are kept:
+**      they are cleared when the save is finished (CALIB_CntCalibDirty, CALIB_SaveDone).
+**      This function is intended to be called when the application starts 
+**      and every time the calibration data is saved to user space in EPROM
+**          
+*/
+void CALIB_InitPartCalibData()
+{
+    int idxScale;
+    for(idxScale = 0; idxScale < DMM_CNTSCALES; idxScale++)
+    {
+        partCalib.DmmPartCalib[idxScale].Calib_Ms_Zero = NAN;
+        partCalib.DmmPartCalib[idxScale].Calib_Ms_ValN  = NAN;
+        partCalib.DmmPartCalib[idxScale].Calib_Ref_ValN = NAN;
+        partCalib.DmmPartCalib[idxScale].Calib_Ms_ValP  = NAN;
+        partCalib.DmmPartCalib[idxScale].Calib_Ref_ValP = NAN;
+    }
+}
+
+/***	CALIB_WriteAllCalibsToEPROM_Raw
+**
+**	Parameters:
+**      EPROM_CALLBACK pfnDone  - null for a synchronous write, otherwise the words are queued to the background write queue
+**                              and pfnDone is called when they are written (through CALIB_SaveDone)
+**
+**	Return Value:
+**		uint8_t 
+**          ERRVAL_SUCCESS                  0       // success
+**          ERRVAL_EPROM_WRTIMEOUT          0xFF    // EPROM write data ready timeout (synchronous write)
+**
+**	Description:
+**		This function is a system function that writes calibration data to the user calibration area of EPROM.
+**      The payload consists of the bytes for the calibration coefficients for all scales and a signature byte called magic number,
+**      that gives the record format (EPROM_MAGIC_CRC16).
+**      The CRC-16 of the calibration data and of the die temperature is stored in the calibration header, at ADR_EPROM_CALIBHDR 
+**      (see CALIB_GetCalibCrc16): the check byte of CALIBDATA is too small for it and the next words hold the serial number.
+**      The temperature coefficients record (TEMPCOEFFDATA) is written first, if it changed. An interrupted write of this record
+**      only disables the temperature compensation.
+**      Then the save is done in steps (see CALIB_SaveStep), each of them leaving a valid calibration in EPROM, or a calibration 
+**      that CALIB_Init completes from the journal. So a save interrupted by a power loss keeps either the previous
+**      or the new coefficients of the scale being saved.
+**      This function is called by CALIB_WriteAllCalibsToEPROM_User and CALIB_WriteAllCalibsToEPROM_UserAsync.
+**      This function shouldn't be called by user, instead, the user should call CALIB_WriteAllCalibsToEPROM_User. 
+**      The function returns ERRVAL_SUCCESS for success or ERRVAL_EPROM_WRTIMEOUT. 
+**      when calibration data write in EPROM is not properly performed. 
+**            
+*/
+uint8_t CALIB_WriteAllCalibsToEPROM_Raw(EPROM_CALLBACK pfnDone)
+{
+    uint8_t bResult;
+    if(pfnSaveDone)
+    {
+        EPROM_AsyncWaitIdle();  // finish the previous background save
+    }
+    // temperature coefficients
+    EPROM_SealRecord((uint8_t *)&tempCoeff, sizeof(TEMPCOEFFDATA));
+    bResult = CALIB_WriteWords_Raw((uint8_t)ADR_EPROM_TEMPCOEFF, (uint16_t *)&tempCoeff, 0, sizeof(TEMPCOEFFDATA)/2, pfnDone != 0, 0);
+    if(bResult != ERRVAL_SUCCESS)
+    {
+        if(pfnDone)
+        {
+            pfnDone(bResult);
+        }
+        return bResult;
+    }
+    CALIB_SaveStart();
+    if(pfnDone)
+    {
+        pfnSaveDone = pfnDone;
+        CALIB_SaveNext(ERRVAL_SUCCESS);
+        return ERRVAL_SUCCESS;
+    }
+    while(bResult == ERRVAL_SUCCESS && (bSaveMode != CALIB_SAVE_JOURNAL || dwSavePending))
+    {
+        bResult = CALIB_SaveStep(0);
+    }
+    return bResult;
+}
+
+/***	CALIB_SaveStart
+**
+**	Parameters:
+**      none
+**
+**	Return Value:
+**		none
+**
+**	Description:
+**		This function prepares the save of the user calibration: the dirty scales are the scales to be saved, 
+**      and the current content of the user calibration area gives the save mode:
+**      CALIB_SAVE_JOURNAL when it is valid in format 3, CALIB_SAVE_MIGRATE when it is valid in the CRC-8 or the legacy format, 
+**      CALIB_SAVE_FULL when it is not valid (no user calibration was saved, or it could not be recovered).
+**            
+*/
+void CALIB_SaveStart()
+{
+    int idxScale;
+    dwSaveScales = 0;
+    for(idxScale = 0; idxScale < DMM_CNTSCALES; idxScale++)
+    {
+        dwSaveScales |= (uint32_t)partCalib.DmmPartCalib[idxScale].fCalibDirty << idxScale;
+    }
+    dwSavePending = dwSaveScales;
+    if(CALIB_ReadAllCalibsFromEPROM_Raw(&calibSave, &hdrSave, (uint8_t)ADR_EPROM_CALIB) != ERRVAL_SUCCESS)
+    {
+        bSaveMode = CALIB_SAVE_FULL;
+    }
+    else
+    {
+        bSaveMode = (calibSave.magic == EPROM_MAGIC_CRC16) ? CALIB_SAVE_JOURNAL : CALIB_SAVE_MIGRATE;
+    }
+}
+
+/***	CALIB_SaveStep
+**
+**	Parameters:
+**      uint8_t fAsync          - 0 for a synchronous write, 1 to queue the words to the background write queue 
+**                              and call CALIB_SaveNext when they are written
+**
+**	Return Value:
+**		uint8_t 
+**          ERRVAL_SUCCESS                  0       // success
+**          ERRVAL_EPROM_WRTIMEOUT          0xFF    // EPROM write data ready timeout
+**
+**	Description:
+**		This function writes the next step of the save of the user calibration, only the words that changed (CALIB_WriteWords_Raw):
+**      - CALIB_SAVE_FULL: all the calibration data, then the header. There is no valid calibration to keep, 
+**        an interrupted save leaves an invalid record and CALIB_Init falls back to the factory calibration, as before.
+**      - CALIB_SAVE_MIGRATE: the same coefficients in format 3. The header is written first, then the first word: 
+**        the record switches from the old format to format 3 when its magic number is written.
+**      - CALIB_SAVE_JOURNAL: the next dirty scale whose coefficients changed. The journal (CALIBJRNL) is written first, 
+**        with the new coefficients and the header of the record after the save, then the words of the scale and the header.
+**        If the save is interrupted after the journal was written, CALIB_Init finishes it (CALIB_ReplayJournal); before,
+**        the previous record is still valid. No generation counter is needed: replaying the journal is idempotent, 
+**        and the journal is only used when the record fails its check.
+**      The words of a scale are taken from calibSave, the content of EPROM after the previous steps, not from calib:
+**      a word holding bytes of the saved scale and of another dirty scale keeps the previous bytes of the other scale.
+**      When fAsync is 1, CALIB_SaveNext is called once, when the step is written, or with the error.
+**            
+*/
+uint8_t CALIB_SaveStep(uint8_t fAsync)
+{
+    uint8_t rgfCheck[sizeof(CALIBDATA)/2];
+    EPROM_CALLBACK pfnNext = fAsync ? CALIB_SaveNext : 0;
+    CALIBJRNL jrnl;
+    int idxScale = 0;
+    uint8_t bResult;
+
+    if(bSaveMode == CALIB_SAVE_FULL)
+    {
+        calibSave = calib;
+        hdrSave.temp = calibHdr.temp;
+        dwSavePending = 0;
+    }
+    else if(bSaveMode == CALIB_SAVE_JOURNAL)
+    {
+        // next scale that changed
+        for(idxScale = 0; idxScale < DMM_CNTSCALES; idxScale++)
+        {
+            if((dwSavePending >> idxScale) & 1)
+            {
+                dwSavePending &= ~(1ul << idxScale);
+                if(memcmp(&calibSave.Dmm[idxScale], &calib.Dmm[idxScale], sizeof(CALIB)) || hdrSave.temp != calibHdr.temp)
+                {
+                    break;
+                }
+            }
+        }
+        if(idxScale == DMM_CNTSCALES)
+        {
+            if(pfnNext)
+            {
+                pfnNext(ERRVAL_SUCCESS);
+            }
+            return ERRVAL_SUCCESS;
+        }
+        calibSave.Dmm[idxScale] = calib.Dmm[idxScale];
+        hdrSave.temp = calibHdr.temp;
+    }
+    // magic number and CRC
+    calibSave.magic = EPROM_MAGIC_CRC16;
+    calibSave.crc = 0;
+    hdrSave.crc = CALIB_GetCalibCrc16(&calibSave, &hdrSave);
+
+    switch(bSaveMode)
+    {
+        case CALIB_SAVE_FULL:
+            bResult = CALIB_WriteWords_Raw((uint8_t)ADR_EPROM_CALIB, (uint16_t *)&calibSave, 0, sizeof(CALIBDATA)/2, fAsync, 0);
+            break;
+        case CALIB_SAVE_MIGRATE:
+            bResult = CALIB_WriteWords_Raw((uint8_t)ADR_EPROM_CALIBHDR, (uint16_t *)&hdrSave, 0, sizeof(CALIBHDR)/2, fAsync, 0);
+            if(bResult == ERRVAL_SUCCESS)
+            {
+                bResult = CALIB_WriteWords_Raw((uint8_t)ADR_EPROM_CALIB, (uint16_t *)&calibSave, 0, sizeof(CALIBDATA)/2, fAsync, pfnNext);
+            }
+            else if(pfnNext)
+            {
+                pfnNext(bResult);
+            }
+            bSaveMode = CALIB_SAVE_JOURNAL;
+            return bResult;
+        default:
+            jrnl.magic = EPROM_MAGIC_CRC16;
+            jrnl.idxScale = idxScale;
+            jrnl.Dmm = calibSave.Dmm[idxScale];
+            jrnl.temp = hdrSave.temp;
+            jrnl.crcHdr = hdrSave.crc;
+            bResult = CALIB_WriteWords_Raw((uint8_t)ADR_EPROM_CALIBJRNL, (uint16_t *)&jrnl, 0, sizeof(CALIBJRNL)/2, fAsync, 0);
+            if(bResult == ERRVAL_SUCCESS)
+            {
+                CALIB_GetScaleWords(idxScale, rgfCheck);
+                bResult = CALIB_WriteWords_Raw((uint8_t)ADR_EPROM_CALIB, (uint16_t *)&calibSave, rgfCheck, sizeof(CALIBDATA)/2, fAsync, 0);
+            }
+            break;
+    }
+    bSaveMode = CALIB_SAVE_JOURNAL;
+    // the header commits the step
+    if(bResult == ERRVAL_SUCCESS)
+    {
+        bResult = CALIB_WriteWords_Raw((uint8_t)ADR_EPROM_CALIBHDR, (uint16_t *)&hdrSave, 0, sizeof(CALIBHDR)/2, fAsync, pfnNext);
+    }
+    else if(pfnNext)
+    {
+        pfnNext(bResult);
+    }
+    return bResult;
+}
+
+/***	CALIB_SaveNext
+**
+**	Parameters:
+**      uint8_t bResult     - the write result of the previous step: ERRVAL_SUCCESS or ERRVAL_EPROM_WRTIMEOUT
+**
+**	Return Value:
+**		none
+**
+**	Description:
+**		This function is the EPROM callback of the save steps of a background save. 
+**      It queues the next step (CALIB_SaveStep), which calls it again when written. When no step is left, 
+**      or a step failed, the save is finished by CALIB_SaveDone. 
+**      A step is at most 111 words (CALIB_SAVE_FULL), 14 words for a scale, so the steps fit in the EPROM write queue.
+**            
+*/
+void CALIB_SaveNext(uint8_t bResult)
+{
+    if(bResult == ERRVAL_SUCCESS && (bSaveMode != CALIB_SAVE_JOURNAL || dwSavePending))
+    {
+        CALIB_SaveStep(1);
+        return;
+    }
+    CALIB_SaveDone(bResult);
+}
+
+/***	CALIB_ReplayJournal
+**
+**	Parameters:
+**      none
+**
+**	Return Value:
+**		uint8_t 
+**          ERRVAL_SUCCESS                  0       // success, the interrupted save is finished
+**          ERRVAL_EPROM_CRC                0xFE    // the journal does not match the calibration data
+**
+**	Description:
+**		This function finishes a save interrupted after its journal was written (see CALIB_SaveStep). 
+**      The calibration data (calib) was read from EPROM and failed its check. The coefficients of the journal are copied 
+**      to their scale, and the temperature to the header: if the CRC-16 of the result is the one of the journal, 
+**      the calibration data is valid again, and the words of the scale and the header are written to EPROM.
+**      Otherwise, the calibration data was damaged outside the saved scale and the function returns ERRVAL_EPROM_CRC.
+**      The write result is not returned: the calibration data is valid, a failed write is retried at the next startup.
+**            
+*/
+uint8_t CALIB_ReplayJournal()
+{
+    uint8_t rgfCheck[sizeof(CALIBDATA)/2];
+    CALIBJRNL jrnl;
+    EPROM_ReadWords((uint8_t)ADR_EPROM_CALIBJRNL, (uint16_t *)&jrnl, sizeof(CALIBJRNL)/2);
+    if(jrnl.magic != EPROM_MAGIC_CRC16 || jrnl.idxScale < 0 || jrnl.idxScale >= DMM_CNTSCALES)
+    {
+        return ERRVAL_EPROM_CRC;
+    }
+    calib.Dmm[jrnl.idxScale] = jrnl.Dmm;
+    calibHdr.temp = jrnl.temp;
+    calibHdr.crc = jrnl.crcHdr;
+    if(CALIB_GetCalibCrc16(&calib, &calibHdr) != jrnl.crcHdr)
+    {
+        return ERRVAL_EPROM_CRC;
+    }
+    CALIB_GetScaleWords(jrnl.idxScale, rgfCheck);
+    if(CALIB_WriteWords_Raw((uint8_t)ADR_EPROM_CALIB, (uint16_t *)&calib, rgfCheck, sizeof(CALIBDATA)/2, 0, 0) == ERRVAL_SUCCESS)
+    {
+        CALIB_WriteWords_Raw((uint8_t)ADR_EPROM_CALIBHDR, (uint16_t *)&calibHdr, 0, sizeof(CALIBHDR)/2, 0, 0);
+    }
+    return ERRVAL_SUCCESS;
+}
+
+/***	CALIB_GetScaleWords
+**
+**	Parameters:
+**      int idxScale        - the Scale index
+**      uint8_t *rgfCheck   - array of sizeof(CALIBDATA)/2 flags, set to 1 for the words of the scale and to 0 for the other words
+**
+**	Return Value:
+**		none
+**
+**	Description:
+**		This function selects the words of CALIBDATA holding the calibration coefficients of a scale.
+**      The calibration coefficients are not word aligned in the packed CALIBDATA structure, so a word can hold bytes of two scales.
+**            
+*/
+void CALIB_GetScaleWords(int idxScale, uint8_t *rgfCheck)
+{
+    int idxFirstByte = (uint8_t *)&calib.Dmm[idxScale] - (uint8_t *)&calib;
+    int idxWord;
+    for(idxWord = 0; idxWord < (int)sizeof(CALIBDATA)/2; idxWord++)
+    {
+        rgfCheck[idxWord] = (idxWord >= idxFirstByte / 2 && idxWord <= (idxFirstByte + (int)sizeof(CALIB) - 1) / 2);
+    }
+}
+
+/***	CALIB_GetCalibCrc16
+**
+**	Parameters:
+**      CALIBDATA *pCalib   - the calibration data, in format 3 (EPROM_MAGIC_CRC16)
+**      CALIBHDR *pHdr      - the calibration header
+**
+**	Return Value:
+**		uint16_t            - the CRC-16 of the calibration
+**
+**	Description:
+**		This function computes the CRC-16 stored in the header of a calibration in format 3: 
+**      the CRC of the die temperature of the header, followed by the bytes of the calibration data before its check byte.
+**            
+*/
+uint16_t CALIB_GetCalibCrc16(CALIBDATA *pCalib, CALIBHDR *pHdr)
+{
+    uint16_t wCrc = GetBufferCrc16(CRC16_INIT, (uint8_t *)&pHdr->temp, sizeof(pHdr->temp));
+    return GetBufferCrc16(wCrc, (uint8_t *)pCalib, sizeof(CALIBDATA) - 1);
+}
+
+/***	CALIB_WriteWords_Raw
+**
+**	Parameters:
+**      uint8_t bAddress		- the address where the words will be written in EPROM
+**      uint16_t *pwNew         - the words to be written
+**      uint8_t *rgfCheck       - 1 for the words to be compared with the EPROM content, the others are skipped; null to compare all the words
+**      int cwVals              - number of words
+**      uint8_t fAsync          - 0 for a synchronous write, 1 to queue the words to the background write queue
+**      EPROM_CALLBACK pfnDone  - called when the words are written, can be null
+**
+**	Return Value:
+**		uint8_t 
+**          ERRVAL_SUCCESS                  0       // success
+**          ERRVAL_EPROM_WRTIMEOUT          0xFF    // EPROM write data ready timeout
+**
+**	Description:
+**		This function writes the words that differ from the EPROM content, read from the RAM image of the EPROM module.
+**      Consecutive changed words are written (or queued) with one EPROM_WriteWords_Raw (EPROM_WriteWordsAsync_Raw) call, 
+**      pfnDone is passed with the last run of words. If no word changed, or a write failed, pfnDone is called before returning:
+**      it is always called once.
+**      The words are written in increasing address order.
+**            
+*/
+uint8_t CALIB_WriteWords_Raw(uint8_t bAddress, uint16_t *pwNew, uint8_t *rgfCheck, int cwVals, uint8_t fAsync, EPROM_CALLBACK pfnDone)
+{
+    uint8_t bResult = ERRVAL_SUCCESS;
+    uint8_t rgfWrite[sizeof(CALIBDATA)/2];
+    uint16_t rgwOld[sizeof(CALIBDATA)/2];
+    int idxWord, idxFirst, idxLast = -1;
+    uint8_t fEnabled = 0;
+
+    // current content of EPROM
+    EPROM_ReadWords(bAddress, rgwOld, cwVals);
+
+    // keep only the changed words
+    for(idxWord = 0; idxWord < cwVals; idxWord++)
+    {
+        rgfWrite[idxWord] = (!rgfCheck || rgfCheck[idxWord]) && (pwNew[idxWord] != rgwOld[idxWord]);
+        idxLast = rgfWrite[idxWord] ? idxWord : idxLast;
+    }
+    if(idxLast < 0 && pfnDone)
+    {
+        pfnDone(ERRVAL_SUCCESS);
+    }
+
+    // write the runs of changed words
+    for(idxWord = 0; idxWord <= idxLast && bResult == ERRVAL_SUCCESS; )
+    {
+        if(!rgfWrite[idxWord])
+        {
+            idxWord++;
+            continue;
+        }
+        idxFirst = idxWord;
+        while(idxWord <= idxLast && rgfWrite[idxWord])
+        {
+            idxWord++;
+        }
+        if(fAsync)
+        {
+            bResult = EPROM_WriteWordsAsync_Raw(bAddress + idxFirst, pwNew + idxFirst, idxWord - idxFirst, (idxWord > idxLast) ? pfnDone : 0);
+        }
+        else
+        {
+            if(!fEnabled)
+            {
+                EPROM_WriteEnable();
+                fEnabled = 1;
+            }
+            bResult = EPROM_WriteWords_Raw(bAddress + idxFirst, pwNew + idxFirst, idxWord - idxFirst);
+        }
+    }
+    if(fEnabled)
+    {
+        EPROM_WriteDisable();
+    }
+    if(idxLast >= 0 && pfnDone && (!fAsync || idxWord <= idxLast))
+    {
+        // synchronous write, or a run before the last one failed
+        pfnDone(bResult);
+    }
+    return bResult;
+}
+
+/***	CALIB_ReadAllCalibsFromEPROM_Raw
+**
+**	Parameters:
+**      CALIBDATA *pCalib   - pointer to CALIB structure where data will be read from EPROM
+**      CALIBHDR *pHdr      - pointer to the calibration header, read from EPROM for a calibration in format 3
+**      uint8_t baseAddr	- the EPROM address from where the calibration data read
+**                  This will distinguish between user and factory calibration areas
+**      
+**
+**	Return Value:
+**		uint8_t 
 **          ERRVAL_SUCCESS                  0       // success
 **          ERRVAL_EPROM_MAGICNO            0xFD    // wrong Magic No. when reading data from EPROM
 **          ERRVAL_EPROM_CRC                0xFE    // wrong CRC when reading data from EPROM
@@ -936,35 +1833,27 @@ uint8_t CALIB_WriteAllCalibsToEPROM_Raw(uint8_t baseAddr)
 **      The function returns ERRVAL_SUCCESS for success. 
 **      The function returns ERRVAL_EPROM_MAGICNO when a wrong magic number was detected in the data read from EPROM. 
 **      The function returns ERRVAL_EPROM_CRC when the checksum is wrong for the data read from EPROM. 
+**      The calibration in format 3 (EPROM_MAGIC_CRC16), only written in the user calibration area, is checked with the CRC-16 
+**      of its header (see CALIB_GetCalibCrc16). The CRC-8 and the legacy additive checksum formats are accepted too (see EPROM_CheckRecord),
+**      their die temperature is unknown (CALIB_TEMP_NONE).
 **            
 */
-uint8_t CALIB_ReadAllCalibsFromEPROM_Raw(CALIBDATA *pCalib, uint8_t baseAddr)
+uint8_t CALIB_ReadAllCalibsFromEPROM_Raw(CALIBDATA *pCalib, CALIBHDR *pHdr, uint8_t baseAddr)
 {
-    uint8_t bCrc, bCrcRead;
- 
     // read calibration structure
     EPROM_ReadWords(baseAddr, (uint16_t *)pCalib, sizeof(CALIBDATA)/2);
-    
-
-    // check CRC
-    bCrcRead = pCalib->crc;
-    pCalib->crc = 0;
-
-    bCrc = GetBufferChecksum((uint8_t *)pCalib, sizeof(CALIBDATA));     
-    
-    pCalib->crc = bCrcRead;
-    
-    if(pCalib->magic != EPROM_MAGIC_NO)
+    pHdr->temp = CALIB_TEMP_NONE;
+    if(pCalib->magic != EPROM_MAGIC_CRC16)
     {
-        // missing magic number
-        return ERRVAL_EPROM_MAGICNO;
+        // check magic number and CRC
+        return EPROM_CheckRecord((uint8_t *)pCalib, sizeof(CALIBDATA));
     }
-    if(pCalib->crc != bCrc)
+    if(baseAddr != (uint8_t)ADR_EPROM_CALIB)
     {
-        // CRC error
-        return ERRVAL_EPROM_CRC;
+        return ERRVAL_EPROM_MAGICNO;
     }
-    return 0;
+    EPROM_ReadWords((uint8_t)ADR_EPROM_CALIBHDR, (uint16_t *)pHdr, sizeof(CALIBHDR)/2);
+    return (CALIB_GetCalibCrc16(pCalib, pHdr) == pHdr->crc) ? ERRVAL_SUCCESS : ERRVAL_EPROM_CRC;
 }
 
 /***	CALIB_VerifyEPROM_Raw
@@ -985,6 +1874,7 @@ uint8_t CALIB_ReadAllCalibsFromEPROM_Raw(CALIBDATA *pCalib, uint8_t baseAddr)
 **	Description:
 **		This function is a system function that compares the calibration data from a specific location in EPROM 
 **      with calibration data provided by the pCalib pointer. 
+**      The EPROM data is read from the RAM image of the EPROM module, use EPROM_RevalidateImage to check the image against the EPROM.
 **      This function is called by CALIB_VerifyEPROM which provide proper address in EPROM for user calibration area.
 **      This function shouldn't be called by user, instead, the user should call CALIB_VerifyEPROM. 
 **      The function returns ERRVAL_SUCCESS for success, the calibration data from EPROM is identical to the calibration 
@@ -999,10 +1889,11 @@ uint8_t CALIB_VerifyEPROM_Raw(CALIBDATA *pCalib, uint8_t baseAddr)
 {
     uint8_t bResult = ERRVAL_SUCCESS;
     CALIBDATA calib1;
+    CALIBHDR hdr1;
     int i;
     
     // 1. Read data from eprom to calib1
-    bResult = CALIB_ReadAllCalibsFromEPROM_Raw(&calib1, baseAddr);
+    bResult = CALIB_ReadAllCalibsFromEPROM_Raw(&calib1, &hdr1, baseAddr);
     
     // 2. Compare data from *pCalib with data from calib1    
     if(bResult == ERRVAL_SUCCESS)
@@ -1050,11 +1941,12 @@ uint8_t CALIB_ExportCalibs_Raw(char *pSzCalibs, uint8_t baseAddr)
 {
     uint8_t bResult = 0;
     CALIBDATA calib1;
+    CALIBHDR hdr1;
     int i;
     char szLine[30];
     pSzCalibs[0] = 0;
     // 1. Read data from eprom to calib1
-    bResult = CALIB_ReadAllCalibsFromEPROM_Raw(&calib1, baseAddr);
+    bResult = CALIB_ReadAllCalibsFromEPROM_Raw(&calib1, &hdr1, baseAddr);
     
     
     //2. Build the export string
@@ -1106,6 +1998,8 @@ uint8_t CALIB_ERR_CheckDoubleVal(double dVal)
 **      CALIB_CalibOnPositive (or CALIB_MeasureForCalibPositiveVal) and CALIB_CalibOnNegative (or CALIB_MeasureForCalibNegativeVal).
 **      If the calibration is found to be complete, the calibration coefficients are computed using CALIB_ComputeMult and CALIB_ComputeAdd functions, 
 **      and the scale index is marked as dirty, meaning that calibrations should be written to EPROM user space. 
+**      The current die temperature (XADC_GetTemp) is recorded as the calibration temperature (see CALIB_UpdateCalibTemp),
+**      unless other scales were calibrated at a different temperature: the calibration temperature is shared by all the scales.
 **      In this moment the calibration is considered finalized, and will be applied to the measured values.
 **                
 */
@@ -1135,14 +2029,59 @@ uint8_t CALIB_CheckCompleteCalib()
         {
             calib.Dmm[idxScale].Mult = CALIB_ComputeMult(idxScale);            
             calib.Dmm[idxScale].Add = CALIB_ComputeAdd(idxScale);
-            partCalib.DmmPartCalib[idxScale].fCalibDirty = 1;   // needs to be written to EPROM
+            CALIB_SetCalibDirty(idxScale);      // needs to be written to EPROM
             // fill information text
             sprintf(ERRORS_GetszLastError(), "Coeff: %.6f, %.6f", calib.Dmm[idxScale].Mult, calib.Dmm[idxScale].Add);            
+            if(!CALIB_UpdateCalibTemp(idxScale))
+            {
+                sprintf(ERRORS_GetszLastError() + strlen(ERRORS_GetszLastError()), 
+                        ", calibration temperature of the other scales kept: %.2f C", CALIB_GetCalibTemp());
+            }
+            DMM_UpdateCorrection();
         }
     }
     return fResult;
 }
 
+/***	CALIB_UpdateCalibTemp
+**
+**	Parameters:
+**      int idxScale    - the index of the scale whose calibration was finalized
+**
+**	Return Value:
+**		0               - the calibration temperature was kept, other scales were calibrated at a different temperature
+**      1               - the scale is calibrated at the calibration temperature
+**
+**	Description:
+**		This function records the current die temperature (XADC_GetTemp) as the calibration temperature, when a calibration is finalized.
+**      There is only one calibration temperature for all the scales, so it is not changed when other scales were calibrated 
+**      at a temperature differing by more than CALIB_TEMP_TOL: the calibration of the scale is then compensated relative 
+**      to the temperature of the other scales, and the function returns 0.
+**      The scales calibrated at the calibration temperature are tracked from the last change of the calibration temperature.
+**      When it was read from EPROM, they are not known and all the scales are considered calibrated at this temperature.
+**      This function is called by CALIB_CheckCompleteCalib.
+**                
+*/
+uint8_t CALIB_UpdateCalibTemp(int idxScale)
+{
+    double dTemp = XADC_GetTemp();
+    int16_t temp = isnan(dTemp) ? CALIB_TEMP_NONE: (int16_t)round(dTemp * 100);
+    if(calibHdr.temp != CALIB_TEMP_NONE && temp != CALIB_TEMP_NONE && abs(temp - calibHdr.temp) <= CALIB_TEMP_TOL)
+    {
+        // same temperature
+        dwCalibTempScales |= 1ul << idxScale;
+        return 1;
+    }
+    if(calibHdr.temp != CALIB_TEMP_NONE && (dwCalibTempScales & ~(1ul << idxScale)))
+    {
+        // other scales were calibrated at the calibration temperature
+        return 0;
+    }
+    calibHdr.temp = temp;
+    dwCalibTempScales = (temp == CALIB_TEMP_NONE) ? 0: 1ul << idxScale;
+    return 1;
+}
+
 /***	CALIB_CntCalibDirty()
 **
 **	Parameters:
@@ -1168,6 +2107,85 @@ uint8_t CALIB_CntCalibDirty()
     return bResult;
 }
 
+/***	CALIB_SetAllCalibDirty()
+**
+**	Parameters:
+**      none
+**
+**	Return Value:
+**		none
+**
+**	Description:
+**		This function marks all the scale indexes as dirty.  
+**      It is called when the whole calibration data is replaced, so that the next save to EPROM checks all the scales.
+**                    
+*/
+void CALIB_SetAllCalibDirty()
+{
+    int idxScale;
+    for(idxScale = 0; idxScale < DMM_CNTSCALES; idxScale++)
+    {
+        CALIB_SetCalibDirty(idxScale);
+    }
+}
+
+/***	CALIB_SetCalibDirty()
+**
+**	Parameters:
+**      int idxScale    - the Scale index
+**
+**	Return Value:
+**		none
+**
+**	Description:
+**		This function marks the scale index as dirty (needs to be written in EPROM).  
+**      If a background save is in progress, the scale is removed from the saved scales: 
+**      its new coefficients may not be written by this save, so its dirty flag is kept when the save completes.
+**                    
+*/
+void CALIB_SetCalibDirty(int idxScale)
+{
+    partCalib.DmmPartCalib[idxScale].fCalibDirty = 1;
+    dwSaveScales &= ~(1ul << idxScale);
+}
+
+/***	CALIB_SaveDone()
+**
+**	Parameters:
+**      uint8_t bResult     - the write result: ERRVAL_SUCCESS or ERRVAL_EPROM_WRTIMEOUT
+**
+**	Return Value:
+**		none
+**
+**	Description:
+**		This function is the EPROM callback of the background save started by CALIB_WriteAllCalibsToEPROM_UserAsync.  
+**      When the calibration data is written, the dirty flags of the saved scales are cleared. 
+**      On a write timeout they are kept, so that the next save writes these scales again.
+**      Then the callback provided to CALIB_WriteAllCalibsToEPROM_UserAsync is called with the write result.
+**                    
+*/
+void CALIB_SaveDone(uint8_t bResult)
+{
+    EPROM_CALLBACK pfnDone = pfnSaveDone;
+    int idxScale;
+    if(bResult == ERRVAL_SUCCESS)
+    {
+        for(idxScale = 0; idxScale < DMM_CNTSCALES; idxScale++)
+        {
+            if((dwSaveScales >> idxScale) & 1)
+            {
+                partCalib.DmmPartCalib[idxScale].fCalibDirty = 0;
+            }
+        }
+    }
+    dwSaveScales = 0;
+    pfnSaveDone = 0;
+    if(pfnDone)
+    {
+        pfnDone(bResult);
+    }
+}
+
 /* *****************************************************************************
  End of File
  */
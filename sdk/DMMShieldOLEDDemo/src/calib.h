@@ -20,15 +20,27 @@
 #ifndef _CALIB_H    /* Guard against multiple inclusion */
 #define _CALIB_H
 
+#include "eprom.h"
+
 /* ************************************************************************** */
 /* ************************************************************************** */
 /* Section: Constants                                                         */
 /* ************************************************************************** */
-#define MEASURE_CNT_AVG 20  // the number of values to be used when measuring for calibration
+#define MEASURE_CNT_AVG 20  // the maximum number of values to be used when measuring for calibration
+#define MEASURE_CNT_MIN 5   // the minimum number of values before the measurement for calibration can end early
+#define CALIB_CI_TARGET 0.1 // the measurement ends when the 95% confidence interval half width is below this fraction of the accepted dispersion
+#define CALIB_DRIFT_MAX 0.5 // the measurement fails when the reference drifts more than this fraction of the accepted dispersion
+#define CALIB_NOISE_MAX 0.5 // the measurement fails when the noise keeps the confidence interval half width above this fraction of the accepted dispersion
+#define CALIB_TEMP_TOL  100 // maximum difference (1/100 Celsius) between the die temperature of a calibration and the calibration temperature of the other scales
 //#define CALIB_RES_ZERO_REFVAL 0
 // 50 mOhm
 #define CALIB_RES_ZERO_REFVAL 0.05
 
+// measurement types for CALIB_MeasureForCalibStart
+#define CALIB_MEASURE_ZERO      0
+#define CALIB_MEASURE_POSITIVE  1
+#define CALIB_MEASURE_NEGATIVE  2
+
 // *****************************************************************************
 // *****************************************************************************
 // Section: Interface Functions
@@ -40,6 +52,7 @@ uint8_t CALIB_Init();
 // EPROM functions
 uint8_t CALIB_RestoreAllCalibsFromEPROM_Factory();
 uint8_t CALIB_WriteAllCalibsToEPROM_User();
+uint8_t CALIB_WriteAllCalibsToEPROM_UserAsync(EPROM_CALLBACK pfnDone);
 uint8_t CALIB_ReadAllCalibsFromEPROM_User();
 uint8_t CALIB_ReadAllCalibsFromEPROM_Factory();
 
@@ -48,8 +61,19 @@ uint8_t CALIB_ExportCalibs_User(char *pSzCalibs);
 uint8_t CALIB_ExportCalibs_Factory(char *pSzCalibs);
 uint8_t CALIB_ImportCalibCoefficients(int idxScale, float fMult, float fAdd);
 
+// temperature compensation
+double CALIB_GetCalibTemp();
+uint8_t CALIB_SetTempCoeff(int idxScale, float fPpm);
+float CALIB_GetTempCoeff(int idxScale);
+double CALIB_GetTempFactor(int idxScale);
+
 // Calibration procedure functions
 uint8_t CALIB_CalibOnZero(double *pMeasuredVal, double *pDispersion, uint8_t fIgnoreDispersion);
+uint8_t CALIB_FinalizeCalibOnZero(double *pMeasuredVal, double *pDispersion, uint8_t fIgnoreDispersion);
+
+// resumable measurement for calibration
+uint8_t CALIB_MeasureForCalibStart(uint8_t bType);
+uint8_t CALIB_MeasureForCalibStep(double *pMeasuredVal);
 
 uint8_t CALIB_MeasureForCalibPositiveVal(double *pMeasuredVal);
 uint8_t CALIB_CalibOnPositive(double dRefVal, double *pMeasuredVal, uint8_t bEarlyMeasurement, double *pDispersion, uint8_t fIgnoreDispersion);
@@ -0,0 +1,604 @@
+/* ************************************************************************** */
+/** Descriptive File Name
+
+  @Company
+    Digilent
+
+  @File Name
+    calseq.c
+
+  @Description
+        This file groups the functions that implement the CALSEQ module, the calibration sequencer.
+        The calibration plan is a list of steps: a scale, a measurement type (zero, positive, negative) and a reference value.
+        When the sequence is started, the steps are ordered so that the steps using the same reference source
+        (the same scale mode, measurement type and reference value) are performed together, and the scale
+        used at the end of a source is used first with the next source, when possible.
+        The operator is prompted only when the reference source must be changed.
+        Each step configures the scale (only when it is not the current scale), performs the measurement for calibration
+        (CALIB_MeasureForCalibStart / CALIB_MeasureForCalibStep) and finalizes the calibration on zero, positive or negative value.
+        The steps are resumable, like DMM_SetScaleStep, and their duration is recorded.
+        The calibrations are saved in EPROM by the caller, once, at the end of the sequence.
+
+ */
+/* ************************************************************************** */
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Included Files                                                    */
+/* ************************************************************************** */
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include "stdint.h"
+#include "dmm.h"
+#include "calib.h"
+#include "errors.h"
+#include "timer.h"
+#include "calseq.h"
+
+// step phases
+#define CALSEQ_PHASE_CONFIG         0   // configure the scale, if needed
+#define CALSEQ_PHASE_CONFIGWAIT     1   // scale configuration in progress
+#define CALSEQ_PHASE_MEASURE        2   // start the measurement for calibration
+#define CALSEQ_PHASE_MEASUREWAIT    3   // measurement for calibration in progress
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+// Section: Local functions prototypes                                        */
+/* ************************************************************************** */
+/* ************************************************************************** */
+uint8_t DMM_FDCScale(int idxScale);
+uint8_t DMM_ERR_CheckIdxCalib(int idxScale);
+
+int CALSEQ_CompareSource(const CALSEQ_STEP *pStep1, const CALSEQ_STEP *pStep2);
+int CALSEQ_CompareStep(const CALSEQ_STEP *pStep1, const CALSEQ_STEP *pStep2);
+void CALSEQ_SortSteps();
+uint8_t CALSEQ_FinalizeStep(CALSEQ_STEP *pStep);
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Global Variables                                                  */
+/* ************************************************************************** */
+/* ************************************************************************** */
+static CALSEQ_STEP rgSteps[CALSEQ_MAXSTEPS];   // the calibration plan, ordered by CALSEQ_Start
+static int cSteps = 0;                          // number of steps of the plan
+static int idxStep = 0;                         // the next step to be performed
+static uint8_t bState = CALSEQ_STATE_IDLE;
+static uint8_t bPhase = CALSEQ_PHASE_CONFIG;
+static uint32_t dwStepStartMs, dwSeqStartMs;
+static CALSEQ_SUMMARY summary;
+
+// names of the scale modes, used in the prompts
+static const char *rgszModes[] = {"", "resistance", "continuity", "diode", "DC voltage", "AC voltage",
+                                  "DC current", "AC current", "DC low current", "AC low current"};
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+// Section: Interface Functions                                               */
+/* ************************************************************************** */
+/* ************************************************************************** */
+
+/***	CALSEQ_Clear
+**
+**	Parameters:
+**		none
+**
+**	Return Value:
+**		none
+**
+**	Description:
+**		This function removes all the steps of the calibration plan and stops the sequence waiting for a reference source.
+**      It must not be called while a step is performed (CALSEQ_STATE_RUNNING).
+**
+*/
+void CALSEQ_Clear()
+{
+    cSteps = 0;
+    bState = CALSEQ_STATE_IDLE;
+}
+
+/***	CALSEQ_AddStep
+**
+**	Parameters:
+**		int idxScale        - the scale index
+**		uint8_t bType       - the measurement type: CALIB_MEASURE_ZERO, CALIB_MEASURE_POSITIVE or CALIB_MEASURE_NEGATIVE
+**		double dRefVal      - the reference value, in the base unit, ignored for CALIB_MEASURE_ZERO
+**		const char *szRef   - the reference value text, used in the prompts, ignored for CALIB_MEASURE_ZERO
+**
+**	Return Value:
+**		uint8_t
+**          ERRVAL_SUCCESS                  0       // success
+**          ERRVAL_DMM_IDXCONFIG            0xFC    // wrong scale index
+**          ERRVAL_CMD_WRONGPARAMS          0xF9    // wrong measurement type, or negative calibration for a scale that is not DC
+**          ERRVAL_CALSEQ_STATE             0xE8    // the sequence is in progress
+**
+**	Description:
+**		This function adds a step to the calibration plan. If the plan already has a step with the same scale and
+**      measurement type, its reference value is replaced. The steps are performed in the order computed by CALSEQ_Start.
+**      The plan can only be changed when the sequence is not in progress (CALSEQ_STATE_IDLE).
+**
+*/
+uint8_t CALSEQ_AddStep(int idxScale, uint8_t bType, double dRefVal, const char *szRef)
+{
+    uint8_t bResult = DMM_ERR_CheckIdxCalib(idxScale);
+    CALSEQ_STEP *pStep;
+    int i;
+    if(bResult != ERRVAL_SUCCESS)
+    {
+        return bResult;
+    }
+    if(bState != CALSEQ_STATE_IDLE)
+    {
+        return ERRVAL_CALSEQ_STATE;
+    }
+    if(bType > CALIB_MEASURE_NEGATIVE || (bType == CALIB_MEASURE_NEGATIVE && !DMM_FDCScale(idxScale)))
+    {
+        return ERRVAL_CMD_WRONGPARAMS;
+    }
+    pStep = &rgSteps[cSteps];
+    for(i = 0; i < cSteps; i++)
+    {
+        if(rgSteps[i].idxScale == idxScale && rgSteps[i].bType == bType)
+        {
+            pStep = &rgSteps[i];
+        }
+    }
+    if(pStep == &rgSteps[cSteps])
+    {
+        // there are at most CALSEQ_MAXSTEPS different scale and type pairs
+        cSteps++;
+    }
+    memset(pStep, 0, sizeof(CALSEQ_STEP));
+    pStep->idxScale = idxScale;
+    pStep->bType = bType;
+    if(bType == CALIB_MEASURE_ZERO)
+    {
+        strcpy(pStep->szRef, "zero");
+    }
+    else
+    {
+        pStep->dRefVal = dRefVal;
+        strncpy(pStep->szRef, szRef, CALSEQ_CCHREF - 1);
+    }
+    return ERRVAL_SUCCESS;
+}
+
+/***	CALSEQ_GetCntSteps
+**
+**	Parameters:
+**		none
+**
+**	Return Value:
+**		int     - the number of steps of the calibration plan
+**
+**	Description:
+**		This function returns the number of steps of the calibration plan.
+**
+*/
+int CALSEQ_GetCntSteps()
+{
+    return cSteps;
+}
+
+/***	CALSEQ_Start
+**
+**	Parameters:
+**		none
+**
+**	Return Value:
+**		uint8_t
+**          ERRVAL_SUCCESS                  0       // success
+**          ERRVAL_CALSEQ_STATE             0xE8    // a step is performed
+**          ERRVAL_CALSEQ_EMPTY             0xE7    // the calibration plan has no steps
+**
+**	Description:
+**		This function starts the calibration sequence. The steps are ordered by reference source (CALSEQ_SortSteps),
+**      and the results of a previous sequence are cleared.
+**      The sequence waits for the first reference source (CALSEQ_STATE_WAITSOURCE): the caller prompts the operator
+**      using CALSEQ_GetPrompt, and calls CALSEQ_Continue when the source is connected.
+**
+*/
+uint8_t CALSEQ_Start()
+{
+    int i;
+    if(bState == CALSEQ_STATE_RUNNING)
+    {
+        return ERRVAL_CALSEQ_STATE;
+    }
+    if(!cSteps)
+    {
+        return ERRVAL_CALSEQ_EMPTY;
+    }
+    CALSEQ_SortSteps();
+    for(i = 0; i < cSteps; i++)
+    {
+        rgSteps[i].bResult = ERRVAL_SUCCESS;
+        rgSteps[i].dMeasuredVal = NAN;
+        rgSteps[i].dDispersion = NAN;
+        rgSteps[i].dwMs = 0;
+    }
+    memset(&summary, 0, sizeof(summary));
+    summary.cSources = 1;
+    idxStep = 0;
+    dwSeqStartMs = TIMER_GetMs();
+    bState = CALSEQ_STATE_WAITSOURCE;
+    return ERRVAL_SUCCESS;
+}
+
+/***	CALSEQ_Continue
+**
+**	Parameters:
+**		none
+**
+**	Return Value:
+**		uint8_t
+**          ERRVAL_SUCCESS                  0       // success
+**          ERRVAL_CALSEQ_STATE             0xE8    // the sequence is not waiting for a reference source
+**
+**	Description:
+**		This function is called when the operator connected the reference source requested by the prompt.
+**      The steps using this source are then performed by CALSEQ_Step calls.
+**
+*/
+uint8_t CALSEQ_Continue()
+{
+    if(bState != CALSEQ_STATE_WAITSOURCE)
+    {
+        return ERRVAL_CALSEQ_STATE;
+    }
+    bState = CALSEQ_STATE_RUNNING;
+    bPhase = CALSEQ_PHASE_CONFIG;
+    return ERRVAL_SUCCESS;
+}
+
+/***	CALSEQ_Abort
+**
+**	Parameters:
+**		none
+**
+**	Return Value:
+**		none
+**
+**	Description:
+**		This function stops the calibration sequence. The calibrations of the performed steps are kept.
+**      The plan is kept, so the sequence can be started again.
+**
+*/
+void CALSEQ_Abort()
+{
+    if(bState == CALSEQ_STATE_RUNNING && bPhase == CALSEQ_PHASE_MEASUREWAIT)
+    {
+        // the measurement for calibration disabled the calibration correction
+        DMM_SetUseCalib(1);
+    }
+    bState = CALSEQ_STATE_IDLE;
+}
+
+/***	CALSEQ_Step
+**
+**	Parameters:
+**      unsigned int *pt10usWait     - pointer to receive the time (in 10 us units) to wait before the next call
+**
+**	Return Value:
+**		uint8_t
+**          ERRVAL_DMM_PENDING              0xEC    // the step is not finished, call again after the wait time
+**          ERRVAL_CALSEQ_STATE             0xE8    // the sequence is not running
+**          otherwise the result of the finished step: ERRVAL_SUCCESS or the error of the scale configuration,
+**          measurement or calibration
+**
+**	Description:
+**		This function performs one operation of the current step: the scale configuration (only when the scale
+**      is not the current one), the measurement for calibration and the calibration on zero, positive or negative value.
+**      When the step is finished, its result, measured value, dispersion and duration are recorded
+**      (see CALSEQ_GetLastStep), and the sequence state is updated:
+**      CALSEQ_STATE_RUNNING if the next step uses the same reference source, CALSEQ_STATE_WAITSOURCE if the next step
+**      needs another source and CALSEQ_STATE_IDLE after the last step.
+**      A failed step does not stop the sequence.
+**
+*/
+uint8_t CALSEQ_Step(unsigned int *pt10usWait)
+{
+    CALSEQ_STEP *pStep = &rgSteps[idxStep];
+    uint8_t bResult;
+    *pt10usWait = 0;
+    if(bState != CALSEQ_STATE_RUNNING)
+    {
+        return ERRVAL_CALSEQ_STATE;
+    }
+    switch(bPhase)
+    {
+        case CALSEQ_PHASE_CONFIG:
+            dwStepStartMs = TIMER_GetMs();
+            bResult = ERRVAL_SUCCESS;
+            if(DMM_GetCurrentScale() != pStep->idxScale)
+            {
+                bResult = DMM_SetScaleStart(pStep->idxScale);
+                if(bResult == ERRVAL_SUCCESS)
+                {
+                    summary.cScaleSwitches++;
+                    bPhase = CALSEQ_PHASE_CONFIGWAIT;
+                    return ERRVAL_DMM_PENDING;
+                }
+                break;
+            }
+            bPhase = CALSEQ_PHASE_MEASURE;
+            return ERRVAL_DMM_PENDING;
+        case CALSEQ_PHASE_CONFIGWAIT:
+            bResult = DMM_SetScaleStep(pt10usWait);
+            if(bResult != ERRVAL_SUCCESS)
+            {
+                break;
+            }
+            bPhase = CALSEQ_PHASE_MEASURE;
+            return ERRVAL_DMM_PENDING;
+        case CALSEQ_PHASE_MEASURE:
+            bResult = CALIB_MeasureForCalibStart(pStep->bType);
+            if(bResult != ERRVAL_SUCCESS)
+            {
+                break;
+            }
+            bPhase = CALSEQ_PHASE_MEASUREWAIT;
+            return ERRVAL_DMM_PENDING;
+        default:
+            bResult = CALIB_MeasureForCalibStep(&pStep->dMeasuredVal);
+            if(bResult == ERRVAL_SUCCESS)
+            {
+                bResult = CALSEQ_FinalizeStep(pStep);
+            }
+            break;
+    }
+    if(bResult == ERRVAL_DMM_PENDING)
+    {
+        return bResult;
+    }
+    // the step is finished
+    pStep->bResult = bResult;
+    pStep->dwMs = TIMER_GetMs() - dwStepStartMs;
+    summary.cSteps++;
+    summary.cFailed += (bResult != ERRVAL_SUCCESS);
+    summary.dwStepsMs += pStep->dwMs;
+    idxStep++;
+    bPhase = CALSEQ_PHASE_CONFIG;
+    if(idxStep >= cSteps)
+    {
+        summary.dwTotalMs = TIMER_GetMs() - dwSeqStartMs;
+        bState = CALSEQ_STATE_IDLE;
+    }
+    else if(CALSEQ_CompareSource(pStep, pStep + 1))
+    {
+        summary.cSources++;
+        bState = CALSEQ_STATE_WAITSOURCE;
+    }
+    return bResult;
+}
+
+/***	CALSEQ_GetState
+**
+**	Parameters:
+**		none
+**
+**	Return Value:
+**		uint8_t     - the sequencer state: CALSEQ_STATE_IDLE, CALSEQ_STATE_WAITSOURCE or CALSEQ_STATE_RUNNING
+**
+**	Description:
+**		This function returns the sequencer state.
+**
+*/
+uint8_t CALSEQ_GetState()
+{
+    return bState;
+}
+
+/***	CALSEQ_GetPrompt
+**
+**	Parameters:
+**		char *szPrompt      - the string to receive the prompt, at least 80 characters
+**
+**	Return Value:
+**		none
+**
+**	Description:
+**		This function builds the text requesting the operator to connect the reference source of the next step,
+**      for example "Connect the DC voltage reference: 4 V (3 steps)".
+**      It must be called when the sequence waits for the reference source (CALSEQ_STATE_WAITSOURCE).
+**
+*/
+void CALSEQ_GetPrompt(char *szPrompt)
+{
+    const CALSEQ_STEP *pStep = &rgSteps[idxStep];
+    int i, cSourceSteps = 1;
+    for(i = idxStep + 1; i < cSteps && !CALSEQ_CompareSource(pStep, &rgSteps[i]); i++)
+    {
+        cSourceSteps++;
+    }
+    sprintf(szPrompt, "Connect the %s reference: %s (%d step%s)", rgszModes[DMM_GetScaleMode(pStep->idxScale)],
+            pStep->szRef, cSourceSteps, (cSourceSteps > 1) ? "s" : "");
+}
+
+/***	CALSEQ_GetLastStep
+**
+**	Parameters:
+**		int *pIdxStep   - pointer to receive the position of the step in the ordered plan (0 based), can be NULL
+**
+**	Return Value:
+**		const CALSEQ_STEP *     - the last performed step, NULL if no step was performed
+**
+**	Description:
+**		This function returns the last step performed by CALSEQ_Step, with its result, measured value,
+**      dispersion and duration.
+**
+*/
+const CALSEQ_STEP *CALSEQ_GetLastStep(int *pIdxStep)
+{
+    if(!idxStep)
+    {
+        return NULL;
+    }
+    if(pIdxStep)
+    {
+        *pIdxStep = idxStep - 1;
+    }
+    return &rgSteps[idxStep - 1];
+}
+
+/***	CALSEQ_GetSummary
+**
+**	Parameters:
+**		CALSEQ_SUMMARY *pSummary    - pointer to receive the results of the sequence
+**
+**	Return Value:
+**		none
+**
+**	Description:
+**		This function returns the number of performed and failed steps, the number of scale configurations and
+**      reference sources, and the durations of the current or last sequence.
+**
+*/
+void CALSEQ_GetSummary(CALSEQ_SUMMARY *pSummary)
+{
+    memcpy(pSummary, &summary, sizeof(CALSEQ_SUMMARY));
+}
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+// Section: Local Functions                                                   */
+/* ************************************************************************** */
+/* ************************************************************************** */
+
+/***	CALSEQ_CompareSource
+**
+**	Parameters:
+**		const CALSEQ_STEP *pStep1   - the first step
+**		const CALSEQ_STEP *pStep2   - the second step
+**
+**	Return Value:
+**		int     - 0 if the steps use the same reference source, negative if the source of the first step is ordered
+**                before the source of the second step, positive otherwise
+**
+**	Description:
+**		This function compares the reference sources of two steps: the scale mode (the input connection),
+**      the measurement type (zero, positive, negative) and the reference value.
+**
+*/
+int CALSEQ_CompareSource(const CALSEQ_STEP *pStep1, const CALSEQ_STEP *pStep2)
+{
+    int iCmp = DMM_GetScaleMode(pStep1->idxScale) - DMM_GetScaleMode(pStep2->idxScale);
+    if(!iCmp)
+    {
+        iCmp = (int)pStep1->bType - (int)pStep2->bType;
+    }
+    if(!iCmp)
+    {
+        iCmp = (pStep1->dRefVal > pStep2->dRefVal) - (pStep1->dRefVal < pStep2->dRefVal);
+    }
+    return iCmp;
+}
+
+/***	CALSEQ_CompareStep
+**
+**	Parameters:
+**		const CALSEQ_STEP *pStep1   - the first step
+**		const CALSEQ_STEP *pStep2   - the second step
+**
+**	Return Value:
+**		int     - negative if the first step is ordered before the second step, positive otherwise
+**
+**	Description:
+**		This function compares two steps by reference source, then by scale range (largest range first).
+**
+*/
+int CALSEQ_CompareStep(const CALSEQ_STEP *pStep1, const CALSEQ_STEP *pStep2)
+{
+    int iCmp = CALSEQ_CompareSource(pStep1, pStep2);
+    double dRange1, dRange2;
+    if(!iCmp)
+    {
+        dRange1 = DMM_GetScaleRange(pStep1->idxScale);
+        dRange2 = DMM_GetScaleRange(pStep2->idxScale);
+        iCmp = (dRange1 < dRange2) - (dRange1 > dRange2);
+    }
+    return iCmp;
+}
+
+/***	CALSEQ_SortSteps
+**
+**	Parameters:
+**		none
+**
+**	Return Value:
+**		none
+**
+**	Description:
+**		This function orders the steps of the plan, so that the number of reference source changes and scale configurations is minimal.
+**      The steps are sorted by reference source (insertion sort, the plan is small), so each source is connected once.
+**      Then the first step of each source is chosen to use the scale of the previous step (the current scale for the first source),
+**      when such a step exists, so that the scale is not configured again.
+**
+*/
+void CALSEQ_SortSteps()
+{
+    CALSEQ_STEP step;
+    int i, j, idxScalePrev = DMM_GetCurrentScale();
+    for(i = 1; i < cSteps; i++)
+    {
+        memcpy(&step, &rgSteps[i], sizeof(CALSEQ_STEP));
+        for(j = i; j > 0 && CALSEQ_CompareStep(&rgSteps[j - 1], &step) > 0; j--)
+        {
+            memcpy(&rgSteps[j], &rgSteps[j - 1], sizeof(CALSEQ_STEP));
+        }
+        memcpy(&rgSteps[j], &step, sizeof(CALSEQ_STEP));
+    }
+    for(i = 0; i < cSteps; i++)
+    {
+        if(!i || CALSEQ_CompareSource(&rgSteps[i - 1], &rgSteps[i]))
+        {
+            // first step of a source
+            for(j = i; j < cSteps && !CALSEQ_CompareSource(&rgSteps[i], &rgSteps[j]); j++)
+            {
+                if(rgSteps[j].idxScale == idxScalePrev)
+                {
+                    memcpy(&step, &rgSteps[i], sizeof(CALSEQ_STEP));
+                    memcpy(&rgSteps[i], &rgSteps[j], sizeof(CALSEQ_STEP));
+                    memcpy(&rgSteps[j], &step, sizeof(CALSEQ_STEP));
+                    break;
+                }
+            }
+        }
+        idxScalePrev = rgSteps[i].idxScale;
+    }
+}
+
+/***	CALSEQ_FinalizeStep
+**
+**	Parameters:
+**		CALSEQ_STEP *pStep  - the step, whose measurement for calibration was performed
+**
+**	Return Value:
+**		uint8_t
+**          ERRVAL_SUCCESS                  0       // success
+**          ERRVAL_DMM_MEASUREDISPERSION    0xF1    // The calibration measurement dispersion exceeds accepted range
+**          ERRVAL_CALIB_MISSINGMEASUREMENT 0xF0    // The measurement is missing
+**
+**	Description:
+**		This function finalizes the calibration on zero, positive or negative value, using the measured value
+**      (early measurement), the same way as the DMMCalibZ, DMMCalibP and DMMCalibN commands.
+**      The dispersion is stored in the step. When all the steps of the scale are performed, the calibration
+**      coefficients are computed and the scale is marked to be saved in EPROM.
+**
+*/
+uint8_t CALSEQ_FinalizeStep(CALSEQ_STEP *pStep)
+{
+    switch(pStep->bType)
+    {
+        case CALIB_MEASURE_ZERO:
+            return CALIB_FinalizeCalibOnZero(&pStep->dMeasuredVal, &pStep->dDispersion, 0);
+        case CALIB_MEASURE_POSITIVE:
+            return CALIB_CalibOnPositive(pStep->dRefVal, &pStep->dMeasuredVal, 1, &pStep->dDispersion, 0);
+        default:
+            return CALIB_CalibOnNegative(pStep->dRefVal, &pStep->dMeasuredVal, 1, &pStep->dDispersion, 0);
+    }
+}
+
+/* *****************************************************************************
+ End of File
+ */
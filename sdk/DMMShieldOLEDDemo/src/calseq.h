@@ -0,0 +1,87 @@
+/* ************************************************************************** */
+/** Descriptive File Name
+
+  @Company
+ Digilent
+
+  @File Name
+    calseq.h
+
+  @Description
+        This file contains the declarations for the CALSEQ module functions.
+        The CALSEQ functions are defined in calseq.c source file.
+
+ */
+/* ************************************************************************** */
+
+#ifndef _CALSEQ_H    /* Guard against multiple inclusion */
+#define _CALSEQ_H
+
+#include "stdint.h"
+#include "dmm.h"
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Constants                                                         */
+/* ************************************************************************** */
+#define CALSEQ_MAXSTEPS         (3 * DMM_CNTSCALES)     // zero, positive and negative steps for each scale
+#define CALSEQ_CCHREF           16                      // size of the reference value text
+
+// sequencer states
+#define CALSEQ_STATE_IDLE       0       // the plan is edited, or the sequence is finished
+#define CALSEQ_STATE_WAITSOURCE 1       // the operator must connect the reference source, then call CALSEQ_Continue
+#define CALSEQ_STATE_RUNNING    2       // the steps using the connected source are performed by CALSEQ_Step
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Data Types
+// *****************************************************************************
+// *****************************************************************************
+
+// step of the calibration plan
+typedef struct _CALSEQ_STEP{
+    int8_t idxScale;                // the scale to be calibrated
+    uint8_t bType;                  // CALIB_MEASURE_ZERO, CALIB_MEASURE_POSITIVE or CALIB_MEASURE_NEGATIVE
+    uint8_t bResult;                // the step result, when performed
+    double dRefVal;                 // the reference value, 0 for the zero steps
+    char szRef[CALSEQ_CCHREF];      // the reference value text, used in the prompts
+    double dMeasuredVal;            // the measured value, when performed
+    double dDispersion;             // the measurement dispersion, when performed
+    uint32_t dwMs;                  // the step duration (scale configuration, measurement, calibration), in ms
+} CALSEQ_STEP;
+
+// results of the sequence
+typedef struct _CALSEQ_SUMMARY{
+    int cSteps;                     // number of steps performed
+    int cFailed;                    // number of steps that failed
+    int cScaleSwitches;             // number of scale configurations
+    int cSources;                   // number of reference sources connected
+    uint32_t dwStepsMs;             // duration of the steps, in ms, without the operator waits
+    uint32_t dwTotalMs;             // duration of the sequence, in ms, from CALSEQ_Start to the last step
+} CALSEQ_SUMMARY;
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Interface Functions
+// *****************************************************************************
+// *****************************************************************************
+// plan
+void CALSEQ_Clear();
+uint8_t CALSEQ_AddStep(int idxScale, uint8_t bType, double dRefVal, const char *szRef);
+int CALSEQ_GetCntSteps();
+
+// sequence
+uint8_t CALSEQ_Start();
+uint8_t CALSEQ_Continue();
+void CALSEQ_Abort();
+uint8_t CALSEQ_Step(unsigned int *pt10usWait);
+uint8_t CALSEQ_GetState();
+void CALSEQ_GetPrompt(char *szPrompt);
+const CALSEQ_STEP *CALSEQ_GetLastStep(int *pIdxStep);
+void CALSEQ_GetSummary(CALSEQ_SUMMARY *pSummary);
+
+#endif /* _CALSEQ_H */
+
+/* *****************************************************************************
+ End of File
+ */
@@ -0,0 +1,267 @@
+/* ************************************************************************** */
+/** Descriptive File Name
+
+  @Company
+    Digilent
+
+  @File Name
+    corr.c
+
+  @Description
+        This file groups the functions that implement the CORR module, the nonlinearity correction of the scales.
+        A correction is applied on the value after the calibration coefficients, it is either a polynomial
+        (evaluated using the Horner scheme) or a piecewise linear table.
+        Only CORR_CNTSLOTS scales can have a correction at the same time, the corrections are kept in RAM only.
+        The VoltageDC50 scale has by default the third power polynomial defined in dmm.h.
+        The DMM module gets the correction of the scale when the scale is set (DMM_UpdateCorrection),
+        so that the scales without correction are not checked when values are acquired.
+
+ */
+/* ************************************************************************** */
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Included Files                                                    */
+/* ************************************************************************** */
+#include <string.h>
+#include <math.h>
+#include "stdint.h"
+#include "dmm.h"
+#include "errors.h"
+#include "corr.h"
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Global Variables                                                  */
+/* ************************************************************************** */
+/* ************************************************************************** */
+// correction slots, the VoltageDC50 scale compensation is P3*v^3 + (P1 + P0)*v
+static CORR rgCorr[CORR_CNTSLOTS] = {
+    {DMMVoltageDC50Scale, CORR_TYPE_POLY, 4, {0, (float)(DMM_Voltage50DCLinearCoeff_P1 + DMM_Voltage50DCLinearCoeff_P0 - 1), 0, (float)DMM_Voltage50DCLinearCoeff_P3}}
+};
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+// Section: Interface Functions                                               */
+/* ************************************************************************** */
+/* ************************************************************************** */
+
+/***	CORR_GetScale
+**
+**	Parameters:
+**		int idxScale    - the scale index
+**
+**	Return Value:
+**		const CORR *    - the correction of the scale, NULL if the scale has no correction
+**
+**	Description:
+**		This function returns the correction of a scale. The returned pointer is valid until the
+**      correction of the scale is changed by CORR_SetScale.
+**
+*/
+const CORR *CORR_GetScale(int idxScale)
+{
+    int i;
+    for(i = 0; i < CORR_CNTSLOTS; i++)
+    {
+        if(rgCorr[i].bType != CORR_TYPE_NONE && rgCorr[i].idxScale == idxScale)
+        {
+            return &rgCorr[i];
+        }
+    }
+    return NULL;
+}
+
+/***	CORR_SetScale
+**
+**	Parameters:
+**		int idxScale        - the scale index
+**		const CORR *pCorr   - the correction, in the stored format, NULL or CORR_TYPE_NONE to remove the correction
+**
+**	Return Value:
+**		uint8_t
+**          ERRVAL_SUCCESS                  0       // success
+**          ERRVAL_DMM_IDXCONFIG            0xFC    // wrong scale index
+**          ERRVAL_CORR_FULL                0xE9    // all the correction slots are used
+**
+**	Description:
+**		This function sets the correction of a scale. The slot of the scale is reused, otherwise a free slot is used.
+**      The idxScale member of pCorr is ignored. The DMM module is informed (DMM_UpdateCorrection),
+**      so the correction is used from the next value of the current scale.
+**      It is used by CORR_ImportScale and, in the AMP configuration, by CPU1 to get the correction of the scale from CPU0.
+**
+*/
+uint8_t CORR_SetScale(int idxScale, const CORR *pCorr)
+{
+    CORR *pSlot = (CORR *)CORR_GetScale(idxScale);
+    int i;
+    if(idxScale < 0 || idxScale >= DMM_CNTSCALES)
+    {
+        return ERRVAL_DMM_IDXCONFIG;
+    }
+    if(!pCorr || pCorr->bType == CORR_TYPE_NONE)
+    {
+        if(pSlot)
+        {
+            pSlot->bType = CORR_TYPE_NONE;
+        }
+    }
+    else
+    {
+        for(i = 0; i < CORR_CNTSLOTS && !pSlot; i++)
+        {
+            if(rgCorr[i].bType == CORR_TYPE_NONE)
+            {
+                pSlot = &rgCorr[i];
+            }
+        }
+        if(!pSlot)
+        {
+            return ERRVAL_CORR_FULL;
+        }
+        memcpy(pSlot, pCorr, sizeof(CORR));
+        pSlot->idxScale = idxScale;
+    }
+    DMM_UpdateCorrection();
+    return ERRVAL_SUCCESS;
+}
+
+/***	CORR_ImportScale
+**
+**	Parameters:
+**		int idxScale            - the scale index
+**		uint8_t bType           - the correction type (CORR_TYPE_ value)
+**		const double *rgdVals   - the correction values:
+**                                  CORR_TYPE_POLY - the coefficients c0, c1, ... cn of c0 + c1*v + ... + cn*v^n
+**                                  CORR_TYPE_TABLE - the points x0, y0, x1, y1, ... the x values strictly increasing
+**		int cVals               - the number of values
+**
+**	Return Value:
+**		uint8_t
+**          ERRVAL_SUCCESS                  0       // success
+**          ERRVAL_DMM_IDXCONFIG            0xFC    // wrong scale index
+**          ERRVAL_CORR_FORMAT              0xEA    // wrong number of values, not finite values or x values not increasing
+**          ERRVAL_CORR_FULL                0xE9    // all the correction slots are used
+**
+**	Description:
+**		This function converts the correction to the stored format (deviation from the identity, float values)
+**      and sets it as correction of the scale, by calling CORR_SetScale.
+**      A polynomial has 1 to CORR_MAXVALS coefficients, a table has 2 to CORR_MAXPOINTS points.
+**      CORR_TYPE_NONE removes the correction of the scale, the values are ignored.
+**
+*/
+uint8_t CORR_ImportScale(int idxScale, uint8_t bType, const double *rgdVals, int cVals)
+{
+    CORR corr;
+    int i;
+    memset(&corr, 0, sizeof(corr));
+    corr.bType = bType;
+    switch(bType)
+    {
+        case CORR_TYPE_NONE:
+            cVals = 0;
+            break;
+        case CORR_TYPE_POLY:
+            if(cVals < 1 || cVals > CORR_MAXVALS)
+            {
+                return ERRVAL_CORR_FORMAT;
+            }
+            for(i = 0; i < cVals; i++)
+            {
+                corr.rgfVals[i] = rgdVals[i];
+            }
+            // the identity term is added by CORR_Apply
+            corr.rgfVals[1] = ((cVals > 1) ? rgdVals[1] : 0) - 1;
+            cVals = (cVals > 1) ? cVals : 2;
+            break;
+        case CORR_TYPE_TABLE:
+            if(cVals < 4 || cVals > CORR_MAXVALS || (cVals % 2))
+            {
+                return ERRVAL_CORR_FORMAT;
+            }
+            for(i = 0; i < cVals; i += 2)
+            {
+                corr.rgfVals[i] = rgdVals[i];
+                corr.rgfVals[i + 1] = rgdVals[i + 1] - rgdVals[i];
+                if(i && corr.rgfVals[i] <= corr.rgfVals[i - 2])
+                {
+                    return ERRVAL_CORR_FORMAT;
+                }
+            }
+            break;
+        default:
+            return ERRVAL_CORR_FORMAT;
+    }
+    for(i = 0; i < cVals; i++)
+    {
+        if(!isfinite(corr.rgfVals[i]))
+        {
+            return ERRVAL_CORR_FORMAT;
+        }
+    }
+    corr.cVals = cVals;
+    return CORR_SetScale(idxScale, &corr);
+}
+
+/***	CORR_Apply
+**
+**	Parameters:
+**		const CORR *pCorr   - the correction, returned by CORR_GetScale
+**		double dVal         - the value after the calibration coefficients were applied
+**
+**	Return Value:
+**		double  - the corrected value
+**
+**	Description:
+**		This function applies the correction on a value. NAN and infinite values are returned unchanged.
+**      The polynomial is evaluated using the Horner scheme.
+**      The table is linearly interpolated between the points, the first and the last point deviations are used
+**      for the values outside the table.
+**
+*/
+double CORR_Apply(const CORR *pCorr, double dVal)
+{
+    const float *pfVals = pCorr->rgfVals;
+    double dDev;
+    int i;
+    if(!isfinite(dVal))
+    {
+        return dVal;
+    }
+    if(pCorr->bType == CORR_TYPE_POLY)
+    {
+        dDev = pfVals[pCorr->cVals - 1];
+        for(i = pCorr->cVals - 2; i >= 0; i--)
+        {
+            dDev = dDev * dVal + pfVals[i];
+        }
+    }
+    else
+    {
+        if(dVal <= pfVals[0])
+        {
+            dDev = pfVals[1];
+        }
+        else
+        {
+            i = 2;
+            while(i < pCorr->cVals - 2 && dVal > pfVals[i])
+            {
+                i += 2;
+            }
+            if(dVal >= pfVals[i])
+            {
+                dDev = pfVals[i + 1];
+            }
+            else
+            {
+                dDev = pfVals[i - 1] + (pfVals[i + 1] - pfVals[i - 1]) * (dVal - pfVals[i - 2]) / (pfVals[i] - pfVals[i - 2]);
+            }
+        }
+    }
+    return dVal + dDev;
+}
+
+/* *****************************************************************************
+ End of File
+ */
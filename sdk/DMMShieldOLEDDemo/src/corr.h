@@ -0,0 +1,64 @@
+/* ************************************************************************** */
+/** Descriptive File Name
+
+  @Company
+ Digilent
+
+  @File Name
+    corr.h
+
+  @Description
+        This file contains the declarations for the CORR module functions.
+        The CORR functions are defined in corr.c source file.
+
+ */
+/* ************************************************************************** */
+
+#ifndef _CORR_H    /* Guard against multiple inclusion */
+#define _CORR_H
+
+#include "stdint.h"
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Constants                                                         */
+/* ************************************************************************** */
+// correction types
+#define CORR_TYPE_NONE          0       // no correction, the value is not changed
+#define CORR_TYPE_POLY          1       // polynomial, the values are the coefficients c0, c1, ... cn
+#define CORR_TYPE_TABLE         2       // piecewise linear table, the values are the (x, y) pairs, x increasing
+
+#define CORR_MAXVALS            16      // maximum number of values of a correction
+#define CORR_MAXPOINTS          (CORR_MAXVALS / 2)  // maximum number of points of a table
+#define CORR_CNTSLOTS           4       // maximum number of scales having a correction at the same time
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Data Types
+// *****************************************************************************
+// *****************************************************************************
+
+// correction of a scale, stored as the deviation from the identity (c1 - 1 for polynomials, y - x for tables),
+// so that the float values keep the resolution of the measured value
+typedef struct _CORR{
+    int8_t idxScale;                // scale using the correction
+    uint8_t bType;                  // CORR_TYPE_ value, CORR_TYPE_NONE for a free slot
+    uint8_t cVals;                  // number of values used in rgfVals
+    float rgfVals[CORR_MAXVALS];    // polynomial coefficients, or x and deviation of the table points
+} CORR;
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Interface Functions
+// *****************************************************************************
+// *****************************************************************************
+const CORR *CORR_GetScale(int idxScale);
+uint8_t CORR_SetScale(int idxScale, const CORR *pCorr);
+uint8_t CORR_ImportScale(int idxScale, uint8_t bType, const double *rgdVals, int cVals);
+double CORR_Apply(const CORR *pCorr, double dVal);
+
+#endif /* _CORR_H */
+
+/* *****************************************************************************
+ End of File
+ */
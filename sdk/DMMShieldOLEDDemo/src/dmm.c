@@ -37,13 +37,18 @@
 /* ************************************************************************** */
 
 #include <stdio.h>
+#include <string.h>
 #include "stdint.h"
 #include "math.h"
 #include "dmm.h"
 #include "gpio.h"
 #include "spi.h"
+#include "spidma.h"
 #include "errors.h"
 #include "utils.h"
+#include "numparse.h"
+#include "corr.h"
+#include "calib.h"
 /* ************************************************************************** */
 /* ************************************************************************** */
 // Section: Local Functions Prototypes                                        */
@@ -58,13 +63,19 @@ void DMM_GetCmdSPI(uint8_t bCmd, int bytesNumber, uint8_t *pbRdData);
 
 // retrieve value from DMM
 double DMM_DGetStatus(uint8_t *pbErr);
+double DMM_ComputeStatus(DMMSTS *pDmmsts);
+double DMM_ComputePeak(uint8_t *pbReg);
+uint8_t DMM_QueueStatusRead();
+void DMM_InitXfer(SPI_XFER *pXfer, uint8_t bCmd, uint8_t fRead, int bytesNumber, uint8_t *pbData);
 
 // value format
 uint8_t DMM_GetScaleUnit(int idxScale, double *pdScaleFact, char *szUnitPrefix, char *szUnit);
+void DMM_InitScaleUnits();
+uint8_t DMM_FormatValueMode(double dVal, char *pString, uint8_t fUnit, uint8_t fFast);
+char *DMM_FormatFixed(double dVal, char *pString);
 
 // configuration functions
 uint8_t DMM_FACScale(int idxScale);
-double DMM_CompensateVoltage50DCLinear(double dVal);
 // errors 
 uint8_t DMM_ERR_CheckIdxCalib(int idxScale);
 
@@ -117,6 +128,39 @@ const static DMMCFG dmmcfg[] = {
 
 int idxCurrentScale = -1;   // stores the current selected scale
 char fUseCalib = 1;         // controls if calibration coefficients should be applied in DMM_DGetStatus
+static const CORR *pCorrCurrent = NULL;   // correction of the current scale, NULL if the scale has none
+static double dTempFactor = 1;            // temperature compensation factor of the current scale, applied with the calibration
+static uint8_t fPeakDetect = 0;           // the peak registers are converted by DMM_ComputeStatus
+static double dPeakMin = NAN, dPeakMax = NAN;     // peak values of the last conversion, NAN until converted
+
+// unit data for each scale, computed once by DMM_InitScaleUnits
+typedef struct _DMMUNIT{
+    double dScaleFact;      // factor to convert from base unit to the prefixed unit
+    char szUnit[8];         // " " + unit prefix + unit, for example " mV"
+    char szBaseUnit[4];     // unit without prefix, for example "V"
+    int expPrefix;          // power of 10 corresponding to the unit prefix, for example -3 for "m"
+} DMMUNIT;
+static DMMUNIT dmmunit[DMM_CNTSCALES];
+
+// powers of 10 used by the fixed point formatter, 10^DMM_FORMAT_DECIMALS must be smaller than 2^27
+static const double dFormatPow10[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8};
+
+// state of the resumable scale configuration (DMM_SetScaleStart / DMM_SetScaleStep)
+static int idxSetScale = -1;
+static uint8_t bSetScaleStep;
+static uint8_t rgSetScaleIn[24];
+
+// state of the resumable value retrieval (DMM_DGetValueStart / DMM_DGetValueStep)
+static unsigned int cntGetValueTimeout;
+static SPI_XFER xferStatus;             // asynchronous read of the status registers
+static DMMSTS dmmstsAsync;              // status registers received by xferStatus
+static uint8_t fStatusXferQueued = 0;   // xferStatus was queued and its result was not used yet
+
+// state of the resumable average value (DMM_DGetAvgValueStart / DMM_DGetAvgValueStep)
+static int cbAvgSamples;
+static int idxAvgSample;
+static uint8_t fAvgAC;
+static double dAvgSum;
 
 
 /* ************************************************************************** */
@@ -136,13 +180,14 @@ char fUseCalib = 1;         // controls if calibration coefficients should be ap
 **	Description:
 **		This function initializes the DMM module. 
 **      It calls the SPI_Init() function to initialize the digital pins used by DMMSHield.
-**     
+**      It also computes the unit data of each scale, used by DMM_FormatValue.
 **      
 **          
 */
 void DMM_Init()
 {
     SPI_Init();
+    DMM_InitScaleUnits();
 }
 
 /***	DMM_SetScale
@@ -160,6 +205,7 @@ void DMM_Init()
 **      According to this scale, it uses data defined in dmmcfg structure to configure the switches and 
 **      to set the value of the registers (24 registers starting at 0x1F address).
 **      It also verifies the configuration setting success status by reading the values of these registers.
+**      The function runs the DMM_SetScaleStart / DMM_SetScaleStep state machine, waiting between steps.
 **      It returns ERRVAL_SUCCESS if the operation is successful.
 **      It returns ERRVAL_DMM_CFGVERIFY if verifying fails.
 **      It returns ERRVAL_DMM_IDXCONFIG if the scale index is not valid.
@@ -167,65 +213,114 @@ void DMM_Init()
 */
 uint8_t DMM_SetScale(int idxScale)
 {
-    // 1. Verify index
+    unsigned int t10usWait;
+    uint8_t bResult = DMM_SetScaleStart(idxScale);
+    while(bResult == ERRVAL_SUCCESS && (bResult = DMM_SetScaleStep(&t10usWait)) == ERRVAL_DMM_PENDING)
+    {
+        DelayAprox10Us(t10usWait);
+    }
+    return bResult;
+}
+
+/***	DMM_SetScaleStart
+**
+**	Parameters:
+**      int idxScale		- the scale index
+**
+**	Return Value:
+**		uint8_t 
+**          ERRVAL_SUCCESS            0      // success
+**          ERRVAL_DMM_IDXCONFIG     0xFC    // error, wrong scale index
+**	Description:
+**		This function starts the resumable configuration of a scale, without accessing the DMM.
+**      The configuration is performed by the following calls of DMM_SetScaleStep.
+**      It returns ERRVAL_DMM_IDXCONFIG if the scale index is not valid.
+**            
+*/
+uint8_t DMM_SetScaleStart(int idxScale)
+{
     uint8_t bResult = DMM_ERR_CheckIdxCalib(idxScale);
-    if(bResult != ERRVAL_SUCCESS)
+    if(bResult == ERRVAL_SUCCESS)
     {
-        return bResult;
+        idxSetScale = idxScale;
+        bSetScaleStep = 0;
     }
+    return bResult;
+}
+
+/***	DMM_SetScaleStep
+**
+**	Parameters:
+**      unsigned int *pt10usWait    - pointer to receive the time (in 10 us units) to wait before the next step
+**
+**	Return Value:
+**		uint8_t 
+**          ERRVAL_SUCCESS            0      // success, the scale is configured
+**          ERRVAL_DMM_PENDING       0xEC    // the configuration is not finished, call again after the wait time
+**          ERRVAL_DMM_CFGVERIFY     0xF5    // DMM Configuration verify error
+**	Description:
+**		This function performs one step of the scale configuration started by DMM_SetScaleStart, so that 
+**      the caller can do other work instead of waiting between steps:
+**      1. reset the DMM and clear the switches, 2. set the switches and write the 24 configuration registers,
+**      3. read back the registers, 4. verify them and set the current scale.
+**      While ERRVAL_DMM_PENDING is returned, the minimum time to wait before the next call is placed in pt10usWait.
+**            
+*/
+uint8_t DMM_SetScaleStep(unsigned int *pt10usWait)
+{
     const int cbCfg = 24;
-    uint8_t rgIn[24];
-    
-    // 2. Reset the DMM by writing 0x60 on 0x37 register
+    uint8_t bCmd;
     uint8_t valReset = 0x60;
-    // Build command:
-    //  MSB: 7 bits address: 0x37
-    //  LSB: 0 for write
-    uint8_t bCmd = 0x37 << 1;
-
-    // Write 1 bytes, starting with 0x37 address
-    DMM_SendCmdSPI(bCmd, 1, &valReset);
-
-    // 3. Set the switches
-    
-    // clear switches
-    DMM_ConfigSwitches(0); 
-    DelayAprox10Us(100);    
-    DMM_ConfigSwitches(dmmcfg[idxScale].sw); 
-    
-    // 4. Set the value for the 24 registers starting with 0x1f
-    // Build command:
-    //  MSB: 7 bits address: 0x1F
-    //  LSB: 0 for write
-    bCmd = 0x1F << 1;
-    
-    // Write 24 bytes, starting with 0x1F address, values taken from dmmcfg[idxScale].cfg array
-    DMM_SendCmdSPI(bCmd, cbCfg, (uint8_t *)dmmcfg[idxScale].cfg);
-
-    // 5. Verify the values of the 24 registers starting with 0x1f
-    
-    // Build command:
-    //  MSB: 7 bits address: 0x1F
-    //  LSB: 1 for read
-    bCmd =(0x1F<<1) | 1;    
-    DelayAprox10Us(500);     
-
-    // 5.1. Read 24 bytes, starting with 0x1F address, values placed in rgIn array
-    DMM_GetCmdSPI(bCmd, cbCfg, rgIn);
-    DelayAprox10Us(1000);     
-
-    // 5.2. Compare values from rgIn and dmmcfg[idxScale].cfg arrays
-     int i;
-     for(i = 0; i < cbCfg; i++){
-         if((rgIn[i]&dmmcfgmask[i])!=(dmmcfgmask[i]&dmmcfg[idxScale].cfg[i]))
-         {
+    int i;
+    switch(bSetScaleStep++)
+    {
+        case 0:
+            // 1. Reset the DMM by writing 0x60 on 0x37 register
+            // Build command:
+            //  MSB: 7 bits address: 0x37
+            //  LSB: 0 for write
+            bCmd = 0x37 << 1;
+            // Write 1 bytes, starting with 0x37 address
+            DMM_SendCmdSPI(bCmd, 1, &valReset);
+            // clear switches
+            DMM_ConfigSwitches(0);
+            *pt10usWait = 100;
+            return ERRVAL_DMM_PENDING;
+        case 1:
+            // 2. Set the switches
+            DMM_ConfigSwitches(dmmcfg[idxSetScale].sw);
+            // Set the value for the 24 registers starting with 0x1f
+            // Build command:
+            //  MSB: 7 bits address: 0x1F
+            //  LSB: 0 for write
+            bCmd = 0x1F << 1;
+            // Write 24 bytes, starting with 0x1F address, values taken from dmmcfg[idxSetScale].cfg array
+            DMM_SendCmdSPI(bCmd, cbCfg, (uint8_t *)dmmcfg[idxSetScale].cfg);
+            *pt10usWait = 500;
+            return ERRVAL_DMM_PENDING;
+        case 2:
+            // 3. Read 24 bytes, starting with 0x1F address, values placed in rgSetScaleIn array
+            // Build command:
+            //  MSB: 7 bits address: 0x1F
+            //  LSB: 1 for read
+            bCmd =(0x1F<<1) | 1;    
+            DMM_GetCmdSPI(bCmd, cbCfg, rgSetScaleIn);
+            *pt10usWait = 1000;
+            return ERRVAL_DMM_PENDING;
+        default:
+            break;
+    }
+    // 4. Compare values from rgSetScaleIn and dmmcfg[idxSetScale].cfg arrays
+    for(i = 0; i < cbCfg; i++){
+        if((rgSetScaleIn[i]&dmmcfgmask[i])!=(dmmcfgmask[i]&dmmcfg[idxSetScale].cfg[i]))
+        {
             // DMM scale configuration verify failed;
-             return ERRVAL_DMM_CFGVERIFY;
-         }
-     }
-     
-     // 6. Set idxScale as current scale
-    idxCurrentScale = idxScale;
+            return ERRVAL_DMM_CFGVERIFY;
+        }
+    }
+    // Set idxSetScale as current scale
+    idxCurrentScale = idxSetScale;
+    DMM_UpdateCorrection();
     return ERRVAL_SUCCESS;
 }
 
@@ -266,34 +361,22 @@ uint8_t DMM_ERR_CheckIdxCalib(int idxScale)
 **          +/- INFINITY if the convertor / RMS registers values are outside the expected range.
 **	Description:
 **		This function repeatedly retrieves the value from the convertor / RMS registers 
-**      by calling private private function DMM_DGetStatus, until a valid value is detected.
+**      by calling DMM_DGetValueStep, until a valid value is detected.
 **      It returns INFINITY when measured values are outside the expected convertor range.
 **      If there is no valid current scale selected, the function sets the error value to ERRVAL_DMM_IDXCONFIG and NAN value is returned. 
 **      If there is no valid value retrieved within a specific timeout period, the error is set to ERRVAL_DMM_VALIDDATATIMEOUT.
-**		This function compensates the not linear behavior of VoltageDC50 scale.
+**		This function compensates the not linear behavior of the scales having a correction (CORR module), by default the VoltageDC50 scale.
 **		When no error is detected, the error is set to ERRVAL_SUCCESS.
 **      The error is copied in the byte pointed by pbErr, if pbErr is not null.
 **            
 */
 double DMM_DGetValue(uint8_t *pbErr)
 {
-    uint8_t bErr = ERRVAL_SUCCESS;
-    // valid data timeout counter 
-    unsigned int cntTimeout = 0;
-    
+    uint8_t bErr;
     double dVal;
+    DMM_DGetValueStart();
     // wait until a valid value is retrieved or the timeout counter exceeds threshold
-    while(DMM_IsNotANumber(dVal = DMM_DGetStatus(&bErr)) && (cntTimeout++ < DMM_VALIDDATA_CNTTIMEOUT) && (bErr == ERRVAL_SUCCESS));
-    // detect timeout 
-    if((bErr == ERRVAL_SUCCESS) && (cntTimeout >=  DMM_VALIDDATA_CNTTIMEOUT))
-    {
-        bErr = ERRVAL_DMM_VALIDDATATIMEOUT;
-    }
-    if(bErr == ERRVAL_SUCCESS && DMM_GetCurrentScale() == DMMVoltageDC50Scale)
-    {
-        // compensate the not linear scale behavior
-        dVal = DMM_CompensateVoltage50DCLinear(dVal);
-    }
+    while((bErr = DMM_DGetValueStep(&dVal)) == ERRVAL_DMM_PENDING);
     
     // set error
     if(pbErr)
@@ -303,6 +386,98 @@ double DMM_DGetValue(uint8_t *pbErr)
     return dVal;
 }
 
+/***	DMM_DGetValueStart
+**
+**	Parameters:
+**      none
+**
+**	Return Value:
+**		none
+**	Description:
+**		This function starts the resumable retrieval of a DMM value, performed by the following calls of DMM_DGetValueStep.
+**      It resets the valid data timeout counter and drops the result of an asynchronous status read
+**      left by a previous retrieval, as it may belong to a different scale.
+**            
+*/
+void DMM_DGetValueStart()
+{
+    cntGetValueTimeout = 0;
+    if(fStatusXferQueued)
+    {
+        SPI_AsyncWaitIdle();
+        fStatusXferQueued = 0;
+    }
+}
+
+/***	DMM_DGetValueStep
+**
+**	Parameters:
+**      double *pdVal - Pointer to receive the value when the function does not return ERRVAL_DMM_PENDING
+**
+**	Return Value:
+**		uint8_t 
+**          ERRVAL_SUCCESS              0       // success
+**          ERRVAL_DMM_PENDING          0xEC    // no valid value yet, call again
+**          ERRVAL_DMM_VALIDDATATIMEOUT 0xFA    // valid data DMM timeout
+**          ERRVAL_DMM_IDXCONFIG        0xFC    // error, wrong current scale index
+**	Description:
+**		This function retrieves once the value from the convertor / RMS registers by calling private function DMM_DGetStatus.
+**      When the asynchronous SPI engine is initialized (SPI_AsyncIsReady), the registers are read in background instead:
+**      the first call queues the read and returns ERRVAL_DMM_PENDING, the following calls return ERRVAL_DMM_PENDING
+**      until the read is finished, then the value is computed from the received registers.
+**      If the value is not ready, it returns ERRVAL_DMM_PENDING, unless the number of retries since 
+**      DMM_DGetValueStart exceeds DMM_VALIDDATA_CNTTIMEOUT, in which case ERRVAL_DMM_VALIDDATATIMEOUT is returned.
+**      Otherwise the value is placed in pdVal, the same way as DMM_DGetValue returns it.
+**		This function compensates the not linear behavior of the scales having a correction (CORR module), 
+**      by default the VoltageDC50 scale.
+**            
+*/
+uint8_t DMM_DGetValueStep(double *pdVal)
+{
+    uint8_t bErr = ERRVAL_SUCCESS;
+    double dVal;
+    if(SPI_AsyncIsReady())
+    {
+        if(!fStatusXferQueued)
+        {
+            bErr = DMM_QueueStatusRead();
+            if(bErr != ERRVAL_SUCCESS)
+            {
+                *pdVal = NAN;
+                return bErr;
+            }
+            fStatusXferQueued = 1;
+            return ERRVAL_DMM_PENDING;
+        }
+        if(!xferStatus.fDone)
+        {
+            return ERRVAL_DMM_PENDING;
+        }
+        fStatusXferQueued = 0;
+        dVal = DMM_ComputeStatus(&dmmstsAsync);
+    }
+    else
+    {
+        dVal = DMM_DGetStatus(&bErr);
+    }
+    if((bErr == ERRVAL_SUCCESS) && DMM_IsNotANumber(dVal))
+    {
+        if(cntGetValueTimeout++ < DMM_VALIDDATA_CNTTIMEOUT)
+        {
+            return ERRVAL_DMM_PENDING;
+        }
+        // detect timeout 
+        bErr = ERRVAL_DMM_VALIDDATATIMEOUT;
+    }
+    if(bErr == ERRVAL_SUCCESS && pCorrCurrent)
+    {
+        // compensate the not linear scale behavior
+        dVal = CORR_Apply(pCorrCurrent, dVal);
+    }
+    *pdVal = dVal;
+    return bErr;
+}
+
 /***	DMM_DGetAvgValue
 **
 **	Parameters:
@@ -321,6 +496,7 @@ double DMM_DGetValue(uint8_t *pbErr)
 **      returned by DMM_DGetValue, for the specified number of samples. 
 **      The function uses Arithmetic mean average value method for all but AC scales, 
 **      and RMS (Quadratic mean) Average value method for for AC scales.
+**      It runs the DMM_DGetAvgValueStart / DMM_DGetAvgValueStep state machine.
 **      If there is no valid current scale selected, the error is set to ERRVAL_DMM_IDXCONFIG. 
 **      If there is no valid value retrieved within a specific timeout period, the error is set to ERRVAL_DMM_VALIDDATATIMEOUT.
 **      It returns INFINITY when measured values are outside the expected convertor range.
@@ -331,62 +507,219 @@ double DMM_DGetValue(uint8_t *pbErr)
 */
 double DMM_DGetAvgValue(int cbSamples, uint8_t *pbErr)
 {
-    uint8_t fValid = 1;
-    double dValAvg = 0.0, dVal;
-    int i;
+    double dValAvg = NAN;
+	uint8_t bErr = DMM_DGetAvgValueStart(cbSamples);
+    if(bErr == ERRVAL_SUCCESS)
+    {
+        while((bErr = DMM_DGetAvgValueStep(&dValAvg)) == ERRVAL_DMM_PENDING);
+    }
+    if(pbErr)
+    {
+        *pbErr = bErr;
+    }
+    return dValAvg;
+}
+
+/***	DMM_DGetAvgValueStart
+**
+**	Parameters:
+**      int cbSamples           - The number of values to be used for the average value        
+**
+**	Return Value:
+**		uint8_t 
+**          ERRVAL_SUCCESS              0       // success
+**          ERRVAL_DMM_IDXCONFIG        0xFC    // error, wrong current scale index
+**	Description:
+**		This function starts the resumable computation of an average value, performed by the following calls of DMM_DGetAvgValueStep.
+**      It returns ERRVAL_DMM_IDXCONFIG if there is no valid current scale selected.
+**            
+*/
+uint8_t DMM_DGetAvgValueStart(int cbSamples)
+{
     int idxScale = DMM_GetCurrentScale();
 	uint8_t bErr  = DMM_ERR_CheckIdxCalib(idxScale);    
-    uint8_t fAC;
     if(bErr == ERRVAL_SUCCESS)
     {
-        fAC = DMM_FACScale(idxScale);
-        if(fAC)
+        fAvgAC = DMM_FACScale(idxScale);
+        cbAvgSamples = cbSamples;
+        idxAvgSample = 0;
+        dAvgSum = 0.0;
+        DMM_DGetValueStart();
+    }
+    return bErr;
+}
+
+/***	DMM_DGetAvgValueStep
+**
+**	Parameters:
+**      double *pdVal - Pointer to receive the average value when the function does not return ERRVAL_DMM_PENDING
+**
+**	Return Value:
+**		uint8_t 
+**          ERRVAL_SUCCESS              0       // success
+**          ERRVAL_DMM_PENDING          0xEC    // the average value is not complete, call again
+**          ERRVAL_DMM_VALIDDATATIMEOUT 0xFA    // valid data DMM timeout
+**          ERRVAL_DMM_IDXCONFIG        0xFC    // error, wrong current scale index
+**	Description:
+**		This function performs one DMM_DGetValueStep for the average value started by DMM_DGetAvgValueStart.
+**      The function uses Arithmetic mean average value method for all but AC scales, 
+**      and RMS (Quadratic mean) Average value method for for AC scales.
+**      When all the samples are accumulated, or when an invalid value is retrieved, the result is placed in pdVal
+**      the same way as DMM_DGetAvgValue returns it.
+**            
+*/
+uint8_t DMM_DGetAvgValueStep(double *pdVal)
+{
+    uint8_t bErr = ERRVAL_SUCCESS;
+    uint8_t fValid = 1;
+    double dVal;
+    if(idxAvgSample < cbAvgSamples)
+    {
+        bErr = DMM_DGetValueStep(&dVal);
+        if(bErr == ERRVAL_DMM_PENDING)
         {
-            // use RMS (Quadratic mean) Average value for AC
-            for(i = 0; (i < cbSamples) && fValid; i++)
-            {
-                dVal = DMM_DGetValue(&bErr);
-                fValid = (bErr == ERRVAL_SUCCESS) && (dVal != INFINITY) && (dVal != -INFINITY )&& !DMM_IsNotANumber(dVal);
-                if(fValid)
-                {
-                    dValAvg += pow(dVal, 2);
-                }
-            }
-            if(fValid && cbSamples)
-            {
-                dValAvg /= cbSamples;                
-                dValAvg = sqrt(dValAvg);
-            }            
+            return bErr;
         }
-        else
+        fValid = (bErr == ERRVAL_SUCCESS) && (dVal != INFINITY) && (dVal != -INFINITY )&& !DMM_IsNotANumber(dVal);
+        if(fValid)
         {
-            // use normal (Arithmetic mean) Average value for other that AC.
-            for(i = 0; (i < cbSamples) && fValid; i++)
-            {
-                dVal = DMM_DGetValue(&bErr);
-                fValid = (bErr == ERRVAL_SUCCESS) && (dVal != INFINITY) && (dVal != -INFINITY )&& !DMM_IsNotANumber(dVal);
-                if(fValid)
-                {
-                    dValAvg += dVal;
-                }
-            }
-            if(fValid && cbSamples)
+            // use RMS (Quadratic mean) Average value for AC, normal (Arithmetic mean) Average value for other that AC.
+            dAvgSum += fAvgAC ? pow(dVal, 2): dVal;
+            if(++idxAvgSample < cbAvgSamples)
             {
-                dValAvg /= cbSamples;                
+                DMM_DGetValueStart();
+                return ERRVAL_DMM_PENDING;
             }
         }
     }
+    dVal = dAvgSum;
+    if(fValid && cbAvgSamples)
+    {
+        dVal /= cbAvgSamples;
+        if(fAvgAC)
+        {
+            dVal = sqrt(dVal);
+        }
+    }
     if(bErr != ERRVAL_SUCCESS)
     {
-        dValAvg = NAN;
+        dVal = NAN;
     }
-    if(pbErr)
+    *pdVal = dVal;
+    return bErr;
+}
+
+
+/***	DMM_SetScaleIdx
+**
+**	Parameters:
+**      int idxScale		- the scale index
+**
+**	Return Value:
+**		uint8_t 
+**          ERRVAL_SUCCESS            0      // success
+**          ERRVAL_DMM_IDXCONFIG     0xFC    // error, wrong scale index
+**	Description:
+**		This function sets the current scale index without configuring the DMM and the switches.
+**      It is used when the DMM was already configured for this scale by other code, for example by CPU0
+**      in the AMP configuration, before CPU1 starts the acquisition.
+**      It returns ERRVAL_DMM_IDXCONFIG if the scale index is not valid.
+**            
+*/
+uint8_t DMM_SetScaleIdx(int idxScale)
+{
+    uint8_t bResult = DMM_ERR_CheckIdxCalib(idxScale);
+    if(bResult == ERRVAL_SUCCESS)
     {
-        *pbErr = bErr;
+        idxCurrentScale = idxScale;
+        DMM_UpdateCorrection();
     }
-    return dValAvg;
+    return bResult;
+}
+
+/***	DMM_UpdateCorrection
+**
+**	Parameters:
+**      none
+**
+**	Return Value:
+**		none
+**
+**	Description:
+**		This function gets the nonlinearity correction of the current scale (CORR_GetScale), applied by DMM_DGetValueStep,
+**      and the temperature compensation factor of the current scale (CALIB_GetTempFactor), applied with the calibration coefficients.
+**      It is called when the current scale is set, by CORR_SetScale when a correction is changed and when
+**      the temperature compensation changes (die temperature, calibration temperature or temperature coefficient),
+**      so that the values of the scales without correction are not checked for correction.
+**            
+*/
+void DMM_UpdateCorrection()
+{
+    pCorrCurrent = (idxCurrentScale >= 0) ? CORR_GetScale(idxCurrentScale) : NULL;
+    dTempFactor = (idxCurrentScale >= 0) ? CALIB_GetTempFactor(idxCurrentScale) : 1;
+}
+
+/***	DMM_SetTempFactor
+**
+**	Parameters:
+**      double dFactor  - the temperature compensation factor of the current scale
+**
+**	Return Value:
+**		none
+**
+**	Description:
+**		This function sets the temperature compensation factor of the current scale, instead of DMM_UpdateCorrection.
+**      It is used in the AMP configuration by CPU1, which gets the factor computed by CPU0 in the shared data.
+**            
+*/
+void DMM_SetTempFactor(double dFactor)
+{
+    dTempFactor = dFactor;
 }
 
+/***	DMM_SetPeakDetect
+**
+**	Parameters:
+**      uint8_t f
+**              1 if the peak registers should be converted in future DMM_DGetStatus calls
+**              0 if the peak registers should not be converted
+**
+**	Return Value:
+**		none
+**
+**	Description:
+**		This function enables the peak detection: for each value retrieved, the minimum and maximum peak registers
+**      (PKHMIN, PKHMAX) read with the convertor / RMS registers are converted too, see DMM_GetPeaks.
+**      The peak values of the previous conversions are cleared.
+**            
+*/
+void DMM_SetPeakDetect(uint8_t f)
+{
+    fPeakDetect = f;
+    dPeakMin = NAN;
+    dPeakMax = NAN;
+}
+
+/***	DMM_GetPeaks
+**
+**	Parameters:
+**      double *pdMin   - pointer to receive the minimum peak value, in the base unit
+**      double *pdMax   - pointer to receive the maximum peak value, in the base unit
+**
+**	Return Value:
+**		uint8_t     - 1 if the peak values are available, 0 if the peak detection is disabled or no value was retrieved yet
+**
+**	Description:
+**		This function returns the peak values of the last conversion, computed with the last value retrieved
+**      when the peak detection is enabled (DMM_SetPeakDetect). The unavailable peak values are NAN.
+**            
+*/
+uint8_t DMM_GetPeaks(double *pdMin, double *pdMax)
+{
+    *pdMin = dPeakMin;
+    *pdMax = dPeakMax;
+    return !isnan(dPeakMin) && !isnan(dPeakMax);
+}
 
 /***	DMM_GetCurrentScale
 **
@@ -428,6 +761,46 @@ double DMM_GetScaleRange(int idxScale)
     double range = dmmcfg[idxScale].range;
     return range;
 }
+
+/***	DMM_GetScaleMode
+**
+**	Parameters:
+**      int idxScale    - the scale index, must be valid
+**
+**	Return Value:
+**		int     - the scale mode: DmmResistance, DmmContinuity, DmmDiode, DmmDCVoltage, DmmACVoltage, 
+**                DmmDCCurrent, DmmACCurrent, DmmDCLowCurrent or DmmACLowCurrent
+**
+**	Description:
+**		This function returns the mode of a scale, the mode field in DMMCFG structure.
+**      Scales of the same mode share the input connection.
+**            
+*/
+int DMM_GetScaleMode(int idxScale)
+{
+    return dmmcfg[idxScale].mode;
+}
+
+/***	DMM_GetCalibAcceptance
+**
+**	Parameters:
+**      int idxScale    - the scale index, must be valid
+**
+**	Return Value:
+**		double  - the narrowest accepted calibration dispersion, in the scale unit
+**
+**	Description:
+**		This function returns the smaller of the calibAcceptP and calibAcceptN fields of the scale, multiplied by the scale range.
+**      It is the deviation from the reference that DMM_CheckAcceptedMeasurementDispersion accepts in both directions,
+**      and it is used to decide when a measurement for calibration is precise enough.
+**            
+*/
+double DMM_GetCalibAcceptance(int idxScale)
+{
+    double dAccept = dmmcfg[idxScale].calibAcceptP < dmmcfg[idxScale].calibAcceptN ? dmmcfg[idxScale].calibAcceptP: dmmcfg[idxScale].calibAcceptN;
+    return dAccept * dmmcfg[idxScale].range;
+}
+
 /***	DMM_SetUseCalib
 **
 **	Parameters:
@@ -772,64 +1145,91 @@ uint8_t DMM_CheckAcceptedMeasurementDispersion(double dMeasuredVal, double dRefV
 **      If dVal is +/- INFINITY (converter values are outside expected range), then "OPEN" string is used for Continuity scale.
 **      The function returns ERRVAL_DMM_IDXCONFIG if the current scale is not valid. 
 **      For example it formats the value 0.0245678912 into the "24.678912 mV" if the current scale is VoltageDC50m.
-**      
+**      If DMM_FORMAT_FAST is 1 the value is formatted by the integer formatter DMM_FormatFixed, otherwise sprintf is used.
+**      The unit text is precomputed for each scale by DMM_Init.
+**                
+*/
+uint8_t DMM_FormatValue(double dVal, char *pString, uint8_t fUnit)
+{
+    return DMM_FormatValueMode(dVal, pString, fUnit, DMM_FORMAT_FAST);
+}
+
+/***	DMM_FormatSelfTest
+**
+**	Parameters:
+**		int *pIdxScale      - pointer to a variable to get the scale of the first mismatch, can be NULL
+**      double *pdVal       - pointer to a variable to get the value of the first mismatch, can be NULL
+**
+**	Return Value:
+**		uint32_t
+**          the number of values for which the integer formatter and sprintf produce different strings
+**
+**	Description:
+**		The function checks the integer formatter used by DMM_FormatValue against sprintf("%.6lf").
+**      For each scale it formats DMM_FORMAT_SELFTESTSTEPS values spread over the -120% .. 120% of the scale range,
+**      values close to the rounding points of the last decimal and the scale range limits, using both methods.
+**      The strings are compared including the unit text.
+**      The scale and value of the first mismatch are returned using pIdxScale and pdVal.
+**      The DMM hardware is not accessed, the current scale is restored before returning.
 **                
 */
-uint8_t DMM_FormatValue(double dVal, char *pString, uint8_t fUnit)
+uint32_t DMM_FormatSelfTest(int *pIdxScale, double *pdVal)
 {
-    // default 6 decimals
-    double dScaleFact;
-    char szUnitPrefix[2], szUnit[5];
-    uint8_t bResult = DMM_ERR_CheckIdxCalib(idxCurrentScale);
-    if(bResult == ERRVAL_SUCCESS)
+    char szFast[50], szRef[50];
+    uint32_t cntErr = 0;
+    int idxScale, i, idxSaved = idxCurrentScale;
+    double dRange, dVal, dStep, dUlp;
+    for(idxScale = 0; idxScale < DMM_CNTSCALES; idxScale++)
     {
-        if (dVal == INFINITY)
+        idxCurrentScale = idxScale;
+        dRange = dmmcfg[idxScale].range;
+        dStep = 2.4 * dRange / DMM_FORMAT_SELFTESTSTEPS;
+        // the last decimal digit in the base unit
+        dUlp = 1 / (dmmunit[idxScale].dScaleFact * dFormatPow10[DMM_FORMAT_DECIMALS]);
+        for(i = 0; i <= DMM_FORMAT_SELFTESTSTEPS; i++)
         {
-            if(dmmcfg[idxCurrentScale].mode == DmmContinuity)
-            {
-                strcpy(pString, "OPEN");
-            }
-            else
+            // sweep the range using a step that is not a round number, then
+            // probe the neighborhood of the rounding point of the last decimal
+            switch(i % 4)
             {
-                strcpy(pString, "OVERLOAD");
+                case 0:
+                    dVal = -1.2 * dRange + i * dStep * 1.000003;
+                    break;
+                case 1:
+                    dVal = ((int64_t)(dVal / dUlp) + 0.5) * dUlp;
+                    break;
+                case 2:
+                    dVal = nextafter(dVal, INFINITY);
+                    break;
+                default:
+                    dVal = -nextafter(dVal, 0);
+                    break;
             }
-        }
-        else
-        {
-            if (dVal == -INFINITY)
+            if(i == DMM_FORMAT_SELFTESTSTEPS)
             {
-                if(dmmcfg[idxCurrentScale].mode == DmmContinuity)
-                {
-                    strcpy(pString, "OPEN");
-                }
-                else
-                {
-                    strcpy(pString, "OVERLOAD");
-                }
+                dVal = (idxScale & 1) ? -dRange : dRange;
             }
-            else
+            DMM_FormatValueMode(dVal, szFast, 1, 1);
+            DMM_FormatValueMode(dVal, szRef, 1, 0);
+            if(strcmp(szFast, szRef))
             {
-                bResult = DMM_GetScaleUnit(idxCurrentScale, &dScaleFact, szUnitPrefix, szUnit);
-                if(bResult == ERRVAL_SUCCESS)
+                if(!cntErr)
                 {
-                    // valid idxScale
-                    dVal *= dScaleFact;
-                    sprintf(pString, "%.6lf", dVal);
-                    if(fUnit)
+                    if(pIdxScale)
+                    {
+                        *pIdxScale = idxScale;
+                    }
+                    if(pdVal)
                     {
-                        strcat(pString, " ");
-                        strcat(pString, szUnitPrefix);
-                        strcat(pString, szUnit);
+                        *pdVal = dVal;
                     }
                 }
+                cntErr++;
             }
         }
-        if(dmmcfg[idxCurrentScale].mode == DmmDiode && dVal > DMM_DIODEOPENTHRESHOLD )
-        {
-            strcpy(pString, "OPEN");        
-        }
     }
-    return bResult;
+    idxCurrentScale = idxSaved;
+    return cntErr;
 }
 
 /***	DMM_InterpretValue
@@ -856,92 +1256,80 @@ uint8_t DMM_FormatValue(double dVal, char *pString, uint8_t fUnit)
 **      The function returns ERRVAL_CMD_VALWRONGUNIT if the measure unit does not match the current scale base Unit (V, A or Ohm).
 **      The function returns ERRVAL_CMD_VALFORMAT if the numeric value cannot be extracted from the provided string.
 **      For example it interprets the string "24.678912 mV" and returns the value 0.0245678912 if the current scale is any of the Voltage scales.
+**      The function calls DMM_InterpretValueEx, the string is not modified.
 **                 
 */
 uint8_t DMM_InterpretValue(char *pString, double *pdVal)
 {
-    double dScaleFact;
-    int szLen = strlen(pString), szLenUnit;
-    char szUnitPrefix[2], szUnit[5];
-    uint8_t bResult = ERRVAL_SUCCESS;
-    // trim the blank values at the end of the string
-    while(pString[szLen - 1] == ' ')
+    return DMM_InterpretValueEx(pString, pdVal, NULL);
+}
+
+/***	DMM_InterpretValueEx
+**
+**	Parameters:
+**		const char *pString     - The string to be interpreted
+**      double *pdVal           - Pointer to a variable to get the value
+**      int *pIdxErr            - Pointer to a variable to get the position of the first wrong character, can be NULL
+**
+**	Return Value:
+**		uint8_t 
+**          ERRVAL_SUCCESS                  0       // success
+**          ERRVAL_DMM_IDXCONFIG            0xFC    // wrong scale index
+**          ERRVAL_CMD_VALWRONGUNIT         0xF4    // The provided value has a wrong measure unit.
+**          ERRVAL_CMD_VALFORMAT            0xF2    // The numeric value cannot be extracted from the provided string.
+**
+**	Description:
+**		The function interprets a value according to the current selected scale, see DMM_InterpretValue.
+**      The string is parsed in a single pass by NUMPARSE_ParseValue, using the base Unit of the current scale.
+**      Besides the u, m, k, M prefixes, the n and G prefixes and the exponent notation (for example "2.5e-3 V") are accepted.
+**      The string is not modified.
+**      On error, *pIdxErr is set to the position (0 based) of the first character that cannot be interpreted, 
+**      or to -1 if the error is not related to a position.
+**                 
+*/
+uint8_t DMM_InterpretValueEx(const char *pString, double *pdVal, int *pIdxErr)
+{
+    return DMM_InterpretScaleValueEx(idxCurrentScale, pString, pdVal, pIdxErr);
+}
+
+/***	DMM_InterpretScaleValueEx
+**
+**	Parameters:
+**		int idxScale            - the scale index
+**		const char *pString     - The string to be interpreted
+**      double *pdVal           - Pointer to a variable to get the value
+**      int *pIdxErr            - Pointer to a variable to get the position of the first wrong character, can be NULL
+**
+**	Return Value:
+**		uint8_t 
+**          ERRVAL_SUCCESS                  0       // success
+**          ERRVAL_DMM_IDXCONFIG            0xFC    // wrong scale index
+**          ERRVAL_CMD_VALWRONGUNIT         0xF4    // The provided value has a wrong measure unit.
+**          ERRVAL_CMD_VALFORMAT            0xF2    // The numeric value cannot be extracted from the provided string.
+**
+**	Description:
+**		The function interprets a value according to the specified scale, the same way as DMM_InterpretValueEx 
+**      does for the current scale. It is used for values of scales that are not configured yet.
+**                 
+*/
+uint8_t DMM_InterpretScaleValueEx(int idxScale, const char *pString, double *pdVal, int *pIdxErr)
+{
+    uint8_t bResult = DMM_ERR_CheckIdxCalib(idxScale);
+    if(pIdxErr)
     {
-        pString[szLen - 1] = 0;
-        szLen --;
+        *pIdxErr = -1;
     }
-    if( !strcmp(pString, "OVERLOAD") || !strcmp(pString, "OPEN"))
+    if(NUMPARSE_MatchToken(pString, "OVERLOAD") || NUMPARSE_MatchToken(pString, "OPEN"))
     {
         *pdVal = INFINITY;
+        bResult = ERRVAL_SUCCESS;
     }
     else
     {
-        bResult = DMM_GetScaleUnit(idxCurrentScale, &dScaleFact, szUnitPrefix, szUnit);
         if(bResult == ERRVAL_SUCCESS)
         {
-            // valid idxScale
-            if(!(pString[szLen - 1] >= '0' && pString[szLen - 1] <= '9'))
-            {
-                // the string does not end with numeric char, it contains Unit.
-                dScaleFact = 1;
-                // look for the szUnit at the end of the provided string
-                szLenUnit = strlen(szUnit);
-                if(!strcmp(szUnit, pString + szLen - szLenUnit))
-                {
-                    szLen -= szLenUnit; // remove Unit length
-                    // look for any multiple / submultiple prefix before the Unit
-                    switch(pString[szLen - 1])
-                    {
-                        case 'u':
-                            dScaleFact = 1e6;
-                            szLen--;    // remove prefix length
-                            break;
-                        case 'm':
-                            dScaleFact = 1e3;
-                            szLen--;    // remove prefix length
-                            break;
-                        case 'k':
-                            dScaleFact = 1e-3;
-                            szLen--;    // remove prefix length
-                            break;
-                        case 'M':
-                            dScaleFact = 1e-6;
-                            szLen--;    // remove prefix length
-                            break;
-                    }
-                }
-                else
-                {
-                    // wrong Unit
-                    bResult = ERRVAL_CMD_VALWRONGUNIT;
-                }
-            }   // end check for measure unit
-            else
-            {
-                // the last character is numeric, missing measure unit
-                // use the scale unit / multiple which are already set after call to DMM_GetScaleUnit
-            }
-            if(bResult == ERRVAL_SUCCESS)
-            {
-                // trim the string to eliminate Unit Prefix and Unit
-                pString[szLen] = 0;
-                // trim the blank values at the end of the string
-                while(pString[szLen - 1] == ' ')
-                {
-                    pString[szLen - 1] = 0;
-                    szLen --;
-                }            
-                // extract the value
-                if(sscanf(pString, "%lf", pdVal))
-                {
-                    *pdVal /= dScaleFact;
-                }
-                else
-                {
-                    // the double value cannot be extracted from string
-                    bResult = ERRVAL_CMD_VALFORMAT;
-                }
-            }
+            // when the unit is missing, the value is expressed in the prefixed unit of the scale
+            bResult = NUMPARSE_ParseValue(pString, dmmunit[idxScale].szBaseUnit, dmmunit[idxScale].expPrefix, pdVal, pIdxErr);
         }
     }
     return bResult;
@@ -1017,11 +1405,27 @@ void DMM_ConfigSwitches(uint8_t sw)
 **      It activates DMM Slave Select pin, sends the command byte, and the specified 
 **      number of bytes from pbWrData, using the SPI_CoreTransferByte function.
 **      Finally it deactivates the DMM Slave Select pin.
+**      The queued asynchronous transactions are finished before.
+**      When the asynchronous engine plays the transactions through DMA (SPIDMA_ENABLE), the command is queued to the engine
+**      and the function waits for its completion.
 **          
 */
 void DMM_SendCmdSPI(uint8_t bCmd, int bytesNumber, uint8_t *pbWrData)
 {
     int i;
+#if SPIDMA_ENABLE
+    SPI_XFER xfer;
+    if(SPI_AsyncIsDma())
+    {
+        DMM_InitXfer(&xfer, bCmd, 0, bytesNumber, pbWrData);
+        if(SPI_AsyncQueue(&xfer) == ERRVAL_SUCCESS)
+        {
+            while(!xfer.fDone);
+            return;
+        }
+    }
+#endif
+    SPI_AsyncWaitIdle();
     GPIO_SetValue_CS_DMM(0); // Activate CS_DMM
 
     DelayAprox10Us(10);   
@@ -1053,11 +1457,27 @@ void DMM_SendCmdSPI(uint8_t bCmd, int bytesNumber, uint8_t *pbWrData)
 **      It activates DMM Slave Select pin, sends the command byte, 
 **      and then retrieves the specified number of bytes into pbRdData, using the SPI_CoreTransferByte function.      
 **      Finally it deactivates the DMM Slave Select pin.
+**      The queued asynchronous transactions are finished before.
+**      When the asynchronous engine plays the transactions through DMA (SPIDMA_ENABLE), the command is queued to the engine
+**      and the function waits for its completion.
 **          
 */
 void DMM_GetCmdSPI(uint8_t bCmd, int bytesNumber, uint8_t *pbRdData)
 {
     int i;
+#if SPIDMA_ENABLE
+    SPI_XFER xfer;
+    if(SPI_AsyncIsDma())
+    {
+        DMM_InitXfer(&xfer, bCmd, 1, bytesNumber, pbRdData);
+        if(SPI_AsyncQueue(&xfer) == ERRVAL_SUCCESS)
+        {
+            while(!xfer.fDone);
+            return;
+        }
+    }
+#endif
+    SPI_AsyncWaitIdle();
 
     GPIO_SetValue_CS_DMM(0); // Activate CS_DMM
     DelayAprox10Us(10);
@@ -1106,9 +1526,6 @@ void DMM_GetCmdSPI(uint8_t bCmd, int bytesNumber, uint8_t *pbRdData)
 */
 double DMM_DGetStatus(uint8_t *pbErr)
 {
-    int i;
-    double v;
-    v = NAN;
     // 1. Verify index
     uint8_t bResult = DMM_ERR_CheckIdxCalib(idxCurrentScale);
     if(bResult != ERRVAL_SUCCESS)
@@ -1131,9 +1548,97 @@ double DMM_DGetStatus(uint8_t *pbErr)
     DMM_GetCmdSPI(bCmd, sizeof(dmmsts), (uint8_t *)&dmmsts);
     
     // 3. Compute value, according to the specific scale
-    
+    if(pbErr)
+    {
+        *pbErr = ERRVAL_SUCCESS;
+    }    
+    return DMM_ComputeStatus(&dmmsts);
+}
+
+/***	DMM_QueueStatusRead
+**
+**	Parameters:
+**      none
+**
+**	Return Value:
+**		uint8_t 
+**          ERRVAL_SUCCESS           0       // success, the read is queued
+**          ERRVAL_DMM_IDXCONFIG     0xFC    // error, wrong current scale index
+**          ERRVAL_SPI_ASYNC         0xEB    // the read cannot be queued
+**	Description:
+**		This function queues the asynchronous read of the convertor / RMS registers (0-0x1F) in dmmstsAsync.
+**      The transaction is the same as the one performed by DMM_GetCmdSPI: command byte, extra read clock, 32 bytes.
+**      xferStatus.fDone is set when the registers are received.
+**            
+*/
+uint8_t DMM_QueueStatusRead()
+{
+    uint8_t bResult = DMM_ERR_CheckIdxCalib(idxCurrentScale);
+    if(bResult != ERRVAL_SUCCESS)
+    {
+        return bResult;
+    }
+    // read, starting with 0 address
+    DMM_InitXfer(&xferStatus, 1, 1, sizeof(dmmstsAsync), (uint8_t *)&dmmstsAsync);
+    return SPI_AsyncQueue(&xferStatus);
+}
+
+/***	DMM_InitXfer
+**
+**	Parameters:
+**      SPI_XFER *pXfer     - the asynchronous transaction to be initialized
+**		uint8_t bCmd        - the command byte
+**		uint8_t fRead       - 1 for a read command (extra read clock, bytes received), 0 for a write command
+**		int bytesNumber     - the number of data bytes
+**		uint8_t *pbData     - the data bytes
+**
+**	Return Value:
+**		none
+**	Description:
+**		This function initializes an asynchronous transaction equivalent to DMM_GetCmdSPI (fRead = 1)
+**      or DMM_SendCmdSPI (fRead = 0).
+**            
+*/
+void DMM_InitXfer(SPI_XFER *pXfer, uint8_t bCmd, uint8_t fRead, int bytesNumber, uint8_t *pbData)
+{
+    memset(pXfer, 0, sizeof(SPI_XFER));
+    pXfer->dwCsMask = GPIO_Mask_CS_DMM;
+    pXfer->bCsActive = 0;
+    pXfer->cTicksCs = 100 / SPI_ASYNC_TICKUS;  // same as DelayAprox10Us(10)
+    pXfer->wCmd = bCmd;
+    pXfer->cbCmdBits = 8;
+    pXfer->fReadClock = fRead;
+    pXfer->fRead = fRead;
+    pXfer->pbData = pbData;
+    pXfer->cbData = bytesNumber;
+}
+
+/***	DMM_ComputeStatus
+**
+**	Parameters:
+**      DMMSTS *pDmmsts - the values of the convertor / RMS registers (0-0x1F)
+**
+**	Return Value:
+**		double 
+**          the value computed according to the convertor / RMS registers values, or
+**          NAN (not a number) value if the convertor / RMS registers value is not ready, or
+**          +/- INFINITY if the convertor / RMS registers values are outside the expected range.
+**	Description:
+**		This function computes the value corresponding to the convertor / RMS registers, according to the current selected scale,
+**      which must be valid. It is called by DMM_DGetStatus and, for the asynchronous reads, by DMM_DGetValueStep.
+**      Depending on the parameter set by DMM_SetUseCalib (default is 1), calibration parameters and the temperature
+**      compensation factor will be applied on the computed value.
+**      When the peak detection is enabled (DMM_SetPeakDetect) and the conversion is done, the peak registers are converted
+**      by DMM_ComputePeak, see DMM_GetPeaks.
+**            
+*/
+double DMM_ComputeStatus(DMMSTS *pDmmsts)
+{
+    int i;
+    double v = NAN;
+
     // AD1 signed value
-    int32_t vad1 = (dmmsts.ad1[2]<<24)|(dmmsts.ad1[1]<<16)|(dmmsts.ad1[0]<<8);
+    int32_t vad1 = (pDmmsts->ad1[2]<<24)|(pDmmsts->ad1[1]<<16)|(pDmmsts->ad1[0]<<8);
     vad1 /= 256;
 
     // RMS for AC
@@ -1141,17 +1646,17 @@ double DMM_DGetStatus(uint8_t *pbErr)
     for(i = 0; i < 5; i++)
     {
         vrms <<= 8;
-        vrms |= dmmsts.rms[4-i];
+        vrms |= pDmmsts->rms[4-i];
     }
 
     if(DMM_FACScale(idxCurrentScale))
     { // AC uses RMS
-        if(dmmsts.intf & 0x10)
+        if(pDmmsts->intf & 0x10)
         { // conversion done
             if(fUseCalib)
             { 
                 // apply calibration coefficients
-                v = sqrt(fabs(pow(dmmcfg[idxCurrentScale].mul,2)*(double)(vrms) - pow(calib.Dmm[idxCurrentScale].Add,2)))*(1.0+calib.Dmm[idxCurrentScale].Mult);
+                v = sqrt(fabs(pow(dmmcfg[idxCurrentScale].mul,2)*(double)(vrms) - pow(calib.Dmm[idxCurrentScale].Add,2)))*(1.0+calib.Dmm[idxCurrentScale].Mult)*dTempFactor;
             }
             else
             {
@@ -1165,7 +1670,7 @@ double DMM_DGetStatus(uint8_t *pbErr)
     }
     else
     { // AD1 value
-        if(dmmsts.intf & 0x04)
+        if(pDmmsts->intf & 0x04)
         { // conversion done
             if(vad1 >= 0x7FFFFE)
             {
@@ -1183,7 +1688,7 @@ double DMM_DGetStatus(uint8_t *pbErr)
                     if(fUseCalib)
                     {
                        // apply calibration coefficients
-                       v = v*(1.0+calib.Dmm[idxCurrentScale].Mult) + calib.Dmm[idxCurrentScale].Add;
+                       v = (v*(1.0+calib.Dmm[idxCurrentScale].Mult) + calib.Dmm[idxCurrentScale].Add)*dTempFactor;
                     }
                 }   
             }
@@ -1193,43 +1698,241 @@ double DMM_DGetStatus(uint8_t *pbErr)
             v = NAN; // not ready
         }
     }
-    if(pbErr)
+    if(fPeakDetect && !isnan(v))
     {
-        *pbErr = ERRVAL_SUCCESS;
-    }    
+        dPeakMin = DMM_ComputePeak(pDmmsts->pkhmin);
+        dPeakMax = DMM_ComputePeak(pDmmsts->pkhmax);
+    }
     return v;
 }
 
-/***	DMM_CompensateVoltage50DCLinear
+/***	DMM_ComputePeak
 **
 **	Parameters:
-**      double dVal - The value to be compensated
+**      uint8_t *pbReg  - the value of a peak register (PKHMIN or PKHMAX), 3 bytes
 **
 **	Return Value:
 **		double 
-**          the compensated value
+**          the peak value, in the base unit, or
+**          +/- INFINITY if the peak is outside the convertor range.
+**	Description:
+**		This function computes the value corresponding to a peak register, according to the current selected scale.
+**      The register is a signed 24 bits sample, as AD1, and it is converted by the mul factor of the scale.
+**      Depending on the parameter set by DMM_SetUseCalib, the calibration is applied:
+**      - on the DC scales as on the AD1 value.
+**      - on the AC scales only the gain and the temperature compensation factor: the calibration offset is removed
+**        from the RMS value in quadrature, it is not an offset of the samples.
+**      As in DMM_DGetValueStep, the correction of the scale (CORR module) is applied whether the calibration is used or not.
+**            
+*/
+double DMM_ComputePeak(uint8_t *pbReg)
+{
+    double v;
+    int32_t vpk = (pbReg[2]<<24)|(pbReg[1]<<16)|(pbReg[0]<<8);
+    vpk /= 256;
+    if(vpk >= 0x7FFFFE)
+    {
+        return INFINITY;   // value outside convertor range
+    }
+    if(vpk <= -0x7FFFFE)
+    {
+        return -INFINITY;   // value outside convertor range
+    }
+    v = dmmcfg[idxCurrentScale].mul*vpk;
+    if(fUseCalib)
+    {
+        if(DMM_FACScale(idxCurrentScale))
+        {
+            v = v*(1.0+calib.Dmm[idxCurrentScale].Mult)*dTempFactor;
+        }
+        else
+        {
+            v = (v*(1.0+calib.Dmm[idxCurrentScale].Mult) + calib.Dmm[idxCurrentScale].Add)*dTempFactor;
+        }
+    }
+    if(pCorrCurrent)
+    {
+        // compensate the not linear scale behavior
+        v = CORR_Apply(pCorrCurrent, v);
+    }
+    return v;
+}
+
+/***	DMM_InitScaleUnits
+**
+**	Parameters:
+**      <none>
+**
+**	Return Value:
+**		none
 **
 **	Description:
-**		This function compensates the not linear behavior of VoltageDC50 scale.
-**      It gets as parameter the value after the normal calibration coefficients were applied. 
-**      It computes the compensated value as P3*dVal^3 + P1*dVal + P0, where P3, P2 and P0 are third power polynomial
-**      coefficients defined in dmm.h: DMM_Voltage50DCLinearCoeff_P3, DMM_Voltage50DCLinearCoeff_P1 and DMM_Voltage50DCLinearCoeff_P0.
-**      It returns the compensated value.
-**      
+**		This function computes the unit data for each scale: the scale factor, the unit text, containing
+**      a leading space, the unit prefix and the unit (for example " mV"), the unit without prefix and the power of 10 
+**      corresponding to the prefix.
+**      The data is stored in the dmmunit array, so that DMM_FormatValue does not need to call DMM_GetScaleUnit and
+**      concatenate strings for each formatted value, and DMM_InterpretValueEx does not need to call DMM_GetScaleUnit.
+**      It is called by DMM_Init().
 **            
 */
-double DMM_CompensateVoltage50DCLinear(double dVal)
+void DMM_InitScaleUnits()
 {
-    double dCompensatedVal;
-    if(!DMM_IsNotANumber(dVal))
+    int idxScale;
+    char szUnitPrefix[2], szUnit[5];
+    for(idxScale = 0; idxScale < DMM_CNTSCALES; idxScale++)
     {
-       dCompensatedVal = dVal * dVal * dVal * DMM_Voltage50DCLinearCoeff_P3 + dVal * DMM_Voltage50DCLinearCoeff_P1 + dVal * DMM_Voltage50DCLinearCoeff_P0;
+        DMM_GetScaleUnit(idxScale, &dmmunit[idxScale].dScaleFact, szUnitPrefix, szUnit);
+        strcpy(dmmunit[idxScale].szUnit, " ");
+        strcat(dmmunit[idxScale].szUnit, szUnitPrefix);
+        strcat(dmmunit[idxScale].szUnit, szUnit);
+        strcpy(dmmunit[idxScale].szBaseUnit, szUnit);
+        dmmunit[idxScale].expPrefix = NUMPARSE_GetPrefixExp(szUnitPrefix[0]);
     }
-    else
+}
+
+/***	DMM_FormatValueMode
+**
+**	Parameters:
+**		double dVal         - The value to be formatted
+**      char *pString       - The string to get the formatted value
+**      uint8_t fUnit       - flag to indicate if unit information should be added
+**              0       - do not add unit
+**              not 0   - add unit / subunit
+**      uint8_t fFast       - flag to select the formatting method
+**              0       - use sprintf
+**              not 0   - use the integer formatter DMM_FormatFixed
+**
+**	Return Value:
+**		uint8_t 
+**          ERRVAL_SUCCESS                  0       // success
+**          ERRVAL_DMM_IDXCONFIG            0xFC    // wrong scale index
+**
+**	Description:
+**		The function implements DMM_FormatValue. See DMM_FormatValue for the output format.
+**      The unit data is taken from the dmmunit array computed by DMM_InitScaleUnits.
+**      Both formatting methods produce the same string, the fFast parameter is used by DMM_FormatSelfTest to compare them.
+**      
+*/
+uint8_t DMM_FormatValueMode(double dVal, char *pString, uint8_t fUnit, uint8_t fFast)
+{
+    char *pEnd;
+    uint8_t bResult = DMM_ERR_CheckIdxCalib(idxCurrentScale);
+    if(bResult == ERRVAL_SUCCESS)
+    {
+        if (dVal == INFINITY || dVal == -INFINITY)
+        {
+            if(dmmcfg[idxCurrentScale].mode == DmmContinuity)
+            {
+                strcpy(pString, "OPEN");
+            }
+            else
+            {
+                strcpy(pString, "OVERLOAD");
+            }
+        }
+        else
+        {
+            dVal *= dmmunit[idxCurrentScale].dScaleFact;
+            if(fFast)
+            {
+                pEnd = DMM_FormatFixed(dVal, pString);
+            }
+            else
+            {
+                pEnd = pString + sprintf(pString, "%.*lf", DMM_FORMAT_DECIMALS, dVal);
+            }
+            if(fUnit)
+            {
+                strcpy(pEnd, dmmunit[idxCurrentScale].szUnit);
+            }
+        }
+        if(dmmcfg[idxCurrentScale].mode == DmmDiode && dVal > DMM_DIODEOPENTHRESHOLD )
+        {
+            strcpy(pString, "OPEN");        
+        }
+    }
+    return bResult;
+}
+
+/***	DMM_FormatFixed
+**
+**	Parameters:
+**		double dVal         - The value to be formatted
+**      char *pString       - The string to get the formatted value
+**
+**	Return Value:
+**		char *
+**          pointer to the terminating 0 character of the formatted string
+**
+**	Description:
+**		The function formats a value with DMM_FORMAT_DECIMALS decimals, producing the same text as sprintf("%.6lf").
+**      The value is multiplied by 10^DMM_FORMAT_DECIMALS and rounded to an integer, which is then converted to digits 
+**      using integer operations.
+**      The rounding error of the multiplication is computed exactly (Dekker product), so that the values placed 
+**      close to the half of the last decimal are rounded like sprintf does: to nearest, ties to even.
+**      The multiplication must not be contracted into a fused multiply-add, this is the case for the Cortex-A9 VFPv3 unit.
+**      The sign is printed for negative values, including those rounded to 0 (for example "-0.000000").
+**      Not a number values and values whose absolute value exceeds DMM_FORMAT_FASTMAX are formatted using sprintf.
+**      
+*/
+char *DMM_FormatFixed(double dVal, char *pString)
+{
+    const double dSplit = 134217729.0;   // 2^27 + 1
+    const double dPow = dFormatPow10[DMM_FORMAT_DECIMALS];
+    double dAbs = fabs(dVal), dProd, dErr, dHi, dLo, dInt, dTie;
+    uint64_t qwScaled;
+    uint32_t dwInt, dwFrac;
+    char rgDigits[12];
+    int i, cDigits;
+    char *pCh = pString;
+    if(isnan(dVal) || dAbs > DMM_FORMAT_FASTMAX)
+    {
+        return pString + sprintf(pString, "%.*lf", DMM_FORMAT_DECIMALS, dVal);
+    }
+    // exact product dAbs * dPow = dProd + dErr, dPow has less than 27 significant bits
+    dProd = dAbs * dPow;
+    dHi = dSplit * dAbs;
+    dHi = dHi - (dHi - dAbs);
+    dLo = dAbs - dHi;
+    dErr = (dHi * dPow - dProd) + dLo * dPow;
+    // round to nearest, ties to even
+    dInt = floor(dProd);
+    dTie = (dProd - dInt - 0.5) + dErr;
+    qwScaled = (uint64_t)dInt;
+    if(dTie > 0 || (dTie == 0 && (qwScaled & 1)))
+    {
+        qwScaled++;
+    }
+    dwInt = (uint32_t)(qwScaled / (uint32_t)dPow);
+    dwFrac = (uint32_t)(qwScaled - (uint64_t)dwInt * (uint32_t)dPow);
+    if(signbit(dVal))
+    {
+        *pCh++ = '-';
+    }
+    // integer part
+    cDigits = 0;
+    do
+    {
+        rgDigits[cDigits++] = '0' + dwInt % 10;
+        dwInt /= 10;
+    }while(dwInt);
+    while(cDigits)
     {
-        dCompensatedVal = dVal;
+        *pCh++ = rgDigits[--cDigits];
+    }
+    // decimals, including the leading zeros
+    if(DMM_FORMAT_DECIMALS)
+    {
+        *pCh++ = '.';
+        for(i = DMM_FORMAT_DECIMALS - 1; i >= 0; i--)
+        {
+            pCh[i] = '0' + dwFrac % 10;
+            dwFrac /= 10;
+        }
+        pCh += DMM_FORMAT_DECIMALS;
     }
-    return dCompensatedVal;
+    *pCh = 0;
+    return pCh;
 }
 /* *****************************************************************************
  End of File
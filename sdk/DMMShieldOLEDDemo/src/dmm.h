@@ -60,10 +60,17 @@ extern "C" {
 #define DMM_VALIDDATA_CNTTIMEOUT    0x100   // number of valid data retrieval re-tries
 #define DMMVoltageDC50Scale          7
     
+// default correction of the VoltageDC50 scale (CORR module): P3*v^3 + (P1 + P0)*v
 #define DMM_Voltage50DCLinearCoeff_P3   -1.59128E-06
 #define DMM_Voltage50DCLinearCoeff_P1   1.003918916
 #define DMM_Voltage50DCLinearCoeff_P0   0.000196999
 
+// value formatting
+#define DMM_FORMAT_FAST             1       // 1 - DMM_FormatValue uses the integer formatter, 0 - it uses sprintf("%.6lf")
+#define DMM_FORMAT_DECIMALS         6       // number of decimals used when formatting values
+#define DMM_FORMAT_FASTMAX          4e9     // scaled absolute values above this limit are formatted using sprintf
+#define DMM_FORMAT_SELFTESTSTEPS    2000    // number of values checked for each scale by DMM_FormatSelfTest
+
     
     
     
@@ -121,9 +128,39 @@ typedef struct _PARTCALIB{
 typedef struct _CALIBDATA{    //
     uint8_t magic;
     CALIB      Dmm[DMM_CNTSCALES];    // 27*2  54
-    uint8_t crc;
+    uint8_t crc;                      // check byte of the formats 1 and 2, 0 for format 3 (the CRC-16 is in CALIBHDR)
 }  __attribute__((__packed__)) CALIBDATA;
 
+// header of the user calibration, stored just before CALIBDATA
+#define CALIB_TEMP_NONE     INT16_MIN   // the calibration temperature is unknown
+typedef struct _CALIBHDR{    //
+    int16_t temp;       // die temperature (1/100 Celsius) when the calibration coefficients were computed
+    uint16_t crc;       // CRC-16 of temp and of the CALIBDATA bytes before its check byte, when CALIBDATA is in format 3
+}  __attribute__((__packed__)) CALIBHDR;
+
+// journal of the user calibration save: the scale being saved, stored before the calibration header
+typedef struct _CALIBJRNL{    //
+    uint8_t magic;      // EPROM_MAGIC_CRC16
+    int8_t idxScale;    // scale being saved
+    CALIB Dmm;          // new calibration coefficients of the scale
+    int16_t temp;       // calibration temperature of the header after the save
+    uint16_t crcHdr;    // CRC-16 of the header after the save, it also checks the journal
+}  __attribute__((__packed__)) CALIBJRNL;
+
+// temperature coefficients of the scales, stored with the user calibration
+#define CALIB_TEMPCOEFF_CNTSLOTS    2       // maximum number of scales having a temperature coefficient at the same time
+typedef struct _TEMPCOEFF{    //
+    int8_t idxScale;    // scale using the coefficient, -1 for a free slot
+    int16_t coeff;      // temperature coefficient (1/100 ppm / Celsius)
+}  __attribute__((__packed__)) TEMPCOEFF;
+
+typedef struct _TEMPCOEFFDATA{    //
+    uint8_t magic;
+    TEMPCOEFF rgCoeffs[CALIB_TEMPCOEFF_CNTSLOTS];   // 2*3  6
+    uint8_t bReserved;                              // the record is a whole number of words
+    uint16_t crc;
+}  __attribute__((__packed__)) TEMPCOEFFDATA;
+
 
 typedef struct _PARTCALIBDATA{    //
     PARTCALIB  DmmPartCalib[DMM_CNTSCALES];    // stores the data needed to the calibration
@@ -142,17 +179,33 @@ void DMM_Init();
 
 // configuration functions
 uint8_t DMM_SetScale(int idxScale);
+uint8_t DMM_SetScaleStart(int idxScale);
+uint8_t DMM_SetScaleStep(unsigned int *pt10usWait);
+uint8_t DMM_SetScaleIdx(int idxScale);
+void DMM_UpdateCorrection();
+void DMM_SetTempFactor(double dFactor);
+void DMM_SetPeakDetect(uint8_t f);
 int DMM_GetCurrentScale();
 double DMM_GetScaleRange(int idxScale);
+int DMM_GetScaleMode(int idxScale);
+double DMM_GetCalibAcceptance(int idxScale);
 
 
 // value functions
 double DMM_DGetValue(uint8_t *pbErr);
 double DMM_DGetAvgValue(int cbSamples, uint8_t *pbErr);
+void DMM_DGetValueStart();
+uint8_t DMM_DGetValueStep(double *pdVal);
+uint8_t DMM_DGetAvgValueStart(int cbSamples);
+uint8_t DMM_DGetAvgValueStep(double *pdVal);
 void DMM_SetUseCalib(uint8_t f);
+uint8_t DMM_GetPeaks(double *pdMin, double *pdMax);
 uint8_t DMM_CheckAcceptedMeasurementDispersion(double dMeasuredVal, double dRefVal, double *pDispersion);
 uint8_t DMM_FormatValue(double dVal, char *pString, uint8_t fUnit);
 uint8_t DMM_InterpretValue(char *pString, double *pdVal);
+uint8_t DMM_InterpretValueEx(const char *pString, double *pdVal, int *pIdxErr);
+uint8_t DMM_InterpretScaleValueEx(int idxScale, const char *pString, double *pdVal, int *pIdxErr);
+uint32_t DMM_FormatSelfTest(int *pIdxScale, double *pdVal);
 
 uint8_t DMM_FDCCurrentScale();
     /* Provide C++ Compatibility */
@@ -14,6 +14,9 @@
         The module also provides an initialization function, that initializes the above mentioned modules
         whose functions are called from within the command interpreter function.
         The module also initializes a PmodOLED and implements displaying the basic DMM information on the PmodOLED.
+        The long operations (scale configuration, average measurement, calibration measurements) are started by the command 
+        and completed by DMMCMD_StepPendingCmd, either in a loop (DMMCMD_USE_SCHED 0) or by the acquisition task of the 
+        cooperative scheduler (DMMCMD_USE_SCHED 1), which also runs the command reception, UART transmission and display tasks.
         The "Interface functions" section groups functions that can also be called by User.
         The "Local functions" section groups low level functions that are only called from within the current module.
 		In order to successfully communicate you must set your terminal to 115200 Baud, 8 data bits, 1 stop bit, no parity, and configure the transmitted content to be followed by CR+LF
@@ -29,15 +32,34 @@
 
  */
 
+#include <math.h>
 #include "xparameters.h"
 #include "dmmcmd.h"
 #include "errors.h"
 #include "serialno.h"
 #include "dmm.h"
 #include "calib.h"
+#include "eprom.h"
 #include "uart.h"
 #include "utils.h"
 #include "PmodOLED.h"
+#include "amp.h"
+#include "sched.h"
+#include "timer.h"
+#include "spi.h"
+#include "oleddisp.h"
+#include "bigfont.h"
+#include "trend.h"
+#include "corr.h"
+#include "calseq.h"
+#include "xadc.h"
+#include "trig.h"
+#include "limit.h"
+#include "mode.h"
+
+#if DMMCMD_USE_SCHED && AMP_ENABLE
+#error "The AMP configuration requires DMMCMD_USE_SCHED 0"
+#endif
 
 #define MAX_CMD_LENGTH			100
 
@@ -65,7 +87,26 @@ const cmd_map_t uartCommands[] = {
 	{"DMMFinalizeCalibP",	CMD_FinalizeCalibP},
 	{"DMMFinalizeCalibN",   CMD_FinalizeCalibN},
 	{"DMMRestoreFactCalibs",CMD_RestoreFactCalibs},
-	{"DMMReadSerialNo",   	CMD_ReadSerialNo}
+	{"DMMReadSerialNo",   	CMD_ReadSerialNo},
+	{"DMMSchedStats",   	CMD_SchedStats},
+	{"DMMDisplayStats",   	CMD_DisplayStats},
+	{"DMMDisplayTrend",   	CMD_DisplayTrend},
+	{"DMMRevalidateEPROM",	CMD_RevalidateEPROM},
+	{"DMMImportCorr",		CMD_ImportCorr},
+	{"DMMCalSeqAdd",		CMD_CalSeqAdd},
+	{"DMMCalSeqClear",		CMD_CalSeqClear},
+	{"DMMCalSeqStart",		CMD_CalSeqStart},
+	{"DMMCalSeqContinue",	CMD_CalSeqContinue},
+	{"DMMCalSeqAbort",		CMD_CalSeqAbort},
+	{"DMMGetTemp",			CMD_GetTemp},
+	{"DMMSetTempCoeff",		CMD_SetTempCoeff},
+	{"DMMTrigConfig",		CMD_TrigConfig},
+	{"DMMTrigArm",			CMD_TrigArm},
+	{"DMMSetLimit",			CMD_SetLimit},
+	{"DMMLimitMonitor",		CMD_LimitMonitor},
+	{"DMMMode",				CMD_Mode},
+	{"DMMModeReset",		CMD_ModeReset},
+	{"DMMModeGet",			CMD_ModeGet}
 };
 
 const char rgScales[][20] = {"Resistance50M", "Resistance5M", "Resistance500k", "Resistance50k", "Resistance5k", "Resistance500", "Resistance50",
@@ -75,6 +116,10 @@ const char rgScales[][20] = {"Resistance50M", "Resistance5M", "Resistance500k",
                          "Continuity", "Diode",
                          "CurrentDC500m", "CurrentDC50m", "CurrentDC5m", "CurrentDC500u",
                          "CurrentAC500m", "CurrentAC50m", "CurrentAC5m", "CurrentAC500u"};
+const char rgCalSeqTypes[][10] = {"zero", "positive", "negative"};    // indexed by CALIB_MEASURE_ type
+const char rgTrigTypes[][10] = {"Level", "Rising", "Falling", "Window", "Overload"};    // indexed by TRIG_TYPE_ type
+const char rgLimitStates[][10] = {"Normal", "High", "Low"};    // indexed by LIMIT_STATE_ state
+const char rgModes[][10] = {"None", "MinMax", "Hold", "Rel", "Peak"};    // indexed by MODE_ mode
 /********************* Global Variables Definitions ***************************/
 char szMsg[200];
 
@@ -85,18 +130,60 @@ char *pszLastErr;
 char szVal[20];
 char szRefVal[20];
 double dRefVal, dMeasuredVal, dispersion;
+double dPeakMin = NAN, dPeakMax = NAN;     // peak values of the conversion of dMeasuredVal, NAN when the peak detection is disabled
+int idxErrPos;  // position of the wrong character when interpreting values
 
 
 // flags for repeated value and repeated raw value
 uint8_t fRepGetVal = 0;
 uint8_t fRepGetRaw = 0;
 uint8_t fRepBlock = 0;
+// the DMMMeasureRep session values are passed to the trigger engine (DMMTrigArm) instead of being sent
+uint8_t fTrigActive = 0;
+int idxTrigReport;      // index of the next captured value to be reported, -1 before the capture header
+// the DMMMeasureRep session values are only checked against the limits (DMMLimitMonitor), only the alarms are sent
+uint8_t fLimitMonitor = 0;
+
+// command whose long operation is in progress, completed by DMMCMD_StepPendingCmd
+cmd_key_t keyPendingCmd = CMD_NONE;
+int idxPendingScale;    // scale being configured by the pending DMMConfig command
+
+// scheduler tasks
+uint8_t fUseTasks = 0;          // the work is performed by the scheduler tasks, set by DMMCMD_InitTasks
+int idTaskAcq, idTaskRx, idTaskTx, idTaskDisp, idTaskEprom, idTaskTemp;
+uint8_t fAcqInProgress = 0;     // a repeated measurement value retrieval is in progress
+
+// background calibration save, started by DMMSaveEPROM when the tasks are used
+volatile uint8_t fSaveDone = 0;     // the save is finished, the result is to be reported by DMMCMD_TaskEprom
+uint8_t bSaveResult;                // result of the save
+volatile uint8_t fLimitSaveDone = 0;    // the limits save started by DMMSetLimit is finished, reported by DMMCMD_TaskEprom
+uint8_t bLimitSaveResult;               // result of the limits save
+
+// display mailbox: holds only the latest value information, a newer value overwrites the one not yet displayed
+char szDisplayVal[20];          // value information posted for display
+char szDisplayMode[20];         // measurement mode information posted for display, empty without mode
+uint32_t cntDisplayPosted = 0;  // number of values posted in the mailbox
+uint32_t cntDisplayShown = 0;   // number of posted values when the display was last updated
+uint32_t cntDisplayRenders = 0; // number of display updates
+uint8_t fTimerInit = 0;         // the timer is running, the display is refreshed at DMMCMD_DISP_REFRESHHZ
+uint32_t dwDisplayLastMs;       // time of the last display task run in the DMMCMD_CheckForCommand loop
+uint32_t dwTempLastMs;          // time of the last temperature task run in the DMMCMD_CheckForCommand loop
+int idxScaleShown = -2;         // scale displayed on the scale row, -2 if the row was not drawn
+char szModeShown[20] = "";      // measurement mode information displayed on the mode row
+uint8_t fTrendView = 0;         // the display shows the trend graph instead of the large digits value
 
 PmodOLED myPmodOLEDDevice;
 
 
 const u8 pmodOLED_orientation = 0b0;  //set up for Normal PmodOLED(false) vs normal Onboard OLED(true)
 const u8 pmodOLED_invert = 0b0;       //true = whitebackground/black letters      false = black background /white letters
+/* ************************************************************************** */
+/* ************************************************************************** */
+// Section: Utility Functions Prototypes, defined in other modules            */
+/* ************************************************************************** */
+/* ************************************************************************** */
+uint8_t DMM_FACScale(int idxScale);
+
 /* ************************************************************************** */
 /* ************************************************************************** */
 // Section: Local Functions Prototypes                                        */
@@ -126,7 +213,51 @@ u8 DMMCMD_CmdFinalizeCalibP(char const *arg0);
 u8 DMMCMD_CmdFinalizeCalibN(char const *arg0);
 u8 DMMCMD_CmdRestoreFactCalib();
 u8 DMMCMD_CmdReadSerialNo();
-void DMMCMD_PmodOLEDDisplay(char *pszVal);
+u8 DMMCMD_CmdSchedStats();
+u8 DMMCMD_CmdDisplayStats();
+u8 DMMCMD_CmdDisplayTrend(char const *arg0);
+u8 DMMCMD_CmdRevalidateEPROM();
+u8 DMMCMD_CmdImportCorr(char const *arg0);
+u8 DMMCMD_CmdCalSeqAdd(char const *arg0);
+u8 DMMCMD_CmdCalSeqClear();
+u8 DMMCMD_CmdCalSeqStart();
+u8 DMMCMD_CmdCalSeqContinue();
+u8 DMMCMD_CmdCalSeqAbort();
+u8 DMMCMD_CmdGetTemp();
+u8 DMMCMD_CmdSetTempCoeff(char const *arg0, char const *arg1);
+u8 DMMCMD_CmdTrigConfig(char const *arg0);
+u8 DMMCMD_CmdTrigArm();
+u8 DMMCMD_CmdSetLimit(char const *arg0);
+u8 DMMCMD_CmdLimitMonitor();
+u8 DMMCMD_CmdMode(char const *arg0);
+u8 DMMCMD_CmdModeReset();
+u8 DMMCMD_CmdModeGet();
+// completion of the long operations
+uint8_t DMMCMD_StepPendingCmd(unsigned int *pt10usWait);
+u8 DMMCMD_CmdConfigDone(u8 bErrCode);
+u8 DMMCMD_CmdMeasureAvgDone(u8 bErrCode);
+u8 DMMCMD_CmdCalibPDone(u8 bErrCode);
+u8 DMMCMD_CmdCalibNDone(u8 bErrCode);
+u8 DMMCMD_CmdCalibZDone(u8 bErrCode);
+u8 DMMCMD_CmdMeasureForCalibDone(u8 bErrCode, char *szSign);
+u8 DMMCMD_CmdCalSeqStepDone(u8 bErrCode);
+void DMMCMD_CalSeqPrompt();
+void DMMCMD_SendRepeatedValue(uint8_t bErrCode);
+void DMMCMD_TrigValue();
+void DMMCMD_CheckLimits();
+void DMMCMD_ModeValue();
+void DMMCMD_FormatModeValue(double dVal, char *pszVal, uint8_t fShort);
+void DMMCMD_FormatCrest(double dCrest, char *pszCrest);
+// scheduler tasks
+void DMMCMD_TaskAcquisition();
+void DMMCMD_TaskCmdRx();
+void DMMCMD_TaskDisplay();
+void DMMCMD_TaskEprom();
+void DMMCMD_TaskTemp();
+void DMMCMD_SaveEPROMDone(uint8_t bResult);
+void DMMCMD_LimitSaveDone(uint8_t bResult);
+void DMMCMD_PmodOLEDDisplay(char *pszVal, char *pszMode);
+void DMMCMD_PmodOLEDRender(char *pszVal, char *pszMode);
 /********************* Function Definitions ***************************/
 
 /***	DMMCMD_Init()
@@ -142,8 +273,8 @@ void DMMCMD_PmodOLEDDisplay(char *pszVal);
 **
 **	Description:
 **		This function initializes the modules involved in the DMMCMD module.
-**      It initializes the DMM, UART, CALIB and SERIALNO modules.
-**      It also initializes PmodOLED.
+**      It initializes the DMM, UART, CALIB, LIMIT, SERIALNO and XADC modules.
+**      It also initializes the timer, used to refresh the display at DMMCMD_DISP_REFRESHHZ, and PmodOLED.
 **      The return values are related to errors when calibration is read from user calibration area of EPROM during calibration initialization call.
 **      The function returns ERRVAL_SUCCESS for success.
 **      The function returns ERRVAL_EPROM_MAGICNO when a wrong magic number was detected in the data read from EPROM.
@@ -157,10 +288,16 @@ u8 DMMCMD_Init()
 
 	bErrCode = CALIB_Init();
 	// no need to process error code as this can be the first run of DMMShield (Calibration not present)
+	// no limits are set when the limits record is missing
+	LIMIT_Init();
+	// without the die temperature, the values are not compensated
+	XADC_Init();
     bErrCode = UART_Init(115200);
     if(bErrCode == ERRVAL_SUCCESS)
     {
     	SERIALNO_Init();
+    	// the timer interrupt requires the interrupt controller, initialized by UART_Init
+    	fTimerInit = (TIMER_Init() == ERRVAL_SUCCESS);
     }
 	pszLastErr = ERRORS_GetszLastError();
 
@@ -169,8 +306,15 @@ u8 DMMCMD_Init()
     //Turn automatic updating off
     OLED_SetCharUpdate(&myPmodOLEDDevice, 0);
     OLED_DisplayOn(&myPmodOLEDDevice);
+    OLED_ClearBuffer(&myPmodOLEDDevice);
+    OLEDDISP_Init(&myPmodOLEDDevice);
+    if(fTimerInit)
+    {
+    	// the asynchronous display flush is advanced from the timer interrupt
+    	TIMER_SetMsTick(OLEDDISP_Tick);
+    }
 
-    DMMCMD_PmodOLEDDisplay("No value");
+    DMMCMD_PmodOLEDDisplay("No value", "");
 	return bErrCode;
 }
 
@@ -186,7 +330,9 @@ u8 DMMCMD_Init()
 **	Description:
 **		This function checks on UART if a command was received.
 **      It compares the received command with the commands defined in the commands array. If recognized, the command is processed accordingly.
-**      It also performs the repeated commands.
+**      It also performs the repeated commands, and runs the display task every DMMCMD_DISP_PERIODMS milliseconds,
+**      so that the values are acquired at full rate while the display shows the latest one.
+**      The temperature task is run every DMMCMD_TEMP_PERIODMS milliseconds.
 **
 */
 void DMMCMD_CheckForCommand()
@@ -203,6 +349,59 @@ void DMMCMD_CheckForCommand()
     }
 
     DMMCMD_ProcessRepeatedCmd();
+
+    if((uint32_t)(TIMER_GetMs() - dwDisplayLastMs) >= DMMCMD_DISP_PERIODMS)
+    {
+    	dwDisplayLastMs = TIMER_GetMs();
+    	DMMCMD_TaskDisplay();
+    }
+    if((uint32_t)(TIMER_GetMs() - dwTempLastMs) >= DMMCMD_TEMP_PERIODMS)
+    {
+    	dwTempLastMs = TIMER_GetMs();
+    	DMMCMD_TaskTemp();
+    }
+}
+
+/***	DMMCMD_InitTasks()
+**
+**	Parameters:
+**          none
+**
+**	Return Value:
+**		uint8_t
+**          ERRVAL_SUCCESS                  0       // success
+**          ERRVAL_DMM_GENERICERROR         0xEF    // the timer was not initialized, or the scheduler is not enabled
+**
+**	Description:
+**		This function prepares the cooperative scheduler (DMMCMD_USE_SCHED 1), that replaces the DMMCMD_CheckForCommand loop.
+**      It initializes the asynchronous SPI engine (DMMCMD_Init must be called before, it initializes the timer), so that the acquisition task
+**      leaves the DMM status read on the wire while the other tasks run, switches the UART transmission to asynchronous mode
+**      and adds the tasks: acquisition, command reception, UART transmission, display, EPROM background write and temperature.
+**      The tasks are run by SCHED_Run.
+**
+*/
+u8 DMMCMD_InitTasks()
+{
+#if DMMCMD_USE_SCHED
+	if(!fTimerInit)
+	{
+		return ERRVAL_DMM_GENERICERROR;
+	}
+	// without the fast tick the DMM status is read synchronously
+	SPI_AsyncInit();
+	UART_SetTxAsync(1);
+	SCHED_Init();
+	idTaskAcq = SCHED_AddTask("Acquisition", DMMCMD_TaskAcquisition, DMMCMD_ACQ_PERIODMS, DMMCMD_ACQ_DEADLINEMS);
+	idTaskRx = SCHED_AddTask("Command RX", DMMCMD_TaskCmdRx, DMMCMD_RX_PERIODMS, DMMCMD_RX_DEADLINEMS);
+	idTaskTx = SCHED_AddTask("UART TX", UART_TxTask, DMMCMD_TX_PERIODMS, DMMCMD_TX_DEADLINEMS);
+	idTaskDisp = SCHED_AddTask("Display", DMMCMD_TaskDisplay, DMMCMD_DISP_PERIODMS, DMMCMD_DISP_DEADLINEMS);
+	idTaskEprom = SCHED_AddTask("EPROM write", DMMCMD_TaskEprom, DMMCMD_EPROM_PERIODMS, DMMCMD_EPROM_DEADLINEMS);
+	idTaskTemp = SCHED_AddTask("Temperature", DMMCMD_TaskTemp, DMMCMD_TEMP_PERIODMS, DMMCMD_TEMP_DEADLINEMS);
+	fUseTasks = 1;
+	return ERRVAL_SUCCESS;
+#else
+	return ERRVAL_DMM_GENERICERROR;
+#endif
 }
 
 /* ************************************************************************** */
@@ -291,11 +490,27 @@ char* DMMCMD_CmdGetNextArg()
 **	Description:
 **		This function calls the processing function corresponding to the provided enumerator key.
 **      It properly provides the command arguments.
+**      When the scheduler tasks are not used, the long operation started by the command is completed here.
+**      Otherwise it is completed by the acquisition task.
+**      In the AMP configuration the acquisition on CPU1 is paused while the command is processed, 
+**      and it is restarted afterwards if a repeated measurement session is active.
 **
 **
 */
 void DMMCMD_ProcessCmd(cmd_key_t keyCmd)
 {
+	unsigned int t10usWait;
+#if AMP_ENABLE
+	uint8_t bErrCode;
+	// CPU1 must not access the DMMShield while the command is processed
+	bErrCode = AMP_PauseAcquisition();
+	if(bErrCode != ERRVAL_SUCCESS)
+	{
+		ERRORS_GetPrefixedMessageString(bErrCode, "", szMsg);
+		UART_PutString(szMsg);
+		return;
+	}
+#endif
     switch(keyCmd)
     {
         case CMD_Config:
@@ -352,12 +567,94 @@ void DMMCMD_ProcessCmd(cmd_key_t keyCmd)
         case CMD_ReadSerialNo:
         	DMMCMD_CmdReadSerialNo();
             break;
+        case CMD_SchedStats:
+        	DMMCMD_CmdSchedStats();
+            break;
+        case CMD_DisplayStats:
+        	DMMCMD_CmdDisplayStats();
+            break;
+        case CMD_DisplayTrend:
+        	DMMCMD_CmdDisplayTrend(DMMCMD_CmdGetNextArg());
+            break;
+        case CMD_RevalidateEPROM:
+        	DMMCMD_CmdRevalidateEPROM();
+            break;
+        case CMD_ImportCorr:
+        	DMMCMD_CmdImportCorr(DMMCMD_CmdGetNextArg());
+            break;
+        case CMD_CalSeqAdd:
+        	DMMCMD_CmdCalSeqAdd(DMMCMD_CmdGetNextArg());
+            break;
+        case CMD_CalSeqClear:
+        	DMMCMD_CmdCalSeqClear();
+            break;
+        case CMD_CalSeqStart:
+        	DMMCMD_CmdCalSeqStart();
+            break;
+        case CMD_CalSeqContinue:
+        	DMMCMD_CmdCalSeqContinue();
+            break;
+        case CMD_CalSeqAbort:
+        	DMMCMD_CmdCalSeqAbort();
+            break;
+        case CMD_GetTemp:
+        	DMMCMD_CmdGetTemp();
+            break;
+        case CMD_SetTempCoeff:
+        	DMMCMD_CmdSetTempCoeff(DMMCMD_CmdGetNextArg(), DMMCMD_CmdGetNextArg());
+            break;
+        case CMD_TrigConfig:
+        	DMMCMD_CmdTrigConfig(DMMCMD_CmdGetNextArg());
+            break;
+        case CMD_TrigArm:
+        	DMMCMD_CmdTrigArm();
+            break;
+        case CMD_SetLimit:
+        	DMMCMD_CmdSetLimit(DMMCMD_CmdGetNextArg());
+            break;
+        case CMD_LimitMonitor:
+        	DMMCMD_CmdLimitMonitor();
+            break;
+        case CMD_Mode:
+        	DMMCMD_CmdMode(DMMCMD_CmdGetNextArg());
+            break;
+        case CMD_ModeReset:
+        	DMMCMD_CmdModeReset();
+            break;
+        case CMD_ModeGet:
+        	DMMCMD_CmdModeGet();
+            break;
 //        case CMD_NONE:
         default:
         	// do nothing
             break;
     }
-    DelayAprox10Us(1000);
+    if(!fUseTasks)
+    {
+    	// complete the long operation started by the command
+    	while(DMMCMD_StepPendingCmd(&t10usWait) == ERRVAL_DMM_PENDING)
+    	{
+    		DelayAprox10Us(t10usWait);
+    	}
+    }
+#if AMP_ENABLE
+    if(fRepGetVal || fRepGetRaw)
+    {
+    	// restart the repeated acquisition on CPU1, using the current scale
+    	bErrCode = AMP_RunAcquisition(DMM_GetCurrentScale(), fRepGetRaw);
+    	if(bErrCode != ERRVAL_SUCCESS)
+    	{
+    		fRepGetVal = 0;
+    		fRepGetRaw = 0;
+    		ERRORS_GetPrefixedMessageString(bErrCode, "", szMsg);
+    		UART_PutString(szMsg);
+    	}
+    }
+#endif
+    if(!fUseTasks)
+    {
+    	DelayAprox10Us(1000);
+    }
     return;
 }
 
@@ -377,9 +674,10 @@ void DMMCMD_ProcessCmd(cmd_key_t keyCmd)
 **	Description:
 **		This function implements the DMMConfig text command of DMMCMD module.
 **      It searches the argument among the defined scales in order to detect the scale index,
-**      then it calls DMM_SetScale providing the scale index as parameter.
-**      The function sends over UART the success message or the error message.
-**      The function returns the error code, which is the error code returned by the DMM_SetScale function.
+**      then it calls DMM_SetScaleStart providing the scale index as parameter.
+**      The configuration is completed by DMMCMD_StepPendingCmd, which calls DMMCMD_CmdConfigDone.
+**      The function sends over UART the error message if the configuration cannot be started.
+**      The function returns the error code, which is the error code returned by the DMM_SetScaleStart function.
 **      The function is called by DMMCMD_ProcessCmd function.
 **
 */
@@ -391,17 +689,16 @@ u8 DMMCMD_CmdConfig(char const *arg0)
     {
         if(!strcmp(arg0, rgScales[idxScale]))
         {
-            bErrCode = DMM_SetScale(idxScale);// send the selected configuration to the DMM
+            bErrCode = DMM_SetScaleStart(idxScale);// send the selected configuration to the DMM
             if(bErrCode == ERRVAL_SUCCESS)
             {
-                sprintf(szMsg, "PASS, Selected scale index is: %d\r\n", idxScale);
-                DMMCMD_PmodOLEDDisplay("No value");
+                idxPendingScale = idxScale;
+                keyPendingCmd = CMD_Config;
             }
             else
             {
-                bErrCode = ERRORS_GetPrefixedMessageString(bErrCode, "", szMsg);
+                DMMCMD_CmdConfigDone(bErrCode);
             }
-            UART_PutString(szMsg);
             return bErrCode;
         }
     }
@@ -421,6 +718,7 @@ u8 DMMCMD_CmdConfig(char const *arg0)
 **
 **	Description:
 **		This function initiates the DMMMeasureRep repeated command session of DMMCMD module.
+**      If the trigger engine was armed (DMMTrigArm) or the limits were monitored (DMMLimitMonitor), all the values are sent again.
 **      The function always returns success: ERRVAL_SUCCESS.
 **      The function is called by DMMCMD_ProcessCmd function.
 **
@@ -429,6 +727,9 @@ uint8_t DMMCMD_CmdMeasureRep()
 {
 	fRepGetVal = 1;
 	fRepGetRaw = 0;
+	fTrigActive = 0;
+	fLimitMonitor = 0;
+	TRIG_Disarm();
     strcpy(szMsg, "Measure repeated");
     ERRORS_GetPrefixedMessageString(ERRVAL_SUCCESS, "", szMsg);
     UART_PutString(szMsg);
@@ -446,7 +747,8 @@ uint8_t DMMCMD_CmdMeasureRep()
 **          ERRVAL_SUCCESS            0      // success
 **
 **	Description:
-**		This function terminates the DMMMeasureRep and DMMMeasureRaw repeated command sessions of DMMCMD module.
+**		This function terminates the DMMMeasureRep and DMMMeasureRaw repeated command sessions of DMMCMD module,
+**      including the DMMTrigArm and DMMLimitMonitor sessions, and disarms the trigger engine.
 **      The function always returns success: ERRVAL_SUCCESS.
 **      The function is called by DMMCMD_ProcessCmd function.
 **
@@ -455,6 +757,9 @@ uint8_t DMMCMD_CmdMeasureStop()
 {
 	fRepGetVal = 0;
 	fRepGetRaw = 0;
+	fTrigActive = 0;
+	fLimitMonitor = 0;
+	TRIG_Disarm();
     strcpy(szMsg, "Stop repeated");
     ERRORS_GetPrefixedMessageString(ERRVAL_SUCCESS, "", szMsg);
     UART_PutString(szMsg);
@@ -514,30 +819,24 @@ u8 DMMCMD_CmdMeasureRaw()
 **
 **	Description:
 **		This function implements the DMMMeasureAVG text command of DMMCMD module.
-**		The function calls the DMM_DGetAvgValue.
-**		In case of success, the returned value is formatted and sent over UART.
+**		The function calls the DMM_DGetAvgValueStart. The average value is completed by DMMCMD_StepPendingCmd, 
+**		which calls DMMCMD_CmdMeasureAvgDone.
 **		In case of error, the error specific message is sent over UART.
-**      The function returns the error code, which is the error code raised by the DMM_DGetAvgValue function.
+**      The function returns the error code, which is the error code raised by the DMM_DGetAvgValueStart function.
 **      The function is called by DMMCMD_ProcessCmd function.
 **
 */
 u8 DMMCMD_CmdMeasureAvg()
 {
-	u8 bErrCode = ERRVAL_SUCCESS;
-	char szVal[20];
-	double dMeasuredVal;
-    dMeasuredVal = DMM_DGetAvgValue(MEASURE_CNT_AVG, &bErrCode);
+	u8 bErrCode = DMM_DGetAvgValueStart(MEASURE_CNT_AVG);
     if(bErrCode == ERRVAL_SUCCESS)
     {
-        DMM_FormatValue(dMeasuredVal, szVal, 1);
-        sprintf(szMsg, "Avg. Value: %s\r\n", szVal);
+        keyPendingCmd = CMD_MeasureAvg;
     }
     else
     {
-        // like this, prefixing is skipped for ERRVAL_SUCCESS
-        ERRORS_GetPrefixedMessageString(bErrCode, "", szMsg);
+        DMMCMD_CmdMeasureAvgDone(bErrCode);
     }
-    UART_PutString(szMsg);
     return bErrCode;
 }
 
@@ -558,42 +857,35 @@ u8 DMMCMD_CmdMeasureAvg()
 **
 **	Description:
 **		This function implements the DMMCalibP text command of DMMCMD module.
-**      It interprets the argument as reference value by calling DMM_InterpretValue function.
-**      then it calls CALIB_CalibOnPositive providing the reference value as parameter and collecting the measured value and dispersion.
-**		In case of success, the function builds the message using the formatted strings for reference value, measured value and dispersion and eventually
-**      the calibration coefficients. Then the message is sent over UART.
-**		In case of error, the error specific message is sent over UART.
-**      The return values are possible errors of DMM_InterpretValue and DMMCalibP functions.
+**      It interprets the argument as reference value by calling DMM_InterpretValueEx function.
+**      then it starts the measurement by calling CALIB_MeasureForCalibStart. The measurement is completed by DMMCMD_StepPendingCmd, 
+**      which calls DMMCMD_CmdCalibPDone to finalize the calibration.
+**		In case of error, the error specific message is sent over UART. For wrong values it includes the position of the wrong character.
+**      The return values are possible errors of DMM_InterpretValueEx and CALIB_MeasureForCalibStart functions.
 **      The function is called by DMMCMD_ProcessCmd function.
 **
 */
 u8 DMMCMD_CmdCalibP(char const *arg0)
 {
 	u8 bErrCode = ERRVAL_SUCCESS;
-    bErrCode = DMM_InterpretValue((char *)arg0, &dRefVal);
+    bErrCode = DMM_InterpretValueEx(arg0, &dRefVal, &idxErrPos);
     if(bErrCode == ERRVAL_SUCCESS)
     {
-		bErrCode = CALIB_CalibOnPositive(dRefVal, &dMeasuredVal, 0, &dispersion, 0);
+		bErrCode = CALIB_MeasureForCalibStart(CALIB_MEASURE_POSITIVE);
         if(bErrCode == ERRVAL_SUCCESS)
         {
-            DMM_FormatValue(dRefVal, szRefVal, 1);
-            DMM_FormatValue(dMeasuredVal, szVal, 1);
-    		sprintf(szMsg, "Calibration on positive done. Reference: %s, Measured: %s, Dispersion: %.2f%%", szRefVal, szVal, dispersion);
-    		if(pszLastErr[0])
-    		{
-    			// append last error string to the message (used for calibration coefficients)
-    			strcat(szMsg, ", ");
-    			strcat(szMsg, pszLastErr);
-    		}
+        	keyPendingCmd = CMD_CalibP;
+        }
+        else
+        {
+        	DMMCMD_CmdCalibPDone(bErrCode);
         }
-        ERRORS_GetPrefixedMessageString(bErrCode, "", szMsg);
-
     }
     else
     {
-    	ERRORS_GetPrefixedMessageString(bErrCode, (char *)arg0, szMsg);
+    	ERRORS_GetPrefixedPositionMessageString(bErrCode, (char *)arg0, idxErrPos, szMsg);
+    	UART_PutString(szMsg);
     }
-    UART_PutString(szMsg);
     return bErrCode;
 }
 
@@ -614,42 +906,35 @@ u8 DMMCMD_CmdCalibP(char const *arg0)
 **
 **	Description:
 **		This function implements the DMMCalibN text command of DMMCMD module.
-**      It interprets the argument as reference value by calling DMM_InterpretValue function.
-**      then it calls CALIB_CalibOnNegative providing the reference value as parameter and collecting the measured value and dispersion.
-**		In case of success, the function builds the message using the formatted strings for reference value, measured value and dispersion and eventually
-**      the calibration coefficients. Then the message is sent over UART.
-**		In case of error, the error specific message is sent over UART.
-**      The return values are possible errors of DMM_InterpretValue and DMMCalibN functions.
+**      It interprets the argument as reference value by calling DMM_InterpretValueEx function.
+**      then it starts the measurement by calling CALIB_MeasureForCalibStart. The measurement is completed by DMMCMD_StepPendingCmd, 
+**      which calls DMMCMD_CmdCalibNDone to finalize the calibration.
+**		In case of error, the error specific message is sent over UART. For wrong values it includes the position of the wrong character.
+**      The return values are possible errors of DMM_InterpretValueEx and CALIB_MeasureForCalibStart functions.
 **      The function is called by DMMCMD_ProcessCmd function.
 **
 */
 u8 DMMCMD_CmdCalibN(char const *arg0)
 {
 	u8 bErrCode = ERRVAL_SUCCESS;
-    bErrCode = DMM_InterpretValue((char *)arg0, &dRefVal);
+    bErrCode = DMM_InterpretValueEx(arg0, &dRefVal, &idxErrPos);
     if(bErrCode == ERRVAL_SUCCESS)
     {
-		bErrCode = CALIB_CalibOnNegative(dRefVal, &dMeasuredVal, 0, &dispersion, 0);
+		bErrCode = CALIB_MeasureForCalibStart(CALIB_MEASURE_NEGATIVE);
         if(bErrCode == ERRVAL_SUCCESS)
         {
-            DMM_FormatValue(dRefVal, szRefVal, 1);
-            DMM_FormatValue(dMeasuredVal, szVal, 1);
-    		sprintf(szMsg, "Calibration on negative done. Reference: %s, Measured: %s, Dispersion: %.2f%%", szRefVal, szVal, dispersion);
-    		if(pszLastErr[0])
-    		{
-    			// append last error string to the message (used for calibration coefficients)
-    			strcat(szMsg, ", ");
-    			strcat(szMsg, pszLastErr);
-    		}
+        	keyPendingCmd = CMD_CalibN;
+        }
+        else
+        {
+        	DMMCMD_CmdCalibNDone(bErrCode);
         }
-        ERRORS_GetPrefixedMessageString(bErrCode, "", szMsg);
-
     }
     else
     {
-    	ERRORS_GetPrefixedMessageString(bErrCode, (char *)arg0, szMsg);
+    	ERRORS_GetPrefixedPositionMessageString(bErrCode, (char *)arg0, idxErrPos, szMsg);
+    	UART_PutString(szMsg);
     }
-    UART_PutString(szMsg);
     return bErrCode;
 }
 
@@ -670,32 +955,24 @@ u8 DMMCMD_CmdCalibN(char const *arg0)
 **          ERRVAL_CALIB_MISSINGMEASUREMENT 0xF0    // A measurement must be performed before calling the finalize calibration function.**
 **	Description:
 **		This function implements the DMMCalibZ text command of DMMCMD module.
-**      It calls CALIB_CalibOnZero collecting the measured value and dispersion.
-**		In case of success, the function builds the message using the formatted string for measured value, dispersion and eventually
-**      the calibration coefficients. Then the message is sent over UART.
+**      It starts the measurement by calling CALIB_MeasureForCalibStart. The measurement is completed by DMMCMD_StepPendingCmd, 
+**      which calls DMMCMD_CmdCalibZDone to finalize the calibration.
 **		In case of error, the error specific message is sent over UART.
-**      The return values are possible errors of DMMCalibZ functions.
+**      The return values are possible errors of CALIB_MeasureForCalibStart function.
 **      The function is called by DMMCMD_ProcessCmd function.
 **
 */
 u8 DMMCMD_CmdCalibZ()
 {
-	u8 bErrCode = ERRVAL_SUCCESS;
-	bErrCode = CALIB_CalibOnZero(&dMeasuredVal, &dispersion, 0);
+	u8 bErrCode = CALIB_MeasureForCalibStart(CALIB_MEASURE_ZERO);
     if(bErrCode == ERRVAL_SUCCESS)
     {
-         DMM_FormatValue(dMeasuredVal, szVal, 1);
-         sprintf(szMsg, "Calibration on zero done. Measured Value: %s, Dispersion: %.2f%%", szVal, dispersion);
-         if(pszLastErr[0])
-         {
-             // append last error string to the message (used for calibration coefficients)
-             strcat(szMsg, ", ");
-             strcat(szMsg, pszLastErr);
-         }
-	}
-	ERRORS_GetPrefixedMessageString(bErrCode, "", szMsg);
-
-    UART_PutString(szMsg);
+    	keyPendingCmd = CMD_CalibZ;
+    }
+    else
+    {
+    	DMMCMD_CmdCalibZDone(bErrCode);
+    }
     return bErrCode;
 }
 
@@ -712,6 +989,9 @@ u8 DMMCMD_CmdCalibZ()
 **	Description:
 **		This function implements the DMMSaveEPROM text command of DMMCMD module.
 **      It calls CALIB_WriteAllCalibsToEPROM_User collecting the number of modified scales or error code.
+**      When the scheduler tasks are used, it calls CALIB_WriteAllCalibsToEPROM_UserAsync instead: the calibration data is written 
+**      in background by the EPROM write task, while the measurements continue, and the task reports the completion.
+**      The temperature coefficients (DMMSetTempCoeff) are saved too, they are not counted in the message.
 **		In case of success, the function builds the message using the the number of modified scales. Then the message is sent over UART.
 **		In case of error, the error specific message is sent over UART.
 **      The function returns the error code, which is the error code returned by the CALIB_WriteAllCalibsToEPROM_User function.
@@ -721,6 +1001,18 @@ u8 DMMCMD_CmdCalibZ()
 u8 DMMCMD_CmdSaveEPROM()
 {
 	u8 bErrCode = ERRVAL_SUCCESS;
+	if(fUseTasks)
+	{
+	    bErrCode = CALIB_WriteAllCalibsToEPROM_UserAsync(DMMCMD_SaveEPROMDone);
+	    if (bErrCode != ERRVAL_EPROM_WRTIMEOUT)
+	    {
+	        sprintf(szMsg, "%d calibrations queued for EPROM write", bErrCode);
+	        bErrCode = ERRVAL_SUCCESS;
+	    }
+	    ERRORS_GetPrefixedMessageString(bErrCode, "", szMsg);
+	    UART_PutString(szMsg);
+	    return bErrCode;
+	}
     bErrCode = CALIB_WriteAllCalibsToEPROM_User();
     if (bErrCode != ERRVAL_EPROM_WRTIMEOUT)
     {
@@ -886,30 +1178,27 @@ u8 DMMCMD_CmdImportCalib(char const *arg0, char const *arg1, char const *arg2)
 **		uint8_t     - the error code
 **          ERRVAL_SUCCESS                  0       // success
 **          ERRVAL_DMM_IDXCONFIG            0xFC    // wrong scale index
-**          ERRVAL_DMM_VALIDDATATIMEOUT     0xFA    // valid data DMM timeout
 **
 **	Description:
 **		This function implements the DMMMeasureForCalibP text command of DMMCMD module.
-**      It calls CALIB_MeasureForCalibPositiveVal collecting the measured value.
-**		In case of success, the function builds the message using the formatted string for measured value. Then the message is sent over UART.
+**      It starts the measurement by calling CALIB_MeasureForCalibStart. The measurement is completed by DMMCMD_StepPendingCmd, 
+**      which calls DMMCMD_CmdMeasureForCalibDone.
 **		In case of error, the error specific message is sent over UART.
-**      The return values are possible errors of CALIB_MeasureForCalibPositiveVal functions.
+**      The return values are possible errors of CALIB_MeasureForCalibStart function.
 **      The function is called by DMMCMD_ProcessCmd function.
 **
 */
 u8 DMMCMD_CmdMeasureForCalibP()
 {
-	u8 bErrCode = ERRVAL_SUCCESS;
-	double dMeasuredVal;
-	bErrCode = CALIB_MeasureForCalibPositiveVal(&dMeasuredVal);
-
+	u8 bErrCode = CALIB_MeasureForCalibStart(CALIB_MEASURE_POSITIVE);
 	if(bErrCode == ERRVAL_SUCCESS)
 	{
-		DMM_FormatValue(dMeasuredVal, szVal, 1);
-		sprintf(szMsg, "Calibration positive measurement done. Measured Value: %s", szVal);
+		keyPendingCmd = CMD_MeasureForCalibP;
+	}
+	else
+	{
+		DMMCMD_CmdMeasureForCalibDone(bErrCode, "positive");
 	}
-	ERRORS_GetPrefixedMessageString(bErrCode, "", szMsg);
-    UART_PutString(szMsg);
     return bErrCode;
 }
 
@@ -922,31 +1211,27 @@ u8 DMMCMD_CmdMeasureForCalibP()
 **		uint8_t     - the error code
 **          ERRVAL_SUCCESS                  0       // success
 **          ERRVAL_DMM_IDXCONFIG            0xFC    // wrong scale index
-**          ERRVAL_DMM_VALIDDATATIMEOUT     0xFA    // valid data DMM timeout
 **
 **	Description:
 **		This function implements the DMMMeasureForCalibN text command of DMMCMD module.
-**      It calls CALIB_MeasureForCalibNegativeVal collecting the measured value.
-**		In case of success, the function builds the message using the formatted string for measured value. Then the message is sent over UART.
+**      It starts the measurement by calling CALIB_MeasureForCalibStart. The measurement is completed by DMMCMD_StepPendingCmd, 
+**      which calls DMMCMD_CmdMeasureForCalibDone.
 **		In case of error, the error specific message is sent over UART.
-**      The return values are possible errors of CALIB_MeasureForCalibNegativeVal functions.
+**      The return values are possible errors of CALIB_MeasureForCalibStart function.
 **      The function is called by DMMCMD_ProcessCmd function.
 **
 */
 u8 DMMCMD_CmdMeasureForCalibN()
 {
-	u8 bErrCode = ERRVAL_SUCCESS;
-	double dMeasuredVal;
-
-	bErrCode = CALIB_MeasureForCalibNegativeVal(&dMeasuredVal);
-
+	u8 bErrCode = CALIB_MeasureForCalibStart(CALIB_MEASURE_NEGATIVE);
 	if(bErrCode == ERRVAL_SUCCESS)
 	{
-		DMM_FormatValue(dMeasuredVal, szVal, 1);
-		sprintf(szMsg, "Calibration negative measurement done. Measured Value: %s", szVal);
+		keyPendingCmd = CMD_MeasureForCalibN;
+	}
+	else
+	{
+		DMMCMD_CmdMeasureForCalibDone(bErrCode, "negative");
 	}
-	ERRORS_GetPrefixedMessageString(bErrCode, "", szMsg);
-    UART_PutString(szMsg);
     return bErrCode;
 }
 
@@ -966,19 +1251,19 @@ u8 DMMCMD_CmdMeasureForCalibN()
 **
 **	Description:
 **		This function implements the DMMFinalizeCalibP text command of DMMCMD module.
-**      It interprets the argument as reference value by calling DMM_InterpretValue function.
+**      It interprets the argument as reference value by calling DMM_InterpretValueEx function.
 **      then it calls CALIB_CalibOnPositive providing the reference value as parameter and collecting the measured value and dispersion.
 **		In case of success, the function builds the message using the formatted strings for reference value, measured value and dispersion and eventually
 **      the calibration coefficients. Then the message is sent over UART.
-**		In case of error, the error specific message is sent over UART.
-**      The return values are possible errors of DMM_InterpretValue and DMMCalibP functions.
+**		In case of error, the error specific message is sent over UART. For wrong values it includes the position of the wrong character.
+**      The return values are possible errors of DMM_InterpretValueEx and DMMCalibP functions.
 **      The function is called by DMMCMD_ProcessCmd function.
 **
 */
 u8 DMMCMD_CmdFinalizeCalibP(char const *arg0)
 {
 	u8 bErrCode = ERRVAL_SUCCESS;
-	bErrCode = DMM_InterpretValue((char *)arg0, &dRefVal);
+	bErrCode = DMM_InterpretValueEx(arg0, &dRefVal, &idxErrPos);
 	if(bErrCode == ERRVAL_SUCCESS)
 	{
 		DMM_FormatValue(dRefVal, szRefVal, 1);
@@ -998,7 +1283,7 @@ u8 DMMCMD_CmdFinalizeCalibP(char const *arg0)
 	}
     else
     {
-    	ERRORS_GetPrefixedMessageString(bErrCode, (char *)arg0, szMsg);
+    	ERRORS_GetPrefixedPositionMessageString(bErrCode, (char *)arg0, idxErrPos, szMsg);
     }
 	UART_PutString(szMsg);
 	return bErrCode;
@@ -1020,19 +1305,19 @@ u8 DMMCMD_CmdFinalizeCalibP(char const *arg0)
 **
 **	Description:
 **		This function implements the DMMCalibN text command of DMMCMD module.
-**      It interprets the argument as reference value by calling DMM_InterpretValue function.
+**      It interprets the argument as reference value by calling DMM_InterpretValueEx function.
 **      then it calls CALIB_CalibOnNegative providing the reference value as parameter and collecting the measured value and dispersion.
 **		In case of success, the function builds the message using the formatted strings for reference value, measured value and dispersion and eventually
 **      the calibration coefficients. Then the message is sent over UART.
-**		In case of error, the error specific message is sent over UART.
-**      The return values are possible errors of DMM_InterpretValue and DMMCalibN functions.
+**		In case of error, the error specific message is sent over UART. For wrong values it includes the position of the wrong character.
+**      The return values are possible errors of DMM_InterpretValueEx and DMMCalibN functions.
 **      The function is called by DMMCMD_ProcessCmd function.
 **
 */
 u8 DMMCMD_CmdFinalizeCalibN(char const *arg0)
 {
 	u8 bErrCode = ERRVAL_SUCCESS;
-	bErrCode = DMM_InterpretValue((char *)arg0, &dRefVal);
+	bErrCode = DMM_InterpretValueEx(arg0, &dRefVal, &idxErrPos);
 	if(bErrCode == ERRVAL_SUCCESS)
 	{
 		DMM_FormatValue(dRefVal, szRefVal, 1);
@@ -1052,7 +1337,7 @@ u8 DMMCMD_CmdFinalizeCalibN(char const *arg0)
 	}
     else
     {
-    	ERRORS_GetPrefixedMessageString(bErrCode, (char *)arg0, szMsg);
+    	ERRORS_GetPrefixedPositionMessageString(bErrCode, (char *)arg0, idxErrPos, szMsg);
     }
 	UART_PutString(szMsg);
 	return bErrCode;
@@ -1123,7 +1408,7 @@ u8 DMMCMD_CmdReadSerialNo()
     return bErrCode;
 }
 
-/***	DMMCMD_ProcessRepeatedCmd
+/***	DMMCMD_CmdSchedStats
 **
 **	Parameters:
 **     none
@@ -1131,81 +1416,1970 @@ u8 DMMCMD_CmdReadSerialNo()
 **	Return Value:
 **		uint8_t     - the error code
 **          ERRVAL_SUCCESS              0       // success
-**          ERRVAL_DMM_VALIDDATATIMEOUT 0xFA    // valid data DMM timeout
-**          ERRVAL_DMM_IDXCONFIG        0xFC    // error, wrong current scale index
+**          ERRVAL_DMM_GENERICERROR     0xEF    // the scheduler is not used
 **
 **	Description:
-**		This function implements the repeated session functionality for DMMMeasureRep and DMMMeasureRaw text commands of DMMCMD module.
-**		The function calls the DMM_DGetValue, eventually without calibration parameters being applied for DMMMeasureRaw.
-**		In case of success, the returned value is formatted and sent over UART.
-**		In case of error, the error specific message is sent over UART.
+**		This function implements the DMMSchedStats text command of DMMCMD module.
+**      For each scheduler task it sends over UART the number of runs, the number of missed deadlines,
+**      the maximum run time and the relative deadline.
+**		If the scheduler tasks are not used, the error message is sent over UART.
 **      The function is called by DMMCMD_ProcessCmd function.
+**
 */
-uint8_t DMMCMD_ProcessRepeatedCmd()
+u8 DMMCMD_CmdSchedStats()
 {
-	uint8_t bErrCode = ERRVAL_SUCCESS;
-    if((fRepGetVal || fRepGetRaw) && !fRepBlock)
-    {
-        if(fRepGetRaw)
-        {
-        	DMM_SetUseCalib(0);
-        }
-        dMeasuredVal = DMM_DGetValue(&bErrCode);
-        DMM_SetUseCalib(1);
-        if(bErrCode == ERRVAL_SUCCESS)
-        {
-            if(fRepGetVal)
-            {
-                DMM_FormatValue(dMeasuredVal, szVal, 1);
-                sprintf(szMsg, "Value: %s\r\n", szVal);
-            	DMMCMD_PmodOLEDDisplay(szVal);
-            }
-            else
-            {
-                sprintf(szMsg, "Raw Value: %.6lf\r\n", dMeasuredVal);
-            }
-        }
-        else
-        {
-            bErrCode = ERRORS_GetPrefixedMessageString(bErrCode, "", szMsg);
-        }
-        UART_PutString(szMsg);
-    }
-    return bErrCode;
+	int idTask;
+	if(!fUseTasks)
+	{
+		strcpy(szMsg, "The scheduler is not used");
+		ERRORS_GetPrefixedMessageString(ERRVAL_DMM_GENERICERROR, "", szMsg);
+		UART_PutString(szMsg);
+		return ERRVAL_DMM_GENERICERROR;
+	}
+	strcpy(szMsg, "Scheduler statistics");
+	ERRORS_GetPrefixedMessageString(ERRVAL_SUCCESS, "", szMsg);
+	UART_PutString(szMsg);
+	for(idTask = 0; idTask < SCHED_GetTaskCount(); idTask++)
+	{
+		SCHED_FormatStats(idTask, szMsg);
+		strcat(szMsg, "\r\n");
+		UART_PutString(szMsg);
+	}
+	return ERRVAL_SUCCESS;
 }
 
-/***	DMMCMD_PmodOLEDDisplay
+/***	DMMCMD_CmdDisplayStats
 **
 **	Parameters:
-**     char const *pszVal           - the character string containing the value information
+**     none
 **
 **	Return Value:
-**		<none>
+**		uint8_t     - the error code
+**          ERRVAL_SUCCESS              0       // success
 **
 **	Description:
-**		This function implements the regular display on PmpdOLED.
-**		It detects the current selected scale and displays it on the second row.
-**		It displays the value information on the forth row.
-**
+**		This function implements the DMMDisplayStats text command of DMMCMD module.
+**      It sends over UART the PmodOLED update statistics: number of updates, number of updates that sent data,
+**      bytes sent by the last update, maximum and average bytes sent per update, duration of the last and the longest update,
+**      the number of asynchronous updates refused because the previous one was in progress,
+**      and the number of values posted for display and dropped because a newer value was posted before the display update.
+**      The function is called by DMMCMD_ProcessCmd function.
 **
 */
-void DMMCMD_PmodOLEDDisplay(char *pszVal)
+u8 DMMCMD_CmdDisplayStats()
 {
-	int idxScale = DMM_GetCurrentScale();
-    OLED_ClearBuffer(&myPmodOLEDDevice);
+	OLEDDISP_STATS stats;
+	OLEDDISP_GetStats(&stats);
+	strcpy(szMsg, "Display statistics");
+	ERRORS_GetPrefixedMessageString(ERRVAL_SUCCESS, "", szMsg);
+	UART_PutString(szMsg);
+	sprintf(szMsg, "Updates %lu, sent %lu, last %lu bytes, max %lu bytes, average %lu bytes\r\n",
+			(unsigned long)stats.cntUpdates, (unsigned long)stats.cntSent, (unsigned long)stats.cbLast,
+			(unsigned long)stats.cbMax, (unsigned long)(stats.cntUpdates ? stats.cbTotal / stats.cntUpdates : 0));
+	UART_PutString(szMsg);
+	sprintf(szMsg, "Duration last %lu us, max %lu us, busy %lu%s\r\n",
+			(unsigned long)stats.usLast, (unsigned long)stats.usMax, (unsigned long)stats.cntBusy,
+			OLEDDISP_IsBusy() ? ", update in progress" : "");
+	UART_PutString(szMsg);
+	sprintf(szMsg, "Values posted %lu, dropped %lu\r\n",
+			(unsigned long)cntDisplayPosted, (unsigned long)(cntDisplayShown - cntDisplayRenders));
+	UART_PutString(szMsg);
+	return ERRVAL_SUCCESS;
+}
 
-    if(idxScale != -1)
-    {
-    	OLED_SetCursor(&myPmodOLEDDevice, (16 - strlen(rgScales[idxScale]))/2, 1);
-    	OLED_PutString(&myPmodOLEDDevice, (char *)rgScales[idxScale]);
-    }
-    else
-    {
-    	OLED_SetCursor(&myPmodOLEDDevice, 4, 1);
-    	OLED_PutString(&myPmodOLEDDevice, "No scale");
+/***	DMMCMD_CmdDisplayTrend
+**
+**	Parameters:
+**     char const *arg0           - the character string containing the first command argument, "On" or "Off"
+**
+**	Return Value:
+**		uint8_t     - the error code
+**          ERRVAL_SUCCESS                  0       // success
+**          ERRVAL_CMD_WRONGPARAMS          0xF9    // wrong parameters when sending UART commands
+**
+**	Description:
+**		This function implements the DMMDisplayTrend text command of DMMCMD module.
+**      It selects the PmodOLED view: the trend graph of the last readings of DMMMeasureRep (On) or the large digits value (Off).
+**      The frame buffer is cleared and the last value information is displayed again in the selected view.
+**      The function is called by DMMCMD_ProcessCmd function.
+**
+*/
+u8 DMMCMD_CmdDisplayTrend(char const *arg0)
+{
+	char szShown[sizeof(szDisplayVal)], szShownMode[sizeof(szDisplayMode)];
+	if(!arg0 || (strcmp(arg0, "On") && strcmp(arg0, "Off")))
+	{
+		ERRORS_GetPrefixedMessageString(ERRVAL_CMD_WRONGPARAMS, "", szMsg);
+		UART_PutString(szMsg);
+		return ERRVAL_CMD_WRONGPARAMS;
+	}
+	fTrendView = !strcmp(arg0, "On");
+	OLED_ClearBuffer(&myPmodOLEDDevice);
+	idxScaleShown = -2;
+	szModeShown[0] = 0;
+	BIGFONT_Invalidate();
+	TREND_Invalidate();
+	strcpy(szShown, szDisplayVal);
+	strcpy(szShownMode, szDisplayMode);
+	DMMCMD_PmodOLEDDisplay(szShown, szShownMode);
+	sprintf(szMsg, "Display %s view", fTrendView ? "trend" : "value");
+	ERRORS_GetPrefixedMessageString(ERRVAL_SUCCESS, "", szMsg);
+	UART_PutString(szMsg);
+	return ERRVAL_SUCCESS;
+}
 
-    }
+/***	DMMCMD_CmdRevalidateEPROM
+**
+**	Parameters:
+**     none
+**
+**	Return Value:
+**		uint8_t     - the error code
+**          ERRVAL_SUCCESS                  0       // success
+**          ERRVAL_DMM_GENERICERROR         0xEF    // Generic error
+**
+**	Description:
+**		This function implements the DMMRevalidateEPROM text command of DMMCMD module.
+**      The EPROM reads (calibration load, verify and export, serial number) are served from the RAM image of EPROM, read at initialization.
+**      This command reads the whole EPROM again and compares it with the image (EPROM_RevalidateImage). 
+**      On mismatch the image is replaced by the EPROM content and the calibration data is loaded again from it.
+**		In case of success and mismatch, the function builds separate messages and then the messages are sent over UART.
+**      The function returns ERRVAL_DMM_GENERICERROR in the case of mismatch.
+**      The function is called by DMMCMD_ProcessCmd function.
+**
+*/
+u8 DMMCMD_CmdRevalidateEPROM()
+{
+	u8 bErrCode;
+	int cwMismatch;
+	bErrCode = EPROM_RevalidateImage(&cwMismatch);
+	if(bErrCode == ERRVAL_SUCCESS)
+	{
+		strcpy(szMsg, "EPROM image is verified");
+	}
+	else
+	{
+		// the calibration data was loaded from the wrong image
+		CALIB_Init();
+		sprintf(szMsg, "EPROM image mismatch: %d words reloaded from EPROM", cwMismatch);
+		bErrCode = ERRVAL_DMM_GENERICERROR;
+	}
+	ERRORS_GetPrefixedMessageString(bErrCode, "", szMsg);
+	UART_PutString(szMsg);
+	return bErrCode;
+}
 
-	OLED_SetCursor(&myPmodOLEDDevice, (16 - strlen(pszVal))/2, 3);
-    OLED_PutString(&myPmodOLEDDevice, pszVal);
-    OLED_Update(&myPmodOLEDDevice);}
+/***	DMMCMD_CmdImportCorr
+**
+**	Parameters:
+**     char const *arg0           - the character string containing the first command argument, to be interpreted as scale index (integer)
+**
+**	Return Value:
+**		uint8_t     - the error code
+**          ERRVAL_SUCCESS                  0       // success
+**          ERRVAL_CMD_WRONGPARAMS          0xF9    // wrong parameters when sending UART commands
+**          ERRVAL_DMM_GENERICERROR         0xEF    // Generic error, parameters cannot be properly interpreted
+**          ERRVAL_DMM_IDXCONFIG            0xFC    // wrong scale index
+**          ERRVAL_CORR_FORMAT              0xEA    // wrong correction values
+**          ERRVAL_CORR_FULL                0xE9    // all the correction slots are used
+**
+**	Description:
+**		This function implements the DMMImportCorr text command of DMMCMD module.
+**      It interprets the first parameter as scale index and gets the next parameters: the correction type and the values.
+**          DMMImportCorr idxScale,Poly,c0,c1,...,cn        - the polynomial c0 + c1*v + ... + cn*v^n
+**          DMMImportCorr idxScale,Table,x0,y0,x1,y1,...    - the piecewise linear table, x values increasing
+**          DMMImportCorr idxScale,None                     - removes the correction of the scale
+**      It calls CORR_ImportScale providing the scale index, the type and the values.
+**      The correction is applied on the values of the scale after the calibration coefficients. It is not saved in EPROM.
+**		In case of success, the function sends the success message over UART.
+**		In case of error, the error specific message is sent over UART.
+**      The function returns the error code, which is the error code detected when parameters are interpreted or returned by the CORR_ImportScale function.
+**      The function is called by DMMCMD_ProcessCmd function.
+**
+*/
+u8 DMMCMD_CmdImportCorr(char const *arg0)
+{
+	u8 bErrCode = ERRVAL_SUCCESS;
+	int idxCfg, cVals = 0;
+	uint8_t bType = CORR_TYPE_NONE;
+	double rgdVals[CORR_MAXVALS];
+	char const *arg1 = DMMCMD_CmdGetNextArg();
+	char *pszVal;
+	if(!arg0 || !arg1)
+	{
+		bErrCode = ERRVAL_CMD_WRONGPARAMS;
+	}
+	if(bErrCode == ERRVAL_SUCCESS)
+	{
+		// idxScale
+		if (!sscanf(arg0, "%d", &idxCfg))
+		{
+			strcpy(szMsg, "Invalid value, provide an integer number for the first token, corresponding to scale index");
+			bErrCode = ERRVAL_DMM_GENERICERROR;
+		}
+		else if(!strcmp(arg1, "Poly"))
+		{
+			bType = CORR_TYPE_POLY;
+		}
+		else if(!strcmp(arg1, "Table"))
+		{
+			bType = CORR_TYPE_TABLE;
+		}
+		else if(strcmp(arg1, "None"))
+		{
+			strcpy(szMsg, "Invalid value, provide Poly, Table or None for the second token, corresponding to correction type");
+			bErrCode = ERRVAL_DMM_GENERICERROR;
+		}
+	}
+	while(bErrCode == ERRVAL_SUCCESS && (pszVal = DMMCMD_CmdGetNextArg()) != NULL)
+	{
+		if(cVals >= CORR_MAXVALS)
+		{
+			bErrCode = ERRVAL_CORR_FORMAT;
+		}
+		else if(!sscanf(pszVal, "%lf", &rgdVals[cVals++]))
+		{
+			sprintf(szMsg, "Invalid value, provide a float number for the token %d, corresponding to correction value", cVals + 2);
+			bErrCode = ERRVAL_DMM_GENERICERROR;
+		}
+	}
+	if(bErrCode == ERRVAL_SUCCESS)
+	{
+		bErrCode = CORR_ImportScale(idxCfg, bType, rgdVals, cVals);
+		sprintf(szMsg, "Correction of scale %d is imported", idxCfg);
+	}
+	ERRORS_GetPrefixedMessageString(bErrCode, "", szMsg);
+	UART_PutString(szMsg);
+	return bErrCode;
+}
+
+/***	DMMCMD_CmdCalSeqAdd
+**
+**	Parameters:
+**     char const *arg0           - the character string containing the first command argument, to be interpreted as scale name
+**
+**	Return Value:
+**		uint8_t     - the error code
+**          ERRVAL_SUCCESS                  0       // success
+**          ERRVAL_CMD_WRONGPARAMS          0xF9    // wrong parameters when sending UART commands
+**          ERRVAL_DMM_IDXCONFIG            0xFC    // wrong scale index
+**          ERRVAL_CMD_VALWRONGUNIT         0xF4    // The provided value has a wrong measure unit.
+**          ERRVAL_CMD_VALFORMAT            0xF2    // The numeric value cannot be extracted from the provided string.
+**          ERRVAL_CALSEQ_STATE             0xE8    // the calibration sequence is in progress
+**
+**	Description:
+**		This function implements the DMMCalSeqAdd text command of DMMCMD module.
+**      It adds a step to the calibration plan of the sequencer (CALSEQ module):
+**          DMMCalSeqAdd Scale,Z            - calibration on zero
+**          DMMCalSeqAdd Scale,P,RefVal     - calibration on positive value, using the reference value
+**          DMMCalSeqAdd Scale,N,RefVal     - calibration on negative value, using the reference value (DC scales)
+**      The scale is given by name, as for DMMConfig. The reference value is interpreted according to the scale, 
+**      as for DMMCalibP. A step with the same scale and type replaces the existing one.
+**		In case of success, the function sends the success message (including the number of steps of the plan) over UART.
+**		In case of error, the error specific message is sent over UART.
+**      The function is called by DMMCMD_ProcessCmd function.
+**
+*/
+u8 DMMCMD_CmdCalSeqAdd(char const *arg0)
+{
+	u8 bErrCode = ERRVAL_SUCCESS;
+	int idxScale;
+	uint8_t bType = CALIB_MEASURE_ZERO;
+	double dVal = 0;
+	char const *arg1 = DMMCMD_CmdGetNextArg();
+	char const *arg2 = DMMCMD_CmdGetNextArg();
+	if(!arg0 || !arg1)
+	{
+		bErrCode = ERRVAL_CMD_WRONGPARAMS;
+	}
+	if(bErrCode == ERRVAL_SUCCESS)
+	{
+		// an unknown scale name gives idxScale = DMM_CNTSCALES, rejected as wrong scale index
+		idxScale = 0;
+		while(idxScale < DMM_CNTSCALES && strcmp(arg0, rgScales[idxScale]))
+		{
+			idxScale++;
+		}
+		if(!strcmp(arg1, "P"))
+		{
+			bType = CALIB_MEASURE_POSITIVE;
+		}
+		else if(!strcmp(arg1, "N"))
+		{
+			bType = CALIB_MEASURE_NEGATIVE;
+		}
+		else if(strcmp(arg1, "Z"))
+		{
+			bErrCode = ERRVAL_CMD_WRONGPARAMS;
+		}
+		if(bErrCode == ERRVAL_SUCCESS && bType != CALIB_MEASURE_ZERO)
+		{
+			if(!arg2)
+			{
+				bErrCode = ERRVAL_CMD_WRONGPARAMS;
+			}
+			else
+			{
+				bErrCode = DMM_InterpretScaleValueEx(idxScale, arg2, &dVal, &idxErrPos);
+				if(bErrCode != ERRVAL_SUCCESS && bErrCode != ERRVAL_DMM_IDXCONFIG)
+				{
+					ERRORS_GetPrefixedPositionMessageString(bErrCode, (char *)arg2, idxErrPos, szMsg);
+					UART_PutString(szMsg);
+					return bErrCode;
+				}
+			}
+		}
+	}
+	if(bErrCode == ERRVAL_SUCCESS)
+	{
+		bErrCode = CALSEQ_AddStep(idxScale, bType, dVal, arg2);
+		sprintf(szMsg, "Calibration step added, the plan has %d steps", CALSEQ_GetCntSteps());
+	}
+	ERRORS_GetPrefixedMessageString(bErrCode, "", szMsg);
+	UART_PutString(szMsg);
+	return bErrCode;
+}
+
+/***	DMMCMD_CmdCalSeqClear
+**
+**	Parameters:
+**     none
+**
+**	Return Value:
+**		uint8_t     - the error code
+**          ERRVAL_SUCCESS                  0       // success
+**
+**	Description:
+**		This function implements the DMMCalSeqClear text command of DMMCMD module.
+**      It removes all the steps of the calibration plan (CALSEQ_Clear) and sends the success message over UART.
+**      The function is called by DMMCMD_ProcessCmd function.
+**
+*/
+u8 DMMCMD_CmdCalSeqClear()
+{
+	CALSEQ_Clear();
+	strcpy(szMsg, "Calibration plan is cleared");
+	ERRORS_GetPrefixedMessageString(ERRVAL_SUCCESS, "", szMsg);
+	UART_PutString(szMsg);
+	return ERRVAL_SUCCESS;
+}
+
+/***	DMMCMD_CmdCalSeqStart
+**
+**	Parameters:
+**     none
+**
+**	Return Value:
+**		uint8_t     - the error code
+**          ERRVAL_SUCCESS                  0       // success
+**          ERRVAL_CALSEQ_STATE             0xE8    // the calibration sequence is in progress
+**          ERRVAL_CALSEQ_EMPTY             0xE7    // the calibration plan has no steps
+**
+**	Description:
+**		This function implements the DMMCalSeqStart text command of DMMCMD module.
+**      It starts the calibration sequence (CALSEQ_Start), which orders the steps of the plan by reference source,
+**      and sends over UART the prompt for the first reference source.
+**		In case of error, the error specific message is sent over UART.
+**      The function is called by DMMCMD_ProcessCmd function.
+**
+*/
+u8 DMMCMD_CmdCalSeqStart()
+{
+	u8 bErrCode = CALSEQ_Start();
+	if(bErrCode == ERRVAL_SUCCESS)
+	{
+		sprintf(szMsg, "Calibration sequence started, %d steps", CALSEQ_GetCntSteps());
+	}
+	ERRORS_GetPrefixedMessageString(bErrCode, "", szMsg);
+	UART_PutString(szMsg);
+	if(bErrCode == ERRVAL_SUCCESS)
+	{
+		DMMCMD_CalSeqPrompt();
+	}
+	return bErrCode;
+}
+
+/***	DMMCMD_CmdCalSeqContinue
+**
+**	Parameters:
+**     none
+**
+**	Return Value:
+**		uint8_t     - the error code
+**          ERRVAL_SUCCESS                  0       // success
+**          ERRVAL_CALSEQ_STATE             0xE8    // the calibration sequence does not wait for a reference source
+**
+**	Description:
+**		This function implements the DMMCalSeqContinue text command of DMMCMD module.
+**      It is sent by the operator after connecting the requested reference source. The steps using this source
+**      are performed by DMMCMD_StepPendingCmd (CALSEQ_Step), which calls DMMCMD_CmdCalSeqStepDone after each step.
+**		In case of error, the error specific message is sent over UART.
+**      The function is called by DMMCMD_ProcessCmd function.
+**
+*/
+u8 DMMCMD_CmdCalSeqContinue()
+{
+	u8 bErrCode = CALSEQ_Continue();
+	if(bErrCode == ERRVAL_SUCCESS)
+	{
+		keyPendingCmd = CMD_CalSeqContinue;
+	}
+	else
+	{
+		ERRORS_GetPrefixedMessageString(bErrCode, "", szMsg);
+		UART_PutString(szMsg);
+	}
+	return bErrCode;
+}
+
+/***	DMMCMD_CmdCalSeqAbort
+**
+**	Parameters:
+**     none
+**
+**	Return Value:
+**		uint8_t     - the error code
+**          ERRVAL_SUCCESS                  0       // success
+**
+**	Description:
+**		This function implements the DMMCalSeqAbort text command of DMMCMD module.
+**      It stops the calibration sequence waiting for a reference source (CALSEQ_Abort). The calibrations of the 
+**      performed steps are kept, but not saved in EPROM. The plan is kept.
+**      The function sends the success message over UART.
+**      The function is called by DMMCMD_ProcessCmd function.
+**
+*/
+u8 DMMCMD_CmdCalSeqAbort()
+{
+	CALSEQ_Abort();
+	strcpy(szMsg, "Calibration sequence is aborted");
+	ERRORS_GetPrefixedMessageString(ERRVAL_SUCCESS, "", szMsg);
+	UART_PutString(szMsg);
+	return ERRVAL_SUCCESS;
+}
+
+/***	DMMCMD_CmdGetTemp
+**
+**	Parameters:
+**     none
+**
+**	Return Value:
+**		uint8_t     - the error code
+**          ERRVAL_SUCCESS                  0       // success
+**
+**	Description:
+**		This function implements the DMMGetTemp text command of DMMCMD module.
+**      It sends over UART the die temperature (XADC_GetTemp), the temperature of the user calibration (CALIB_GetCalibTemp),
+**      the temperature coefficient of the current scale and the compensation factor applied on its values.
+**      The temperatures are reported as unknown before the first reading, or when the calibration temperature was not recorded.
+**      It states whether the compensation is disabled: no coefficient was set for the scale, or a temperature is unknown.
+**      The function is called by DMMCMD_ProcessCmd function.
+**
+*/
+u8 DMMCMD_CmdGetTemp()
+{
+	char szTemp[20], szCalibTemp[20], szComp[50];
+	int idxScale = DMM_GetCurrentScale();
+	double dTemp = XADC_GetTemp(), dCalibTemp = CALIB_GetCalibTemp();
+	float fPpm = CALIB_GetTempCoeff(idxScale);
+	if(isnan(dTemp))
+	{
+		strcpy(szTemp, "unknown");
+	}
+	else
+	{
+		sprintf(szTemp, "%.2f C", dTemp);
+	}
+	if(isnan(dCalibTemp))
+	{
+		strcpy(szCalibTemp, "unknown");
+	}
+	else
+	{
+		sprintf(szCalibTemp, "%.2f C", dCalibTemp);
+	}
+	if(fPpm == 0)
+	{
+		strcpy(szComp, "disabled (no coefficient)");
+	}
+	else if(isnan(dTemp) || isnan(dCalibTemp))
+	{
+		strcpy(szComp, "disabled (unknown temperature)");
+	}
+	else
+	{
+		strcpy(szComp, "enabled");
+	}
+	sprintf(szMsg, "Die temperature: %s, Calibration temperature: %s, Coeff: %.2f ppm/C, Factor: %.6f, Compensation: %s",
+			szTemp, szCalibTemp, fPpm, CALIB_GetTempFactor(idxScale), szComp);
+	ERRORS_GetPrefixedMessageString(ERRVAL_SUCCESS, "", szMsg);
+	UART_PutString(szMsg);
+	return ERRVAL_SUCCESS;
+}
+
+/***	DMMCMD_CmdSetTempCoeff
+**
+**	Parameters:
+**     char const *arg0           - the character string containing the first command argument, to be interpreted as scale index (integer)
+**     char const *arg1           - the character string containing the second command argument, to be interpreted as temperature coefficient in ppm/C (float)
+**
+**	Return Value:
+**		uint8_t     - the error code
+**          ERRVAL_SUCCESS                  0       // success
+**          ERRVAL_CMD_WRONGPARAMS          0xF9    // wrong parameters when sending UART commands
+**          ERRVAL_DMM_GENERICERROR         0xEF    // Generic error, parameters cannot be properly interpreted
+**          ERRVAL_DMM_IDXCONFIG            0xFC    // wrong scale index
+**          ERRVAL_TEMPCOEFF_FULL           0xE1    // coefficients are already set for CALIB_TEMPCOEFF_CNTSLOTS other scales
+**          ERRVAL_TEMPCOEFF_FORMAT         0xE0    // the coefficient is out of the -327.67 to 327.67 ppm/C range
+**
+**	Description:
+**		This function implements the DMMSetTempCoeff text command of DMMCMD module.
+**      It interprets the first parameter as scale index and the second as the temperature coefficient of the scale (ppm/C),
+**      then calls CALIB_SetTempCoeff. A 0 coefficient disables the temperature compensation of the scale.
+**      Coefficients can be set for CALIB_TEMPCOEFF_CNTSLOTS scales, with a 0.01 ppm/C resolution.
+**      They are stored in EPROM by the DMMSaveEPROM command, together with the user calibration.
+**      In the AMP configuration, the new factor is used from the next acquisition started on the scale.
+**		The success message or the error specific message is sent over UART.
+**      The function is called by DMMCMD_ProcessCmd function.
+**
+*/
+u8 DMMCMD_CmdSetTempCoeff(char const *arg0, char const *arg1)
+{
+	u8 bErrCode = ERRVAL_SUCCESS;
+	int idxCfg;
+	float fPpm;
+	if(!arg0 || !arg1)
+	{
+		bErrCode = ERRVAL_CMD_WRONGPARAMS;
+	}
+	if(bErrCode == ERRVAL_SUCCESS)
+	{
+		// idxScale
+		if (!sscanf(arg0, "%d", &idxCfg))
+		{
+			strcpy(szMsg, "Invalid value, provide an integer number for the first token, corresponding to scale index");
+			bErrCode = ERRVAL_DMM_GENERICERROR;
+		}
+		else if (!sscanf(arg1, "%f", &fPpm))
+		{
+			strcpy(szMsg, "Invalid value, provide a float number for the second token, corresponding to temperature coefficient (ppm/C)");
+			bErrCode = ERRVAL_DMM_GENERICERROR;
+		}
+	}
+	if(bErrCode == ERRVAL_SUCCESS)
+	{
+		bErrCode = CALIB_SetTempCoeff(idxCfg, fPpm);
+		if(bErrCode == ERRVAL_SUCCESS)
+		{
+			sprintf(szMsg, "Temperature coefficient of scale %d: %.2f ppm/C, use DMMSaveEPROM to keep it after reset", idxCfg, CALIB_GetTempCoeff(idxCfg));
+		}
+	}
+	ERRORS_GetPrefixedMessageString(bErrCode, "", szMsg);
+	UART_PutString(szMsg);
+	return bErrCode;
+}
+
+/***	DMMCMD_CmdTrigConfig
+**
+**	Parameters:
+**     char const *arg0           - the character string containing the first command argument, to be interpreted as trigger type
+**
+**	Return Value:
+**		uint8_t     - the error code
+**          ERRVAL_SUCCESS                  0       // success
+**          ERRVAL_CMD_WRONGPARAMS          0xF9    // wrong parameters when sending UART commands
+**          ERRVAL_DMM_GENERICERROR         0xEF    // Generic error, parameters cannot be properly interpreted
+**          ERRVAL_DMM_IDXCONFIG            0xFC    // wrong scale index, the levels cannot be interpreted
+**          ERRVAL_CMD_VALWRONGUNIT         0xF4    // The provided value has a wrong measure unit.
+**          ERRVAL_CMD_VALFORMAT            0xF2    // The numeric value cannot be extracted from the provided string.
+**          ERRVAL_TRIG_CONFIG              0xE5    // wrong trigger configuration
+**
+**	Description:
+**		This function implements the DMMTrigConfig text command of DMMCMD module. It configures the trigger engine (TRIG module):
+**          DMMTrigConfig Type,Pre,Post,Holdoff,Level[,LevelHi]
+**      Type is Level, Rising, Falling, Window or Overload. Pre and Post are the numbers of values captured before the trigger value
+**      and from the trigger value, Holdoff is the number of values acquired after arming, during which no trigger is accepted.
+**      Level is the trigger level (the window low level), LevelHi is the window high level. The levels are interpreted
+**      as for DMMCalibP, according to the current scale. The Overload trigger has no level.
+**      The trigger engine is disarmed, DMMTrigArm arms it. During a DMMTrigArm session, the engine is armed again with the new configuration.
+**		The success message or the error specific message is sent over UART.
+**      The function is called by DMMCMD_ProcessCmd function.
+**
+*/
+u8 DMMCMD_CmdTrigConfig(char const *arg0)
+{
+	u8 bErrCode = ERRVAL_SUCCESS;
+	TRIG_CFG cfg;
+	char const *rgArgs[5];
+	char const *pszLevel = NULL;
+	int idxArg;
+	for(idxArg = 0; idxArg < 5; idxArg++)
+	{
+		rgArgs[idxArg] = DMMCMD_CmdGetNextArg();
+	}
+	if(!arg0 || !rgArgs[0] || !rgArgs[1] || !rgArgs[2])
+	{
+		bErrCode = ERRVAL_CMD_WRONGPARAMS;
+	}
+	if(bErrCode == ERRVAL_SUCCESS)
+	{
+		cfg.bType = 0;
+		while(cfg.bType < sizeof(rgTrigTypes)/sizeof(rgTrigTypes[0]) && strcmp(arg0, rgTrigTypes[cfg.bType]))
+		{
+			cfg.bType++;
+		}
+		cfg.dLevel = 0;
+		cfg.dLevelHi = 0;
+		if(cfg.bType >= sizeof(rgTrigTypes)/sizeof(rgTrigTypes[0]))
+		{
+			strcpy(szMsg, "Invalid value, provide Level, Rising, Falling, Window or Overload for the first token, corresponding to trigger type");
+			bErrCode = ERRVAL_DMM_GENERICERROR;
+		}
+		else if(!sscanf(rgArgs[0], "%d", &cfg.cPre) || !sscanf(rgArgs[1], "%d", &cfg.cPost) || !sscanf(rgArgs[2], "%d", &cfg.cHoldoff))
+		{
+			strcpy(szMsg, "Invalid value, provide integer numbers for the tokens 2 to 4, corresponding to pre-trigger, post-trigger and holdoff values");
+			bErrCode = ERRVAL_DMM_GENERICERROR;
+		}
+		else if(cfg.bType != TRIG_TYPE_OVERLOAD && (!rgArgs[3] || (cfg.bType == TRIG_TYPE_WINDOW && !rgArgs[4])))
+		{
+			bErrCode = ERRVAL_CMD_WRONGPARAMS;
+		}
+		else if(cfg.bType != TRIG_TYPE_OVERLOAD)
+		{
+			pszLevel = rgArgs[3];
+			bErrCode = DMM_InterpretValueEx(pszLevel, &cfg.dLevel, &idxErrPos);
+			if(bErrCode == ERRVAL_SUCCESS && cfg.bType == TRIG_TYPE_WINDOW)
+			{
+				pszLevel = rgArgs[4];
+				bErrCode = DMM_InterpretValueEx(pszLevel, &cfg.dLevelHi, &idxErrPos);
+			}
+			if(bErrCode == ERRVAL_CMD_VALWRONGUNIT || bErrCode == ERRVAL_CMD_VALFORMAT)
+			{
+				ERRORS_GetPrefixedPositionMessageString(bErrCode, (char *)pszLevel, idxErrPos, szMsg);
+				UART_PutString(szMsg);
+				return bErrCode;
+			}
+		}
+	}
+	if(bErrCode == ERRVAL_SUCCESS)
+	{
+		bErrCode = TRIG_SetConfig(&cfg);
+		sprintf(szMsg, "Trigger %s, %d values before, %d values from the trigger", rgTrigTypes[cfg.bType], cfg.cPre, cfg.cPost);
+	}
+	if(bErrCode == ERRVAL_SUCCESS && fTrigActive)
+	{
+		// the engine was disarmed by the new configuration, the armed session continues with it
+		TRIG_Arm();
+	}
+	ERRORS_GetPrefixedMessageString(bErrCode, "", szMsg);
+	UART_PutString(szMsg);
+	return bErrCode;
+}
+
+/***	DMMCMD_CmdTrigArm
+**
+**	Parameters:
+**     none
+**
+**	Return Value:
+**		uint8_t     - the error code
+**          ERRVAL_SUCCESS                  0       // success
+**
+**	Description:
+**		This function implements the DMMTrigArm text command of DMMCMD module.
+**      It starts a DMMMeasureRep repeated session whose values are passed to the trigger engine configured by DMMTrigConfig,
+**      instead of being sent over UART. Each capture is sent as one block of values (DMMCMD_TrigValue),
+**      then the engine is rearmed. The values are still displayed on PmodOLED.
+**      The session is stopped by DMMMeasureStop, DMMMeasureRep sends again all the values.
+**      The function sends the success message over UART.
+**      The function is called by DMMCMD_ProcessCmd function.
+**
+*/
+u8 DMMCMD_CmdTrigArm()
+{
+	fRepGetVal = 1;
+	fRepGetRaw = 0;
+	fTrigActive = 1;
+	fLimitMonitor = 0;
+	TRIG_Arm();
+	sprintf(szMsg, "Trigger %s armed", rgTrigTypes[TRIG_GetConfig()->bType]);
+	ERRORS_GetPrefixedMessageString(ERRVAL_SUCCESS, "", szMsg);
+	UART_PutString(szMsg);
+	return ERRVAL_SUCCESS;
+}
+
+/***	DMMCMD_CmdSetLimit
+**
+**	Parameters:
+**     char const *arg0           - the character string containing the first command argument, to be interpreted as scale name
+**
+**	Return Value:
+**		uint8_t     - the error code
+**          ERRVAL_SUCCESS                  0       // success
+**          ERRVAL_CMD_WRONGPARAMS          0xF9    // wrong parameters when sending UART commands
+**          ERRVAL_DMM_IDXCONFIG            0xFC    // wrong scale index
+**          ERRVAL_CMD_VALWRONGUNIT         0xF4    // The provided value has a wrong measure unit.
+**          ERRVAL_CMD_VALFORMAT            0xF2    // The numeric value cannot be extracted from the provided string.
+**          ERRVAL_LIMIT_FORMAT             0xE4    // the low limit is not below the high limit, or wrong hysteresis
+**          ERRVAL_LIMIT_FULL               0xE3    // all the limit slots are used
+**          ERRVAL_EPROM_WRTIMEOUT          0xFF    // EPROM write data ready timeout
+**
+**	Description:
+**		This function implements the DMMSetLimit text command of DMMCMD module. It sets the limits of a scale (LIMIT module):
+**          DMMSetLimit Scale,Lo,Hi[,Hyst]
+**      Lo and Hi are the low and the high limits, None when the scale has no limit on that side. Hyst is the hysteresis, 0 by default.
+**      The values are interpreted as for DMMCalibP, according to the specified scale. DMMSetLimit Scale,None,None removes the limits.
+**      The limits are written in EPROM (ADR_EPROM_LIMITS): in background when the tasks are used, the result being reported
+**      by DMMCMD_TaskEprom, otherwise before the command message is sent.
+**		In case of error, the error specific message is sent over UART.
+**      The function is called by DMMCMD_ProcessCmd function.
+**
+*/
+u8 DMMCMD_CmdSetLimit(char const *arg0)
+{
+	u8 bErrCode = ERRVAL_SUCCESS;
+	int idxScale, idxArg;
+	double rgdVals[3] = {NAN, NAN, 0};     // low limit, high limit, hysteresis
+	char const *rgArgs[3];
+	for(idxArg = 0; idxArg < 3; idxArg++)
+	{
+		rgArgs[idxArg] = DMMCMD_CmdGetNextArg();
+	}
+	if(!arg0 || !rgArgs[0] || !rgArgs[1])
+	{
+		bErrCode = ERRVAL_CMD_WRONGPARAMS;
+	}
+	if(bErrCode == ERRVAL_SUCCESS)
+	{
+		// an unknown scale name gives idxScale = DMM_CNTSCALES, rejected as wrong scale index
+		idxScale = 0;
+		while(idxScale < DMM_CNTSCALES && strcmp(arg0, rgScales[idxScale]))
+		{
+			idxScale++;
+		}
+		for(idxArg = 0; idxArg < 3 && bErrCode == ERRVAL_SUCCESS; idxArg++)
+		{
+			if(rgArgs[idxArg] && strcmp(rgArgs[idxArg], "None"))
+			{
+				bErrCode = DMM_InterpretScaleValueEx(idxScale, rgArgs[idxArg], &rgdVals[idxArg], &idxErrPos);
+				if(bErrCode == ERRVAL_CMD_VALWRONGUNIT || bErrCode == ERRVAL_CMD_VALFORMAT)
+				{
+					ERRORS_GetPrefixedPositionMessageString(bErrCode, (char *)rgArgs[idxArg], idxErrPos, szMsg);
+					UART_PutString(szMsg);
+					return bErrCode;
+				}
+			}
+		}
+	}
+	if(bErrCode == ERRVAL_SUCCESS)
+	{
+		bErrCode = LIMIT_SetScale(idxScale, rgdVals[0], rgdVals[1], rgdVals[2]);
+	}
+	if(bErrCode == ERRVAL_SUCCESS)
+	{
+		bErrCode = LIMIT_Save(fUseTasks ? DMMCMD_LimitSaveDone: NULL);
+		sprintf(szMsg, fUseTasks ? "Limits of scale %s queued for EPROM write": "Limits of scale %s written to EPROM", rgScales[idxScale]);
+	}
+	ERRORS_GetPrefixedMessageString(bErrCode, "", szMsg);
+	UART_PutString(szMsg);
+	return bErrCode;
+}
+
+/***	DMMCMD_CmdLimitMonitor
+**
+**	Parameters:
+**     none
+**
+**	Return Value:
+**		uint8_t     - the error code
+**          ERRVAL_SUCCESS                  0       // success
+**
+**	Description:
+**		This function implements the DMMLimitMonitor text command of DMMCMD module.
+**      It starts a DMMMeasureRep repeated session whose values are only checked against the limits of the current scale:
+**      instead of the values, only the alarms are sent over UART (DMMCMD_CheckLimits). The values are still displayed on PmodOLED.
+**      The session is stopped by DMMMeasureStop, DMMMeasureRep sends again all the values.
+**      The function sends the success message over UART.
+**      The function is called by DMMCMD_ProcessCmd function.
+**
+*/
+u8 DMMCMD_CmdLimitMonitor()
+{
+	fRepGetVal = 1;
+	fRepGetRaw = 0;
+	fTrigActive = 0;
+	fLimitMonitor = 1;
+	TRIG_Disarm();
+	strcpy(szMsg, "Limit monitoring");
+	ERRORS_GetPrefixedMessageString(ERRVAL_SUCCESS, "", szMsg);
+	UART_PutString(szMsg);
+	return ERRVAL_SUCCESS;
+}
+
+/***	DMMCMD_CmdMode
+**
+**	Parameters:
+**     char const *arg0           - the character string containing the first command argument, to be interpreted as measurement mode
+**
+**	Return Value:
+**		uint8_t     - the error code
+**          ERRVAL_SUCCESS                  0       // success
+**          ERRVAL_CMD_WRONGPARAMS          0xF9    // wrong parameters when sending UART commands
+**          ERRVAL_DMM_GENERICERROR         0xEF    // wrong measurement mode
+**          ERRVAL_CMD_VALWRONGUNIT         0xF4    // The provided value has a wrong measure unit.
+**          ERRVAL_CMD_VALFORMAT            0xF2    // The numeric value cannot be extracted from the provided string.
+**
+**	Description:
+**		This function implements the DMMMode text command of DMMCMD module. It selects the measurement mode (MODE module):
+**          DMMMode None|MinMax|Hold|Rel|Peak[,Ref]
+**      MinMax reports the minimum and the maximum since the reset with each value, Hold displays the last stable value,
+**      Rel displays the difference from the reference: Ref, interpreted according to the current scale, or the first value.
+**      Ref is kept when the scale changes to a scale of the same mode, it is dropped when the mode of the scale changes.
+**      Peak enables the conversion of the converter peak registers (DMM_SetPeakDetect, on CPU1 in the AMP configuration),
+**      displays the peak-to-peak value since the reset and reports the peaks and, on the AC scales, the crest factor.
+**      The statistics are reset. The mode applies to the values of the DMMMeasureRep, DMMTrigArm and DMMLimitMonitor sessions.
+**		In case of error, the error specific message is sent over UART.
+**      The function is called by DMMCMD_ProcessCmd function.
+**
+*/
+u8 DMMCMD_CmdMode(char const *arg0)
+{
+	u8 bErrCode = ERRVAL_SUCCESS;
+	uint8_t bMode = 0;
+	double dRef = NAN;
+	char const *arg1 = DMMCMD_CmdGetNextArg();
+	if(!arg0)
+	{
+		bErrCode = ERRVAL_CMD_WRONGPARAMS;
+	}
+	if(bErrCode == ERRVAL_SUCCESS)
+	{
+		while(bMode < sizeof(rgModes)/sizeof(rgModes[0]) && strcmp(arg0, rgModes[bMode]))
+		{
+			bMode++;
+		}
+		if(bMode >= sizeof(rgModes)/sizeof(rgModes[0]))
+		{
+			strcpy(szMsg, "Invalid value, provide None, MinMax, Hold, Rel or Peak for the first token, corresponding to measurement mode");
+			bErrCode = ERRVAL_DMM_GENERICERROR;
+		}
+		else if(arg1 && bMode != MODE_REL)
+		{
+			bErrCode = ERRVAL_CMD_WRONGPARAMS;
+		}
+		else if(arg1)
+		{
+			bErrCode = DMM_InterpretValueEx(arg1, &dRef, &idxErrPos);
+			if(bErrCode == ERRVAL_CMD_VALWRONGUNIT || bErrCode == ERRVAL_CMD_VALFORMAT)
+			{
+				ERRORS_GetPrefixedPositionMessageString(bErrCode, (char *)arg1, idxErrPos, szMsg);
+				UART_PutString(szMsg);
+				return bErrCode;
+			}
+		}
+	}
+	if(bErrCode == ERRVAL_SUCCESS)
+	{
+		bErrCode = MODE_Set(bMode);
+		if(!isnan(dRef))
+		{
+			MODE_SetRef(dRef);
+		}
+		// the peak registers are only converted for the peak mode
+#if AMP_ENABLE
+		AMP_SetPeakDetect(bMode == MODE_PEAK);
+#else
+		DMM_SetPeakDetect(bMode == MODE_PEAK);
+#endif
+		sprintf(szMsg, "Mode %s", rgModes[bMode]);
+	}
+	ERRORS_GetPrefixedMessageString(bErrCode, "", szMsg);
+	UART_PutString(szMsg);
+	return bErrCode;
+}
+
+/***	DMMCMD_CmdModeReset
+**
+**	Parameters:
+**     none
+**
+**	Return Value:
+**		uint8_t     - the error code
+**          ERRVAL_SUCCESS                  0       // success
+**
+**	Description:
+**		This function implements the DMMModeReset text command of DMMCMD module.
+**      It resets the measurement mode statistics (MODE_Reset): the minimum, the maximum and the hold value restart from the next value,
+**      which also becomes the reference of the relative mode.
+**      The function is called by DMMCMD_ProcessCmd function.
+**
+*/
+u8 DMMCMD_CmdModeReset()
+{
+	MODE_Reset();
+	strcpy(szMsg, "Mode statistics reset");
+	ERRORS_GetPrefixedMessageString(ERRVAL_SUCCESS, "", szMsg);
+	UART_PutString(szMsg);
+	return ERRVAL_SUCCESS;
+}
+
+/***	DMMCMD_CmdModeGet
+**
+**	Parameters:
+**     none
+**
+**	Return Value:
+**		uint8_t     - the error code
+**          ERRVAL_SUCCESS                  0       // success
+**
+**	Description:
+**		This function implements the DMMModeGet text command of DMMCMD module.
+**      It sends over UART the measurement mode summary, computed on the device whatever the selected mode:
+**          Mode MinMax, n values, Min: a, Max: b, Hold: h, Ref: r, PkPk: p, Crest: c
+**      The values not available yet are reported as None. So the host can fetch the summary of a DMMLimitMonitor session
+**      instead of receiving all the values.
+**      The function is called by DMMCMD_ProcessCmd function.
+**
+*/
+u8 DMMCMD_CmdModeGet()
+{
+	char szMin[20], szMax[20], szHeld[20], szRef[20], szPkPk[20], szCrest[20];
+	DMMCMD_FormatModeValue(MODE_GetMin(), szMin, 0);
+	DMMCMD_FormatModeValue(MODE_GetMax(), szMax, 0);
+	DMMCMD_FormatModeValue(MODE_GetHeld(), szHeld, 0);
+	DMMCMD_FormatModeValue(MODE_GetRef(), szRef, 0);
+	DMMCMD_FormatModeValue(MODE_GetPeakMax() - MODE_GetPeakMin(), szPkPk, 0);
+	DMMCMD_FormatCrest(MODE_GetCrest(), szCrest);
+	sprintf(szMsg, "Mode %s, %lu values, Min: %s, Max: %s, Hold: %s, Ref: %s, PkPk: %s, Crest: %s", rgModes[MODE_Get()],
+			(unsigned long)MODE_GetCntSamples(), szMin, szMax, szHeld, szRef, szPkPk, szCrest);
+	ERRORS_GetPrefixedMessageString(ERRVAL_SUCCESS, "", szMsg);
+	UART_PutString(szMsg);
+	return ERRVAL_SUCCESS;
+}
+
+/***	DMMCMD_StepPendingCmd
+**
+**	Parameters:
+**     unsigned int *pt10usWait     - pointer to receive the time (in 10 us units) to wait before the next call
+**
+**	Return Value:
+**		uint8_t     - the error code
+**          ERRVAL_SUCCESS              0       // no pending operation, or the pending operation is finished
+**          ERRVAL_DMM_PENDING          0xEC    // the pending operation is not finished, call again after the wait time
+**
+**	Description:
+**		This function performs one step of the long operation started by the command stored in keyPendingCmd:
+**      DMM_SetScaleStep for DMMConfig, DMM_DGetAvgValueStep for DMMMeasureAvg, CALIB_MeasureForCalibStep for 
+**      the calibration commands and CALSEQ_Step for DMMCalSeqContinue.
+**      When the operation is finished, the pending command is cleared and its completion function is called,
+**      which sends the command result over UART. If the completion function starts another operation, 
+**      ERRVAL_DMM_PENDING is returned.
+**
+*/
+uint8_t DMMCMD_StepPendingCmd(unsigned int *pt10usWait)
+{
+	uint8_t bErrCode;
+	cmd_key_t keyCmd = keyPendingCmd;
+	*pt10usWait = 0;
+	switch(keyCmd)
+	{
+		case CMD_Config:
+			bErrCode = DMM_SetScaleStep(pt10usWait);
+			break;
+		case CMD_MeasureAvg:
+			bErrCode = DMM_DGetAvgValueStep(&dMeasuredVal);
+			break;
+		case CMD_CalibP:
+		case CMD_CalibN:
+		case CMD_CalibZ:
+		case CMD_MeasureForCalibP:
+		case CMD_MeasureForCalibN:
+			bErrCode = CALIB_MeasureForCalibStep(&dMeasuredVal);
+			break;
+		case CMD_CalSeqContinue:
+			bErrCode = CALSEQ_Step(pt10usWait);
+			break;
+		default:
+			// no pending operation
+			return ERRVAL_SUCCESS;
+	}
+	if(bErrCode == ERRVAL_DMM_PENDING)
+	{
+		return bErrCode;
+	}
+	keyPendingCmd = CMD_NONE;
+	switch(keyCmd)
+	{
+		case CMD_Config:
+			DMMCMD_CmdConfigDone(bErrCode);
+			break;
+		case CMD_MeasureAvg:
+			DMMCMD_CmdMeasureAvgDone(bErrCode);
+			break;
+		case CMD_CalibP:
+			DMMCMD_CmdCalibPDone(bErrCode);
+			break;
+		case CMD_CalibN:
+			DMMCMD_CmdCalibNDone(bErrCode);
+			break;
+		case CMD_CalibZ:
+			DMMCMD_CmdCalibZDone(bErrCode);
+			break;
+		case CMD_MeasureForCalibP:
+			DMMCMD_CmdMeasureForCalibDone(bErrCode, "positive");
+			break;
+		case CMD_CalSeqContinue:
+			DMMCMD_CmdCalSeqStepDone(bErrCode);
+			break;
+		default:
+			DMMCMD_CmdMeasureForCalibDone(bErrCode, "negative");
+			break;
+	}
+	// the completion function can start the next operation (the next step of the calibration sequence)
+	return (keyPendingCmd != CMD_NONE) ? ERRVAL_DMM_PENDING : ERRVAL_SUCCESS;
+}
+
+/***	DMMCMD_CmdConfigDone
+**
+**	Parameters:
+**     u8 bErrCode      - the error code of the scale configuration
+**
+**	Return Value:
+**		uint8_t     - the error code
+**
+**	Description:
+**		This function completes the DMMConfig text command.
+**      The function sends over UART the success message (including the scale index) or the error message.
+**
+*/
+u8 DMMCMD_CmdConfigDone(u8 bErrCode)
+{
+    if(bErrCode == ERRVAL_SUCCESS)
+    {
+        sprintf(szMsg, "PASS, Selected scale index is: %d\r\n", idxPendingScale);
+        DMMCMD_PmodOLEDDisplay("No value", "");
+    }
+    else
+    {
+        bErrCode = ERRORS_GetPrefixedMessageString(bErrCode, "", szMsg);
+    }
+    UART_PutString(szMsg);
+    return bErrCode;
+}
+
+/***	DMMCMD_CmdMeasureAvgDone
+**
+**	Parameters:
+**     u8 bErrCode      - the error code of the average value, the value is in dMeasuredVal
+**
+**	Return Value:
+**		uint8_t     - the error code
+**
+**	Description:
+**		This function completes the DMMMeasureAvg text command.
+**		In case of success, the average value is formatted and sent over UART.
+**		In case of error, the error specific message is sent over UART.
+**
+*/
+u8 DMMCMD_CmdMeasureAvgDone(u8 bErrCode)
+{
+    if(bErrCode == ERRVAL_SUCCESS)
+    {
+        DMM_FormatValue(dMeasuredVal, szVal, 1);
+        sprintf(szMsg, "Avg. Value: %s\r\n", szVal);
+    }
+    else
+    {
+        // like this, prefixing is skipped for ERRVAL_SUCCESS
+        ERRORS_GetPrefixedMessageString(bErrCode, "", szMsg);
+    }
+    UART_PutString(szMsg);
+    return bErrCode;
+}
+
+/***	DMMCMD_CmdCalibPDone
+**
+**	Parameters:
+**     u8 bErrCode      - the error code of the measurement for calibration
+**
+**	Return Value:
+**		uint8_t     - the error code
+**
+**	Description:
+**		This function completes the DMMCalibP text command.
+**      When the measurement succeeded, it calls CALIB_CalibOnPositive with the stored reference value, using the measured value (early measurement).
+**		In case of success, the function builds the message using the formatted strings for reference value, measured value and dispersion and eventually
+**      the calibration coefficients. Then the message is sent over UART.
+**		In case of error, the error specific message is sent over UART.
+**
+*/
+u8 DMMCMD_CmdCalibPDone(u8 bErrCode)
+{
+    if(bErrCode == ERRVAL_SUCCESS)
+    {
+		bErrCode = CALIB_CalibOnPositive(dRefVal, &dMeasuredVal, 1, &dispersion, 0);
+    }
+    if(bErrCode == ERRVAL_SUCCESS)
+    {
+        DMM_FormatValue(dRefVal, szRefVal, 1);
+        DMM_FormatValue(dMeasuredVal, szVal, 1);
+		sprintf(szMsg, "Calibration on positive done. Reference: %s, Measured: %s, Dispersion: %.2f%%", szRefVal, szVal, dispersion);
+		if(pszLastErr[0])
+		{
+			// append last error string to the message (used for calibration coefficients)
+			strcat(szMsg, ", ");
+			strcat(szMsg, pszLastErr);
+		}
+    }
+    ERRORS_GetPrefixedMessageString(bErrCode, "", szMsg);
+    UART_PutString(szMsg);
+    return bErrCode;
+}
+
+/***	DMMCMD_CmdCalibNDone
+**
+**	Parameters:
+**     u8 bErrCode      - the error code of the measurement for calibration
+**
+**	Return Value:
+**		uint8_t     - the error code
+**
+**	Description:
+**		This function completes the DMMCalibN text command.
+**      When the measurement succeeded, it calls CALIB_CalibOnNegative with the stored reference value, using the measured value (early measurement).
+**		In case of success, the function builds the message using the formatted strings for reference value, measured value and dispersion and eventually
+**      the calibration coefficients. Then the message is sent over UART.
+**		In case of error, the error specific message is sent over UART.
+**
+*/
+u8 DMMCMD_CmdCalibNDone(u8 bErrCode)
+{
+    if(bErrCode == ERRVAL_SUCCESS)
+    {
+		bErrCode = CALIB_CalibOnNegative(dRefVal, &dMeasuredVal, 1, &dispersion, 0);
+    }
+    if(bErrCode == ERRVAL_SUCCESS)
+    {
+        DMM_FormatValue(dRefVal, szRefVal, 1);
+        DMM_FormatValue(dMeasuredVal, szVal, 1);
+		sprintf(szMsg, "Calibration on negative done. Reference: %s, Measured: %s, Dispersion: %.2f%%", szRefVal, szVal, dispersion);
+		if(pszLastErr[0])
+		{
+			// append last error string to the message (used for calibration coefficients)
+			strcat(szMsg, ", ");
+			strcat(szMsg, pszLastErr);
+		}
+    }
+    ERRORS_GetPrefixedMessageString(bErrCode, "", szMsg);
+    UART_PutString(szMsg);
+    return bErrCode;
+}
+
+/***	DMMCMD_CmdCalibZDone
+**
+**	Parameters:
+**     u8 bErrCode      - the error code of the measurement for calibration
+**
+**	Return Value:
+**		uint8_t     - the error code
+**
+**	Description:
+**		This function completes the DMMCalibZ text command.
+**      When the measurement succeeded, it calls CALIB_FinalizeCalibOnZero collecting the measured value and dispersion.
+**		In case of success, the function builds the message using the formatted string for measured value, dispersion and eventually
+**      the calibration coefficients. Then the message is sent over UART.
+**		In case of error, the error specific message is sent over UART.
+**
+*/
+u8 DMMCMD_CmdCalibZDone(u8 bErrCode)
+{
+    if(bErrCode == ERRVAL_SUCCESS)
+    {
+    	bErrCode = CALIB_FinalizeCalibOnZero(&dMeasuredVal, &dispersion, 0);
+    }
+    if(bErrCode == ERRVAL_SUCCESS)
+    {
+         DMM_FormatValue(dMeasuredVal, szVal, 1);
+         sprintf(szMsg, "Calibration on zero done. Measured Value: %s, Dispersion: %.2f%%", szVal, dispersion);
+         if(pszLastErr[0])
+         {
+             // append last error string to the message (used for calibration coefficients)
+             strcat(szMsg, ", ");
+             strcat(szMsg, pszLastErr);
+         }
+	}
+	ERRORS_GetPrefixedMessageString(bErrCode, "", szMsg);
+
+    UART_PutString(szMsg);
+    return bErrCode;
+}
+
+/***	DMMCMD_CmdMeasureForCalibDone
+**
+**	Parameters:
+**     u8 bErrCode      - the error code of the measurement for calibration, the value is in dMeasuredVal
+**     char *szSign     - "positive" or "negative", used in the message
+**
+**	Return Value:
+**		uint8_t     - the error code
+**
+**	Description:
+**		This function completes the DMMMeasureForCalibP and DMMMeasureForCalibN text commands.
+**		In case of success, the function builds the message using the formatted string for measured value. Then the message is sent over UART.
+**		In case of error, the error specific message is sent over UART.
+**
+*/
+u8 DMMCMD_CmdMeasureForCalibDone(u8 bErrCode, char *szSign)
+{
+	if(bErrCode == ERRVAL_SUCCESS)
+	{
+		DMM_FormatValue(dMeasuredVal, szVal, 1);
+		sprintf(szMsg, "Calibration %s measurement done. Measured Value: %s", szSign, szVal);
+	}
+	ERRORS_GetPrefixedMessageString(bErrCode, "", szMsg);
+    UART_PutString(szMsg);
+    return bErrCode;
+}
+
+/***	DMMCMD_CmdCalSeqStepDone
+**
+**	Parameters:
+**     u8 bErrCode      - the result of the calibration sequence step
+**
+**	Return Value:
+**		uint8_t     - the error code
+**
+**	Description:
+**		This function completes a step of the calibration sequence, performed by DMMCMD_StepPendingCmd (CALSEQ_Step).
+**      It sends over UART the step description and duration, followed by the measured value, dispersion and eventually 
+**      the calibration coefficients, or by the error message. A failed step does not stop the sequence.
+**      Then, according to the sequencer state:
+**      - the next step is started, when it uses the same reference source
+**      - the operator is prompted to connect the next reference source
+**      - after the last step, the summary is sent and the calibrations are saved in EPROM, once for the whole sequence (DMMCMD_CmdSaveEPROM).
+**
+*/
+u8 DMMCMD_CmdCalSeqStepDone(u8 bErrCode)
+{
+	CALSEQ_SUMMARY sum;
+	int idxStep;
+	const CALSEQ_STEP *pStep = CALSEQ_GetLastStep(&idxStep);
+	if(bErrCode == ERRVAL_CALSEQ_STATE || !pStep)
+	{
+		ERRORS_GetPrefixedMessageString(bErrCode, "", szMsg);
+		UART_PutString(szMsg);
+		return bErrCode;
+	}
+	sprintf(szMsg, "Step %d/%d, %s %s %s, %lu ms: ", idxStep + 1, CALSEQ_GetCntSteps(), rgScales[pStep->idxScale],
+			rgCalSeqTypes[pStep->bType], pStep->szRef, (unsigned long)pStep->dwMs);
+	UART_PutString(szMsg);
+	if(bErrCode == ERRVAL_SUCCESS)
+	{
+		DMM_FormatValue(pStep->dMeasuredVal, szVal, 1);
+		sprintf(szMsg, "Measured: %s, Dispersion: %.2f%%", szVal, pStep->dDispersion);
+		if(pszLastErr[0])
+		{
+			// append last error string to the message (used for calibration coefficients)
+			strcat(szMsg, ", ");
+			strcat(szMsg, pszLastErr);
+		}
+	}
+	ERRORS_GetPrefixedMessageString(bErrCode, "", szMsg);
+	UART_PutString(szMsg);
+	// the calibration coefficients are reported only by the step that completes the scale calibration
+	pszLastErr[0] = 0;
+	switch(CALSEQ_GetState())
+	{
+		case CALSEQ_STATE_RUNNING:
+			keyPendingCmd = CMD_CalSeqContinue;
+			break;
+		case CALSEQ_STATE_WAITSOURCE:
+			DMMCMD_CalSeqPrompt();
+			break;
+		default:
+			CALSEQ_GetSummary(&sum);
+			sprintf(szMsg, "Calibration sequence done, %d steps, %d failed, %d scale configurations, %d reference sources, steps %lu ms, total %lu ms",
+					sum.cSteps, sum.cFailed, sum.cScaleSwitches, sum.cSources, (unsigned long)sum.dwStepsMs, (unsigned long)sum.dwTotalMs);
+			ERRORS_GetPrefixedMessageString(ERRVAL_SUCCESS, "", szMsg);
+			UART_PutString(szMsg);
+			DMMCMD_CmdSaveEPROM();
+			break;
+	}
+	return bErrCode;
+}
+
+/***	DMMCMD_CalSeqPrompt
+**
+**	Parameters:
+**     none
+**
+**	Return Value:
+**		none
+**
+**	Description:
+**		This function sends over UART the prompt requesting the operator to connect the next reference source 
+**      of the calibration sequence.
+**
+*/
+void DMMCMD_CalSeqPrompt()
+{
+	char szPrompt[100];
+	CALSEQ_GetPrompt(szPrompt);
+	sprintf(szMsg, "%s, then send DMMCalSeqContinue\r\n", szPrompt);
+	UART_PutString(szMsg);
+}
+
+#if DMMCMD_USE_SCHED
+/***	DMMCMD_TaskCmdRx
+**
+**	Parameters:
+**     none
+**
+**	Return Value:
+**		<none>
+**
+**	Description:
+**		This function implements the command reception task of the scheduler.
+**      It checks on UART if a command was received and processes it, like DMMCMD_CheckForCommand.
+**      While a long operation is pending, the received command is left in the UART receive buffer, 
+**      so that it is processed after the operation is finished.
+**      A value retrieval in progress for the repeated measurement session is abandoned.
+**
+*/
+void DMMCMD_TaskCmdRx()
+{
+    char uartCmd[MAX_RCVCMD_LEN];
+    if(keyPendingCmd != CMD_NONE)
+    {
+    	return;
+    }
+    if(UART_GetString(uartCmd, MAX_RCVCMD_LEN) > 0)
+    {
+	    sprintf(szMsg, "Received command: %s\r\n", uartCmd);
+	    UART_PutString(szMsg);
+	    DMMCMD_ProcessCmd(DMMCMD_CmdDecode(uartCmd));
+	    fAcqInProgress = 0;
+	    if(keyPendingCmd != CMD_NONE)
+	    {
+	    	// start the long operation
+	    	SCHED_Signal(idTaskAcq);
+	    }
+    }
+}
+
+/***	DMMCMD_TaskAcquisition
+**
+**	Parameters:
+**     none
+**
+**	Return Value:
+**		<none>
+**
+**	Description:
+**		This function implements the acquisition task of the scheduler.
+**      If a long operation is pending, it performs one step of it (DMMCMD_StepPendingCmd) and, if the step requires,
+**      it programs the next run after the wait time.
+**      Otherwise, during DMMMeasureRep and DMMMeasureRaw repeated sessions, it performs one value retrieval step (DMM_DGetValueStep),
+**      eventually without calibration parameters being applied for DMMMeasureRaw.
+**      When the value is retrieved, the peaks of the peak-detect mode are read (DMM_GetPeaks) and the value is sent over UART by DMMCMD_SendRepeatedValue.
+**
+*/
+void DMMCMD_TaskAcquisition()
+{
+	uint8_t bErrCode;
+	unsigned int t10usWait;
+	if(keyPendingCmd != CMD_NONE)
+	{
+		if(DMMCMD_StepPendingCmd(&t10usWait) == ERRVAL_DMM_PENDING && t10usWait)
+		{
+			// resume after the wait time, rounded up to ms
+			SCHED_WakeAfter(idTaskAcq, (t10usWait + 99) / 100);
+		}
+		return;
+	}
+    if(fRepGetVal || fRepGetRaw)
+    {
+    	if(!fAcqInProgress)
+    	{
+    		DMM_DGetValueStart();
+    		fAcqInProgress = 1;
+    	}
+        if(fRepGetRaw)
+        {
+        	DMM_SetUseCalib(0);
+        }
+        bErrCode = DMM_DGetValueStep(&dMeasuredVal);
+        DMM_SetUseCalib(1);
+        if(bErrCode != ERRVAL_DMM_PENDING)
+        {
+        	fAcqInProgress = 0;
+        	DMM_GetPeaks(&dPeakMin, &dPeakMax);
+        	DMMCMD_SendRepeatedValue(bErrCode);
+        }
+    }
+}
+
+#endif
+
+/***	DMMCMD_TaskDisplay
+**
+**	Parameters:
+**     none
+**
+**	Return Value:
+**		<none>
+**
+**	Description:
+**		This function implements the display task, run by the scheduler or by the DMMCMD_CheckForCommand loop
+**      every DMMCMD_DISP_PERIODMS milliseconds.
+**      It updates the PmodOLED with the latest value information of the display mailbox, only when a value was posted
+**      since the previous update. The values posted in between are dropped.
+**      While the previous update is still sent over SPI, the value stays in the mailbox until the next run.
+**
+*/
+void DMMCMD_TaskDisplay()
+{
+	char szVal[sizeof(szDisplayVal)], szMode[sizeof(szDisplayMode)];
+	uint32_t cntPosted = cntDisplayPosted;
+	if(cntPosted != cntDisplayShown && !OLEDDISP_IsBusy())
+	{
+		strcpy(szVal, szDisplayVal);
+		strcpy(szMode, szDisplayMode);
+		cntDisplayShown = cntPosted;
+		cntDisplayRenders++;
+		DMMCMD_PmodOLEDRender(szVal, szMode);
+	}
+}
+
+/***	DMMCMD_TaskEprom
+**
+**	Parameters:
+**     none
+**
+**	Return Value:
+**		<none>
+**
+**	Description:
+**		This function implements the EPROM write task of the scheduler.
+**      It advances the EPROM background write queue (EPROM_AsyncTick), whose SPI transactions are interleaved 
+**      with the DMM transactions of the acquisition task, and reports the result of the background calibration save
+**      started by the DMMSaveEPROM command and of the background limits save started by the DMMSetLimit command.
+**
+*/
+void DMMCMD_TaskEprom()
+{
+	EPROM_AsyncTick();
+	if(fSaveDone)
+	{
+		fSaveDone = 0;
+		strcpy(szMsg, "Calibrations written to EPROM");
+		ERRORS_GetPrefixedMessageString(bSaveResult, "", szMsg);
+		UART_PutString(szMsg);
+	}
+	if(fLimitSaveDone)
+	{
+		fLimitSaveDone = 0;
+		strcpy(szMsg, "Limits written to EPROM");
+		ERRORS_GetPrefixedMessageString(bLimitSaveResult, "", szMsg);
+		UART_PutString(szMsg);
+	}
+}
+
+/***	DMMCMD_TaskTemp
+**
+**	Parameters:
+**     none
+**
+**	Return Value:
+**		<none>
+**
+**	Description:
+**		This function implements the temperature task, run by the scheduler or by the DMMCMD_CheckForCommand loop
+**      every DMMCMD_TEMP_PERIODMS milliseconds.
+**      It advances the die temperature reading (XADC_Tick), which never waits for the XADC. When the filtered temperature 
+**      changed, the temperature compensation factor of the current scale is recomputed (DMM_UpdateCorrection), 
+**      and in the AMP configuration it is passed to CPU1 (AMP_SetTempFactor). The acquisition path only applies the factor.
+**
+*/
+void DMMCMD_TaskTemp()
+{
+	if(XADC_Tick())
+	{
+		DMM_UpdateCorrection();
+#if AMP_ENABLE
+		AMP_SetTempFactor(CALIB_GetTempFactor(DMM_GetCurrentScale()));
+#endif
+	}
+}
+
+/***	DMMCMD_SaveEPROMDone
+**
+**	Parameters:
+**     uint8_t bResult      - the result of the background calibration save
+**
+**	Return Value:
+**		<none>
+**
+**	Description:
+**		This function is called by the EPROM background write queue when the calibration save started by DMMSaveEPROM is finished.
+**      The result is reported by the next run of DMMCMD_TaskEprom, after the command message.
+**
+*/
+void DMMCMD_SaveEPROMDone(uint8_t bResult)
+{
+	bSaveResult = bResult;
+	fSaveDone = 1;
+}
+
+/***	DMMCMD_LimitSaveDone
+**
+**	Parameters:
+**     uint8_t bResult      - the result of the background limits save
+**
+**	Return Value:
+**		<none>
+**
+**	Description:
+**		This function is called by the EPROM background write queue when the limits save started by DMMSetLimit is finished.
+**      The result is reported by the next run of DMMCMD_TaskEprom, after the command message.
+**
+*/
+void DMMCMD_LimitSaveDone(uint8_t bResult)
+{
+	bLimitSaveResult = bResult;
+	fLimitSaveDone = 1;
+}
+
+/***	DMMCMD_ProcessRepeatedCmd
+**
+**	Parameters:
+**     none
+**
+**	Return Value:
+**		uint8_t     - the error code
+**          ERRVAL_SUCCESS              0       // success
+**          ERRVAL_DMM_VALIDDATATIMEOUT 0xFA    // valid data DMM timeout
+**          ERRVAL_DMM_IDXCONFIG        0xFC    // error, wrong current scale index
+**
+**	Description:
+**		This function implements the repeated session functionality for DMMMeasureRep and DMMMeasureRaw text commands of DMMCMD module.
+**		The function calls the DMM_DGetValue, eventually without calibration parameters being applied for DMMMeasureRaw.
+**		In the AMP configuration the values are acquired by CPU1, the function extracts one value from the AMP queue, if available.
+**		The peak values of the conversion (DMMMode Peak) are retrieved with the value.
+**		The value or the error message is sent over UART by DMMCMD_SendRepeatedValue.
+**      The function is called by DMMCMD_CheckForCommand function.
+*/
+uint8_t DMMCMD_ProcessRepeatedCmd()
+{
+	uint8_t bErrCode = ERRVAL_SUCCESS;
+#if AMP_ENABLE
+	SPSCQ_SAMPLE sample;
+	// the values are acquired by CPU1
+    if((fRepGetVal || fRepGetRaw) && !fRepBlock && AMP_GetSample(&sample))
+    {
+    	bErrCode = sample.bErr;
+    	dMeasuredVal = sample.dVal;
+    	dPeakMin = sample.fPeakMin;
+    	dPeakMax = sample.fPeakMax;
+#else
+    if((fRepGetVal || fRepGetRaw) && !fRepBlock)
+    {
+        if(fRepGetRaw)
+        {
+        	DMM_SetUseCalib(0);
+        }
+        dMeasuredVal = DMM_DGetValue(&bErrCode);
+        DMM_SetUseCalib(1);
+        DMM_GetPeaks(&dPeakMin, &dPeakMax);
+#endif
+        DMMCMD_SendRepeatedValue(bErrCode);
+    }
+    return bErrCode;
+}
+
+/***	DMMCMD_SendRepeatedValue
+**
+**	Parameters:
+**     uint8_t bErrCode     - the error code of the value retrieval, the value is in dMeasuredVal
+**
+**	Return Value:
+**		<none>
+**
+**	Description:
+**		This function sends over UART a value of the DMMMeasureRep and DMMMeasureRaw repeated command sessions.
+**		In case of success, the value is formatted and sent over UART, and for DMMMeasureRep it is also displayed on PmodOLED
+**		and added to the trend graph readings.
+**		The measurement mode (DMMMode) is applied by DMMCMD_ModeValue, which adds the mode result to the message and displays the mode value.
+**		The value is checked against the limits of the scale (DMMCMD_CheckLimits), which sends an alarm when the limit state changes.
+**		When the trigger engine is armed (DMMTrigArm), the value is passed to DMMCMD_TrigValue instead of being sent over UART.
+**		When the limits are monitored (DMMLimitMonitor), the value is not sent over UART.
+**		In case of error, the error specific message is sent over UART.
+**
+*/
+void DMMCMD_SendRepeatedValue(uint8_t bErrCode)
+{
+    if(bErrCode == ERRVAL_SUCCESS)
+    {
+        if(fRepGetVal)
+        {
+            DMM_FormatValue(dMeasuredVal, szVal, 1);
+            sprintf(szMsg, "Value: %s", szVal);
+            TREND_AddSample(dMeasuredVal, DMM_GetCurrentScale());
+        	DMMCMD_ModeValue();
+        	DMMCMD_CheckLimits();
+        	if(fTrigActive)
+        	{
+        		DMMCMD_TrigValue();
+        		return;
+        	}
+        	if(fLimitMonitor)
+        	{
+        		return;
+        	}
+        }
+        else
+        {
+            sprintf(szMsg, "Raw Value: %.6lf\r\n", dMeasuredVal);
+        }
+    }
+    else
+    {
+        ERRORS_GetPrefixedMessageString(bErrCode, "", szMsg);
+    }
+    UART_PutString(szMsg);
+}
+
+/***	DMMCMD_TrigValue
+**
+**	Parameters:
+**     none
+**
+**	Return Value:
+**		<none>
+**
+**	Description:
+**		This function passes the value of the DMMTrigArm session (dMeasuredVal) to the trigger engine (TRIG_AddSample).
+**		When a capture is complete, it is sent over UART as one block, without blocking the acquisition:
+**		the header line is sent for the value which completed the capture, then a line of DMMCMD_TRIG_VALSPERLINE values
+**		for each of the following values, which are not passed to the engine. The end line rearms the engine (TRIG_Rearm):
+**          Trigger n: Type, c values, trigger at index i
+**          v0, v1, ...
+**          Trigger end
+**		The captured values are sent in the base unit, out of range values as inf.
+**
+*/
+void DMMCMD_TrigValue()
+{
+	int idx, cCaptured;
+	char *pch;
+	if(TRIG_GetState() != TRIG_STATE_DONE)
+	{
+		if(!TRIG_AddSample(dMeasuredVal, DMM_GetCurrentScale()))
+		{
+			return;
+		}
+		idxTrigReport = -1;
+	}
+	cCaptured = TRIG_GetCntCaptured();
+	if(idxTrigReport < 0)
+	{
+		sprintf(szMsg, "Trigger %lu: %s, %d values, trigger at index %d\r\n", (unsigned long)TRIG_GetCntTriggers(),
+				rgTrigTypes[TRIG_GetConfig()->bType], cCaptured, TRIG_GetConfig()->cPre);
+		idxTrigReport = 0;
+	}
+	else if(idxTrigReport < cCaptured)
+	{
+		pch = szMsg;
+		for(idx = idxTrigReport; idx < cCaptured && idx < idxTrigReport + DMMCMD_TRIG_VALSPERLINE; idx++)
+		{
+			pch += sprintf(pch, (idx > idxTrigReport) ? ", %.6e": "%.6e", TRIG_GetCaptured(idx));
+		}
+		strcpy(pch, "\r\n");
+		idxTrigReport = idx;
+	}
+	else
+	{
+		strcpy(szMsg, "Trigger end\r\n");
+		TRIG_Rearm();
+	}
+	UART_PutString(szMsg);
+}
+
+/***	DMMCMD_CheckLimits
+**
+**	Parameters:
+**     none
+**
+**	Return Value:
+**		<none>
+**
+**	Description:
+**		This function checks the repeated session value (dMeasuredVal, formatted in szVal) against the limits of the current scale
+**		(LIMIT_Check). When the limit state changes, a short alarm line is sent over UART, without waiting for the host:
+**          Alarm: High, Scale, Value
+**		The state is High or Low when a limit is exceeded, Normal when the value came back inside the limits.
+**		The alarm uses szAlarm, so the value message in szMsg is kept.
+**
+*/
+void DMMCMD_CheckLimits()
+{
+	char szAlarm[60];
+	int idxScale = DMM_GetCurrentScale();
+	uint8_t bEvt = LIMIT_Check(dMeasuredVal, idxScale);
+	if(bEvt != LIMIT_EVT_NONE)
+	{
+		sprintf(szAlarm, "Alarm: %s, %s, %s\r\n", rgLimitStates[bEvt], rgScales[idxScale], szVal);
+		UART_PutString(szAlarm);
+	}
+}
+
+/***	DMMCMD_ModeValue
+**
+**	Parameters:
+**     none
+**
+**	Return Value:
+**		<none>
+**
+**	Description:
+**		This function applies the measurement mode to the repeated session value (dMeasuredVal).
+**		The value is added to the mode statistics (MODE_AddSample), then the mode result is appended to the value message in szMsg,
+**		which is terminated by CR+LF:
+**          Value: x, Min: a, Max: b        MinMax mode
+**          Value: x, Hold: h               Hold mode, None until the values are stable
+**          Value: x, Rel: d                Rel mode
+**          Value: x, PkMin: a, PkMax: b, PkPk: p, Crest: c     Peak mode, the crest factor is None on the DC scales
+**		The peak values of the conversion (dPeakMin, dPeakMax) are added to the mode statistics (MODE_AddPeaks),
+**		with the value as RMS value on the AC scales.
+**		The mode value (MODE_GetValue) is displayed on PmodOLED instead of the value, and a short mode information on the mode row.
+**
+*/
+void DMMCMD_ModeValue()
+{
+	char szModeVal[20], szRow[20], szLo[20], szHi[20];
+	char *pch = szMsg + strlen(szMsg);
+	double dModeVal;
+	MODE_AddSample(dMeasuredVal, DMM_GetCurrentScale());
+	MODE_AddPeaks(dPeakMin, dPeakMax, DMM_FACScale(DMM_GetCurrentScale()) ? dMeasuredVal: NAN);
+	dModeVal = MODE_GetValue(dMeasuredVal);
+	DMMCMD_FormatModeValue(dModeVal, szModeVal, 0);
+	switch(MODE_Get())
+	{
+		case MODE_MINMAX:
+			DMMCMD_FormatModeValue(MODE_GetMin(), szLo, 0);
+			DMMCMD_FormatModeValue(MODE_GetMax(), szHi, 0);
+			pch += sprintf(pch, ", Min: %s, Max: %s", szLo, szHi);
+			DMMCMD_FormatModeValue(MODE_GetMin(), szLo, 1);
+			DMMCMD_FormatModeValue(MODE_GetMax(), szHi, 1);
+			sprintf(szRow, "L%s H%s", szLo, szHi);
+			break;
+		case MODE_HOLD:
+			pch += sprintf(pch, ", Hold: %s", szModeVal);
+			strcpy(szRow, isnan(dModeVal) ? "HOLD ---": "HOLD");
+			break;
+		case MODE_REL:
+			pch += sprintf(pch, ", Rel: %s", szModeVal);
+			DMMCMD_FormatModeValue(MODE_GetRef(), szLo, 1);
+			sprintf(szRow, "REL %s", szLo);
+			break;
+		case MODE_PEAK:
+			DMMCMD_FormatModeValue(MODE_GetPeakMin(), szLo, 0);
+			DMMCMD_FormatModeValue(MODE_GetPeakMax(), szHi, 0);
+			pch += sprintf(pch, ", PkMin: %s, PkMax: %s, PkPk: %s", szLo, szHi, szModeVal);
+			DMMCMD_FormatCrest(MODE_GetCrest(), szLo);
+			pch += sprintf(pch, ", Crest: %s", szLo);
+			if(DMM_FACScale(DMM_GetCurrentScale()))
+			{
+				sprintf(szRow, "PK-PK CF %.5s", isnan(MODE_GetCrest()) ? "---": szLo);
+			}
+			else
+			{
+				strcpy(szRow, "PK-PK");
+			}
+			break;
+		default:
+			szRow[0] = 0;
+			break;
+	}
+	strcpy(pch, "\r\n");
+	DMMCMD_PmodOLEDDisplay(isnan(dModeVal) ? "No value": szModeVal, szRow);
+}
+
+/***	DMMCMD_FormatModeValue
+**
+**	Parameters:
+**     double dVal              - the value to be formatted, in the base unit
+**     char *pszVal             - the string to get the formatted value, at least 20 characters
+**     uint8_t fShort           - 1 for the short format of the PmodOLED mode row, 0 for the DMM_FormatValue format
+**
+**	Return Value:
+**		<none>
+**
+**	Description:
+**		This function formats a measurement mode value according to the current scale. A missing value (NAN) is formatted as None.
+**		The short format has no unit and at most DMMCMD_MODE_SHORTLEN characters, an out of range value is formatted as OL.
+**
+*/
+void DMMCMD_FormatModeValue(double dVal, char *pszVal, uint8_t fShort)
+{
+	int cch;
+	if(isnan(dVal))
+	{
+		strcpy(pszVal, fShort ? "---": "None");
+	}
+	else if(!fShort)
+	{
+		DMM_FormatValue(dVal, pszVal, 1);
+	}
+	else if(isinf(dVal))
+	{
+		strcpy(pszVal, "OL");
+	}
+	else
+	{
+		DMM_FormatValue(dVal, pszVal, 0);
+		cch = strlen(pszVal);
+		if(cch > DMMCMD_MODE_SHORTLEN)
+		{
+			cch = DMMCMD_MODE_SHORTLEN;
+		}
+		// no decimal point without decimals
+		if(pszVal[cch - 1] == '.')
+		{
+			cch--;
+		}
+		pszVal[cch] = 0;
+	}
+}
+
+/***	DMMCMD_FormatCrest
+**
+**	Parameters:
+**     double dCrest            - the crest factor, NAN if not available
+**     char *pszCrest           - the string to get the formatted crest factor
+**
+**	Return Value:
+**		<none>
+**
+**	Description:
+**		This function formats a crest factor with 3 decimals, or as None when it is not available (DC scales).
+**
+*/
+void DMMCMD_FormatCrest(double dCrest, char *pszCrest)
+{
+	if(isnan(dCrest))
+	{
+		strcpy(pszCrest, "None");
+	}
+	else
+	{
+		sprintf(pszCrest, "%.3f", dCrest);
+	}
+}
+
+/***	DMMCMD_PmodOLEDDisplay
+**
+**	Parameters:
+**     char const *pszVal           - the character string containing the value information
+**     char const *pszMode          - the character string containing the measurement mode information, empty without mode
+**
+**	Return Value:
+**		<none>
+**
+**	Description:
+**		This function implements the regular display on PmpdOLED.
+**		The value information and the measurement mode information are stored in the display mailbox, overwriting the value not yet displayed.
+**		When the timer is running, the value is only posted,
+**		and the display is updated by the display task at DMMCMD_DISP_REFRESHHZ, so the acquisition is not limited by the display speed.
+**		Otherwise the display is updated immediately by DMMCMD_PmodOLEDRender.
+**
+**
+*/
+void DMMCMD_PmodOLEDDisplay(char *pszVal, char *pszMode)
+{
+	// overwrite the value not yet displayed
+	strncpy(szDisplayVal, pszVal, sizeof(szDisplayVal) - 1);
+	strncpy(szDisplayMode, pszMode, sizeof(szDisplayMode) - 1);
+	if(fTimerInit)
+	{
+		cntDisplayPosted++;
+	}
+	else
+	{
+		DMMCMD_PmodOLEDRender(szDisplayVal, szDisplayMode);
+	}
+}
+
+/***	DMMCMD_PmodOLEDRender
+**
+**	Parameters:
+**     char const *pszVal           - the character string containing the value information
+**     char const *pszMode          - the character string containing the measurement mode information
+**
+**	Return Value:
+**		<none>
+**
+**	Description:
+**		This function updates the PmodOLED.
+**		It displays the current selected scale on the first row, redrawn only when the scale changes.
+**		It displays the measurement mode information on the second row, redrawn only when it changes.
+**		It displays the value with the large digits font on the last 2 pages, redrawing only the digits that changed (BIGFONT_DrawValue).
+**		The value information that has no large glyphs (for example "No value" or "OVERLOAD") is displayed with the regular font on the forth row.
+**		In the trend view (DMMDisplayTrend), it displays the value information on the first row and the trend graph (TREND_Draw) on the other pages.
+**		The frame is drawn in the driver buffer and only the changes since the previous update are sent:
+**		when the timer is running by OLEDDISP_FlushAsync, which returns without waiting for the SPI transfer, otherwise by OLEDDISP_Flush.
+**
+**
+*/
+void DMMCMD_PmodOLEDRender(char *pszVal, char *pszMode)
+{
+	int idxScale = DMM_GetCurrentScale();
+	uint8_t *pbFrame = myPmodOLEDDevice.OLEDState.rgbOledBmp;
+
+	if(fTrendView)
+	{
+		memset(pbFrame + DMMCMD_DISP_TRENDROW * ccolOledMax, 0, ccolOledMax);
+		OLED_SetCursor(&myPmodOLEDDevice, (16 - strlen(pszVal))/2, DMMCMD_DISP_TRENDROW);
+		OLED_PutString(&myPmodOLEDDevice, pszVal);
+		TREND_Draw(pbFrame, DMMCMD_DISP_TRENDPAGE, DMMCMD_DISP_TRENDPAGES);
+	}
+	else if(idxScale != idxScaleShown)
+	{
+		memset(pbFrame + DMMCMD_DISP_SCALEROW * ccolOledMax, 0, ccolOledMax);
+		if(idxScale != -1)
+		{
+			OLED_SetCursor(&myPmodOLEDDevice, (16 - strlen(rgScales[idxScale]))/2, DMMCMD_DISP_SCALEROW);
+			OLED_PutString(&myPmodOLEDDevice, (char *)rgScales[idxScale]);
+		}
+		else
+		{
+			OLED_SetCursor(&myPmodOLEDDevice, 4, DMMCMD_DISP_SCALEROW);
+			OLED_PutString(&myPmodOLEDDevice, "No scale");
+		}
+		idxScaleShown = idxScale;
+	}
+	if(!fTrendView && strcmp(pszMode, szModeShown))
+	{
+		memset(pbFrame + DMMCMD_DISP_MODEROW * ccolOledMax, 0, ccolOledMax);
+		OLED_SetCursor(&myPmodOLEDDevice, (16 - strlen(pszMode))/2, DMMCMD_DISP_MODEROW);
+		OLED_PutString(&myPmodOLEDDevice, pszMode);
+		strcpy(szModeShown, pszMode);
+	}
+
+	if(!fTrendView && BIGFONT_DrawValue(pbFrame, DMMCMD_DISP_VALUEPAGE, pszVal) < 0)
+	{
+		memset(pbFrame + DMMCMD_DISP_VALUEPAGE * ccolOledMax, 0, BIGFONT_PAGES * ccolOledMax);
+		BIGFONT_Invalidate();
+		OLED_SetCursor(&myPmodOLEDDevice, (16 - strlen(pszVal))/2, DMMCMD_DISP_VALUEPAGE + 1);
+		OLED_PutString(&myPmodOLEDDevice, pszVal);
+	}
+    // send only the changed column ranges
+    if(fTimerInit)
+    {
+    	OLEDDISP_FlushAsync();
+    }
+    else
+    {
+    	OLEDDISP_Flush();
+    }
+}
@@ -44,7 +44,26 @@ typedef enum {
 	CMD_FinalizeCalibP,
 	CMD_FinalizeCalibN,
 	CMD_RestoreFactCalibs,
-	CMD_ReadSerialNo
+	CMD_ReadSerialNo,
+	CMD_SchedStats,
+	CMD_DisplayStats,
+	CMD_DisplayTrend,
+	CMD_RevalidateEPROM,
+	CMD_ImportCorr,
+	CMD_CalSeqAdd,
+	CMD_CalSeqClear,
+	CMD_CalSeqStart,
+	CMD_CalSeqContinue,
+	CMD_CalSeqAbort,
+	CMD_GetTemp,
+	CMD_SetTempCoeff,
+	CMD_TrigConfig,
+	CMD_TrigArm,
+	CMD_SetLimit,
+	CMD_LimitMonitor,
+	CMD_Mode,
+	CMD_ModeReset,
+	CMD_ModeGet
 
 } cmd_key_t;
 
@@ -54,10 +73,55 @@ typedef struct {
 	cmd_key_t eCmd;
 } cmd_map_t;
 /************************** Definitions ******************************/
+// command processing
+//  DMMCMD_USE_SCHED 0 - Demo_UART_Dispatch calls DMMCMD_CheckForCommand in a loop, each command is completed before returning
+//  DMMCMD_USE_SCHED 1 - the work is split in tasks run by the cooperative scheduler (SCHED module), see DMMCMD_InitTasks
+#ifndef DMMCMD_USE_SCHED
+#define DMMCMD_USE_SCHED        1
+#endif
+
+// scheduler tasks period and relative deadline (ms)
+#define DMMCMD_ACQ_PERIODMS     1       // acquisition: repeated measurement and long operations (scale configuration, calibration)
+#define DMMCMD_ACQ_DEADLINEMS   5
+#define DMMCMD_RX_PERIODMS      10      // command reception and processing
+#define DMMCMD_RX_DEADLINEMS    20
+#define DMMCMD_TX_PERIODMS      2       // UART transmission
+#define DMMCMD_TX_DEADLINEMS    5
+#define DMMCMD_DISP_PERIODMS    (1000 / DMMCMD_DISP_REFRESHHZ)  // PmodOLED update, when the displayed information changed
+#define DMMCMD_DISP_DEADLINEMS  DMMCMD_DISP_PERIODMS
+#define DMMCMD_EPROM_PERIODMS   1       // EPROM background write: one SPI transaction per run
+#define DMMCMD_EPROM_DEADLINEMS 5
+#define DMMCMD_TEMP_PERIODMS    250     // die temperature reading (XADC) and temperature compensation update, also used by the DMMCMD_CheckForCommand loop
+#define DMMCMD_TEMP_DEADLINEMS  50
+
+// PmodOLED layout: the scale on a text row (8 pixels), the value with the large digits font on 2 pages (16 pixels)
+#define DMMCMD_DISP_SCALEROW    0
+#define DMMCMD_DISP_VALUEPAGE   2
+// the measurement mode information (DMMMode) on the text row between them
+#define DMMCMD_DISP_MODEROW     1
+// trend view: the value on a text row, the trend graph of the last readings on the remaining pages
+#define DMMCMD_DISP_TRENDROW    0
+#define DMMCMD_DISP_TRENDPAGE   1
+#define DMMCMD_DISP_TRENDPAGES  3
+
+// measurement mode row: maximum number of characters of each value
+#define DMMCMD_MODE_SHORTLEN    6
+
+// trigger capture report: number of values sent on each line, one line for each acquired value
+#define DMMCMD_TRIG_VALSPERLINE 8
+
+// PmodOLED refresh rate (Hz, 5 - 20), independent of the acquisition rate, also used by the DMMCMD_CheckForCommand loop
+#ifndef DMMCMD_DISP_REFRESHHZ
+#define DMMCMD_DISP_REFRESHHZ   10
+#endif
+#if DMMCMD_DISP_REFRESHHZ < 5 || DMMCMD_DISP_REFRESHHZ > 20
+#error "DMMCMD_DISP_REFRESHHZ must be between 5 and 20 Hz"
+#endif
 
 /************************** Function Prototypes ******************************/
 u8 DMMCMD_Init();
 void DMMCMD_CheckForCommand();
+u8 DMMCMD_InitTasks();
 
 
 
@@ -17,6 +17,13 @@
         In this section the EPROM module provides Initialization, data write and data read functions
         as well as implementations for Erase and Write Enable / Disable instructions.
         The EPROM write function EPROM_WriteWords prevents user from writing to addresses where system data is stored.
+        The whole EPROM is read once by EPROM_Init in a RAM image, which then serves all the reads. The writes and the erase
+        update the image and go through to the EPROM. EPROM_RevalidateImage compares the image with the EPROM content.
+        The system records (serial number, calibration) start with a format byte and end with a check byte, 
+        see EPROM_CheckRecord and EPROM_SealRecord.
+        EPROM_WriteWordsAsync queues the words to be written in background: EPROM_AsyncTick, called periodically, 
+        sends one word at a time as a transaction of the asynchronous SPI engine, so the EPROM transactions are interleaved 
+        with the DMM transactions, and polls the end of the self-timed write cycle without blocking.
         The "Internal low level functions" section groups functions that are called from other modules (CALIB and SERIALNO). 
         They are not intended to be called by user.
         The "Local functions" section groups low level functions that are only called from within the current module. 
@@ -42,6 +49,7 @@
 #include "eprom.h"
 #include "errors.h"
 #include "utils.h"
+#include "timer.h"
 
 /* ************************************************************************** */
 /* ************************************************************************** */
@@ -51,8 +59,38 @@
 void EPROM_StartBitOpAddr_Raw(uint8_t bOp, uint8_t bAddress);
 uint8_t EPROM_WaitUntilReady_Raw();
 uint16_t EPROM_Read_Raw(uint8_t bAddress);
+void EPROM_ReadSeq_Raw(uint8_t bAddress, uint16_t *prgVals, int cwVals);
 uint8_t EPROM_Write_Raw(uint8_t bAddress, uint16_t wVal);
 uint8_t EPROM_WriteWords_Raw(uint8_t bAddress, uint16_t *prgVals, int cwVals);
+uint8_t EPROM_WriteWordsAsync_Raw(uint8_t bAddress, uint16_t *prgVals, int cwVals, EPROM_CALLBACK pfnDone);
+uint8_t EPROM_AsyncIssue(uint8_t bState);
+void EPROM_AsyncPop(uint8_t bResult);
+void EPROM_LoadImage_Raw();
+uint8_t EPROM_CheckUserArea(uint8_t bAddress, int cwVals);
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Global Variables                                                  */
+/* ************************************************************************** */
+/* ************************************************************************** */
+// SPI transaction issued by the background write queue
+#define EPROM_ASYNC_IDLE    0
+#define EPROM_ASYNC_EWEN    1       // write enable
+#define EPROM_ASYNC_WRITE   2       // write of the first queued word
+#define EPROM_ASYNC_STATUS  3       // ready / busy status read
+#define EPROM_ASYNC_EWDS    4       // write disable
+
+static EPROM_WRITE rgWriteQueue[EPROM_ASYNC_QUEUESIZE];     // words to be written, filled by EPROM_WriteWordsAsync_Raw
+static int idxWriteHead = 0, cWriteQueued = 0;              // first queued, number of queued words
+static uint8_t bAsyncState = EPROM_ASYNC_IDLE;              // transaction issued last, or to be issued when fAsyncIssued is 0
+static uint8_t fAsyncIssued = 0;                            // the transaction is queued to the SPI engine
+static SPI_XFER xferAsync;
+static uint8_t rgbAsyncData[2];                             // word transmitted by EPROM_ASYNC_WRITE, ready status received by EPROM_ASYNC_STATUS
+static uint32_t dwAsyncWriteMs;                             // start of the self-timed write cycle
+
+// RAM image of the whole EPROM, holding the queued background writes too
+static uint16_t rgwImage[EPROM_CWORDS];
+static uint8_t fImageValid = 0;                             // cleared when a write fails, the image is read again
 
 /* ************************************************************************** */
 /* ************************************************************************** */
@@ -71,6 +109,7 @@ uint8_t EPROM_WriteWords_Raw(uint8_t bAddress, uint16_t *prgVals, int cwVals);
 **	Description:
 **		This function initializes the EPROM module. 
 **      It calls the SPI_Init() function to initialize the digital pins used by DMMShield.
+**      Then it reads the whole EPROM in the RAM image.
 **      This function is called by CALIB_Init() and SERIALNO_Init().
 **      The function guards against multiple calls using a static flag variable.
 **      
@@ -82,6 +121,7 @@ void EPROM_Init()
     if(!fInitialized)
     {
         SPI_Init();
+        EPROM_LoadImage_Raw();
         fInitialized = 1;
     }
 }
@@ -100,18 +140,60 @@ void EPROM_Init()
 **
 **	Description:
 **		This function reads the specified number of words (16 bit values) from the specified EPROM word address into the specified buffer.  
+**      The words are copied from the RAM image, including the words queued for background write.
+**      If the image is not valid (a write failed), the whole EPROM is read again in the image before.
 **            
 */
 void EPROM_ReadWords(uint8_t bAddress, uint16_t *prgVals, int cwVals)
 {
     int i;
-    
+    if(!fImageValid)
+    {
+        EPROM_LoadImage_Raw();
+    }
     for(i = 0; i < cwVals; i++)
     {
-        prgVals[i] = EPROM_Read_Raw(bAddress + i);
+        prgVals[i] = rgwImage[(uint8_t)(bAddress + i)];
     }
 }
 
+/* ************************************************************************** */
+/***	EPROM_RevalidateImage
+**
+**	Parameters:
+**      int *pcwMismatch        - pointer to receive the number of words of the RAM image that differ from the EPROM content
+**
+**	Return Value:
+**		uint8_t 
+**          ERRVAL_SUCCESS                  0       // success, the image is identical to the EPROM content
+**          ERRVAL_EPROM_VERIFY             0xF7    // eprom verify error, mismatch values found
+**
+**	Description:
+**		This function checks the integrity of the RAM image: it finishes the background writes, reads the whole EPROM
+**      and compares it with the image. Then the image is replaced by the EPROM content, 
+**      so that the following reads return the data actually stored in EPROM.
+**            
+*/
+uint8_t EPROM_RevalidateImage(int *pcwMismatch)
+{
+    uint16_t rgwDevice[EPROM_CWORDS];
+    int i, cwMismatch = 0;
+    EPROM_AsyncWaitIdle();  // finish the background writes
+    SPI_AsyncWaitIdle();    // finish the queued asynchronous DMM transactions
+    EPROM_ReadSeq_Raw(0, rgwDevice, EPROM_CWORDS);
+    for(i = 0; i < EPROM_CWORDS; i++)
+    {
+        cwMismatch += (rgwDevice[i] != rgwImage[i]) || !fImageValid;
+        rgwImage[i] = rgwDevice[i];
+    }
+    fImageValid = 1;
+    if(pcwMismatch)
+    {
+        *pcwMismatch = cwMismatch;
+    }
+    return cwMismatch ? ERRVAL_EPROM_VERIFY : ERRVAL_SUCCESS;
+}
+
 
 
 /* ************************************************************************** */
@@ -126,30 +208,244 @@ void EPROM_ReadWords(uint8_t bAddress, uint16_t *prgVals, int cwVals)
 **		uint8_t 
 **          ERRVAL_SUCCESS                  0       // success
 **          ERRVAL_EPROM_ADDR_VIOLATION     0xF6    // EPROM write address violation: attempt to write over system data
+**          ERRVAL_EPROM_USERAREA           0xE2    // EPROM write to words removed from the user area
 **          ERRVAL_EPROM_WRTIMEOUT          0xFF    // EPROM write data ready timeout
 **
 **	Description:
 **		This function writes the specified number of words (16-bit values) in EPROM, at the specified word address.
 **      It is mandatory to enable the write operation before sending the data to EPROM, by calling the EPROM_WriteEnable() function. 
-**      The function returns  ERRVAL_EPROM_ADDR_VIOLATION if write is attempted over the system reserved areas of EPROM.
+**      The function returns an error if write is attempted outside the user area (see EPROM_CheckUserArea).
 **      Otherwise, the function returns ERRVAL_SUCCESS for success or ERRVAL_EPROM_WRTIMEOUT when EPROM is 
 **      not answering with the write successful message. 
 **            
 */
 uint8_t EPROM_WriteWords(uint8_t bAddress, uint16_t *prgVals, int cwVals)
 {
-    uint8_t bResult;
-    if(bAddress + cwVals - 1 >= (uint8_t)ADR_EPROM_CALIB || bAddress >= (uint8_t)ADR_EPROM_CALIB)
-    {
-        bResult = ERRVAL_EPROM_ADDR_VIOLATION;
-    }   
-    else
+    uint8_t bResult = EPROM_CheckUserArea(bAddress, cwVals);
+    if(bResult == ERRVAL_SUCCESS)
     {
         bResult = EPROM_WriteWords_Raw(bAddress, prgVals, cwVals);
     }
     return bResult;
 }
 
+/* ************************************************************************** */
+/***	EPROM_WriteWordsAsync
+**
+**	Parameters:
+**      uint8_t bAddress		- the word address of the EPROM memory location to be written
+**      uint16_t *prgVals       - pointer to an array of words (16 bits values), to be written in EPROM
+**      int cwVals              - number of words to be written in EPROM
+**      EPROM_CALLBACK pfnDone  - called when the words are written or the write failed, can be null
+**
+**	Return Value:
+**		uint8_t 
+**          ERRVAL_SUCCESS                  0       // success, the words are queued
+**          ERRVAL_EPROM_ADDR_VIOLATION     0xF6    // EPROM write address violation: attempt to write over system data
+**          ERRVAL_EPROM_USERAREA           0xE2    // EPROM write to words removed from the user area
+**
+**	Description:
+**		This function queues the specified number of words (16-bit values) to be written in EPROM in background, 
+**      at the specified word address, and returns. The write enable and disable instructions are sent by the queue.
+**      The values are copied, the array can be reused after the call.
+**      pfnDone is called from EPROM_AsyncTick with ERRVAL_SUCCESS or ERRVAL_EPROM_WRTIMEOUT.
+**      The function returns an error if write is attempted outside the user area (see EPROM_CheckUserArea), 
+**      in this case pfnDone is not called.
+**            
+*/
+uint8_t EPROM_WriteWordsAsync(uint8_t bAddress, uint16_t *prgVals, int cwVals, EPROM_CALLBACK pfnDone)
+{
+    uint8_t bResult = EPROM_CheckUserArea(bAddress, cwVals);
+    if(bResult != ERRVAL_SUCCESS)
+    {
+        return bResult;
+    }
+    return EPROM_WriteWordsAsync_Raw(bAddress, prgVals, cwVals, pfnDone);
+}
+
+/* ************************************************************************** */
+/***	EPROM_AsyncIsIdle
+**
+**	Parameters:
+**      none
+**
+**	Return Value:
+**		uint8_t     - 1 if no background write is queued or in progress, 0 otherwise
+**
+**	Description:
+**		This function returns the state of the background write queue.
+**            
+*/
+uint8_t EPROM_AsyncIsIdle()
+{
+    return bAsyncState == EPROM_ASYNC_IDLE && !fAsyncIssued && !cWriteQueued;
+}
+
+/* ************************************************************************** */
+/***	EPROM_AsyncWaitIdle
+**
+**	Parameters:
+**      none
+**
+**	Return Value:
+**		none
+**
+**	Description:
+**		This function runs EPROM_AsyncTick until all the background writes are finished.
+**      The synchronous EPROM functions call it before accessing the EPROM, that can be in a self-timed write cycle.
+**            
+*/
+void EPROM_AsyncWaitIdle()
+{
+    while(!EPROM_AsyncIsIdle())
+    {
+        EPROM_AsyncTick();
+    }
+}
+
+/* ************************************************************************** */
+/***	EPROM_AsyncTick
+**
+**	Parameters:
+**      none
+**
+**	Return Value:
+**		none
+**
+**	Description:
+**		This function advances the background write queue. It must be called periodically from the main loop
+**      (not from the interrupt context, as the synchronous DMM and EPROM functions drive the SPI pins directly), 
+**      for example by a scheduler task. It never waits: when the SPI transaction issued previously is not finished,
+**      it returns immediately.
+**      For each word, the queue issues the WRITE instruction, then reads the ready / busy status of EPROM until it is ready
+**      or EPROM_ASYNC_TIMEOUTMS milliseconds passed. The write enable instruction is issued before the first word,
+**      the write disable instruction after the last one.
+**      When the last word of a write request is written, its pfnDone is called with ERRVAL_SUCCESS.
+**      On a timeout, all the queued words are dropped and the pending pfnDone callbacks are called with ERRVAL_EPROM_WRTIMEOUT.
+**      The RAM image, which already holds the dropped words, is then read again by the next read.
+**            
+*/
+void EPROM_AsyncTick()
+{
+    if(fAsyncIssued)
+    {
+        if(!xferAsync.fDone)
+        {
+            return;
+        }
+        fAsyncIssued = 0;
+        // the transaction is finished, choose the next one
+        switch(bAsyncState)
+        {
+            case EPROM_ASYNC_EWEN:
+                bAsyncState = EPROM_ASYNC_WRITE;
+                break;
+            case EPROM_ASYNC_WRITE:
+                dwAsyncWriteMs = TIMER_GetMs();
+                bAsyncState = EPROM_ASYNC_STATUS;
+                break;
+            case EPROM_ASYNC_STATUS:
+                if(rgbAsyncData[0])
+                {
+                    // ready
+                    EPROM_AsyncPop(ERRVAL_SUCCESS);
+                    bAsyncState = cWriteQueued ? EPROM_ASYNC_WRITE : EPROM_ASYNC_EWDS;
+                }
+                else if((uint32_t)(TIMER_GetMs() - dwAsyncWriteMs) > EPROM_ASYNC_TIMEOUTMS)
+                {
+                    fImageValid = 0;    // the dropped words are in the image
+                    while(cWriteQueued)
+                    {
+                        EPROM_AsyncPop(ERRVAL_EPROM_WRTIMEOUT);
+                    }
+                    bAsyncState = EPROM_ASYNC_EWDS;
+                }
+                // otherwise read the status again
+                break;
+            case EPROM_ASYNC_EWDS:
+                bAsyncState = EPROM_ASYNC_IDLE;
+                break;
+        }
+    }
+    if(bAsyncState == EPROM_ASYNC_IDLE)
+    {
+        if(!cWriteQueued)
+        {
+            return;
+        }
+        bAsyncState = EPROM_ASYNC_EWEN;
+    }
+    // when the SPI engine queue is full, the transaction is issued by the next call
+    fAsyncIssued = (EPROM_AsyncIssue(bAsyncState) == ERRVAL_SUCCESS);
+}
+
+/* ************************************************************************** */
+/***	EPROM_CheckRecord
+**
+**	Parameters:
+**      uint8_t *pbRecord       - the record read from EPROM: format byte, data bytes, check byte
+**      int cbRecord            - the record size, in bytes
+**
+**	Return Value:
+**		uint8_t 
+**          ERRVAL_SUCCESS                  0       // success
+**          ERRVAL_EPROM_MAGICNO            0xFD    // wrong Magic No. when reading data from EPROM
+**          ERRVAL_EPROM_CRC                0xFE    // wrong CRC when reading data from EPROM
+**
+**	Description:
+**		This function checks a record read from EPROM. The first byte gives the record format:
+**      EPROM_MAGIC_CRC16 records are checked with the CRC-16 of the bytes before the 2 check bytes,
+**      EPROM_MAGIC_CRC8 records with the CRC-8 of the bytes before the check byte, 
+**      legacy EPROM_MAGIC_NO records with the additive checksum of the record bytes (the check byte counted as 0).
+**      The function returns ERRVAL_EPROM_MAGICNO for an unknown format and ERRVAL_EPROM_CRC when the check bytes are wrong.
+**            
+*/
+uint8_t EPROM_CheckRecord(uint8_t *pbRecord, int cbRecord)
+{
+    uint8_t bCheck, bCheckRead = pbRecord[cbRecord - 1];
+    uint16_t wCheck;
+    switch(pbRecord[0])
+    {
+        case EPROM_MAGIC_CRC16:
+            wCheck = GetBufferCrc16(CRC16_INIT, pbRecord, cbRecord - 2);
+            return (wCheck == (pbRecord[cbRecord - 2] | (pbRecord[cbRecord - 1] << 8))) ? ERRVAL_SUCCESS : ERRVAL_EPROM_CRC;
+        case EPROM_MAGIC_CRC8:
+            bCheck = GetBufferCrc8(pbRecord, cbRecord - 1);
+            break;
+        case EPROM_MAGIC_NO:
+            bCheck = GetBufferChecksum(pbRecord, cbRecord - 1);
+            break;
+        default:
+            // missing magic number
+            return ERRVAL_EPROM_MAGICNO;
+    }
+    return (bCheck == bCheckRead) ? ERRVAL_SUCCESS : ERRVAL_EPROM_CRC;
+}
+
+/* ************************************************************************** */
+/***	EPROM_SealRecord
+**
+**	Parameters:
+**      uint8_t *pbRecord       - the record to be written in EPROM: format byte, data bytes, check byte
+**      int cbRecord            - the record size, in bytes
+**
+**	Return Value:
+**		none
+**
+**	Description:
+**		This function sets the format byte of the record to EPROM_MAGIC_CRC16 and its last 2 bytes to the CRC-16 of the other bytes.
+**      The records are always written in this format, the CRC-8 and the legacy formats are only read.
+**            
+*/
+void EPROM_SealRecord(uint8_t *pbRecord, int cbRecord)
+{
+    uint16_t wCheck;
+    pbRecord[0] = EPROM_MAGIC_CRC16;
+    wCheck = GetBufferCrc16(CRC16_INIT, pbRecord, cbRecord - 2);
+    pbRecord[cbRecord - 2] = wCheck & 0xFF;
+    pbRecord[cbRecord - 1] = wCheck >> 8;
+}
+
 // Implementation of EPROM instructions
 
 /* ************************************************************************** */
@@ -168,6 +464,8 @@ uint8_t EPROM_WriteWords(uint8_t bAddress, uint16_t *prgVals, int cwVals)
 */
 void EPROM_WriteEnable()
 {
+    EPROM_AsyncWaitIdle();  // finish the background writes
+    SPI_AsyncWaitIdle();    // finish the queued asynchronous DMM transactions
     GPIO_SetValue_CS_EPROM(1); // Activate CS_EPROM
 
     // some delay
@@ -201,6 +499,8 @@ void EPROM_WriteEnable()
 */
 void EPROM_WriteDisable()
 {
+    EPROM_AsyncWaitIdle();  // finish the background writes
+    SPI_AsyncWaitIdle();    // finish the queued asynchronous DMM transactions
     GPIO_SetValue_CS_EPROM(1); // Activate CS_EPROM
 
     // Send instruction code
@@ -226,14 +526,18 @@ void EPROM_WriteDisable()
 **	Description:
 **		This function implements the ERASE EPROM instruction that erases one word.
 **      Call this function in order to force all 16 bits of the specified address to 1.
+**      The word of the RAM image is updated.
 **            
 */
 void EPROM_Erase(uint8_t bAddress)
 {
+    EPROM_AsyncWaitIdle();  // finish the background writes
+    SPI_AsyncWaitIdle();    // finish the queued asynchronous DMM transactions
     GPIO_SetValue_CS_EPROM(1); // Activate CS_EPROM
 
     // Send instruction code
     EPROM_StartBitOpAddr_Raw(EPROM_OPCODE_ERASE, bAddress);
+    rgwImage[bAddress] = 0xFFFF;
 
     GPIO_SetValue_CS_EPROM(0); // Deactivate CS_EPROM
 	GPIO_SetValue_MOSI(0);	// clear the MOSI GPIO pin
@@ -338,6 +642,70 @@ uint16_t EPROM_Read_Raw(uint8_t bAddress)
     return wVal;
 }
 
+/* ************************************************************************** */
+/***	EPROM_ReadSeq_Raw
+**
+**	Parameters:
+**      uint8_t bAddress		- the EPROM address of the first word to be read
+**      uint16_t *prgVals       - pointer to an array of 16-bit values, to store the values read from EPROM
+**      int cwVals              - number of 16-bit values to be read
+**
+**	Return Value:
+**		none
+**
+**	Description:
+**		This function reads consecutive words from EPROM using the sequential read of the Microwire EPROM: 
+**      the READ instruction and the address are sent once, then CS is kept active and the EPROM 
+**      increments the address internally and outputs the next word after each 16 data bits.
+**      Compared to one READ instruction for each word, this saves the CS toggle and the 11 start, opcode and 
+**      address bits for each word after the first one.
+**      The address wraps around at the end of the EPROM memory, as in EPROM_Read_Raw with an 8-bit address.
+**            
+*/
+void EPROM_ReadSeq_Raw(uint8_t bAddress, uint16_t *prgVals, int cwVals)
+{
+    int i;
+    uint16_t wVal;
+    if(cwVals <= 0)
+    {
+        return;
+    }
+    GPIO_SetValue_CS_EPROM(1); // Activate CS_EPROM
+
+    EPROM_StartBitOpAddr_Raw(EPROM_OPCODE_READ, bAddress);
+	GPIO_SetValue_MOSI(0);	// clear the MOSI GPIO pin
+    for(i = 0; i < cwVals; i++)
+    {
+        wVal = SPI_CoreTransferByte(0);                  // MSByte
+        prgVals[i] = (wVal << 8) | SPI_CoreTransferByte(0);   // LSByte
+    }
+
+	GPIO_SetValue_MOSI(0);	// clear the MOSI GPIO pin
+    GPIO_SetValue_CS_EPROM(0); // Deactivate CS_EPROM
+}
+
+/* ************************************************************************** */
+/***	EPROM_LoadImage_Raw
+**
+**	Parameters:
+**      none
+**
+**	Return Value:
+**		none
+**
+**	Description:
+**		This function reads the whole EPROM in the RAM image, with one sequential read.
+**      The background writes and the queued asynchronous DMM transactions are finished before.
+**            
+*/
+void EPROM_LoadImage_Raw()
+{
+    EPROM_AsyncWaitIdle();  // finish the background writes
+    SPI_AsyncWaitIdle();    // finish the queued asynchronous DMM transactions
+    EPROM_ReadSeq_Raw(0, rgwImage, EPROM_CWORDS);
+    fImageValid = 1;
+}
+
 /* ************************************************************************** */
 /***	EPROM_Write_Raw
 **
@@ -355,6 +723,7 @@ uint16_t EPROM_Read_Raw(uint8_t bAddress)
 **      It is mandatory to enable the write operation before sending the data to EPROM, by calling the EPROM_WriteEnable() function. 
 **      The function returns ERRVAL_SUCCESS for success or ERRVAL_EPROM_WRTIMEOUT when eprom is 
 **      not answering with write successful message. 
+**      On success the word of the RAM image is updated, otherwise the image is read again by the next read.
 **            
 */
 uint8_t EPROM_Write_Raw(uint8_t bAddress, uint16_t wVal)
@@ -372,6 +741,14 @@ uint8_t EPROM_Write_Raw(uint8_t bAddress, uint16_t wVal)
     GPIO_SetValue_CS_EPROM(0); // Deactivate CS_EPROM
 
     bResult = EPROM_WaitUntilReady_Raw();
+    if(bResult == ERRVAL_SUCCESS)
+    {
+        rgwImage[bAddress] = wVal;
+    }
+    else
+    {
+        fImageValid = 0;
+    }
     return bResult;
 
 }
@@ -402,6 +779,8 @@ uint8_t EPROM_WriteWords_Raw(uint8_t bAddress, uint16_t *prgVals, int cwVals)
 {
     uint8_t bResult = 0;
     int i;
+    EPROM_AsyncWaitIdle();  // finish the background writes
+    SPI_AsyncWaitIdle();    // finish the queued asynchronous DMM transactions
     
     for(i = 0; i < cwVals && !bResult; i++)
     {
@@ -411,6 +790,180 @@ uint8_t EPROM_WriteWords_Raw(uint8_t bAddress, uint16_t *prgVals, int cwVals)
 }
 
 
+/* ************************************************************************** */
+/***	EPROM_WriteWordsAsync_Raw
+**
+**	Parameters:
+**      uint8_t bAddress		- the address where the values will be written to
+**      uint16_t *prgVals       - pointer to an array of 16-bit values, to be written in EPROM
+**      int cwVals              - number of 16-bit values to be written in EPROM
+**      EPROM_CALLBACK pfnDone  - called when the words are written or the write failed, can be null
+**
+**	Return Value:
+**		uint8_t 
+**          ERRVAL_SUCCESS                  0       // success
+**          ERRVAL_EPROM_WRTIMEOUT          0xFF    // EPROM write data ready timeout (synchronous write)
+**
+**	Description:
+**		This function queues the specified number of words (16-bit values) to be written in EPROM in background, see EPROM_WriteWordsAsync.
+**      When the queue is full, it runs EPROM_AsyncTick until there is room for the words.
+**      The RAM image is updated when the words are queued.
+**      If the asynchronous SPI engine is not initialized, the words are written synchronously (with the write enable and disable
+**      instructions), pfnDone is called before returning and the write result is also returned.
+**      This function is not intended to be called by the user, as it might alter the content 
+**      of User Calibration, SerialNO, Factory Calibration areas of EPROM. User should call EPROM_WriteWordsAsync function instead.
+**            
+*/
+uint8_t EPROM_WriteWordsAsync_Raw(uint8_t bAddress, uint16_t *prgVals, int cwVals, EPROM_CALLBACK pfnDone)
+{
+    uint8_t bResult;
+    int i;
+    if(!SPI_AsyncIsReady())
+    {
+        EPROM_WriteEnable();
+        bResult = EPROM_WriteWords_Raw(bAddress, prgVals, cwVals);
+        EPROM_WriteDisable();
+        if(pfnDone)
+        {
+            pfnDone(bResult);
+        }
+        return bResult;
+    }
+    for(i = 0; i < cwVals; i++)
+    {
+        while(cWriteQueued == EPROM_ASYNC_QUEUESIZE)
+        {
+            EPROM_AsyncTick();
+        }
+        rgWriteQueue[(idxWriteHead + cWriteQueued) % EPROM_ASYNC_QUEUESIZE].bAddress = bAddress + i;
+        rgWriteQueue[(idxWriteHead + cWriteQueued) % EPROM_ASYNC_QUEUESIZE].wVal = prgVals[i];
+        rgWriteQueue[(idxWriteHead + cWriteQueued) % EPROM_ASYNC_QUEUESIZE].pfnDone = (i == cwVals - 1) ? pfnDone : 0;
+        cWriteQueued++;
+        rgwImage[(uint8_t)(bAddress + i)] = prgVals[i];
+    }
+    if(cwVals <= 0 && pfnDone)
+    {
+        pfnDone(ERRVAL_SUCCESS);
+    }
+    return ERRVAL_SUCCESS;
+}
+
+/* ************************************************************************** */
+/***	EPROM_AsyncIssue
+**
+**	Parameters:
+**      uint8_t bState          - the transaction: EPROM_ASYNC_EWEN, EPROM_ASYNC_WRITE, EPROM_ASYNC_STATUS or EPROM_ASYNC_EWDS
+**
+**	Return Value:
+**		uint8_t 
+**          ERRVAL_SUCCESS                  0       // success, the transaction is queued
+**          ERRVAL_SPI_ASYNC                0xEB    // the transaction cannot be queued
+**
+**	Description:
+**		This function queues to the asynchronous SPI engine the transaction of the background write queue.
+**      The instructions are the same as the ones sent by EPROM_WriteEnable, EPROM_Write_Raw and EPROM_WriteDisable: 
+**      start bit, 2-bit operation code and 8 address bits as command bits, followed by the data word for WRITE.
+**      The status read keeps the chip select active while 8 clocks are generated with MOSI low, that is not a start bit:
+**      MISO is high when the self-timed write cycle is finished.
+**            
+*/
+uint8_t EPROM_AsyncIssue(uint8_t bState)
+{
+    EPROM_WRITE *pWrite = &rgWriteQueue[idxWriteHead];
+    xferAsync.dwCsMask = GPIO_Mask_CS_EPROM;
+    xferAsync.bCsActive = 1;
+    xferAsync.cTicksCs = EPROM_ASYNC_CSTICKS;
+    xferAsync.cbCmdBits = 11;
+    xferAsync.fReadClock = 0;
+    xferAsync.fRead = 0;
+    xferAsync.pbData = rgbAsyncData;
+    xferAsync.cbData = 0;
+    xferAsync.pfnDone = 0;
+    xferAsync.pRef = 0;
+    switch(bState)
+    {
+        case EPROM_ASYNC_EWEN:
+            xferAsync.wCmd = (((1 << 2) | EPROM_OPCODE_EWEN) << 8) | 0xC0;
+            break;
+        case EPROM_ASYNC_WRITE:
+            xferAsync.wCmd = (((1 << 2) | EPROM_OPCODE_WRITE) << 8) | pWrite->bAddress;
+            rgbAsyncData[0] = pWrite->wVal >> 8;      // MSByte
+            rgbAsyncData[1] = pWrite->wVal & 0xFF;    // LSByte
+            xferAsync.cbData = 2;
+            break;
+        case EPROM_ASYNC_STATUS:
+            xferAsync.cbCmdBits = 0;
+            xferAsync.fRead = 1;
+            xferAsync.cbData = 1;
+            break;
+        default:
+            xferAsync.wCmd = (((1 << 2) | EPROM_OPCODE_EWDS) << 8) | 0x00;
+            break;
+    }
+    return SPI_AsyncQueue(&xferAsync);
+}
+
+/* ************************************************************************** */
+/***	EPROM_CheckUserArea
+**
+**	Parameters:
+**      uint8_t bAddress		- the word address of the first word to be written
+**      int cwVals              - number of words to be written
+**
+**	Return Value:
+**		uint8_t 
+**          ERRVAL_SUCCESS                  0       // success, the words are in the user area
+**          ERRVAL_EPROM_ADDR_VIOLATION     0xF6    // EPROM write address violation: attempt to write over system data
+**          ERRVAL_EPROM_USERAREA           0xE2    // EPROM write to words removed from the user area
+**
+**	Description:
+**		This function checks that the words written by EPROM_WriteWords or EPROM_WriteWordsAsync are in the user area, 
+**      words 27 - 28 (ADR_EPROM_USERFREE to ADR_EPROM_CALIBHDR - 1).
+**      The user area was words 0 - 30 before the system records were stored in words 0 - 26 (limits, calibration journal, 
+**      temperature coefficients) and 29 - 30 (calibration header): a write to these words returns the distinct 
+**      ERRVAL_EPROM_USERAREA error, so that an application written for the former user area can tell it from a write 
+**      over the calibration, the serial number or the factory calibration (ERRVAL_EPROM_ADDR_VIOLATION).
+**      The system records are written by the _Raw functions, which do not check the address.
+**            
+*/
+uint8_t EPROM_CheckUserArea(uint8_t bAddress, int cwVals)
+{
+    if(bAddress + cwVals - 1 >= (uint8_t)ADR_EPROM_CALIB)
+    {
+        return ERRVAL_EPROM_ADDR_VIOLATION;
+    }
+    if(bAddress < (uint8_t)ADR_EPROM_USERFREE || bAddress + cwVals - 1 >= (uint8_t)ADR_EPROM_CALIBHDR)
+    {
+        return ERRVAL_EPROM_USERAREA;
+    }
+    return ERRVAL_SUCCESS;
+}
+
+/* ************************************************************************** */
+/***	EPROM_AsyncPop
+**
+**	Parameters:
+**      uint8_t bResult         - the write result: ERRVAL_SUCCESS or ERRVAL_EPROM_WRTIMEOUT
+**
+**	Return Value:
+**		none
+**
+**	Description:
+**		This function removes the first word from the background write queue. If it is the last word of a write request, 
+**      the pfnDone callback of the request is called with the provided result.
+**            
+*/
+void EPROM_AsyncPop(uint8_t bResult)
+{
+    EPROM_CALLBACK pfnDone = rgWriteQueue[idxWriteHead].pfnDone;
+    idxWriteHead = (idxWriteHead + 1) % EPROM_ASYNC_QUEUESIZE;
+    cWriteQueued--;
+    if(pfnDone)
+    {
+        pfnDone(bResult);
+    }
+}
+
 /* *****************************************************************************
  End of File
  */
@@ -40,12 +40,46 @@
 
 
 // Addresses 
-
+// The user area, written by EPROM_WriteWords and EPROM_WriteWordsAsync, is words 27 - 28 (ADR_EPROM_USERFREE to ADR_EPROM_CALIBHDR - 1).
+// API change: it was 0 - 30 (up to ADR_EPROM_CALIB - 1) before the system records were stored in words 0 - 26 and 29 - 30,
+// a write to these words now fails with ERRVAL_EPROM_USERAREA.
+#define ADR_EPROM_LIMITS    0       // limits of the scales (LIMITDATA), words 0 - 14
+#define ADR_EPROM_CALIBJRNL 15      // journal of the user calibration save (CALIBJRNL), words 15 - 21
+#define ADR_EPROM_TEMPCOEFF 22      // temperature coefficients of the scales (TEMPCOEFFDATA), words 22 - 26
+#define ADR_EPROM_USERFREE  27      // first word of the user area, words 27 - 28
+#define ADR_EPROM_CALIBHDR  29      // header of the user calibration (CALIBHDR): temperature and CRC-16, words 29 - 30
 #define ADR_EPROM_CALIB     31
 #define ADR_EPROM_FACTCALIB 147
 #define ADR_EPROM_SERIALNO  140
 
-#define EPROM_MAGIC_NO      0x23
+// records (serial number, calibration, limits): the first byte gives the record format, the last bytes are the check bytes
+#define EPROM_MAGIC_NO      0x23    // format 1 (legacy, read only): 8-bit additive checksum in the last byte
+#define EPROM_MAGIC_CRC8    0x24    // format 2 (read only): CRC-8 (GetBufferCrc8) of the other bytes in the last byte
+#define EPROM_MAGIC_CRC16   0x25    // format 3: CRC-16 (GetBufferCrc16) of the other bytes in the last 2 bytes, LSByte first
+
+// number of words of the EPROM memory (8-bit word address), all kept in the RAM image
+#define EPROM_CWORDS        256
+
+// background write queue
+#define EPROM_ASYNC_QUEUESIZE   128     // maximum number of words waiting to be written
+#define EPROM_ASYNC_TIMEOUTMS   20      // maximum duration of the self-timed write cycle of one word (ms)
+#define EPROM_ASYNC_CSTICKS     1       // chip select setup and hold time of the queued SPI transactions (SPI engine ticks)
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Data Types
+// *****************************************************************************
+// *****************************************************************************
+// called by EPROM_AsyncTick when a background write request is finished, with ERRVAL_SUCCESS or the error code;
+// it must not call the synchronous EPROM functions
+typedef void (*EPROM_CALLBACK)(uint8_t bResult);
+
+// word waiting in the background write queue
+typedef struct _EPROM_WRITE{
+    uint8_t bAddress;           // EPROM word address
+    uint16_t wVal;              // value to be written
+    EPROM_CALLBACK pfnDone;     // set on the last word of a write request, null otherwise
+} EPROM_WRITE;
 
 
 /* ************************************************************************** */
@@ -57,7 +91,16 @@
 void EPROM_Init();
 // EPROM data access
 void EPROM_ReadWords(uint8_t bAddress, uint16_t *prgVals, int cwVals);
+uint8_t EPROM_RevalidateImage(int *pcwMismatch);
+// records
+uint8_t EPROM_CheckRecord(uint8_t *pbRecord, int cbRecord);
+void EPROM_SealRecord(uint8_t *pbRecord, int cbRecord);
 uint8_t EPROM_WriteWords(uint8_t bAddress, uint16_t *prgVals, int cwVals);
+// EPROM background writes
+uint8_t EPROM_WriteWordsAsync(uint8_t bAddress, uint16_t *prgVals, int cwVals, EPROM_CALLBACK pfnDone);
+uint8_t EPROM_AsyncIsIdle();
+void EPROM_AsyncWaitIdle();
+void EPROM_AsyncTick();
 // some EPROM implemented functions:
 void EPROM_Erase(uint8_t bAddress);
 void EPROM_WriteDisable();
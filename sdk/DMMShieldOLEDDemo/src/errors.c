@@ -168,6 +168,62 @@ uint8_t ERRORS_GetPrefixedMessageString(uint8_t bErrCode, char *szContent, char
         	strcpy(szLastError, "UART Init error");
             prefix = PREFIX_ERROR;
             break;
+        case ERRVAL_AMP_TIMEOUT:
+            strcpy(szLastError, "CPU1 acquisition command timeout");
+            prefix = PREFIX_ERROR;
+            break;
+        case ERRVAL_DMM_PENDING:
+            strcpy(szLastError, "Operation in progress");
+            prefix = PREFIX_ERROR;
+            break;
+        case ERRVAL_SPI_ASYNC:
+            strcpy(szLastError, "SPI transaction queue full");
+            prefix = PREFIX_ERROR;
+            break;
+        case ERRVAL_CORR_FORMAT:
+            strcpy(szLastError, "Wrong correction values");
+            prefix = PREFIX_ERROR;
+            break;
+        case ERRVAL_CORR_FULL:
+            strcpy(szLastError, "No free correction slot");
+            prefix = PREFIX_ERROR;
+            break;
+        case ERRVAL_CALSEQ_STATE:
+            strcpy(szLastError, "Wrong calibration sequence state");
+            prefix = PREFIX_ERROR;
+            break;
+        case ERRVAL_CALSEQ_EMPTY:
+            strcpy(szLastError, "The calibration plan has no steps");
+            prefix = PREFIX_ERROR;
+            break;
+        case ERRVAL_CALIB_UNSTABLE:
+            // szLastError already contains the error message
+            prefix = PREFIX_ERROR;
+            break;
+        case ERRVAL_TRIG_CONFIG:
+            strcpy(szLastError, "Wrong trigger configuration");
+            prefix = PREFIX_ERROR;
+            break;
+        case ERRVAL_LIMIT_FORMAT:
+            strcpy(szLastError, "Wrong limit values");
+            prefix = PREFIX_ERROR;
+            break;
+        case ERRVAL_LIMIT_FULL:
+            strcpy(szLastError, "No free limit slot");
+            prefix = PREFIX_ERROR;
+            break;
+        case ERRVAL_EPROM_USERAREA:
+            strcpy(szLastError, "EPROM words 0 - 26 and 29 - 30 are no longer in the user area, they hold the limits, the calibration journal and header. The user area is words 27 - 28.");
+            prefix = PREFIX_ERROR;
+            break;
+        case ERRVAL_TEMPCOEFF_FULL:
+            strcpy(szLastError, "No free temperature coefficient slot, set the coefficient of another scale to 0");
+            prefix = PREFIX_ERROR;
+            break;
+        case ERRVAL_TEMPCOEFF_FORMAT:
+            strcpy(szLastError, "The temperature coefficient must be between -327.67 and 327.67 ppm/C");
+            prefix = PREFIX_ERROR;
+            break;
         default:
             bResult = ERRVAL_CMD_MISSINGCODE;
             break;        
@@ -177,6 +233,45 @@ uint8_t ERRORS_GetPrefixedMessageString(uint8_t bErrCode, char *szContent, char
     return bResult;
     
 }
+/* ------------------------------------------------------------ */
+/***    ERRORS_GetPrefixedPositionMessageString
+**
+**	Synopsis:
+**		
+**
+**	Parameters:
+**      uint8_t bErrCode        - The error code for which the error string is requested
+**      char *szContent         - The characters string acting as content for some of the error messages
+**      int idxPos              - The position (0 based) of the wrong character in szContent, -1 if not available
+**      char *pSzErr            - String to receive the error meaning
+**		
+**
+**	Return Values:
+**      ERRVAL_SUCCESS                   0   - success
+**      ERRVAL_CMD_MISSINGCODE        0xF9   - The provided code is not among accepted values
+**
+**	Errors:
+**		none
+**
+**	Description:
+**		This function builds the error message like ERRORS_GetPrefixedMessageString.
+**      For ERRVAL_CMD_VALFORMAT and ERRVAL_CMD_VALWRONGUNIT errors, when idxPos is not negative, 
+**      the position of the wrong character is added to the message, for example:
+**      "The provided value "12.3x V" has a wrong format (position 4)."
+**		
+*/
+uint8_t ERRORS_GetPrefixedPositionMessageString(uint8_t bErrCode, char *szContent, int idxPos, char *pSzErr)
+{
+    uint8_t bResult = ERRORS_GetPrefixedMessageString(bErrCode, szContent, pSzErr);
+    if(idxPos >= 0 && (bErrCode == ERRVAL_CMD_VALFORMAT || bErrCode == ERRVAL_CMD_VALWRONGUNIT))
+    {
+        // replace the final '.' of the message
+        sprintf(szLastError + strlen(szLastError) - 1, " (position %d).", idxPos);
+        ERRORS_PrefixMessage(PREFIX_ERROR, pSzErr, szLastError);
+    }
+    return bResult;
+}
+
 /* ------------------------------------------------------------ */
 /***    ERRORS_GetszLastError
 **
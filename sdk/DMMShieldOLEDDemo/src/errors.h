@@ -61,6 +61,20 @@ typedef enum {
 #define ERRVAL_CALIB_MISSINGMEASUREMENT 0xF0    // A measurement must be performed before calling the finalize calibration.
 #define ERRVAL_DMM_GENERICERROR         0xEF    // Generic error
 #define ERRVAL_DMM_UARTERROR         	0xEE    // UART Init error
+#define ERRVAL_AMP_TIMEOUT              0xED    // CPU1 did not acknowledge the AMP command
+#define ERRVAL_DMM_PENDING              0xEC    // the resumable operation is not finished yet
+#define ERRVAL_SPI_ASYNC                0xEB    // the asynchronous SPI transaction was not queued
+#define ERRVAL_CORR_FORMAT              0xEA    // wrong correction values
+#define ERRVAL_CORR_FULL                0xE9    // all the correction slots are used
+#define ERRVAL_CALSEQ_STATE             0xE8    // the calibration sequence is not in the required state
+#define ERRVAL_CALSEQ_EMPTY             0xE7    // the calibration plan has no steps
+#define ERRVAL_CALIB_UNSTABLE           0xE6    // the calibration reference is too noisy or drifting
+#define ERRVAL_TRIG_CONFIG              0xE5    // wrong trigger configuration
+#define ERRVAL_LIMIT_FORMAT             0xE4    // wrong limit values
+#define ERRVAL_LIMIT_FULL               0xE3    // all the limit slots are used
+#define ERRVAL_EPROM_USERAREA           0xE2    // EPROM write to words removed from the user area
+#define ERRVAL_TEMPCOEFF_FULL           0xE1    // all the temperature coefficient slots are used
+#define ERRVAL_TEMPCOEFF_FORMAT         0xE0    // the temperature coefficient is out of range
 
 // *****************************************************************************
 // *****************************************************************************
@@ -69,6 +83,7 @@ typedef enum {
 // *****************************************************************************
 void ERRORS_Init(const char *szPrefixSuccess, const char *szPrefixError);
 uint8_t ERRORS_GetPrefixedMessageString(uint8_t bErrCode, char *szContent, char *pSzErr);
+uint8_t ERRORS_GetPrefixedPositionMessageString(uint8_t bErrCode, char *szContent, int idxPos, char *pSzErr);
 char *ERRORS_GetszLastError();
 
 char * ERRORS_PrefixMessage(msg_prefix_status prefix, char *pDestString, const char *szMsg);
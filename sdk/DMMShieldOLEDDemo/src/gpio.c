@@ -23,6 +23,8 @@
 #include <stdio.h>
 #include "platform.h"
 #include "xparameters.h"
+#include "xil_exception.h"
+#include "xpseudo_asm.h"
 
 #include "gpio.h"
 
@@ -72,6 +74,10 @@ int GPIO_Init()
 
 void GPIO_SetOutputValue(u32 dwMask, u8 bVal)
 {
+	// the asynchronous SPI engine changes the group value from the fast tick interrupt,
+	// so the read-modify-write is done with the interrupts disabled
+	u32 dwCpsr = mfcpsr();
+	mtcpsr(dwCpsr | XIL_EXCEPTION_IRQ);
 	// update group value
 	if(bVal)
 	{
@@ -84,5 +90,43 @@ void GPIO_SetOutputValue(u32 dwMask, u8 bVal)
 
 	// write group value
 	XGpio_DiscreteWrite(&Gpio, GPIO_OUTPUT_CHANNEL, dwStoreOutputGroupVal);
+	mtcpsr(dwCpsr);
+}
+
+/***	GPIO_SyncOutputValue
+**
+**	Parameters:
+**		none
+**
+**	Return Value:
+**		none
+**
+**	Description:
+**		This function reloads the stored output group value from the GPIO output data register.
+**      It must be called before using the GPIO output pins when they could have been changed by other code,
+**      for example by the other core in the AMP configuration.
+**
+*/
+void GPIO_SyncOutputValue()
+{
+	dwStoreOutputGroupVal = XGpio_DiscreteRead(&Gpio, GPIO_OUTPUT_CHANNEL);
+}
+
+/***	GPIO_GetOutputValue
+**
+**	Parameters:
+**		none
+**
+**	Return Value:
+**		u32     - the stored output group value
+**
+**	Description:
+**		This function returns the stored output group value, the last value written in the GPIO output data register.
+**      It is used by the SPIDMA module as the level of the pins not involved in the SPI transaction.
+**
+*/
+u32 GPIO_GetOutputValue()
+{
+	return dwStoreOutputGroupVal;
 }
 
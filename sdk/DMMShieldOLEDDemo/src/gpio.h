@@ -53,6 +53,8 @@ extern XGpio Gpio; /* The Instance of the GPIO Driver, declared in GPIO.c */
 /***************** Function prototypes *********************/
 int GPIO_Init();
 void GPIO_SetOutputValue(u32 dwMask, u8 bVal);
+void GPIO_SyncOutputValue();
+u32 GPIO_GetOutputValue();
 /***************** Macros (Inline Functions) Definitions *********************/
 #define GPIO_SetValue_CS_EPROM(val) \
 		GPIO_SetOutputValue(GPIO_Mask_CS_EPROM, val)
@@ -0,0 +1,354 @@
+/* ************************************************************************** */
+/** Descriptive File Name
+
+  @Company
+    Digilent
+
+  @File Name
+    limit.c
+
+  @Description
+        This file groups the functions that implement the LIMIT module, the limit monitoring of the acquired values.
+        Up to LIMIT_CNTSLOTS scales have a high and / or a low limit, with a hysteresis.
+        Each acquired value is checked by LIMIT_Check, which only reports the state changes: a limit is exceeded,
+        or the value came back inside the limits by more than the hysteresis. So the host is notified of the exceptions
+        instead of receiving all the values.
+        The limits are stored in EPROM (ADR_EPROM_LIMITS, below the user area) as a record protected by a CRC-16,
+        they are read by LIMIT_Init and written by LIMIT_Save.
+        The module uses errors defined in the ERRORS module.
+
+ */
+/* ************************************************************************** */
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Included Files                                                    */
+/* ************************************************************************** */
+#include <string.h>
+#include <math.h>
+#include "stdint.h"
+#include "dmm.h"
+#include "eprom.h"
+#include "errors.h"
+#include "limit.h"
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+// Section: Local functions prototypes                                        */
+/* ************************************************************************** */
+/* ************************************************************************** */
+void LIMIT_Clear();
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+// Section: Utility Functions Prototypes, defined in other modules            */
+/* ************************************************************************** */
+/* ************************************************************************** */
+uint8_t EPROM_WriteWords_Raw(uint8_t bAddress, uint16_t *prgVals, int cwVals);
+uint8_t EPROM_WriteWordsAsync_Raw(uint8_t bAddress, uint16_t *prgVals, int cwVals, EPROM_CALLBACK pfnDone);
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Global Variables                                                  */
+/* ************************************************************************** */
+/* ************************************************************************** */
+static LIMITDATA limits;                    // limit slots, in the EPROM record format
+static const LIMIT *pLimitCurrent = NULL;   // limits of the checked scale, NULL if the scale has no limits
+static int idxLimitScale = -1;              // scale of the last checked value
+static uint8_t bLimitState = LIMIT_STATE_NORMAL;
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+// Section: Interface Functions                                               */
+/* ************************************************************************** */
+/* ************************************************************************** */
+
+/***	LIMIT_Init
+**
+**	Parameters:
+**		none
+**
+**	Return Value:
+**		uint8_t
+**          ERRVAL_SUCCESS                  0       // success
+**          ERRVAL_EPROM_MAGICNO            0xFD    // wrong Magic No. when reading data from EPROM
+**          ERRVAL_EPROM_CRC                0xFE    // wrong CRC when reading data from EPROM
+**          ERRVAL_EPROM_WRTIMEOUT          0xFF    // EPROM write data ready timeout (conversion of a CRC-8 record)
+**
+**	Description:
+**		This function reads the limits from EPROM (ADR_EPROM_LIMITS). The EPROM module must be initialized (CALIB_Init).
+**      If the record is missing or invalid, no scale has limits.
+**      A record in the CRC-8 or the legacy format (LIMITDATA_V2, 4 slots over words 0 - 26) is converted: the limits of its 
+**      first LIMIT_CNTSLOTS used slots are kept, and the record is written again in the CRC-16 format, 
+**      as its last words are now used by other records.
+**
+*/
+uint8_t LIMIT_Init()
+{
+    uint8_t bResult;
+    LIMITDATA_V2 limitsV2;
+    int i, idxSlot;
+    EPROM_ReadWords((uint8_t)ADR_EPROM_LIMITS, (uint16_t *)&limits, sizeof(LIMITDATA)/2);
+    if(limits.magic == EPROM_MAGIC_CRC16)
+    {
+        bResult = EPROM_CheckRecord((uint8_t *)&limits, sizeof(LIMITDATA));
+        if(bResult != ERRVAL_SUCCESS)
+        {
+            LIMIT_Clear();
+        }
+        idxLimitScale = -1;
+        return bResult;
+    }
+    LIMIT_Clear();
+    EPROM_ReadWords((uint8_t)ADR_EPROM_LIMITS, (uint16_t *)&limitsV2, sizeof(LIMITDATA_V2)/2);
+    bResult = EPROM_CheckRecord((uint8_t *)&limitsV2, sizeof(LIMITDATA_V2));
+    if(bResult == ERRVAL_SUCCESS)
+    {
+        for(i = 0, idxSlot = 0; i < LIMIT_CNTSLOTS_V2 && idxSlot < LIMIT_CNTSLOTS; i++)
+        {
+            if(limitsV2.rgLimits[i].idxScale >= 0)
+            {
+                limits.rgLimits[idxSlot++] = limitsV2.rgLimits[i];
+            }
+        }
+        bResult = LIMIT_Save(NULL);
+    }
+    idxLimitScale = -1;
+    return bResult;
+}
+
+/***	LIMIT_GetScale
+**
+**	Parameters:
+**		int idxScale    - the scale index
+**
+**	Return Value:
+**		const LIMIT *   - the limits of the scale, NULL if the scale has no limits
+**
+**	Description:
+**		This function returns the limits of a scale. The returned pointer is valid until the limits are changed by LIMIT_SetScale.
+**
+*/
+const LIMIT *LIMIT_GetScale(int idxScale)
+{
+    int i;
+    for(i = 0; i < LIMIT_CNTSLOTS; i++)
+    {
+        if(limits.rgLimits[i].idxScale >= 0 && limits.rgLimits[i].idxScale == idxScale)
+        {
+            return &limits.rgLimits[i];
+        }
+    }
+    return NULL;
+}
+
+/***	LIMIT_SetScale
+**
+**	Parameters:
+**		int idxScale    - the scale index
+**		double dLo      - the low limit (base unit), NAN for no low limit
+**		double dHi      - the high limit (base unit), NAN for no high limit
+**		double dHyst    - the hysteresis (base unit), 0 or positive
+**
+**	Return Value:
+**		uint8_t
+**          ERRVAL_SUCCESS                  0       // success
+**          ERRVAL_DMM_IDXCONFIG            0xFC    // wrong scale index
+**          ERRVAL_LIMIT_FORMAT             0xE4    // the low limit is not below the high limit, or wrong hysteresis
+**          ERRVAL_LIMIT_FULL               0xE3    // all the limit slots are used
+**
+**	Description:
+**		This function sets the limits of a scale. The slot of the scale is reused, otherwise a free slot is used.
+**      When both limits are NAN, the limits of the scale are removed. The limits are stored in EPROM by LIMIT_Save.
+**      The limit state is reset: a value outside the new limits is reported again.
+**
+*/
+uint8_t LIMIT_SetScale(int idxScale, double dLo, double dHi, double dHyst)
+{
+    LIMIT *pSlot = (LIMIT *)LIMIT_GetScale(idxScale);
+    int i;
+    if(idxScale < 0 || idxScale >= DMM_CNTSCALES)
+    {
+        return ERRVAL_DMM_IDXCONFIG;
+    }
+    if(isinf(dLo) || isinf(dHi) || !isfinite(dHyst) || dHyst < 0 || dLo >= dHi)
+    {
+        return ERRVAL_LIMIT_FORMAT;
+    }
+    if(isnan(dLo) && isnan(dHi))
+    {
+        if(pSlot)
+        {
+            pSlot->idxScale = -1;
+        }
+    }
+    else
+    {
+        for(i = 0; i < LIMIT_CNTSLOTS && !pSlot; i++)
+        {
+            if(limits.rgLimits[i].idxScale < 0)
+            {
+                pSlot = &limits.rgLimits[i];
+            }
+        }
+        if(!pSlot)
+        {
+            return ERRVAL_LIMIT_FULL;
+        }
+        pSlot->idxScale = idxScale;
+        pSlot->fLo = dLo;
+        pSlot->fHi = dHi;
+        pSlot->fHyst = dHyst;
+    }
+    // the checked scale gets its limits again
+    idxLimitScale = -1;
+    return ERRVAL_SUCCESS;
+}
+
+/***	LIMIT_Save
+**
+**	Parameters:
+**      EPROM_CALLBACK pfnDone  - null for a synchronous write, otherwise the record is queued to the background write queue
+**                              and pfnDone is called when it is written
+**
+**	Return Value:
+**		uint8_t
+**          ERRVAL_SUCCESS                  0       // success
+**          ERRVAL_EPROM_WRTIMEOUT          0xFF    // EPROM write data ready timeout (synchronous write)
+**
+**	Description:
+**		This function writes the limits record in EPROM (ADR_EPROM_LIMITS), sealed with the magic number and the CRC (EPROM_SealRecord).
+**      If the record did not change, nothing is written and pfnDone is called before returning.
+**      The record is not in the user area, so it is written by the _Raw EPROM functions.
+**
+*/
+uint8_t LIMIT_Save(EPROM_CALLBACK pfnDone)
+{
+    uint8_t bResult;
+    LIMITDATA limitsEPROM;
+    EPROM_SealRecord((uint8_t *)&limits, sizeof(LIMITDATA));
+    EPROM_ReadWords((uint8_t)ADR_EPROM_LIMITS, (uint16_t *)&limitsEPROM, sizeof(LIMITDATA)/2);
+    if(!memcmp(&limits, &limitsEPROM, sizeof(LIMITDATA)))
+    {
+        if(pfnDone)
+        {
+            pfnDone(ERRVAL_SUCCESS);
+        }
+        return ERRVAL_SUCCESS;
+    }
+    if(pfnDone)
+    {
+        return EPROM_WriteWordsAsync_Raw((uint8_t)ADR_EPROM_LIMITS, (uint16_t *)&limits, sizeof(LIMITDATA)/2, pfnDone);
+    }
+    EPROM_WriteEnable();
+    bResult = EPROM_WriteWords_Raw((uint8_t)ADR_EPROM_LIMITS, (uint16_t *)&limits, sizeof(LIMITDATA)/2);
+    EPROM_WriteDisable();
+    return bResult;
+}
+
+/***	LIMIT_Check
+**
+**	Parameters:
+**		double dVal     - the acquired value, in the base unit, infinite when out of the scale range
+**		int idxScale    - the scale of the value
+**
+**	Return Value:
+**		uint8_t     - the new limit state (LIMIT_STATE_NORMAL, LIMIT_STATE_HIGH or LIMIT_STATE_LOW) if it changed,
+**                    LIMIT_EVT_NONE otherwise
+**
+**	Description:
+**		This function checks an acquired value against the limits of its scale. The limit state changes:
+**      - to LIMIT_STATE_HIGH when the value is above the high limit, to LIMIT_STATE_LOW when it is below the low limit.
+**      - back to LIMIT_STATE_NORMAL when the value is below the high limit, or above the low limit, by at least the hysteresis.
+**      An out of range value (infinite) is above or below all the limits.
+**      When the scale changes, the state is reset to LIMIT_STATE_NORMAL without event, and the limits of the scale are
+**      looked up once, so the values of a scale without limits are not checked.
+**
+*/
+uint8_t LIMIT_Check(double dVal, int idxScale)
+{
+    uint8_t bState;
+    if(idxScale != idxLimitScale)
+    {
+        idxLimitScale = idxScale;
+        pLimitCurrent = LIMIT_GetScale(idxScale);
+        bLimitState = LIMIT_STATE_NORMAL;
+    }
+    if(!pLimitCurrent || isnan(dVal))
+    {
+        return LIMIT_EVT_NONE;
+    }
+    bState = bLimitState;
+    if(bState == LIMIT_STATE_HIGH && dVal <= pLimitCurrent->fHi - pLimitCurrent->fHyst)
+    {
+        bState = LIMIT_STATE_NORMAL;
+    }
+    else if(bState == LIMIT_STATE_LOW && dVal >= pLimitCurrent->fLo + pLimitCurrent->fHyst)
+    {
+        bState = LIMIT_STATE_NORMAL;
+    }
+    // NAN limits are never exceeded
+    if(dVal > pLimitCurrent->fHi)
+    {
+        bState = LIMIT_STATE_HIGH;
+    }
+    else if(dVal < pLimitCurrent->fLo)
+    {
+        bState = LIMIT_STATE_LOW;
+    }
+    if(bState == bLimitState)
+    {
+        return LIMIT_EVT_NONE;
+    }
+    bLimitState = bState;
+    return bState;
+}
+
+/***	LIMIT_GetState
+**
+**	Parameters:
+**		none
+**
+**	Return Value:
+**		uint8_t     - the limit state of the last checked value (LIMIT_STATE_ value)
+**
+**	Description:
+**		This function returns the limit state updated by LIMIT_Check.
+**
+*/
+uint8_t LIMIT_GetState()
+{
+    return bLimitState;
+}
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+// Section: Local Functions                                                   */
+/* ************************************************************************** */
+/* ************************************************************************** */
+
+/***	LIMIT_Clear
+**
+**	Parameters:
+**		none
+**
+**	Return Value:
+**		none
+**
+**	Description:
+**		This function frees all the limit slots.
+**
+*/
+void LIMIT_Clear()
+{
+    int i;
+    memset(&limits, 0, sizeof(limits));
+    for(i = 0; i < LIMIT_CNTSLOTS; i++)
+    {
+        limits.rgLimits[i].idxScale = -1;
+    }
+}
+
+/* *****************************************************************************
+ End of File
+ */
@@ -0,0 +1,81 @@
+/* ************************************************************************** */
+/** Descriptive File Name
+
+  @Company
+ Digilent
+
+  @File Name
+    limit.h
+
+  @Description
+        This file contains the declarations for the LIMIT module functions.
+        The LIMIT functions are defined in limit.c source file.
+
+ */
+/* ************************************************************************** */
+
+#ifndef _LIMIT_H    /* Guard against multiple inclusion */
+#define _LIMIT_H
+
+#include "stdint.h"
+#include "eprom.h"
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Constants                                                         */
+/* ************************************************************************** */
+#define LIMIT_CNTSLOTS          2       // maximum number of scales having limits at the same time
+#define LIMIT_CNTSLOTS_V2       4       // number of slots of the limits record in the CRC-8 format (read only)
+
+// limit states and events returned by LIMIT_Check
+#define LIMIT_STATE_NORMAL      0       // the value is between the limits
+#define LIMIT_STATE_HIGH        1       // the value is above the high limit
+#define LIMIT_STATE_LOW         2       // the value is below the low limit
+#define LIMIT_EVT_NONE          0xFF    // the state did not change
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Data Types
+// *****************************************************************************
+// *****************************************************************************
+
+// limits of a scale, in the base unit, NAN when the scale has no limit on that side
+typedef struct _LIMIT{
+    int8_t idxScale;        // scale using the limits, -1 for a free slot
+    float fLo;              // low limit
+    float fHi;              // high limit
+    float fHyst;            // hysteresis: the value must come back inside the limits by this amount to end the alarm
+}  __attribute__((__packed__)) LIMIT;
+
+// limits record, stored in EPROM at ADR_EPROM_LIMITS (format EPROM_MAGIC_CRC16)
+typedef struct _LIMITDATA{
+    uint8_t magic;
+    LIMIT rgLimits[LIMIT_CNTSLOTS];     // 2*13     26
+    uint8_t bReserved;                  // the record is a whole number of words
+    uint16_t crc;
+}  __attribute__((__packed__)) LIMITDATA;
+
+// limits record in the CRC-8 (EPROM_MAGIC_CRC8) or the legacy format, read and converted by LIMIT_Init
+typedef struct _LIMITDATA_V2{
+    uint8_t magic;
+    LIMIT rgLimits[LIMIT_CNTSLOTS_V2];  // 4*13     52
+    uint8_t crc;
+}  __attribute__((__packed__)) LIMITDATA_V2;
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Interface Functions
+// *****************************************************************************
+// *****************************************************************************
+uint8_t LIMIT_Init();
+const LIMIT *LIMIT_GetScale(int idxScale);
+uint8_t LIMIT_SetScale(int idxScale, double dLo, double dHi, double dHyst);
+uint8_t LIMIT_Save(EPROM_CALLBACK pfnDone);
+uint8_t LIMIT_Check(double dVal, int idxScale);
+uint8_t LIMIT_GetState();
+
+#endif /* _LIMIT_H */
+
+/* *****************************************************************************
+ End of File
+ */
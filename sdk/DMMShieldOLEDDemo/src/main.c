@@ -11,6 +11,8 @@
         This file is the application entry point.
         It contains the definition of the UART dispatch commands demo function, used for communicating with the DMM module and is called from main function
         It also implements a demo function for EPROM functionality, which is not called by the main function.
+        It also implements a value formatting self test function, which is not called by the main function.
+        When built with AMP_CPU1 defined, the main function runs the CPU1 acquisition loop of the AMP configuration.
 
   @Author
     Cristian Fatu
@@ -33,10 +35,15 @@
 #include "uart.h"
 #include "errors.h"
 #include "eprom.h"
+#include "dmm.h"
+#include "amp.h"
+#include "sched.h"
 
 
 void Demo_UART_Dispatch();
 void Demo_UserEPROM();
+void Demo_FormatSelfTest();
+void Demo_AMP_Cpu1();
 
 
 
@@ -45,8 +52,14 @@ int main()
 {
 	init_platform();
 
+#ifdef AMP_CPU1
+	// CPU1 application of the AMP configuration
+	Demo_AMP_Cpu1();
+#else
 	Demo_UART_Dispatch();
+#endif
 //	Demo_UserEPROM();
+//	Demo_FormatSelfTest();
 
     cleanup_platform();
     return 0;
@@ -63,7 +76,9 @@ int main()
 **	Description:
 **		This function implements the main demo UART command dispatch interpreter.
 **      It calls the initialization function for DMMCMD module DMMCMD_Init().
-**      In an infinite - while - loop the function calls DMMCMD_CheckForCommand to check with null parameter for uartCmdFurtherProcess.
+**      In the AMP configuration (AMP_ENABLE 1) it starts CPU1, which performs the repeated acquisition.
+**      When the scheduler is used (DMMCMD_USE_SCHED 1), it adds the DMMCMD tasks and runs the scheduler, which never returns.
+**      Otherwise, in an infinite - while - loop the function calls DMMCMD_CheckForCommand to check with null parameter for uartCmdFurtherProcess.
 **
 */
 void Demo_UART_Dispatch()
@@ -71,9 +86,20 @@ void Demo_UART_Dispatch()
     GPIO_Init();
     DMMCMD_Init();
     ERRORS_Init("OK", "ERROR");
+#if AMP_ENABLE
+    AMP_Init();
+    AMP_StartCpu1();
+#endif
 
     UART_PutString("Command loop\r\n");
 	XGpio_DiscreteSet(&Gpio, GPIO_OUTPUT_CHANNEL, 0x00);
+#if DMMCMD_USE_SCHED
+    if(DMMCMD_InitTasks() == ERRVAL_SUCCESS)
+    {
+        SCHED_Run();
+    }
+    UART_PutString("Scheduler init error\r\n");
+#endif
     while(1)
     {
         DMMCMD_CheckForCommand();
@@ -81,6 +107,27 @@ void Demo_UART_Dispatch()
 }
 
 
+/***	Demo_AMP_Cpu1()
+**
+**	Parameters:
+**		none
+**
+**	Return Value:
+**          none
+**
+**	Description:
+**		This function implements the CPU1 application of the AMP configuration, built with AMP_CPU1 defined.
+**      It initializes the GPIO and DMM modules and runs the acquisition loop, which never returns.
+**      The DMMShield is configured by CPU0, CPU1 only acquires values while CPU0 allows it.
+**
+*/
+void Demo_AMP_Cpu1()
+{
+    GPIO_Init();
+    DMM_Init();
+    AMP_Cpu1Loop();
+}
+
 /***	Demo_UserEPROM()
 **
 **	Parameters:
@@ -91,13 +138,16 @@ void Demo_UART_Dispatch()
 **
 **	Description:
 **		This function implements an EPROM demo.
-**      It demonstrates how to write / retrieve data from user space of EPROM (address space 00 - 31).
+**      It demonstrates how to write / retrieve data from user space of EPROM (address space ADR_EPROM_USERFREE (27) - 28).
+**      Words 00 - 26 hold the limits record (ADR_EPROM_LIMITS), the calibration journal (ADR_EPROM_CALIBJRNL) and
+**      the temperature coefficients (ADR_EPROM_TEMPCOEFF), words 29 - 30 the calibration header:
+**      writing them with EPROM_WriteWords fails with ERRVAL_EPROM_USERAREA.
 **
 */
 void Demo_UserEPROM()
 {
-    char sUserText[] = "01020304050607080910111213141516171819202122232425262728293031"; // 62 chars
-    char sReceivedText[62+1]; // 62 chars + terminating 0
+    char sUserText[] = "2728"; // 4 chars
+    char sReceivedText[4+1]; // 4 chars + terminating 0
     u8 bErrCode;
     EPROM_Init();
     UART_Init(115200);
@@ -105,14 +155,14 @@ void Demo_UserEPROM()
     UART_PutString("Stored string:\r\n");
     UART_PutString(sUserText);
     UART_PutString("\r\n");
-    // write data to user area of EPROM, 31 words starting from address 0
+    // write data to the free words of the user area of EPROM, 2 words starting from address 27
     EPROM_WriteEnable();
-    bErrCode = EPROM_WriteWords(0, (uint16_t *)sUserText, 31);
+    bErrCode = EPROM_WriteWords((uint8_t)ADR_EPROM_USERFREE, (uint16_t *)sUserText, 2);
     if(bErrCode == ERRVAL_SUCCESS)
     {
-		// read back the data from the user area of EPROM, 31 words starting from address 0
-    	EPROM_ReadWords(0, (uint16_t *)sReceivedText, 31);
-    	sReceivedText[62] = 0;	// 0 terminator
+		// read back the data from the free words of the user area of EPROM, 2 words starting from address 27
+    	EPROM_ReadWords((uint8_t)ADR_EPROM_USERFREE, (uint16_t *)sReceivedText, 2);
+    	sReceivedText[4] = 0;	// 0 terminator
 
 		UART_PutString("Retrieved string:\r\n");
 		UART_PutString(sUserText);
@@ -129,6 +179,42 @@ void Demo_UserEPROM()
     }
 }
 
+/***	Demo_FormatSelfTest()
+**
+**	Parameters:
+**		none
+**
+**	Return Value:
+**          none
+**
+**	Description:
+**		This function checks the integer value formatter used by DMM_FormatValue against newlib sprintf.
+**      It calls DMM_FormatSelfTest, which formats values over the full range of every scale using both methods,
+**      and sends the number of mismatches over UART.
+**      The DMM hardware is not accessed.
+**
+*/
+void Demo_FormatSelfTest()
+{
+    char szMsg[100];
+    int idxScale = -1;
+    double dVal = 0;
+    uint32_t cntErr;
+    UART_Init(115200);
+    DMM_Init();
+    UART_PutString("Format self test\r\n");
+    cntErr = DMM_FormatSelfTest(&idxScale, &dVal);
+    if(cntErr)
+    {
+        sprintf(szMsg, "%u mismatches, first on scale %d, value %.17g\r\n", (unsigned int)cntErr, idxScale, dVal);
+    }
+    else
+    {
+        sprintf(szMsg, "No mismatches\r\n");
+    }
+    UART_PutString(szMsg);
+}
+
 //int main()
 //{
 //    DemoInitialize();
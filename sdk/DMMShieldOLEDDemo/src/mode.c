@@ -0,0 +1,501 @@
+/* ************************************************************************** */
+/** Descriptive File Name
+
+  @Company
+    Digilent
+
+  @File Name
+    mode.c
+
+  @Description
+        This file groups the functions that implement the MODE module, the handheld style measurement modes.
+        The acquired values are passed one by one to MODE_AddSample, which updates incrementally, whatever the selected mode:
+        - the number of values, the minimum and the maximum since the reset.
+        - the hold value: the mean of the last MODE_HOLD_CNT consecutive values, when they stay within the hold band.
+          It is kept while the values change, and replaced when the values are stable again.
+        - the reference of the relative mode: the first value after the reset, unless it is set by MODE_SetRef.
+        In the peak mode, the peak values of each conversion are passed to MODE_AddPeaks, which keeps the lowest and
+        the highest peak since the reset and the crest factor of the last conversion.
+        The selected mode decides the value returned by MODE_GetValue, displayed instead of the acquired value.
+        So the host can fetch the summary instead of receiving all the values.
+        The statistics belong to one scale: they are reset when the scale of the values changes.
+        Only a reference set by MODE_SetRef is kept, if the new scale measures the same quantity (DMM_GetScaleMode).
+        The module uses errors defined in the ERRORS module.
+
+ */
+/* ************************************************************************** */
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Included Files                                                    */
+/* ************************************************************************** */
+#include <math.h>
+#include "stdint.h"
+#include "dmm.h"
+#include "errors.h"
+#include "mode.h"
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+// Section: Local functions prototypes                                        */
+/* ************************************************************************** */
+/* ************************************************************************** */
+void MODE_Restart(int idxScale);
+void MODE_HoldAdd(double dVal);
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Global Variables                                                  */
+/* ************************************************************************** */
+/* ************************************************************************** */
+static uint8_t bModeCurrent = MODE_NONE;
+static int idxModeScale = -1;           // scale of the statistics
+static uint32_t cntSamples = 0;         // number of values since the reset
+static double dMin = NAN, dMax = NAN;   // minimum and maximum since the reset, NAN before the first value
+static double dRef = NAN;               // reference of the relative mode, NAN until captured or set
+static double dHeld = NAN;              // hold value, NAN until the values were stable once
+static double dPkMin = NAN, dPkMax = NAN;   // lowest and highest peak since the reset, NAN before the first peaks
+static double dCrest = NAN;             // crest factor of the last conversion, NAN on the DC scales
+
+static uint8_t fRefSet = 0;             // the reference was set by MODE_SetRef, it is kept when the scale changes
+
+// last MODE_HOLD_CNT finite values, checked against the hold band
+static double rgdHold[MODE_HOLD_CNT];
+static int idxHold = 0;                 // position of the next value
+static int cHold = 0;                   // number of values, up to MODE_HOLD_CNT
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+// Section: Interface Functions                                               */
+/* ************************************************************************** */
+/* ************************************************************************** */
+
+/***	MODE_Set
+**
+**	Parameters:
+**		uint8_t bMode   - the measurement mode, MODE_ value
+**
+**	Return Value:
+**		uint8_t
+**          ERRVAL_SUCCESS                  0       // success
+**          ERRVAL_CMD_WRONGPARAMS          0xF9    // wrong measurement mode
+**
+**	Description:
+**		This function selects the measurement mode and resets the statistics (MODE_Reset),
+**      so the minimum, maximum, hold value and reference start from the next value.
+**
+*/
+uint8_t MODE_Set(uint8_t bMode)
+{
+    if(bMode > MODE_PEAK)
+    {
+        return ERRVAL_CMD_WRONGPARAMS;
+    }
+    bModeCurrent = bMode;
+    MODE_Reset();
+    return ERRVAL_SUCCESS;
+}
+
+/***	MODE_Get
+**
+**	Parameters:
+**		none
+**
+**	Return Value:
+**		uint8_t     - the measurement mode, MODE_ value
+**
+**	Description:
+**		This function returns the measurement mode selected by MODE_Set.
+**
+*/
+uint8_t MODE_Get()
+{
+    return bModeCurrent;
+}
+
+/***	MODE_Reset
+**
+**	Parameters:
+**		none
+**
+**	Return Value:
+**		none
+**
+**	Description:
+**		This function clears the statistics: the number of values, the minimum, the maximum, the hold value, the reference
+**      and the peaks. A reference set by MODE_SetRef is cleared too, the next value becomes the reference.
+**      The statistics are restarted for the current scale.
+**
+*/
+void MODE_Reset()
+{
+    fRefSet = 0;
+    MODE_Restart(DMM_GetCurrentScale());
+}
+
+/***	MODE_SetRef
+**
+**	Parameters:
+**		double dRefVal  - the reference of the relative mode, in the base unit
+**
+**	Return Value:
+**		none
+**
+**	Description:
+**		This function sets the reference of the relative mode, instead of the first value after the reset.
+**      The reference is kept when the scale changes to a scale of the same mode (autorange), since it is in the base unit.
+**      It is dropped when the scale changes to another mode, the first value of the new scale becomes the reference.
+**      MODE_Reset clears it.
+**
+*/
+void MODE_SetRef(double dRefVal)
+{
+    dRef = dRefVal;
+    fRefSet = !isnan(dRefVal);
+}
+
+/***	MODE_AddSample
+**
+**	Parameters:
+**		double dVal     - the acquired value, in the base unit, infinite when out of the scale range
+**		int idxScale    - the scale of the value
+**
+**	Return Value:
+**		none
+**
+**	Description:
+**		This function updates the statistics with an acquired value, in constant time:
+**      - the number of values, the minimum and the maximum. An out of range value (infinite) is kept as minimum or maximum.
+**      - the reference, if it is not captured or set yet. An out of range value is not used as reference.
+**      - the hold value: the value replaces the oldest of the last MODE_HOLD_CNT values. When they stay within the hold band,
+**        their mean becomes the hold value. An out of range value clears the last values.
+**      If the scale changes, the statistics of the previous scale are discarded (see MODE_Restart).
+**
+*/
+void MODE_AddSample(double dVal, int idxScale)
+{
+    if(isnan(dVal))
+    {
+        return;
+    }
+    if(idxScale != idxModeScale)
+    {
+        MODE_Restart(idxScale);
+    }
+    cntSamples++;
+    // the comparisons are false for the initial NAN
+    if(!(dVal >= dMin))
+    {
+        dMin = dVal;
+    }
+    if(!(dVal <= dMax))
+    {
+        dMax = dVal;
+    }
+    if(isnan(dRef) && isfinite(dVal))
+    {
+        dRef = dVal;
+    }
+    MODE_HoldAdd(dVal);
+}
+
+/***	MODE_AddPeaks
+**
+**	Parameters:
+**		double dPeakMin     - the minimum peak of the conversion, in the base unit
+**		double dPeakMax     - the maximum peak of the conversion, in the base unit
+**		double dRms         - the RMS value of the conversion on the AC scales, NAN on the DC scales
+**
+**	Return Value:
+**		none
+**
+**	Description:
+**		This function updates the peak statistics with the peak values of the conversion of the last value passed to MODE_AddSample,
+**      so the peaks belong to the scale of that value. The lowest and the highest peaks since the reset are kept.
+**      The crest factor of the conversion is the largest absolute peak divided by the RMS value, NAN without RMS value.
+**      Unavailable peak values (NAN) are ignored.
+**
+*/
+void MODE_AddPeaks(double dPeakMin, double dPeakMax, double dRms)
+{
+    double dPeak;
+    if(isnan(dPeakMin) || isnan(dPeakMax))
+    {
+        return;
+    }
+    if(!(dPeakMin >= dPkMin))
+    {
+        dPkMin = dPeakMin;
+    }
+    if(!(dPeakMax <= dPkMax))
+    {
+        dPkMax = dPeakMax;
+    }
+    dPeak = (fabs(dPeakMin) > fabs(dPeakMax)) ? fabs(dPeakMin): fabs(dPeakMax);
+    dCrest = (dRms > 0 && isfinite(dRms)) ? dPeak / dRms: NAN;
+}
+
+/***	MODE_GetValue
+**
+**	Parameters:
+**		double dVal     - the acquired value, in the base unit
+**
+**	Return Value:
+**		double  - the value of the measurement mode, in the base unit:
+**                  MODE_NONE, MODE_MINMAX  - the acquired value
+**                  MODE_HOLD               - the hold value, NAN if the values were not stable yet
+**                  MODE_REL                - the acquired value minus the reference, NAN without reference
+**                  MODE_PEAK               - the highest peak minus the lowest peak, NAN before the first peaks
+**
+**	Description:
+**		This function returns the value to be displayed for the acquired value, according to the measurement mode.
+**      The acquired value must be passed to MODE_AddSample before.
+**
+*/
+double MODE_GetValue(double dVal)
+{
+    switch(bModeCurrent)
+    {
+        case MODE_HOLD:
+            return dHeld;
+        case MODE_REL:
+            return dVal - dRef;
+        case MODE_PEAK:
+            return dPkMax - dPkMin;
+    }
+    return dVal;
+}
+
+/***	MODE_GetCntSamples
+**
+**	Parameters:
+**		none
+**
+**	Return Value:
+**		uint32_t    - the number of values since the reset
+**
+**	Description:
+**		This function returns the number of values passed to MODE_AddSample since the statistics were reset.
+**
+*/
+uint32_t MODE_GetCntSamples()
+{
+    return cntSamples;
+}
+
+/***	MODE_GetMin
+**
+**	Parameters:
+**		none
+**
+**	Return Value:
+**		double  - the minimum value since the reset, in the base unit, NAN if there was no value
+**
+**	Description:
+**		This function returns the minimum value since the statistics were reset.
+**
+*/
+double MODE_GetMin()
+{
+    return dMin;
+}
+
+/***	MODE_GetMax
+**
+**	Parameters:
+**		none
+**
+**	Return Value:
+**		double  - the maximum value since the reset, in the base unit, NAN if there was no value
+**
+**	Description:
+**		This function returns the maximum value since the statistics were reset.
+**
+*/
+double MODE_GetMax()
+{
+    return dMax;
+}
+
+/***	MODE_GetHeld
+**
+**	Parameters:
+**		none
+**
+**	Return Value:
+**		double  - the hold value, in the base unit, NAN if the values were not stable since the reset
+**
+**	Description:
+**		This function returns the mean of the last stable run of values.
+**
+*/
+double MODE_GetHeld()
+{
+    return dHeld;
+}
+
+/***	MODE_GetRef
+**
+**	Parameters:
+**		none
+**
+**	Return Value:
+**		double  - the reference of the relative mode, in the base unit, NAN if it was not captured or set
+**
+**	Description:
+**		This function returns the reference subtracted from the acquired values in the relative mode.
+**
+*/
+double MODE_GetRef()
+{
+    return dRef;
+}
+
+/***	MODE_GetPeakMin
+**
+**	Parameters:
+**		none
+**
+**	Return Value:
+**		double  - the lowest peak since the reset, in the base unit, NAN if no peaks were added
+**
+**	Description:
+**		This function returns the lowest minimum peak passed to MODE_AddPeaks since the statistics were reset.
+**
+*/
+double MODE_GetPeakMin()
+{
+    return dPkMin;
+}
+
+/***	MODE_GetPeakMax
+**
+**	Parameters:
+**		none
+**
+**	Return Value:
+**		double  - the highest peak since the reset, in the base unit, NAN if no peaks were added
+**
+**	Description:
+**		This function returns the highest maximum peak passed to MODE_AddPeaks since the statistics were reset.
+**
+*/
+double MODE_GetPeakMax()
+{
+    return dPkMax;
+}
+
+/***	MODE_GetCrest
+**
+**	Parameters:
+**		none
+**
+**	Return Value:
+**		double  - the crest factor of the last conversion, NAN if it is not available (DC scale)
+**
+**	Description:
+**		This function returns the crest factor (peak / RMS) computed by the last MODE_AddPeaks call.
+**
+*/
+double MODE_GetCrest()
+{
+    return dCrest;
+}
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+// Section: Local Functions                                                   */
+/* ************************************************************************** */
+/* ************************************************************************** */
+
+/***	MODE_Restart
+**
+**	Parameters:
+**		int idxScale    - the scale of the following values
+**
+**	Return Value:
+**		none
+**
+**	Description:
+**		This function clears the statistics and assigns them to a scale.
+**      A reference set by MODE_SetRef is kept if the scale has the same mode as the previous one: the scales of a mode
+**      measure the same quantity in the same base unit. Otherwise it is dropped.
+**
+*/
+void MODE_Restart(int idxScale)
+{
+    if(!fRefSet || idxScale < 0 || idxModeScale < 0 || DMM_GetScaleMode(idxScale) != DMM_GetScaleMode(idxModeScale))
+    {
+        fRefSet = 0;
+        dRef = NAN;
+    }
+    idxModeScale = idxScale;
+    cntSamples = 0;
+    dMin = NAN;
+    dMax = NAN;
+    dHeld = NAN;
+    dPkMin = NAN;
+    dPkMax = NAN;
+    dCrest = NAN;
+    cHold = 0;
+}
+
+/***	MODE_HoldAdd
+**
+**	Parameters:
+**		double dVal     - the acquired value, in the base unit
+**
+**	Return Value:
+**		none
+**
+**	Description:
+**		This function adds a value to the last MODE_HOLD_CNT values, replacing the oldest one. They are within the band
+**      when the difference between the largest and the smallest value is not larger than MODE_HOLD_BAND of their mean,
+**      or MODE_HOLD_FLOOR of the scale range near zero. Then their mean becomes the hold value, otherwise the hold value is kept.
+**      An out of range value clears the last values, MODE_HOLD_CNT new values are needed.
+**
+*/
+void MODE_HoldAdd(double dVal)
+{
+    double dBand, dLo, dHi, dSum;
+    int i;
+    if(!isfinite(dVal))
+    {
+        cHold = 0;
+        return;
+    }
+    if(!cHold)
+    {
+        idxHold = 0;
+    }
+    rgdHold[idxHold] = dVal;
+    idxHold = (idxHold + 1) % MODE_HOLD_CNT;
+    if(cHold < MODE_HOLD_CNT)
+    {
+        cHold++;
+    }
+    if(cHold < MODE_HOLD_CNT)
+    {
+        return;
+    }
+    dLo = dHi = dSum = rgdHold[0];
+    for(i = 1; i < MODE_HOLD_CNT; i++)
+    {
+        dLo = (rgdHold[i] < dLo) ? rgdHold[i]: dLo;
+        dHi = (rgdHold[i] > dHi) ? rgdHold[i]: dHi;
+        dSum += rgdHold[i];
+    }
+    dBand = MODE_HOLD_BAND * fabs(dSum / MODE_HOLD_CNT);
+    if(idxModeScale >= 0 && dBand < MODE_HOLD_FLOOR * DMM_GetScaleRange(idxModeScale))
+    {
+        dBand = MODE_HOLD_FLOOR * DMM_GetScaleRange(idxModeScale);
+    }
+    if(dHi - dLo <= dBand)
+    {
+        dHeld = dSum / MODE_HOLD_CNT;
+    }
+}
+
+/* *****************************************************************************
+ End of File
+ */
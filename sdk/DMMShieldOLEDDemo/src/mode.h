@@ -0,0 +1,63 @@
+/* ************************************************************************** */
+/** Descriptive File Name
+
+  @Company
+ Digilent
+
+  @File Name
+    mode.h
+
+  @Description
+        This file contains the declarations for the MODE module functions.
+        The MODE functions are defined in mode.c source file.
+
+ */
+/* ************************************************************************** */
+
+#ifndef _MODE_H    /* Guard against multiple inclusion */
+#define _MODE_H
+
+#include "stdint.h"
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Constants                                                         */
+/* ************************************************************************** */
+// measurement modes, selecting the value returned by MODE_GetValue
+#define MODE_NONE               0       // the acquired value
+#define MODE_MINMAX             1       // the acquired value, the minimum and maximum since reset are reported with it
+#define MODE_HOLD               2       // the last stable value
+#define MODE_REL                3       // the difference between the acquired value and the reference
+#define MODE_PEAK               4       // the peak-to-peak value of the converter peak registers, the peaks and the crest factor are reported with it
+
+// hold: the value is stable when the last MODE_HOLD_CNT consecutive values stay within the band, the hold value is their mean
+#define MODE_HOLD_CNT           5
+#define MODE_HOLD_BAND          1e-3    // band width relative to the value
+#define MODE_HOLD_FLOOR         1e-4    // minimum band width relative to the scale range, used near zero
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Interface Functions
+// *****************************************************************************
+// *****************************************************************************
+uint8_t MODE_Set(uint8_t bMode);
+uint8_t MODE_Get();
+void MODE_Reset();
+void MODE_SetRef(double dRef);
+void MODE_AddSample(double dVal, int idxScale);
+void MODE_AddPeaks(double dPeakMin, double dPeakMax, double dRms);
+double MODE_GetValue(double dVal);
+uint32_t MODE_GetCntSamples();
+double MODE_GetMin();
+double MODE_GetMax();
+double MODE_GetHeld();
+double MODE_GetRef();
+double MODE_GetPeakMin();
+double MODE_GetPeakMax();
+double MODE_GetCrest();
+
+#endif /* _MODE_H */
+
+/* *****************************************************************************
+ End of File
+ */
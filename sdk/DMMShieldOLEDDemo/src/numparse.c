@@ -0,0 +1,437 @@
+/* ************************************************************************** */
+/** Descriptive File Name
+
+  @Company
+    Digilent
+
+  @File Name
+    numparse.c
+
+  @Description
+        This file groups the functions that implement the NUMPARSE module.
+        The module converts text values like "-24.678912 mV", "1.5e-3A" or "2 kOhm" into double values.
+        The string is parsed in a single pass, it is not modified and no memory is allocated.
+        When the string cannot be interpreted, the functions return the position of the first wrong character.
+        The module does not depend on the DMM, so it can be used by other command front ends.
+        The "Interface functions" section groups functions that can also be called by User.
+        The "Local functions" section groups low level functions that are only called from within the current module.
+        The module uses errors defined in the ERRORS module.
+        The NUMPARSE functions are called from DMM module.
+
+ */
+/* ************************************************************************** */
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Included Files                                                    */
+/* ************************************************************************** */
+#include <string.h>
+#include "stdint.h"
+#include "math.h"
+#include "numparse.h"
+#include "errors.h"
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+// Section: Local functions prototypes                                        */
+/* ************************************************************************** */
+/* ************************************************************************** */
+int NUMPARSE_SkipBlanks(const char *pString, int idx);
+int NUMPARSE_MatchUnit(const char *pString, int idx, const char *szUnit);
+double NUMPARSE_Scale(uint64_t qwMant, int exp10);
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Global Variables                                                  */
+/* ************************************************************************** */
+/* ************************************************************************** */
+// powers of 10 that are exactly represented as double
+static const double dNumParsePow10[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+                                        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+// Section: Interface Functions                                               */
+/* ************************************************************************** */
+/* ************************************************************************** */
+
+/***	NUMPARSE_ParseValue
+**
+**	Parameters:
+**		const char *pString     - the string to be interpreted
+**      const char *szUnit      - the expected measure unit (for example "V"), can be NULL or empty
+**      int expDefault          - power of 10 applied to the value when the string contains neither prefix nor unit
+**      double *pdVal           - pointer to a variable to get the value
+**      int *pIdxErr            - pointer to a variable to get the position of the first wrong character, can be NULL
+**
+**	Return Value:
+**		uint8_t 
+**          ERRVAL_SUCCESS                  0       // success
+**          ERRVAL_CMD_VALWRONGUNIT         0xF4    // The provided value has a wrong measure unit.
+**          ERRVAL_CMD_VALFORMAT            0xF2    // The numeric value cannot be extracted from the provided string.
+**
+**	Description:
+**		The function interprets a string containing a numeric value followed by an optional SI prefix and measure unit.
+**      The accepted format is: [blanks][sign]digits[.digits][(e|E)[sign]digits][blanks][prefix][unit][blanks].
+**      The digits before or after the decimal point can be missing, but not both.
+**      The accepted prefixes are n, u, m, k, M and G. When szUnit is not empty, a prefix must be followed by the unit.
+**      When szUnit is NULL or empty, the prefix can be the last character.
+**      When neither prefix nor unit is present, the value is multiplied by 10^expDefault. For example expDefault is -3 
+**      to interpret the string "24.5" as 24.5 m(unit).
+**      The string is parsed in a single pass, it is not modified and no memory is allocated.
+**      The decimal mantissa is accumulated as an integer. When it has at most 15 significant digits and the total power of 10 
+**      is within -22 .. 22, the result is correctly rounded, otherwise it is within a few units in the last place.
+**      On error, *pIdxErr is set to the position (0 based) of the first character that cannot be interpreted.
+**      The function returns ERRVAL_CMD_VALWRONGUNIT if the string contains a different measure unit or a wrong prefix.
+**      The function returns ERRVAL_CMD_VALFORMAT if the numeric value is missing, malformed or out of the double range.
+**                 
+*/
+uint8_t NUMPARSE_ParseValue(const char *pString, const char *szUnit, int expDefault, double *pdVal, int *pIdxErr)
+{
+    uint64_t qwMant = 0;
+    int idx, idxNum, idxErr = -1, exp10 = 0, expVal = 0, cDigits = 0, cchUnit;
+    uint8_t fNeg = 0, fNegExp = 0, fPoint = 0, fSuffix = 0, bResult = ERRVAL_SUCCESS;
+    char ch;
+    double dVal;
+
+    idx = NUMPARSE_SkipBlanks(pString, 0);
+    idxNum = idx;
+    // sign
+    if(pString[idx] == '+' || pString[idx] == '-')
+    {
+        fNeg = (pString[idx] == '-');
+        idx++;
+    }
+    // mantissa, the digits that don't fit in 64 bits only change the exponent
+    for(;; idx++)
+    {
+        ch = pString[idx];
+        if(ch >= '0' && ch <= '9')
+        {
+            cDigits++;
+            if(qwMant < 1000000000000000000ULL)
+            {
+                qwMant = qwMant * 10 + (ch - '0');
+                if(fPoint)
+                {
+                    exp10--;
+                }
+            }
+            else
+            {
+                if(!fPoint)
+                {
+                    exp10++;
+                }
+            }
+        }
+        else
+        {
+            if(ch == '.' && !fPoint)
+            {
+                fPoint = 1;
+            }
+            else
+            {
+                break;
+            }
+        }
+    }
+    if(!cDigits)
+    {
+        idxErr = idx;
+        bResult = ERRVAL_CMD_VALFORMAT;
+    }
+    // exponent
+    if(bResult == ERRVAL_SUCCESS && (pString[idx] == 'e' || pString[idx] == 'E'))
+    {
+        idx++;
+        if(pString[idx] == '+' || pString[idx] == '-')
+        {
+            fNegExp = (pString[idx] == '-');
+            idx++;
+        }
+        if(pString[idx] < '0' || pString[idx] > '9')
+        {
+            idxErr = idx;
+            bResult = ERRVAL_CMD_VALFORMAT;
+        }
+        while(pString[idx] >= '0' && pString[idx] <= '9')
+        {
+            if(expVal <= NUMPARSE_MAXEXP)
+            {
+                expVal = expVal * 10 + (pString[idx] - '0');
+            }
+            idx++;
+        }
+        exp10 += fNegExp ? -expVal : expVal;
+    }
+    // prefix and unit
+    if(bResult == ERRVAL_SUCCESS)
+    {
+        idx = NUMPARSE_SkipBlanks(pString, idx);
+        cchUnit = NUMPARSE_MatchUnit(pString, idx, szUnit);
+        if(cchUnit)
+        {
+            // unit without prefix
+            idx += cchUnit;
+            fSuffix = 1;
+        }
+        else
+        {
+            ch = pString[idx];
+            if(ch && strchr(NUMPARSE_PREFIXES, ch))
+            {
+                exp10 += NUMPARSE_GetPrefixExp(ch);
+                idx++;
+                fSuffix = 1;
+                if(szUnit && szUnit[0])
+                {
+                    cchUnit = NUMPARSE_MatchUnit(pString, idx, szUnit);
+                    if(cchUnit)
+                    {
+                        idx += cchUnit;
+                    }
+                    else
+                    {
+                        // the prefix is not followed by the expected unit
+                        idxErr = idx;
+                        bResult = ERRVAL_CMD_VALWRONGUNIT;
+                    }
+                }
+            }
+        }
+    }
+    // nothing else is accepted after the unit
+    if(bResult == ERRVAL_SUCCESS)
+    {
+        idx = NUMPARSE_SkipBlanks(pString, idx);
+        ch = pString[idx];
+        if(ch)
+        {
+            idxErr = idx;
+            if((ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z'))
+            {
+                bResult = ERRVAL_CMD_VALWRONGUNIT;
+            }
+            else
+            {
+                bResult = ERRVAL_CMD_VALFORMAT;
+            }
+        }
+    }
+    if(bResult == ERRVAL_SUCCESS)
+    {
+        if(!fSuffix)
+        {
+            exp10 += expDefault;
+        }
+        dVal = NUMPARSE_Scale(qwMant, exp10);
+        if(isinf(dVal))
+        {
+            // out of the double range
+            idxErr = idxNum;
+            bResult = ERRVAL_CMD_VALFORMAT;
+        }
+        else
+        {
+            *pdVal = fNeg ? -dVal : dVal;
+        }
+    }
+    if(pIdxErr)
+    {
+        *pIdxErr = idxErr;
+    }
+    return bResult;
+}
+
+/***	NUMPARSE_MatchToken
+**
+**	Parameters:
+**		const char *pString     - the string to be checked
+**      const char *szToken     - the token, for example "OVERLOAD"
+**
+**	Return Value:
+**		1 if the string contains only the token, eventually surrounded by blanks.
+**		0 otherwise.
+**
+**	Description:
+**		The function checks if the string contains the specified token (case sensitive), eventually surrounded by blanks.
+**      It is used to detect the special values like "OVERLOAD" without trimming the string.
+**                 
+*/
+uint8_t NUMPARSE_MatchToken(const char *pString, const char *szToken)
+{
+    int idx = NUMPARSE_SkipBlanks(pString, 0);
+    int cchToken = strlen(szToken);
+    if(strncmp(pString + idx, szToken, cchToken))
+    {
+        return 0;
+    }
+    idx = NUMPARSE_SkipBlanks(pString, idx + cchToken);
+    return (pString[idx] == 0);
+}
+
+/***	NUMPARSE_GetPrefixExp
+**
+**	Parameters:
+**		char chPrefix       - the SI prefix character
+**
+**	Return Value:
+**		int
+**          the power of 10 corresponding to the prefix, 0 if the character is not a prefix
+**
+**	Description:
+**		The function returns the power of 10 corresponding to an SI prefix: -9 for n, -6 for u, -3 for m,
+**      3 for k, 6 for M and 9 for G.
+**                 
+*/
+int NUMPARSE_GetPrefixExp(char chPrefix)
+{
+    int exp10;
+    switch(chPrefix)
+    {
+        case 'n':
+            exp10 = -9;
+            break;
+        case 'u':
+            exp10 = -6;
+            break;
+        case 'm':
+            exp10 = -3;
+            break;
+        case 'k':
+            exp10 = 3;
+            break;
+        case 'M':
+            exp10 = 6;
+            break;
+        case 'G':
+            exp10 = 9;
+            break;
+        default:
+            exp10 = 0;
+            break;
+    }
+    return exp10;
+}
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+// Section: Local Functions                                                   */
+/* ************************************************************************** */
+/* ************************************************************************** */
+
+/***	NUMPARSE_SkipBlanks
+**
+**	Parameters:
+**		const char *pString     - the string
+**      int idx                 - the start position
+**
+**	Return Value:
+**		int
+**          the position of the first character that is not a blank (space or tab)
+**
+**	Description:
+**		The function skips the blank characters starting from the specified position.
+**                 
+*/
+int NUMPARSE_SkipBlanks(const char *pString, int idx)
+{
+    while(pString[idx] == ' ' || pString[idx] == '\t')
+    {
+        idx++;
+    }
+    return idx;
+}
+
+/***	NUMPARSE_MatchUnit
+**
+**	Parameters:
+**		const char *pString     - the string
+**      int idx                 - the position where the unit is expected
+**      const char *szUnit      - the unit, can be NULL or empty
+**
+**	Return Value:
+**		int
+**          the length of the unit if the string contains the unit at the specified position, 0 otherwise
+**
+**	Description:
+**		The function checks if the unit is found in the string at the specified position.
+**      The unit must be followed by a blank or by the end of the string.
+**                 
+*/
+int NUMPARSE_MatchUnit(const char *pString, int idx, const char *szUnit)
+{
+    int cchUnit;
+    char ch;
+    if(!szUnit || !szUnit[0])
+    {
+        return 0;
+    }
+    cchUnit = strlen(szUnit);
+    if(strncmp(pString + idx, szUnit, cchUnit))
+    {
+        return 0;
+    }
+    ch = pString[idx + cchUnit];
+    return (ch == 0 || ch == ' ' || ch == '\t') ? cchUnit : 0;
+}
+
+/***	NUMPARSE_Scale
+**
+**	Parameters:
+**		uint64_t qwMant     - the decimal mantissa
+**      int exp10           - the power of 10
+**
+**	Return Value:
+**		double
+**          the value qwMant * 10^exp10
+**
+**	Description:
+**		The function computes the value of a decimal number.
+**      When the mantissa is exactly represented as double (at most 2^53) and exp10 is within -22 .. 22, the result 
+**      is obtained by a single multiplication or division with an exact power of 10, so it is correctly rounded.
+**      Otherwise the power of 10 is applied in steps of 10^22, each step adding a rounding error.
+**      Very large exponents give INFINITY, very small exponents give 0.
+**                 
+*/
+double NUMPARSE_Scale(uint64_t qwMant, int exp10)
+{
+    double dVal = (double)qwMant;
+    if(qwMant == 0)
+    {
+        return 0;
+    }
+    while(exp10 > 22)
+    {
+        dVal *= dNumParsePow10[22];
+        exp10 -= 22;
+        if(isinf(dVal))
+        {
+            return dVal;
+        }
+    }
+    while(exp10 < -22)
+    {
+        dVal /= dNumParsePow10[22];
+        exp10 += 22;
+        if(dVal == 0)
+        {
+            return dVal;
+        }
+    }
+    if(exp10 >= 0)
+    {
+        dVal *= dNumParsePow10[exp10];
+    }
+    else
+    {
+        dVal /= dNumParsePow10[-exp10];
+    }
+    return dVal;
+}
+
+/* *****************************************************************************
+ End of File
+ */
@@ -0,0 +1,42 @@
+/* ************************************************************************** */
+/** Descriptive File Name
+
+  @Company
+ Digilent
+
+  @File Name
+    numparse.h
+
+  @Description
+        This file contains the declarations for the NUMPARSE module functions.
+        The NUMPARSE functions are defined in numparse.c source file.
+
+ */
+/* ************************************************************************** */
+
+#ifndef _NUMPARSE_H    /* Guard against multiple inclusion */
+#define _NUMPARSE_H
+
+#include "stdint.h"
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Constants                                                         */
+/* ************************************************************************** */
+#define NUMPARSE_MAXEXP         999     // absolute value limit for the exponent field
+#define NUMPARSE_PREFIXES       "numkMG" // accepted SI prefixes: nano, micro, mili, kilo, Mega, Giga
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Interface Functions
+// *****************************************************************************
+// *****************************************************************************
+uint8_t NUMPARSE_ParseValue(const char *pString, const char *szUnit, int expDefault, double *pdVal, int *pIdxErr);
+uint8_t NUMPARSE_MatchToken(const char *pString, const char *szToken);
+int NUMPARSE_GetPrefixExp(char chPrefix);
+
+#endif /* _NUMPARSE_H */
+
+/* *****************************************************************************
+ End of File
+ */
@@ -0,0 +1,646 @@
+/* ************************************************************************** */
+/** Descriptive File Name
+
+  @Company
+    Digilent
+
+  @File Name
+    oleddisp.c
+
+  @Description
+        This file groups the functions that implement the OLEDDISP module, the display layer of PmodOLED.
+        The PmodOLED driver functions are still used to draw in the driver frame buffer, but instead of OLED_Update,
+        which sends the whole 512 bytes frame, OLEDDISP_Flush compares the frame buffer with a copy of the last
+        frame sent (shadow frame) and sends only the changed column ranges of each page.
+        Each range is sent as a column and page address command followed by the data bytes.
+        The commands set the address for both the horizontal and the page addressing modes of the display controller,
+        and the full address range is restored at the end, so that OLED_Update can still be used.
+        The changed ranges are copied with their commands in a transmit buffer, which acts as a second frame buffer:
+        OLEDDISP_FlushAsync returns immediately and the next frame can be drawn in the driver frame buffer
+        while the transmit buffer is sent. The hardware design does not connect the AXI Quad SPI interrupt, so the
+        FIFO is refilled by OLEDDISP_Tick, called from the timer interrupt (see TIMER_SetMsTick).
+        OLEDDISP_Flush sends the transmit buffer polled, it is used when the timer is not running.
+        OLEDDISP_ScrollLeft adds to the next flush the controller command that scrolls a group of pages by one column,
+        so that a scrolling graph is updated by writing only one column.
+        The module writes the AXI Quad SPI registers directly (the core is configured by OLED_Begin)
+        and the Data / Command pin through the PmodOLED GPIO.
+
+ */
+/* ************************************************************************** */
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Included Files                                                    */
+/* ************************************************************************** */
+#include <string.h>
+#include "stdint.h"
+#include "xil_io.h"
+#include "xspi.h"
+#include "PmodOLED.h"
+#include "timer.h"
+#include "oleddisp.h"
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+// Section: Local functions prototypes                                        */
+/* ************************************************************************** */
+/* ************************************************************************** */
+uint32_t OLEDDISP_Prepare();
+void OLEDDISP_AddRange(int idxPage, int idxColFirst, int idxColLast, uint8_t *pbData);
+void OLEDDISP_AddBytes(uint8_t fData, const uint8_t *pbData, int cbData);
+void OLEDDISP_AddScroll();
+void OLEDDISP_FillFifo();
+void OLEDDISP_Finish();
+void OLEDDISP_SetDC(uint8_t fData);
+void OLEDDISP_SpiBegin();
+void OLEDDISP_SpiEnd();
+void OLEDDISP_SpiWrite(uint8_t fData, const uint8_t *pbData, int cbData);
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Global Variables                                                  */
+/* ************************************************************************** */
+/* ************************************************************************** */
+static PmodOLED *pOledDev = 0;
+static uint8_t rgbShadow[OLEDDISP_PAGES * OLEDDISP_COLUMNS];   // the frame displayed by the PmodOLED (after the flush in progress)
+static uint8_t fShadowValid = 0;                                // rgbShadow matches the display
+static OLEDDISP_STATS oleddispStats;
+static uint32_t cbFlush;                                        // bytes of the current flush
+
+// transmit buffer, split in segments sent with the same Data / Command level
+static uint8_t rgbTx[OLEDDISP_TXBYTES];
+static OLEDDISP_SEGMENT rgSegs[OLEDDISP_MAXSEGMENTS];
+static int cSegs;
+
+// asynchronous flush, advanced by OLEDDISP_Tick
+static volatile uint8_t fFlushBusy = 0;     // a flush is in progress
+static int idxSegTx;                        // segment being sent
+static int cbSegTx;                         // bytes of the segment written in the transmit FIFO
+static int cbSegRx;                         // bytes of the segment received back (completely sent)
+static uint32_t dwFlushStartUs;             // start time of the flush
+
+// one column scroll, sent by the next flush
+static int idxScrollFirst = -1;             // first page to be scrolled, -1 if no scroll is requested
+static int idxScrollLast;                   // last page to be scrolled
+static uint8_t fScrollSent = 0;             // a scroll command was sent, at dwScrollMs
+static uint32_t dwScrollMs;
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+// Section: Interface Functions                                               */
+/* ************************************************************************** */
+/* ************************************************************************** */
+
+/***	OLEDDISP_Init
+**
+**	Parameters:
+**		PmodOLED *pOled     - the PmodOLED device, initialized by OLED_Begin
+**
+**	Return Value:
+**		none
+**
+**	Description:
+**		This function initializes the display layer and resets the statistics.
+**      The first flush sends the whole frame.
+**
+*/
+void OLEDDISP_Init(PmodOLED *pOled)
+{
+    while(fFlushBusy);
+    pOledDev = pOled;
+    memset(&oleddispStats, 0, sizeof(oleddispStats));
+    OLEDDISP_Invalidate();
+}
+
+/***	OLEDDISP_Invalidate
+**
+**	Parameters:
+**		none
+**
+**	Return Value:
+**		none
+**
+**	Description:
+**		This function marks the shadow frame as not matching the display, so that the next flush sends the whole frame.
+**      It must be called after the display content is changed without OLEDDISP_Flush or OLEDDISP_FlushAsync (for example by OLED_Update).
+**
+*/
+void OLEDDISP_Invalidate()
+{
+    fShadowValid = 0;
+}
+
+/***	OLEDDISP_Flush
+**
+**	Parameters:
+**		none
+**
+**	Return Value:
+**		uint32_t    - the number of bytes sent over SPI (commands and data)
+**
+**	Description:
+**		This function sends to the display the changes of the driver frame buffer since the previous flush,
+**      and returns when they are sent. It first waits for the asynchronous flush in progress, if any.
+**
+*/
+uint32_t OLEDDISP_Flush()
+{
+    int idxSeg;
+    while(fFlushBusy);
+    if(!OLEDDISP_Prepare())
+    {
+        return 0;
+    }
+    dwFlushStartUs = TIMER_GetUs();
+    for(idxSeg = 0; idxSeg < cSegs; idxSeg++)
+    {
+        OLEDDISP_SpiWrite(rgSegs[idxSeg].fData, rgbTx + rgSegs[idxSeg].idxFirst, rgSegs[idxSeg].cbSeg);
+    }
+    OLEDDISP_Finish();
+    return cbFlush;
+}
+
+/***	OLEDDISP_FlushAsync
+**
+**	Parameters:
+**		none
+**
+**	Return Value:
+**		uint32_t    - the number of bytes to be sent over SPI (commands and data), 0 if nothing changed or a flush is in progress
+**
+**	Description:
+**		This function starts sending to the display the changes of the driver frame buffer since the previous flush, and returns
+**      without waiting. The changes are copied in the transmit buffer, so the next frame can be drawn in the driver frame buffer
+**      right away. OLEDDISP_Tick, called from the timer interrupt, refills the SPI FIFO until the flush is finished.
+**      If a flush is in progress, nothing is done (the caller should check OLEDDISP_IsBusy and retry later).
+**
+*/
+uint32_t OLEDDISP_FlushAsync()
+{
+    if(fFlushBusy)
+    {
+        oleddispStats.cntBusy++;
+        return 0;
+    }
+    if(!OLEDDISP_Prepare())
+    {
+        return 0;
+    }
+    dwFlushStartUs = TIMER_GetUs();
+    idxSegTx = 0;
+    cbSegTx = 0;
+    cbSegRx = 0;
+    OLEDDISP_SetDC(rgSegs[0].fData);
+    OLEDDISP_SpiBegin();
+    OLEDDISP_FillFifo();
+    // from now on the flush is advanced by OLEDDISP_Tick
+    fFlushBusy = 1;
+    return cbFlush;
+}
+
+/***	OLEDDISP_IsBusy
+**
+**	Parameters:
+**		none
+**
+**	Return Value:
+**		uint8_t     - 1 if an asynchronous flush is in progress, 0 otherwise
+**
+**	Description:
+**		This function returns the flush-in-progress state. While a flush is in progress, the driver frame buffer
+**      can be drawn, but OLED_Update and other direct display accesses must not be used.
+**
+*/
+uint8_t OLEDDISP_IsBusy()
+{
+    return fFlushBusy;
+}
+
+/***	OLEDDISP_ScrollLeft
+**
+**	Parameters:
+**		int idxPageFirst    - the first page to be scrolled
+**		int idxPageLast     - the last page to be scrolled
+**
+**	Return Value:
+**		uint8_t     - 1 if the scroll is added to the next flush, 0 if it is refused
+**
+**	Description:
+**		This function requests the scrolling of the pages by one column to the left, performed by the display controller
+**      (one column scroll command, 2Dh). The first column is moved in the last column.
+**      The next flush first sends the changed ranges, then the scroll command, and then rotates the same way both the driver
+**      frame buffer and the shadow frame, so that they match the display. To append a column at the right end of the pages,
+**      the caller draws it in the first column of the driver frame buffer before the flush.
+**      The scroll is refused while another one is requested, or when the previous scroll command was sent less than
+**      OLEDDISP_SCROLL_MINMS milliseconds ago (the controller needs 2 frames to perform it); then the caller must redraw the pages.
+**
+*/
+uint8_t OLEDDISP_ScrollLeft(int idxPageFirst, int idxPageLast)
+{
+    if(idxScrollFirst >= 0 || idxPageFirst < 0 || idxPageLast >= OLEDDISP_PAGES || idxPageFirst > idxPageLast ||
+            (fScrollSent && (uint32_t)(TIMER_GetMs() - dwScrollMs) < OLEDDISP_SCROLL_MINMS))
+    {
+        return 0;
+    }
+    idxScrollFirst = idxPageFirst;
+    idxScrollLast = idxPageLast;
+    return 1;
+}
+
+/***	OLEDDISP_Tick
+**
+**	Parameters:
+**		none
+**
+**	Return Value:
+**		none
+**
+**	Description:
+**		This function advances the asynchronous flush. It is called from the timer interrupt context, and does not wait.
+**      It counts the bytes received back (completely sent), and when the current segment is finished it sets the
+**      Data / Command pin for the next segment. Then it refills the transmit FIFO.
+**      After the last segment, the slave select is released and the flush duration is counted.
+**
+*/
+void OLEDDISP_Tick()
+{
+    if(!fFlushBusy)
+    {
+        return;
+    }
+    while(!(XSpi_ReadReg(OLEDDISP_SPI_BASEADDR, XSP_SR_OFFSET) & XSP_SR_RX_EMPTY_MASK))
+    {
+        XSpi_ReadReg(OLEDDISP_SPI_BASEADDR, XSP_DRR_OFFSET);
+        cbSegRx++;
+    }
+    if(cbSegRx == rgSegs[idxSegTx].cbSeg)
+    {
+        // the Data / Command pin is changed only when all the bytes of the segment are sent
+        if(++idxSegTx == cSegs)
+        {
+            OLEDDISP_SpiEnd();
+            OLEDDISP_Finish();
+            fFlushBusy = 0;
+            return;
+        }
+        cbSegTx = 0;
+        cbSegRx = 0;
+        OLEDDISP_SetDC(rgSegs[idxSegTx].fData);
+    }
+    OLEDDISP_FillFifo();
+}
+
+/***	OLEDDISP_GetStats
+**
+**	Parameters:
+**		OLEDDISP_STATS *pStats  - pointer to receive the statistics
+**
+**	Return Value:
+**		none
+**
+**	Description:
+**		This function copies the display layer statistics: number of flushes, number of flushes that sent data,
+**      bytes sent by the last flush, the largest flush and all the flushes, duration of the last and the longest flush,
+**      and the number of asynchronous flushes refused because a flush was in progress.
+**
+*/
+void OLEDDISP_GetStats(OLEDDISP_STATS *pStats)
+{
+    *pStats = oleddispStats;
+}
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+// Section: Local Functions                                                   */
+/* ************************************************************************** */
+/* ************************************************************************** */
+
+/***	OLEDDISP_Prepare
+**
+**	Parameters:
+**		none
+**
+**	Return Value:
+**		uint32_t    - the number of bytes to be sent (commands and data), 0 if nothing changed
+**
+**	Description:
+**		This function compares the driver frame buffer with the shadow frame and fills the transmit buffer.
+**      For each page, the changed columns are grouped in ranges (unchanged gaps shorter than OLEDDISP_MERGEGAP columns
+**      are sent with the range, as they cost less than a new address command), and each range is added.
+**      The requested scroll is added after the ranges.
+**      The shadow frame is updated and the statistics are counted.
+**
+*/
+uint32_t OLEDDISP_Prepare()
+{
+    uint8_t *pbFrame;
+    int idxPage, idxCol, idxFirst, idxLast, cGap;
+    cbFlush = 0;
+    cSegs = 0;
+    if(!pOledDev)
+    {
+        return 0;
+    }
+    pbFrame = pOledDev->OLEDState.rgbOledBmp;
+    for(idxPage = 0; idxPage < OLEDDISP_PAGES; idxPage++)
+    {
+        idxFirst = -1;
+        idxLast = -1;
+        cGap = 0;
+        for(idxCol = 0; idxCol < OLEDDISP_COLUMNS; idxCol++)
+        {
+            if(fShadowValid && pbFrame[idxPage * OLEDDISP_COLUMNS + idxCol] == rgbShadow[idxPage * OLEDDISP_COLUMNS + idxCol])
+            {
+                cGap++;
+                continue;
+            }
+            if(idxFirst >= 0 && cGap >= OLEDDISP_MERGEGAP)
+            {
+                // the gap is too long, add the previous range
+                OLEDDISP_AddRange(idxPage, idxFirst, idxLast, pbFrame);
+                idxFirst = -1;
+            }
+            if(idxFirst < 0)
+            {
+                idxFirst = idxCol;
+            }
+            idxLast = idxCol;
+            cGap = 0;
+        }
+        if(idxFirst >= 0)
+        {
+            OLEDDISP_AddRange(idxPage, idxFirst, idxLast, pbFrame);
+        }
+    }
+    if(idxScrollFirst >= 0)
+    {
+        OLEDDISP_AddScroll();
+    }
+    if(cbFlush)
+    {
+        // restore the full address range for OLED_Update
+        const uint8_t rgbRestore[OLEDDISP_RESTOREBYTES] = {0x21, 0x00, OLEDDISP_COLUMNS - 1, 0x22, 0x00, OLEDDISP_PAGES - 1};
+        OLEDDISP_AddBytes(0, rgbRestore, sizeof(rgbRestore));
+        oleddispStats.cntSent++;
+    }
+    fShadowValid = 1;
+
+    oleddispStats.cntUpdates++;
+    oleddispStats.cbLast = cbFlush;
+    oleddispStats.cbTotal += cbFlush;
+    if(cbFlush > oleddispStats.cbMax)
+    {
+        oleddispStats.cbMax = cbFlush;
+    }
+    return cbFlush;
+}
+
+/***	OLEDDISP_AddRange
+**
+**	Parameters:
+**		int idxPage         - the page
+**		int idxColFirst     - the first column of the range
+**		int idxColLast      - the last column of the range
+**		uint8_t *pbData     - the frame buffer
+**
+**	Return Value:
+**		none
+**
+**	Description:
+**		This function adds one column range of a page to the transmit buffer and copies it in the shadow frame.
+**      The address command sets the column and page range (horizontal addressing mode)
+**      and the page and start column (page addressing mode); each mode ignores the commands of the other one.
+**
+*/
+void OLEDDISP_AddRange(int idxPage, int idxColFirst, int idxColLast, uint8_t *pbData)
+{
+    int idxOffset = idxPage * OLEDDISP_COLUMNS + idxColFirst;
+    int cbRange = idxColLast - idxColFirst + 1;
+    uint8_t rgbCmd[OLEDDISP_CMDBYTES] = {
+        0x21, idxColFirst, idxColLast,              // column range
+        0x22, idxPage, idxPage,                     // page range
+        0xB0 | idxPage,                             // page start
+        idxColFirst & 0x0F, 0x10 | (idxColFirst >> 4)  // start column, lower and higher nibble
+    };
+    OLEDDISP_AddBytes(0, rgbCmd, sizeof(rgbCmd));
+    OLEDDISP_AddBytes(1, pbData + idxOffset, cbRange);
+    memcpy(rgbShadow + idxOffset, pbData + idxOffset, cbRange);
+}
+
+/***	OLEDDISP_AddBytes
+**
+**	Parameters:
+**		uint8_t fData           - 1 for display data, 0 for commands
+**		const uint8_t *pbData   - the bytes to be sent
+**		int cbData              - the number of bytes
+**
+**	Return Value:
+**		none
+**
+**	Description:
+**		This function appends bytes to the transmit buffer. They extend the last segment when the Data / Command level
+**      is the same, otherwise a new segment is started.
+**
+*/
+void OLEDDISP_AddBytes(uint8_t fData, const uint8_t *pbData, int cbData)
+{
+    if(!cSegs || rgSegs[cSegs - 1].fData != fData)
+    {
+        rgSegs[cSegs].fData = fData;
+        rgSegs[cSegs].idxFirst = cbFlush;
+        rgSegs[cSegs].cbSeg = 0;
+        cSegs++;
+    }
+    memcpy(rgbTx + cbFlush, pbData, cbData);
+    rgSegs[cSegs - 1].cbSeg += cbData;
+    cbFlush += cbData;
+}
+
+/***	OLEDDISP_AddScroll
+**
+**	Parameters:
+**		none
+**
+**	Return Value:
+**		none
+**
+**	Description:
+**		This function adds the one column scroll command of the requested pages to the transmit buffer,
+**      and rotates these pages of the driver frame buffer and of the shadow frame by one column to the left.
+**
+*/
+void OLEDDISP_AddScroll()
+{
+    int idxPage;
+    uint8_t bFirst;
+    uint8_t *pbFrame = pOledDev->OLEDState.rgbOledBmp, *pbPage;
+    const uint8_t rgbScroll[OLEDDISP_SCROLLBYTES] = {
+        0x2D, 0x00,                                 // left horizontal scroll by one column
+        idxScrollFirst, 0x01, idxScrollLast,        // start page, 1 column, end page
+        0x00, 0x00, OLEDDISP_COLUMNS - 1            // start and end column
+    };
+    OLEDDISP_AddBytes(0, rgbScroll, sizeof(rgbScroll));
+    for(idxPage = idxScrollFirst; idxPage <= idxScrollLast; idxPage++)
+    {
+        pbPage = pbFrame + idxPage * OLEDDISP_COLUMNS;
+        bFirst = pbPage[0];
+        memmove(pbPage, pbPage + 1, OLEDDISP_COLUMNS - 1);
+        pbPage[OLEDDISP_COLUMNS - 1] = bFirst;
+        pbPage = rgbShadow + idxPage * OLEDDISP_COLUMNS;
+        bFirst = pbPage[0];
+        memmove(pbPage, pbPage + 1, OLEDDISP_COLUMNS - 1);
+        pbPage[OLEDDISP_COLUMNS - 1] = bFirst;
+    }
+    idxScrollFirst = -1;
+    fScrollSent = 1;
+    dwScrollMs = TIMER_GetMs();
+    oleddispStats.cntScrolls++;
+}
+
+/***	OLEDDISP_FillFifo
+**
+**	Parameters:
+**		none
+**
+**	Return Value:
+**		none
+**
+**	Description:
+**		This function writes the next bytes of the current segment in the transmit FIFO.
+**      The bytes not yet received back are limited to the FIFO depth, so that the receive FIFO cannot overflow.
+**
+*/
+void OLEDDISP_FillFifo()
+{
+    const OLEDDISP_SEGMENT *pSeg = &rgSegs[idxSegTx];
+    while(cbSegTx < pSeg->cbSeg && (cbSegTx - cbSegRx) < OLEDDISP_FIFO_DEPTH &&
+            !(XSpi_ReadReg(OLEDDISP_SPI_BASEADDR, XSP_SR_OFFSET) & XSP_SR_TX_FULL_MASK))
+    {
+        XSpi_WriteReg(OLEDDISP_SPI_BASEADDR, XSP_DTR_OFFSET, rgbTx[pSeg->idxFirst + cbSegTx]);
+        cbSegTx++;
+    }
+}
+
+/***	OLEDDISP_Finish
+**
+**	Parameters:
+**		none
+**
+**	Return Value:
+**		none
+**
+**	Description:
+**		This function counts the duration of the flush that just finished.
+**
+*/
+void OLEDDISP_Finish()
+{
+    oleddispStats.usLast = TIMER_GetUs() - dwFlushStartUs;
+    if(oleddispStats.usLast > oleddispStats.usMax)
+    {
+        oleddispStats.usMax = oleddispStats.usLast;
+    }
+}
+
+/***	OLEDDISP_SetDC
+**
+**	Parameters:
+**		uint8_t fData           - 1 for display data, 0 for commands
+**
+**	Return Value:
+**		none
+**
+**	Description:
+**		This function sets the Data / Command pin.
+**
+*/
+void OLEDDISP_SetDC(uint8_t fData)
+{
+    uint32_t dwGpio = Xil_In32(OLEDDISP_GPIO_BASEADDR);
+    Xil_Out32(OLEDDISP_GPIO_BASEADDR, fData ? (dwGpio | OLEDDISP_GPIO_DC_MASK) : (dwGpio & ~OLEDDISP_GPIO_DC_MASK));
+}
+
+/***	OLEDDISP_SpiBegin
+**
+**	Parameters:
+**		none
+**
+**	Return Value:
+**		none
+**
+**	Description:
+**		This function selects the display and enables the AXI Quad SPI master transactions.
+**
+*/
+void OLEDDISP_SpiBegin()
+{
+    XSpi_WriteReg(OLEDDISP_SPI_BASEADDR, XSP_SSR_OFFSET, ~OLEDDISP_SPI_SLAVE_MASK);
+    XSpi_WriteReg(OLEDDISP_SPI_BASEADDR, XSP_CR_OFFSET,
+            XSpi_ReadReg(OLEDDISP_SPI_BASEADDR, XSP_CR_OFFSET) & ~XSP_CR_TRANS_INHIBIT_MASK);
+}
+
+/***	OLEDDISP_SpiEnd
+**
+**	Parameters:
+**		none
+**
+**	Return Value:
+**		none
+**
+**	Description:
+**		This function inhibits the AXI Quad SPI master transactions and releases the display.
+**
+*/
+void OLEDDISP_SpiEnd()
+{
+    XSpi_WriteReg(OLEDDISP_SPI_BASEADDR, XSP_CR_OFFSET,
+            XSpi_ReadReg(OLEDDISP_SPI_BASEADDR, XSP_CR_OFFSET) | XSP_CR_TRANS_INHIBIT_MASK);
+    XSpi_WriteReg(OLEDDISP_SPI_BASEADDR, XSP_SSR_OFFSET, 0xFFFFFFFF);
+}
+
+/***	OLEDDISP_SpiWrite
+**
+**	Parameters:
+**		uint8_t fData           - 1 for display data, 0 for commands
+**		const uint8_t *pbData   - the bytes to be sent
+**		int cbData              - the number of bytes
+**
+**	Return Value:
+**		none
+**
+**	Description:
+**		This function sets the Data / Command pin and sends the bytes over the PmodOLED SPI, filling the transmit FIFO
+**      and waiting until the bytes are received back. The received bytes are discarded.
+**
+*/
+void OLEDDISP_SpiWrite(uint8_t fData, const uint8_t *pbData, int cbData)
+{
+    int cbChunk;
+    OLEDDISP_SetDC(fData);
+    OLEDDISP_SpiBegin();
+    while(cbData)
+    {
+        // fill the transmit FIFO, at most the receive FIFO depth
+        cbChunk = 0;
+        while(cbData && cbChunk < OLEDDISP_FIFO_DEPTH && !(XSpi_ReadReg(OLEDDISP_SPI_BASEADDR, XSP_SR_OFFSET) & XSP_SR_TX_FULL_MASK))
+        {
+            XSpi_WriteReg(OLEDDISP_SPI_BASEADDR, XSP_DTR_OFFSET, *pbData++);
+            cbData--;
+            cbChunk++;
+        }
+        // each sent byte produces a received byte: wait for all of them, so that the last byte is completely shifted out
+        while(cbChunk)
+        {
+            if(!(XSpi_ReadReg(OLEDDISP_SPI_BASEADDR, XSP_SR_OFFSET) & XSP_SR_RX_EMPTY_MASK))
+            {
+                XSpi_ReadReg(OLEDDISP_SPI_BASEADDR, XSP_DRR_OFFSET);
+                cbChunk--;
+            }
+        }
+    }
+    OLEDDISP_SpiEnd();
+}
+
+/* *****************************************************************************
+ End of File
+ */
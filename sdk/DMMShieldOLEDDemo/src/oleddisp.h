@@ -0,0 +1,89 @@
+/* ************************************************************************** */
+/** Descriptive File Name
+
+  @Company
+ Digilent
+
+  @File Name
+    oleddisp.h
+
+  @Description
+        This file contains the declarations for the OLEDDISP module functions.
+        The OLEDDISP functions are defined in oleddisp.c source file.
+
+ */
+/* ************************************************************************** */
+
+#ifndef _OLEDDISP_H    /* Guard against multiple inclusion */
+#define _OLEDDISP_H
+
+#include "stdint.h"
+#include "xparameters.h"
+#include "PmodOLED.h"
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Constants                                                         */
+/* ************************************************************************** */
+#define OLEDDISP_SPI_BASEADDR   XPAR_PMODOLED_0_AXI_LITE_SPI_BASEADDR
+#define OLEDDISP_GPIO_BASEADDR  XPAR_PMODOLED_0_AXI_LITE_GPIO_BASEADDR
+#define OLEDDISP_GPIO_DC_MASK   0x1     // PmodOLED GPIO bit of the Data / Command pin (0 - command, 1 - data)
+#define OLEDDISP_SPI_SLAVE_MASK 0x1     // AXI Quad SPI slave select of the display
+
+#define OLEDDISP_PAGES          cpagOledMax     // number of 8 pixel rows (pages)
+#define OLEDDISP_COLUMNS        ccolOledMax     // number of columns
+#define OLEDDISP_CMDBYTES       9               // command bytes sent before each changed column range
+#define OLEDDISP_MERGEGAP       OLEDDISP_CMDBYTES   // unchanged columns shorter than this are sent instead of starting a new range
+#define OLEDDISP_RESTOREBYTES   6               // command bytes that restore the full address range at the end of a flush
+#define OLEDDISP_FIFO_DEPTH     16              // AXI Quad SPI transmit / receive FIFO depth (C_FIFO_DEPTH)
+#define OLEDDISP_SCROLLBYTES    8               // command bytes of the one column scroll
+#define OLEDDISP_SCROLL_MINMS   30              // minimum time between two scroll commands (ms), at least 2 display frames
+
+// transmit buffer: the changed ranges of a frame with their address commands, sent while the next frame is drawn
+#define OLEDDISP_MAXRANGES      (OLEDDISP_PAGES * (OLEDDISP_COLUMNS / (OLEDDISP_MERGEGAP + 1) + 1))
+#define OLEDDISP_MAXSEGMENTS    (2 * OLEDDISP_MAXRANGES + 1)
+#define OLEDDISP_TXBYTES        (OLEDDISP_PAGES * OLEDDISP_COLUMNS + OLEDDISP_MAXRANGES * OLEDDISP_CMDBYTES + OLEDDISP_SCROLLBYTES + OLEDDISP_RESTOREBYTES)
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Data Types
+// *****************************************************************************
+// *****************************************************************************
+typedef struct _OLEDDISP_STATS{
+    uint32_t cntUpdates;        // number of OLEDDISP_Flush calls
+    uint32_t cntSent;           // number of flushes that sent at least one range
+    uint32_t cbLast;            // bytes sent by the last flush (commands and data)
+    uint32_t cbMax;             // maximum bytes sent by a flush
+    uint32_t cbTotal;           // bytes sent by all the flushes
+    uint32_t usLast;            // duration of the last flush that sent data (us), until the last byte was sent
+    uint32_t usMax;             // maximum duration of a flush (us)
+    uint32_t cntBusy;           // number of OLEDDISP_FlushAsync calls refused because a flush was in progress
+    uint32_t cntScrolls;        // number of one column scroll commands sent
+} OLEDDISP_STATS;
+
+// part of the transmit buffer sent with the same level of the Data / Command pin
+typedef struct _OLEDDISP_SEGMENT{
+    uint8_t fData;              // 1 for display data, 0 for commands
+    uint16_t idxFirst;          // first byte in the transmit buffer
+    uint16_t cbSeg;             // number of bytes
+} OLEDDISP_SEGMENT;
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Interface Functions
+// *****************************************************************************
+// *****************************************************************************
+void OLEDDISP_Init(PmodOLED *pOled);
+void OLEDDISP_Invalidate();
+uint32_t OLEDDISP_Flush();
+uint32_t OLEDDISP_FlushAsync();
+uint8_t OLEDDISP_IsBusy();
+uint8_t OLEDDISP_ScrollLeft(int idxPageFirst, int idxPageLast);
+void OLEDDISP_Tick();
+void OLEDDISP_GetStats(OLEDDISP_STATS *pStats);
+
+#endif /* _OLEDDISP_H */
+
+/* *****************************************************************************
+ End of File
+ */
@@ -0,0 +1,353 @@
+/* ************************************************************************** */
+/** Descriptive File Name
+
+  @Company
+    Digilent
+
+  @File Name
+    sched.c
+
+  @Description
+        This file groups the functions that implement the SCHED module, a cooperative scheduler.
+        Each task is a function that performs a bounded amount of work and returns.
+        A task is released periodically (dwPeriodMs), after a delay requested with SCHED_WakeAfter,
+        or immediately by SCHED_Signal (which can be called from an interrupt handler).
+        Among the released tasks, the one with the earliest absolute deadline runs first (EDF).
+        For each task the module counts the runs, the runs finished after their deadline and the maximum run time.
+        When no task is released the processor waits for an interrupt (wfi), the timer interrupt
+        (TIMER module) occurs every TIMER_TICK_MS milliseconds.
+
+ */
+/* ************************************************************************** */
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Included Files                                                    */
+/* ************************************************************************** */
+#include <stdio.h>
+#include <string.h>
+#include "stdint.h"
+#include "xpseudo_asm.h"
+#include "sched.h"
+#include "timer.h"
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+// Section: Local functions prototypes                                        */
+/* ************************************************************************** */
+/* ************************************************************************** */
+uint8_t SCHED_IsReleased(SCHED_TASK *pTask, uint32_t dwNowMs);
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Global Variables                                                  */
+/* ************************************************************************** */
+/* ************************************************************************** */
+SCHED_TASK rgTasks[SCHED_MAXTASKS];
+int cntTasks = 0;
+int idCurrentTask = SCHED_NOTASK;
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+// Section: Interface Functions                                               */
+/* ************************************************************************** */
+/* ************************************************************************** */
+
+/***	SCHED_Init
+**
+**	Parameters:
+**		none
+**
+**	Return Value:
+**		none
+**
+**	Description:
+**		This function removes all the tasks.
+**
+*/
+void SCHED_Init()
+{
+    memset(rgTasks, 0, sizeof(rgTasks));
+    cntTasks = 0;
+    idCurrentTask = SCHED_NOTASK;
+}
+
+/***	SCHED_AddTask
+**
+**	Parameters:
+**		const char *szName      - the task name, used for statistics
+**		SCHED_TASKFN pfnTask    - the task function
+**		uint32_t dwPeriodMs     - the release period (ms), 0 for tasks released only by SCHED_Signal / SCHED_WakeAfter
+**		uint32_t dwDeadlineMs   - the relative deadline (ms)
+**
+**	Return Value:
+**		int
+**          the task id, to be used with SCHED_Signal and SCHED_WakeAfter, or
+**          SCHED_NOTASK if SCHED_MAXTASKS tasks are already added
+**
+**	Description:
+**		This function adds a task. Periodic tasks are released for the first time immediately.
+**      The relative deadline is counted from the release moment and is used to select the task
+**      to run (earliest deadline first) and to count the missed deadlines.
+**
+*/
+int SCHED_AddTask(const char *szName, SCHED_TASKFN pfnTask, uint32_t dwPeriodMs, uint32_t dwDeadlineMs)
+{
+    SCHED_TASK *pTask;
+    if(cntTasks >= SCHED_MAXTASKS)
+    {
+        return SCHED_NOTASK;
+    }
+    pTask = &rgTasks[cntTasks];
+    memset(pTask, 0, sizeof(SCHED_TASK));
+    pTask->szName = szName;
+    pTask->pfnTask = pfnTask;
+    pTask->dwPeriodMs = dwPeriodMs;
+    pTask->dwDeadlineMs = dwDeadlineMs;
+    pTask->fTimed = (dwPeriodMs != 0);
+    pTask->dwReleaseMs = TIMER_GetMs();
+    return cntTasks++;
+}
+
+/***	SCHED_Signal
+**
+**	Parameters:
+**		int idTask      - the task id
+**
+**	Return Value:
+**		none
+**
+**	Description:
+**		This function releases the task immediately. It can be called from an interrupt handler.
+**
+*/
+void SCHED_Signal(int idTask)
+{
+    if(idTask >= 0 && idTask < cntTasks)
+    {
+        rgTasks[idTask].fSignaled = 1;
+    }
+}
+
+/***	SCHED_WakeAfter
+**
+**	Parameters:
+**		int idTask      - the task id
+**		uint32_t dwMs   - the delay (ms)
+**
+**	Return Value:
+**		none
+**
+**	Description:
+**		This function programs the next timer release of the task after the specified delay, replacing the
+**      periodic release. It is normally called by a task for itself, to resume a long operation after a wait.
+**      A delay of 0 releases the task at the next scheduler pass.
+**
+*/
+void SCHED_WakeAfter(int idTask, uint32_t dwMs)
+{
+    if(idTask >= 0 && idTask < cntTasks)
+    {
+        rgTasks[idTask].dwReleaseMs = TIMER_GetMs() + dwMs;
+        rgTasks[idTask].fTimed = 1;
+    }
+}
+
+/***	SCHED_RunOnce
+**
+**	Parameters:
+**		none
+**
+**	Return Value:
+**		uint8_t
+**          1 if a task was run
+**          0 if no task is released
+**
+**	Description:
+**		This function selects, among the released tasks, the one with the earliest absolute deadline and runs it.
+**      Before running, the next release of a periodic task is programmed one period later, or one period from now
+**      if the task is late (the missed releases are skipped).
+**      After running, the run time and missed deadline statistics are updated.
+**
+*/
+uint8_t SCHED_RunOnce()
+{
+    uint32_t dwNowMs = TIMER_GetMs();
+    uint32_t dwStartUs, dwRunUs;
+    SCHED_TASK *pTask, *pSel = 0;
+    int i, idSel = SCHED_NOTASK;
+    for(i = 0; i < cntTasks; i++)
+    {
+        pTask = &rgTasks[i];
+        if(SCHED_IsReleased(pTask, dwNowMs) && (!pSel || (int32_t)(pTask->dwAbsDeadlineMs - pSel->dwAbsDeadlineMs) < 0))
+        {
+            pSel = pTask;
+            idSel = i;
+        }
+    }
+    if(!pSel)
+    {
+        return 0;
+    }
+    pSel->fSignaled = 0;
+    if(pSel->fTimed && (int32_t)(dwNowMs - pSel->dwReleaseMs) >= 0)
+    {
+        if(pSel->dwPeriodMs)
+        {
+            pSel->dwReleaseMs += pSel->dwPeriodMs;
+            if((int32_t)(dwNowMs - pSel->dwReleaseMs) >= 0)
+            {
+                // late, skip the missed releases
+                pSel->dwReleaseMs = dwNowMs + pSel->dwPeriodMs;
+            }
+        }
+        else
+        {
+            pSel->fTimed = 0;
+        }
+    }
+
+    idCurrentTask = idSel;
+    dwStartUs = TIMER_GetUs();
+    pSel->pfnTask();
+    dwRunUs = TIMER_GetUs() - dwStartUs;
+    idCurrentTask = SCHED_NOTASK;
+
+    pSel->cntRuns++;
+    if(dwRunUs > pSel->dwMaxRunUs)
+    {
+        pSel->dwMaxRunUs = dwRunUs;
+    }
+    if((int32_t)(TIMER_GetMs() - pSel->dwAbsDeadlineMs) > 0)
+    {
+        pSel->cntMissed++;
+    }
+    return 1;
+}
+
+/***	SCHED_Run
+**
+**	Parameters:
+**		none
+**
+**	Return Value:
+**		none
+**
+**	Description:
+**		This function runs the released tasks, in an infinite loop. It never returns.
+**      When no task is released, it waits for an interrupt. A task signaled by an interrupt handler
+**      runs after that interrupt, at the latest after the next timer interrupt.
+**
+*/
+void SCHED_Run()
+{
+    while(1)
+    {
+        if(!SCHED_RunOnce())
+        {
+            wfi();
+        }
+    }
+}
+
+/***	SCHED_GetCurrentTask
+**
+**	Parameters:
+**		none
+**
+**	Return Value:
+**		int     - the id of the running task, or SCHED_NOTASK when called outside a task
+**
+**	Description:
+**		This function returns the id of the running task.
+**
+*/
+int SCHED_GetCurrentTask()
+{
+    return idCurrentTask;
+}
+
+/***	SCHED_GetTaskCount
+**
+**	Parameters:
+**		none
+**
+**	Return Value:
+**		int     - the number of tasks
+**
+**	Description:
+**		This function returns the number of added tasks.
+**
+*/
+int SCHED_GetTaskCount()
+{
+    return cntTasks;
+}
+
+/***	SCHED_FormatStats
+**
+**	Parameters:
+**		int idTask      - the task id
+**		char *pString   - the string to receive the statistics (at least 80 characters)
+**
+**	Return Value:
+**		none
+**
+**	Description:
+**		This function formats the statistics of the task: name, number of runs, missed deadlines and maximum run time.
+**
+*/
+void SCHED_FormatStats(int idTask, char *pString)
+{
+    SCHED_TASK *pTask;
+    if(idTask < 0 || idTask >= cntTasks)
+    {
+        pString[0] = 0;
+        return;
+    }
+    pTask = &rgTasks[idTask];
+    sprintf(pString, "%s: runs %lu, missed %lu, max %lu us, deadline %lu ms", pTask->szName,
+            (unsigned long)pTask->cntRuns, (unsigned long)pTask->cntMissed,
+            (unsigned long)pTask->dwMaxRunUs, (unsigned long)pTask->dwDeadlineMs);
+}
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+// Section: Local Functions                                                   */
+/* ************************************************************************** */
+/* ************************************************************************** */
+
+/***	SCHED_IsReleased
+**
+**	Parameters:
+**		SCHED_TASK *pTask   - the task
+**		uint32_t dwNowMs    - the current time (ms)
+**
+**	Return Value:
+**		uint8_t
+**          1 if the task is released (signaled or timer release reached)
+**          0 otherwise
+**
+**	Description:
+**		This function checks if the task is released and computes the absolute deadline of the release:
+**      from the timer release moment, or from now for a signaled task.
+**
+*/
+uint8_t SCHED_IsReleased(SCHED_TASK *pTask, uint32_t dwNowMs)
+{
+    if(pTask->fTimed && (int32_t)(dwNowMs - pTask->dwReleaseMs) >= 0)
+    {
+        pTask->dwAbsDeadlineMs = pTask->dwReleaseMs + pTask->dwDeadlineMs;
+        return 1;
+    }
+    if(pTask->fSignaled)
+    {
+        pTask->dwAbsDeadlineMs = dwNowMs + pTask->dwDeadlineMs;
+        return 1;
+    }
+    return 0;
+}
+
+/* *****************************************************************************
+ End of File
+ */
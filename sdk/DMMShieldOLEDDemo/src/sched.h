@@ -0,0 +1,69 @@
+/* ************************************************************************** */
+/** Descriptive File Name
+
+  @Company
+ Digilent
+
+  @File Name
+    sched.h
+
+  @Description
+        This file contains the declarations for the SCHED module functions.
+        The SCHED functions are defined in sched.c source file.
+
+ */
+/* ************************************************************************** */
+
+#ifndef _SCHED_H    /* Guard against multiple inclusion */
+#define _SCHED_H
+
+#include "stdint.h"
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Constants                                                         */
+/* ************************************************************************** */
+#define SCHED_MAXTASKS      8       // maximum number of tasks
+#define SCHED_NOTASK        -1      // returned by SCHED_AddTask when no more tasks can be added
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Data Types
+// *****************************************************************************
+// *****************************************************************************
+typedef void (*SCHED_TASKFN)();
+
+typedef struct _SCHED_TASK{
+    const char *szName;             // task name, used for statistics
+    SCHED_TASKFN pfnTask;           // task function, it must return after a bounded amount of work
+    uint32_t dwPeriodMs;            // release period (ms), 0 if the task is released only by SCHED_Signal / SCHED_WakeAfter
+    uint32_t dwDeadlineMs;          // relative deadline (ms), from the release moment
+    uint32_t dwReleaseMs;           // next timer release moment (ms)
+    uint32_t dwAbsDeadlineMs;       // deadline of the current release (ms)
+    volatile uint8_t fSignaled;     // the task was signaled, it is released immediately
+    uint8_t fTimed;                 // the task has a pending timer release at dwReleaseMs
+    uint32_t cntRuns;               // number of runs
+    uint32_t cntMissed;             // number of runs finished after their deadline
+    uint32_t dwMaxRunUs;            // maximum run time (us)
+} SCHED_TASK;
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Interface Functions
+// *****************************************************************************
+// *****************************************************************************
+void SCHED_Init();
+int SCHED_AddTask(const char *szName, SCHED_TASKFN pfnTask, uint32_t dwPeriodMs, uint32_t dwDeadlineMs);
+void SCHED_Signal(int idTask);
+void SCHED_WakeAfter(int idTask, uint32_t dwMs);
+uint8_t SCHED_RunOnce();
+void SCHED_Run();
+int SCHED_GetCurrentTask();
+void SCHED_FormatStats(int idTask, char *pString);
+int SCHED_GetTaskCount();
+
+#endif /* _SCHED_H */
+
+/* *****************************************************************************
+ End of File
+ */
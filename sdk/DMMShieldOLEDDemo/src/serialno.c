@@ -85,32 +85,21 @@ void SERIALNO_Init()
 **      The function returns ERRVAL_SUCCESS for success. 
 **      The function returns ERRVAL_EPROM_MAGICNO when a wrong magic number was detected in the data read from EPROM. 
 **      The function returns ERRVAL_EPROM_CRC when the checksum is wrong for the data read from EPROM. 
+**      All the record formats are accepted: CRC-16, CRC-8 and the legacy additive checksum (see EPROM_CheckRecord).
 **            
 */
 uint8_t SERIALNO_ReadSerialNoFromEPROM(char *pSzSerialNo)
 {
-    uint8_t bCrc, bCrcRead;
+    uint8_t bResult;
  
     // read serialNo structure
     EPROM_ReadWords(ADR_EPROM_SERIALNO, (uint16_t *)&serialNo, sizeof(serialNo)/2);
 
-    // check CRC
-    bCrcRead = serialNo.crc;
-    serialNo.crc = 0;
-
-    bCrc = GetBufferChecksum((uint8_t *)&serialNo, sizeof(serialNo));     
-    
-    serialNo.crc = bCrcRead;
-    
-    if(serialNo.magic != EPROM_MAGIC_NO)
-    {
-        // missing magic number
-        return ERRVAL_EPROM_MAGICNO;
-    }
-    if(serialNo.crc != bCrc)
+    // check magic number and CRC
+    bResult = EPROM_CheckRecord((uint8_t *)&serialNo, sizeof(serialNo));
+    if(bResult != ERRVAL_SUCCESS)
     {
-        // CRC error
-        return ERRVAL_EPROM_CRC;
+        return bResult;
     }
     strncpy(pSzSerialNo, serialNo.rgchSN, SERIALNO_SIZE);   // copy 12 chars of serial number from serialNo to the destination string
     pSzSerialNo[SERIALNO_SIZE] = 0; // terminate string
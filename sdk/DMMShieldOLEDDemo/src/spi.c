@@ -16,6 +16,12 @@
         The "Internal low level functions" section groups functions that are called from other modules (DMM and EPROM). 
         The "Local functions" section groups low level functions that are only called from within current module. 
         All SPI functions are not intended to be called by user, instead user should call functions from DMM and EPROM modules.
+        The "SPI asynchronous transactions" section groups the functions of the asynchronous engine: a state machine stepped
+        by the TIMER fast tick (one clock phase every SPI_ASYNC_TICKUS) runs the queued transactions while the processor
+        does other work, and signals the completion through the transaction fDone flag and callback.
+        When the SPIDMA module is enabled (SPIDMA_ENABLE) and initialized, the engine plays each transaction through DMA
+        instead: the fast tick only starts the DMA transfers and is stopped until the DMA completion.
+        The synchronous DMM and EPROM functions call SPI_AsyncWaitIdle before driving the pins.
 
   @Author
     Cristian Fatu 
@@ -32,10 +38,54 @@
 /* ************************************************************************** */
 /* Section: Included Files                                                    */
 /* ************************************************************************** */
+#include "xil_exception.h"
+#include "xpseudo_asm.h"
 #include "gpio.h"
 #include "spi.h"
+#include "spidma.h"
+#include "timer.h"
+#include "errors.h"
 #include "utils.h"
 
+/* ************************************************************************** */
+/* ************************************************************************** */
+// Section: Local functions prototypes                                        */
+/* ************************************************************************** */
+/* ************************************************************************** */
+void SPI_AsyncTick();
+uint8_t SPI_AsyncClockBit(uint8_t bTx);
+#if SPIDMA_ENABLE
+void SPI_AsyncDmaDone(SPI_XFER *pXfer);
+#endif
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Global Variables                                                  */
+/* ************************************************************************** */
+/* ************************************************************************** */
+// phases of the asynchronous transaction
+#define SPI_PHASE_IDLE      0
+#define SPI_PHASE_CMD       1
+#define SPI_PHASE_READCLK   2
+#define SPI_PHASE_DATA      3
+#define SPI_PHASE_END       4
+#if SPIDMA_ENABLE
+#define SPI_PHASE_DMA       5
+#endif
+
+static uint8_t fAsyncReady = 0;                             // set by SPI_AsyncInit
+#if SPIDMA_ENABLE
+static uint8_t fAsyncDma = 0;                               // the transactions are played through DMA
+#endif
+static volatile uint8_t fAsyncRunning = 0;                  // the fast tick is running
+static SPI_XFER *rgpXferQueue[SPI_ASYNC_QUEUESIZE];         // queued transactions, filled by SPI_AsyncQueue
+static volatile uint8_t idxXferHead = 0, idxXferTail = 0;   // first queued, first free
+static SPI_XFER * volatile pXferCurrent = 0;                // transaction on the wire
+static uint8_t bXferPhase = SPI_PHASE_IDLE;
+static uint16_t cXferWaitTicks;                             // ticks to wait before the next action
+static int idxXferBit, idxXferByte;
+static uint8_t fXferClkHigh, bXferShift;
+
 /* ************************************************************************** */
 /* ************************************************************************** */
 // Section: Internal low level functions Functions                            */
@@ -144,7 +194,331 @@ uint8_t SPI_CoreTransferBits(uint8_t bVal, uint8_t cbBits)
 	return bRx;
 }
 
+// SPI asynchronous transactions
+
+/***	SPI_AsyncInit
+**
+**	Parameters:
+**		none
+**
+**	Return Value:
+**		uint8_t
+**          ERRVAL_SUCCESS              0       // success
+**          ERRVAL_DMM_GENERICERROR     0xEF    // the fast tick cannot be initialized
+**
+**	Description:
+**		This function initializes the asynchronous transactions engine: it connects SPI_AsyncTick to the TIMER fast tick
+**      and, if SPIDMA_ENABLE is 1, initializes the DMA playback. If the DMA cannot be initialized, the fast tick toggles the pins.
+**      The interrupt controller must be initialized (UART_Init). Until this function succeeds, SPI_AsyncIsReady
+**      returns 0 and the DMM module uses the synchronous transfers.
+**
+*/
+uint8_t SPI_AsyncInit()
+{
+    uint8_t bErr;
+    SPI_Init();
+    bErr = TIMER_InitFastTick(SPI_ASYNC_TICKUS, SPI_AsyncTick);
+    fAsyncReady = (bErr == ERRVAL_SUCCESS);
+#if SPIDMA_ENABLE
+    fAsyncDma = fAsyncReady && (SPIDMA_Init() == ERRVAL_SUCCESS);
+#endif
+    return bErr;
+}
+
+/***	SPI_AsyncIsReady
+**
+**	Parameters:
+**		none
+**
+**	Return Value:
+**		uint8_t     - 1 if the asynchronous transactions engine is initialized, 0 otherwise
+**
+**	Description:
+**		This function returns the state of the asynchronous transactions engine.
+**
+*/
+uint8_t SPI_AsyncIsReady()
+{
+    return fAsyncReady;
+}
+
+/***	SPI_AsyncIsDma
+**
+**	Parameters:
+**		none
+**
+**	Return Value:
+**		uint8_t     - 1 if the transactions are played through DMA, 0 otherwise
+**
+**	Description:
+**		This function returns 1 when a queued transaction costs almost no processor time, so that
+**      the synchronous DMM transfers can use the engine too. It always returns 0 when SPIDMA_ENABLE is 0.
+**
+*/
+uint8_t SPI_AsyncIsDma()
+{
+#if SPIDMA_ENABLE
+    return fAsyncDma;
+#else
+    return 0;
+#endif
+}
+
+/***	SPI_AsyncQueue
+**
+**	Parameters:
+**		SPI_XFER *pXfer     - the transaction, it must stay valid until its fDone flag is set
+**
+**	Return Value:
+**		uint8_t
+**          ERRVAL_SUCCESS              0       // success, the transaction is queued
+**          ERRVAL_SPI_ASYNC            0xEB    // the engine is not initialized or the queue is full
+**
+**	Description:
+**		This function clears the fDone flag of the transaction, appends it to the transactions queue and starts the
+**      fast tick if it is not running. The transactions are run in the order they are queued.
+**      When the transaction is finished, fDone is set and pfnDone (if not null) is called from the interrupt context.
+**      The function can also be called from a pfnDone callback, to chain transactions.
+**
+*/
+uint8_t SPI_AsyncQueue(SPI_XFER *pXfer)
+{
+    uint32_t dwCpsr;
+    uint8_t idxNext, bErr = ERRVAL_SUCCESS;
+    if(!fAsyncReady)
+    {
+        return ERRVAL_SPI_ASYNC;
+    }
+    pXfer->fDone = 0;
+    // the fast tick interrupt must not run between the queue update and the tick start
+    dwCpsr = mfcpsr();
+    mtcpsr(dwCpsr | XIL_EXCEPTION_IRQ);
+    idxNext = (idxXferTail + 1) % SPI_ASYNC_QUEUESIZE;
+    if(idxNext == idxXferHead)
+    {
+        bErr = ERRVAL_SPI_ASYNC;
+    }
+    else
+    {
+        rgpXferQueue[idxXferTail] = pXfer;
+        idxXferTail = idxNext;
+        if(!fAsyncRunning)
+        {
+            fAsyncRunning = 1;
+            TIMER_StartFastTick();
+        }
+    }
+    mtcpsr(dwCpsr);
+    return bErr;
+}
 
+/***	SPI_AsyncIsIdle
+**
+**	Parameters:
+**		none
+**
+**	Return Value:
+**		uint8_t     - 1 if no transaction is on the wire or queued, 0 otherwise
+**
+**	Description:
+**		This function returns the state of the asynchronous transactions engine.
+**
+*/
+uint8_t SPI_AsyncIsIdle()
+{
+    return !pXferCurrent && idxXferHead == idxXferTail;
+}
+
+/***	SPI_AsyncWaitIdle
+**
+**	Parameters:
+**		none
+**
+**	Return Value:
+**		none
+**
+**	Description:
+**		This function waits until all the queued transactions are finished.
+**      The synchronous functions of DMM and EPROM modules call it before driving the SPI and chip select pins.
+**
+*/
+void SPI_AsyncWaitIdle()
+{
+    while(!SPI_AsyncIsIdle());
+}
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+// Section: Local Functions                                                   */
+/* ************************************************************************** */
+/* ************************************************************************** */
+
+/***	SPI_AsyncTick
+**
+**	Parameters:
+**		none
+**
+**	Return Value:
+**		none
+**
+**	Description:
+**		This function is the fast tick function of the asynchronous transactions engine, called from the interrupt context.
+**      Each call performs one action of the current transaction: activate the chip select, one clock phase of a
+**      command, read clock or data bit, or deactivate the chip select and signal the completion.
+**      The chip select setup and hold times are cTicksCs ticks.
+**      When no transaction is queued, it stops the fast tick.
+**
+*/
+void SPI_AsyncTick()
+{
+    SPI_XFER *pXfer = pXferCurrent;
+    if(cXferWaitTicks)
+    {
+        cXferWaitTicks--;
+        return;
+    }
+    switch(bXferPhase)
+    {
+        case SPI_PHASE_IDLE:
+            if(idxXferHead == idxXferTail)
+            {
+                TIMER_StopFastTick();
+                fAsyncRunning = 0;
+                break;
+            }
+            pXfer = rgpXferQueue[idxXferHead];
+            idxXferHead = (idxXferHead + 1) % SPI_ASYNC_QUEUESIZE;
+            pXferCurrent = pXfer;
+#if SPIDMA_ENABLE
+            if(fAsyncDma && SPIDMA_Start(pXfer, GPIO_GetOutputValue(), SPI_AsyncDmaDone) == ERRVAL_SUCCESS)
+            {
+                // the DMA drives the pins, SPI_AsyncDmaDone restarts the tick
+                bXferPhase = SPI_PHASE_DMA;
+                TIMER_StopFastTick();
+                break;
+            }
+#endif
+            GPIO_SetOutputValue(pXfer->dwCsMask, pXfer->bCsActive);    // activate chip select
+            cXferWaitTicks = pXfer->cTicksCs;
+            idxXferBit = 0;
+            idxXferByte = 0;
+            fXferClkHigh = 0;
+            bXferPhase = pXfer->cbCmdBits ? SPI_PHASE_CMD : (pXfer->fReadClock ? SPI_PHASE_READCLK : SPI_PHASE_DATA);
+            if(bXferPhase == SPI_PHASE_DATA && pXfer->cbData <= 0)
+            {
+                bXferPhase = SPI_PHASE_END;
+            }
+            break;
+        case SPI_PHASE_CMD:
+            if(SPI_AsyncClockBit((pXfer->wCmd >> (pXfer->cbCmdBits - idxXferBit - 1)) & 1) && ++idxXferBit == pXfer->cbCmdBits)
+            {
+                idxXferBit = 0;
+                bXferPhase = pXfer->fReadClock ? SPI_PHASE_READCLK : SPI_PHASE_DATA;
+                if(bXferPhase == SPI_PHASE_DATA && pXfer->cbData <= 0)
+                {
+                    bXferPhase = SPI_PHASE_END;
+                    cXferWaitTicks = pXfer->cTicksCs;
+                }
+            }
+            break;
+        case SPI_PHASE_READCLK:
+            // extra clock, nothing is transferred
+            fXferClkHigh = !fXferClkHigh;
+            GPIO_SetValue_CLK(fXferClkHigh);
+            if(!fXferClkHigh)
+            {
+                bXferPhase = (pXfer->cbData > 0) ? SPI_PHASE_DATA : SPI_PHASE_END;
+                if(bXferPhase == SPI_PHASE_END)
+                {
+                    cXferWaitTicks = pXfer->cTicksCs;
+                }
+            }
+            break;
+        case SPI_PHASE_DATA:
+            if(SPI_AsyncClockBit(pXfer->fRead ? 0 : (pXfer->pbData[idxXferByte] >> (7 - idxXferBit)) & 1) && ++idxXferBit == 8)
+            {
+                idxXferBit = 0;
+                if(pXfer->fRead)
+                {
+                    pXfer->pbData[idxXferByte] = bXferShift;
+                }
+                if(++idxXferByte == pXfer->cbData)
+                {
+                    bXferPhase = SPI_PHASE_END;
+                    cXferWaitTicks = pXfer->cTicksCs;
+                }
+            }
+            break;
+        case SPI_PHASE_END:
+            GPIO_SetOutputValue(pXfer->dwCsMask, !pXfer->bCsActive);   // deactivate chip select
+            GPIO_SetValue_MOSI(0);
+            bXferPhase = SPI_PHASE_IDLE;
+            pXferCurrent = 0;
+            pXfer->fDone = 1;
+            if(pXfer->pfnDone)
+            {
+                pXfer->pfnDone(pXfer->pRef);
+            }
+            break;
+#if SPIDMA_ENABLE
+        case SPI_PHASE_DMA:
+            // waiting for SPI_AsyncDmaDone
+            break;
+#endif
+    }
+}
+
+#if SPIDMA_ENABLE
+/***	SPI_AsyncDmaDone
+**
+**	Parameters:
+**		SPI_XFER *pXfer     - the transaction played through DMA
+**
+**	Return Value:
+**		none
+**
+**	Description:
+**		This function is called by the SPIDMA module from the DMA interrupt context when the transaction is finished.
+**      The chip select is already deactivated by the last DMA word. The function restarts the fast tick, which
+**      finishes the transaction (SPI_PHASE_END) and starts the next queued one.
+**
+*/
+void SPI_AsyncDmaDone(SPI_XFER *pXfer)
+{
+    bXferPhase = SPI_PHASE_END;
+    cXferWaitTicks = 0;
+    TIMER_StartFastTick();
+}
+#endif
+
+/***	SPI_AsyncClockBit
+**
+**	Parameters:
+**		uint8_t bTx     - the bit to be transmitted
+**
+**	Return Value:
+**		uint8_t         - 1 when the bit transfer is complete, 0 after the first clock phase
+**
+**	Description:
+**		This function performs one clock phase of a bit transfer, the same way as SPI_CoreTransferBits:
+**      on the first call it sets MOSI and the clock line, on the second call it shifts MISO into bXferShift
+**      and clears the clock line.
+**
+*/
+uint8_t SPI_AsyncClockBit(uint8_t bTx)
+{
+    if(!fXferClkHigh)
+    {
+        GPIO_SetValue_MOSI(bTx);	// set the MOSI pin
+        GPIO_SetValue_CLK(1);		// set the clock line
+        fXferClkHigh = 1;
+        return 0;
+    }
+    bXferShift = (bXferShift << 1) | (GPIO_Get_MISO() ? 1 : 0);
+    GPIO_SetValue_CLK(0);	// clear the clock line
+    fXferClkHigh = 0;
+    return 1;
+}
 
 /* *****************************************************************************
  End of File
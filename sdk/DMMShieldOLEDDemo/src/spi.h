@@ -34,6 +34,33 @@
 /* ************************************************************************** */
 #define SPI_CLK_DELAY   1   // the parameter used in delay functions in order to implement a clock phase.
 
+// asynchronous transactions engine
+#define SPI_ASYNC_TICKUS        (SPI_CLK_DELAY * 10)    // engine tick (us), one clock phase per tick
+#define SPI_ASYNC_QUEUESIZE     8                       // maximum number of queued transactions
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Data Types
+// *****************************************************************************
+// *****************************************************************************
+typedef void (*SPI_CALLBACK)(void *pRef);
+
+// asynchronous transaction: chip select, command bits, optional read clock, data bytes in or out, chip select
+typedef struct _SPI_XFER{
+    uint32_t dwCsMask;          // GPIO mask of the chip select pin (GPIO_Mask_CS_DMM, GPIO_Mask_CS_EPROM)
+    uint8_t bCsActive;          // level of the active chip select: 0 for DMM, 1 for EPROM
+    uint16_t cTicksCs;          // ticks between chip select activation and first clock, and between last clock and deactivation
+    uint16_t wCmd;              // command bits, transmitted MSB first
+    uint8_t cbCmdBits;          // number of command bits (<= 16)
+    uint8_t fReadClock;         // generate an extra clock after the command (DMM SPI read period)
+    uint8_t fRead;              // 1 - receive cbData bytes in pbData, 0 - transmit cbData bytes from pbData
+    uint8_t *pbData;            // data bytes
+    int cbData;                 // number of data bytes
+    SPI_CALLBACK pfnDone;       // called from the interrupt context when the transaction is finished, can be null
+    void *pRef;                 // parameter of pfnDone
+    volatile uint8_t fDone;     // set when the transaction is finished
+} SPI_XFER;
+
 
 /* ************************************************************************** */
 /* ************************************************************************** */
@@ -47,6 +74,14 @@ void SPI_Init();
 uint8_t SPI_CoreTransferBits(uint8_t bVal, uint8_t cbBits);
 uint8_t SPI_CoreTransferByte(uint8_t bVal);
 
+// SPI asynchronous transactions
+uint8_t SPI_AsyncInit();
+uint8_t SPI_AsyncIsReady();
+uint8_t SPI_AsyncIsDma();
+uint8_t SPI_AsyncQueue(SPI_XFER *pXfer);
+uint8_t SPI_AsyncIsIdle();
+void SPI_AsyncWaitIdle();
+
 
 #endif /* _SPIJA_H */
 
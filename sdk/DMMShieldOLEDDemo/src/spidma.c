@@ -0,0 +1,426 @@
+/* ************************************************************************** */
+/** Descriptive File Name
+
+  @Company
+    Digilent
+
+  @File Name
+    spidma.c
+
+  @Description
+        This file groups the functions that implement the SPIDMA module.
+        The module plays an asynchronous SPI transaction (SPI_XFER) through the PS DMA controller (PL330)
+        instead of toggling the pins from the processor:
+        SPIDMA_Compile converts the transaction into a buffer of AXI GPIO output words (chip select, clock and MOSI
+        for each clock phase), a DMA channel writes these words to the GPIO output data register, while a second
+        channel reads the GPIO input data register (MISO) once for each output word.
+        When both channels are done, SPIDMA_Decode extracts the received bytes from the captured words:
+        each bit is taken in the middle of its clock high phase, which tolerates a drift of half a phase
+        between the two channels. The channels are not paced by a common request, the capture channel may run ahead
+        of the output channel by more than that, so the module is only used when SPIDMA_ENABLE is set to 1 (see spidma.h).
+        A clock phase lasts SPIDMA_WORDS_PER_PHASE DMA beats, a chip select setup / hold tick lasts SPIDMA_WORDS_PER_CSTICK beats.
+        When SPIDMA_HOST is 1 the DMA controller is replaced by a stand-in that plays the words through a pin model
+        (SPIDMA_HostSetPins), so that the compile / decode functions can be checked on a host computer.
+        The DMA interrupts are connected to the interrupt controller initialized by the UART module.
+        The module is used by the SPI module and uses errors defined in the ERRORS module.
+
+ */
+/* ************************************************************************** */
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Included Files                                                    */
+/* ************************************************************************** */
+#include <string.h>
+#include "stdint.h"
+#include "spidma.h"
+#include "errors.h"
+
+// the module, and its buffers, are only built when the DMA playback is enabled, or for the host check
+#if SPIDMA_ENABLE || SPIDMA_HOST
+#if SPIDMA_HOST
+// the output pins of gpio.h, the host build does not use the Xilinx drivers
+#define GPIO_Mask_CLK       4
+#define GPIO_Mask_MOSI      8
+#define GPIO_Mask_MISO      1
+#else
+#include "xdmaps.h"
+#include "xscugic.h"
+#include "xil_cache.h"
+#include "gpio.h"
+#endif
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+// Section: Local functions prototypes                                        */
+/* ************************************************************************** */
+/* ************************************************************************** */
+int SPIDMA_AddWords(uint32_t *pwWave, int cw, int cwMax, uint32_t dwVal, int cwAdd);
+void SPIDMA_Finish();
+#if !SPIDMA_HOST
+void SPIDMA_DoneHandler(unsigned int Channel, XDmaPs_Cmd *DmaCmd, void *CallbackRef);
+#endif
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Global Variables                                                  */
+/* ************************************************************************** */
+/* ************************************************************************** */
+static uint32_t rgwWave[SPIDMA_MAXWORDS] __attribute__ ((aligned (32)));       // output words of the current transaction
+static uint32_t rgwCapture[SPIDMA_MAXWORDS] __attribute__ ((aligned (32)));    // input words captured during the current transaction
+static int cwCurrent;                   // number of words of the current transaction
+static SPI_XFER *pXferDma = 0;          // current transaction
+static SPIDMA_DONEFN pfnDmaDone = 0;    // called when the current transaction is finished
+
+#if SPIDMA_HOST
+static SPIDMA_HOSTPINFN pfnHostPins = 0;
+#else
+extern XScuGic InterruptController;     // defined in uart.c
+XDmaPs DmaInstance;
+static XDmaPs_Cmd cmdOut, cmdIn;
+static volatile uint8_t cntChannelsDone;
+#endif
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+// Section: Interface Functions                                               */
+/* ************************************************************************** */
+/* ************************************************************************** */
+
+/***	SPIDMA_Init
+**
+**	Parameters:
+**		none
+**
+**	Return Value:
+**		uint8_t
+**          ERRVAL_SUCCESS              0       // success
+**          ERRVAL_DMM_GENERICERROR     0xEF    // the DMA controller cannot be initialized
+**
+**	Description:
+**		This function initializes the DMA controller and connects the done interrupts of the two channels
+**      and the fault interrupt to the interrupt controller, which must be already initialized by UART_Init.
+**      The host build has nothing to initialize.
+**
+*/
+uint8_t SPIDMA_Init()
+{
+#if SPIDMA_HOST
+    return ERRVAL_SUCCESS;
+#else
+    XDmaPs_Config *pConfig = XDmaPs_LookupConfig(SPIDMA_DEVICE_ID);
+    if(!pConfig || XDmaPs_CfgInitialize(&DmaInstance, pConfig, pConfig->BaseAddress) != XST_SUCCESS)
+    {
+        return ERRVAL_DMM_GENERICERROR;
+    }
+    if(XScuGic_Connect(&InterruptController, SPIDMA_FAULT_INTR, (Xil_ExceptionHandler)XDmaPs_FaultISR, (void *)&DmaInstance) != XST_SUCCESS ||
+       XScuGic_Connect(&InterruptController, SPIDMA_DONE_INTR_OUT, (Xil_ExceptionHandler)XDmaPs_DoneISR_0, (void *)&DmaInstance) != XST_SUCCESS ||
+       XScuGic_Connect(&InterruptController, SPIDMA_DONE_INTR_IN, (Xil_ExceptionHandler)XDmaPs_DoneISR_1, (void *)&DmaInstance) != XST_SUCCESS)
+    {
+        return ERRVAL_DMM_GENERICERROR;
+    }
+    XScuGic_Enable(&InterruptController, SPIDMA_FAULT_INTR);
+    XScuGic_Enable(&InterruptController, SPIDMA_DONE_INTR_OUT);
+    XScuGic_Enable(&InterruptController, SPIDMA_DONE_INTR_IN);
+    XDmaPs_SetDoneHandler(&DmaInstance, SPIDMA_CHANNEL_OUT, SPIDMA_DoneHandler, 0);
+    XDmaPs_SetDoneHandler(&DmaInstance, SPIDMA_CHANNEL_IN, SPIDMA_DoneHandler, 0);
+
+    // both channels transfer one 32 bit word per beat, the GPIO side address is fixed
+    memset(&cmdOut, 0, sizeof(cmdOut));
+    cmdOut.ChanCtrl.SrcBurstSize = 4;
+    cmdOut.ChanCtrl.SrcBurstLen = 1;
+    cmdOut.ChanCtrl.SrcInc = 1;
+    cmdOut.ChanCtrl.DstBurstSize = 4;
+    cmdOut.ChanCtrl.DstBurstLen = 1;
+    cmdOut.ChanCtrl.DstInc = 0;
+    cmdOut.BD.SrcAddr = (uint32_t)rgwWave;
+    cmdOut.BD.DstAddr = SPIDMA_GPIO_OUT_ADDR;
+
+    memset(&cmdIn, 0, sizeof(cmdIn));
+    cmdIn.ChanCtrl.SrcBurstSize = 4;
+    cmdIn.ChanCtrl.SrcBurstLen = 1;
+    cmdIn.ChanCtrl.SrcInc = 0;
+    cmdIn.ChanCtrl.DstBurstSize = 4;
+    cmdIn.ChanCtrl.DstBurstLen = 1;
+    cmdIn.ChanCtrl.DstInc = 1;
+    cmdIn.BD.SrcAddr = SPIDMA_GPIO_IN_ADDR;
+    cmdIn.BD.DstAddr = (uint32_t)rgwCapture;
+    return ERRVAL_SUCCESS;
+#endif
+}
+
+/***	SPIDMA_Compile
+**
+**	Parameters:
+**		SPI_XFER *pXfer     - the transaction
+**		uint32_t dwBase     - the current value of the GPIO output data register, gives the level of the other output pins
+**		uint32_t *pwWave    - the buffer to receive the output words
+**		int cwMax           - the size of the buffer, in words
+**
+**	Return Value:
+**		int
+**          the number of output words, or
+**          -1 if the transaction does not fit in the buffer
+**
+**	Description:
+**		This function converts the transaction into the sequence of values to be written in the GPIO output data register:
+**      chip select activation and setup ticks, then for each clock (command bits, read clock, data bits) a low phase
+**      that sets MOSI followed by a high phase, then the chip select hold ticks and the chip select deactivation.
+**      MOSI changes only while the clock is low, the same way as SPI_CoreTransferBits.
+**
+*/
+int SPIDMA_Compile(SPI_XFER *pXfer, uint32_t dwBase, uint32_t *pwWave, int cwMax)
+{
+    int cw = 0, idxBit, idxByte;
+    uint32_t dwIdle, dwSel, dwVal;
+    uint8_t bTx;
+    if(pXfer->cTicksCs > SPIDMA_MAXCSTICKS || pXfer->cbData > SPIDMA_MAXBYTES || pXfer->cbCmdBits > 16)
+    {
+        return -1;
+    }
+    dwIdle = dwBase & ~(GPIO_Mask_CLK | GPIO_Mask_MOSI);
+    dwIdle = pXfer->bCsActive ? (dwIdle & ~pXfer->dwCsMask) : (dwIdle | pXfer->dwCsMask);
+    dwSel = dwIdle ^ pXfer->dwCsMask;
+
+    // chip select setup
+    cw = SPIDMA_AddWords(pwWave, cw, cwMax, dwSel, pXfer->cTicksCs * SPIDMA_WORDS_PER_CSTICK);
+    // command bits
+    for(idxBit = 0; idxBit < pXfer->cbCmdBits; idxBit++)
+    {
+        dwVal = dwSel | (((pXfer->wCmd >> (pXfer->cbCmdBits - idxBit - 1)) & 1) ? GPIO_Mask_MOSI : 0);
+        cw = SPIDMA_AddWords(pwWave, cw, cwMax, dwVal, SPIDMA_WORDS_PER_PHASE);
+        cw = SPIDMA_AddWords(pwWave, cw, cwMax, dwVal | GPIO_Mask_CLK, SPIDMA_WORDS_PER_PHASE);
+    }
+    // extra read clock
+    if(pXfer->fReadClock)
+    {
+        cw = SPIDMA_AddWords(pwWave, cw, cwMax, dwSel, SPIDMA_WORDS_PER_PHASE);
+        cw = SPIDMA_AddWords(pwWave, cw, cwMax, dwSel | GPIO_Mask_CLK, SPIDMA_WORDS_PER_PHASE);
+    }
+    // data bits, MSB first
+    for(idxByte = 0; idxByte < pXfer->cbData; idxByte++)
+    {
+        for(idxBit = 0; idxBit < 8; idxBit++)
+        {
+            bTx = pXfer->fRead ? 0 : (pXfer->pbData[idxByte] >> (7 - idxBit)) & 1;
+            dwVal = dwSel | (bTx ? GPIO_Mask_MOSI : 0);
+            cw = SPIDMA_AddWords(pwWave, cw, cwMax, dwVal, SPIDMA_WORDS_PER_PHASE);
+            cw = SPIDMA_AddWords(pwWave, cw, cwMax, dwVal | GPIO_Mask_CLK, SPIDMA_WORDS_PER_PHASE);
+        }
+    }
+    // clock low, chip select hold, then chip select deactivation
+    cw = SPIDMA_AddWords(pwWave, cw, cwMax, dwSel, SPIDMA_WORDS_PER_PHASE + pXfer->cTicksCs * SPIDMA_WORDS_PER_CSTICK);
+    cw = SPIDMA_AddWords(pwWave, cw, cwMax, dwIdle, 1);
+    return cw;
+}
+
+/***	SPIDMA_Decode
+**
+**	Parameters:
+**		SPI_XFER *pXfer             - the transaction, compiled by SPIDMA_Compile
+**		const uint32_t *pwCapture   - the input words captured during the transaction, one for each output word
+**
+**	Return Value:
+**		none
+**
+**	Description:
+**		For a read transaction, this function places the received bytes in pXfer->pbData.
+**      Each bit is the MISO value captured in the middle of the clock high phase of that bit.
+**
+*/
+void SPIDMA_Decode(SPI_XFER *pXfer, const uint32_t *pwCapture)
+{
+    int idxByte, idxBit, idxWord;
+    uint8_t bRx;
+    if(!pXfer->fRead)
+    {
+        return;
+    }
+    // middle of the high phase of the first data bit
+    idxWord = pXfer->cTicksCs * SPIDMA_WORDS_PER_CSTICK +
+            2 * (pXfer->cbCmdBits + (pXfer->fReadClock ? 1 : 0)) * SPIDMA_WORDS_PER_PHASE +
+            SPIDMA_WORDS_PER_PHASE + SPIDMA_WORDS_PER_PHASE / 2;
+    for(idxByte = 0; idxByte < pXfer->cbData; idxByte++)
+    {
+        bRx = 0;
+        for(idxBit = 0; idxBit < 8; idxBit++)
+        {
+            bRx = (bRx << 1) | ((pwCapture[idxWord] & GPIO_Mask_MISO) ? 1 : 0);
+            idxWord += 2 * SPIDMA_WORDS_PER_PHASE;
+        }
+        pXfer->pbData[idxByte] = bRx;
+    }
+}
+
+/***	SPIDMA_Start
+**
+**	Parameters:
+**		SPI_XFER *pXfer         - the transaction, it must stay valid until pfnDone is called
+**		uint32_t dwBase         - the current value of the GPIO output data register
+**		SPIDMA_DONEFN pfnDone   - the function called from the DMA interrupt context when the transaction is finished
+**
+**	Return Value:
+**		uint8_t
+**          ERRVAL_SUCCESS              0       // success, the DMA transfers are started
+**          ERRVAL_SPI_ASYNC            0xEB    // the transaction is too long, or a transaction is already running
+**          ERRVAL_DMM_GENERICERROR     0xEF    // the DMA transfers cannot be started
+**
+**	Description:
+**		This function compiles the transaction and starts the capture channel, then the output channel.
+**      When both channels are done, the received bytes are decoded and pfnDone is called.
+**      The caller keeps the other users of the GPIO pins away until then (the SPI asynchronous engine does).
+**      In the host build, the stand-in plays the words through the pin model and calls pfnDone before returning.
+**
+*/
+uint8_t SPIDMA_Start(SPI_XFER *pXfer, uint32_t dwBase, SPIDMA_DONEFN pfnDone)
+{
+    int cw;
+    if(pXferDma)
+    {
+        return ERRVAL_SPI_ASYNC;
+    }
+    cw = SPIDMA_Compile(pXfer, dwBase, rgwWave, SPIDMA_MAXWORDS);
+    if(cw < 0)
+    {
+        return ERRVAL_SPI_ASYNC;
+    }
+    pXferDma = pXfer;
+    pfnDmaDone = pfnDone;
+    cwCurrent = cw;
+#if SPIDMA_HOST
+    {
+        int i;
+        for(i = 0; i < cw; i++)
+        {
+            rgwCapture[i] = pfnHostPins ? pfnHostPins(rgwWave[i]) : 0;
+        }
+    }
+    SPIDMA_Finish();
+#else
+    Xil_DCacheFlushRange((UINTPTR)rgwWave, cw * sizeof(uint32_t));
+    Xil_DCacheInvalidateRange((UINTPTR)rgwCapture, cw * sizeof(uint32_t));
+    cmdOut.BD.Length = cw * sizeof(uint32_t);
+    cmdIn.BD.Length = cw * sizeof(uint32_t);
+    cntChannelsDone = 0;
+    if(XDmaPs_Start(&DmaInstance, SPIDMA_CHANNEL_IN, &cmdIn, 0) != XST_SUCCESS ||
+       XDmaPs_Start(&DmaInstance, SPIDMA_CHANNEL_OUT, &cmdOut, 0) != XST_SUCCESS)
+    {
+        pXferDma = 0;
+        return ERRVAL_DMM_GENERICERROR;
+    }
+#endif
+    return ERRVAL_SUCCESS;
+}
+
+#if SPIDMA_HOST
+/***	SPIDMA_HostSetPins
+**
+**	Parameters:
+**		SPIDMA_HOSTPINFN pfnPins    - the pin model
+**
+**	Return Value:
+**		none
+**
+**	Description:
+**		This function sets the pin model used by the host stand-in of the DMA controller.
+**      For each output word, the stand-in calls the pin model and stores the returned input word,
+**      which is the ideal interleaving of the two DMA channels.
+**
+*/
+void SPIDMA_HostSetPins(SPIDMA_HOSTPINFN pfnPins)
+{
+    pfnHostPins = pfnPins;
+}
+#endif
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+// Section: Local Functions                                                   */
+/* ************************************************************************** */
+/* ************************************************************************** */
+
+/***	SPIDMA_AddWords
+**
+**	Parameters:
+**		uint32_t *pwWave    - the output words buffer
+**		int cw              - the number of words already in the buffer, or -1 if the buffer already overflowed
+**		int cwMax           - the size of the buffer, in words
+**		uint32_t dwVal      - the output word to be added
+**		int cwAdd           - the number of times the word is added
+**
+**	Return Value:
+**		int     - the new number of words in the buffer, or -1 if the words do not fit
+**
+**	Description:
+**		This function appends cwAdd copies of an output word to the buffer.
+**
+*/
+int SPIDMA_AddWords(uint32_t *pwWave, int cw, int cwMax, uint32_t dwVal, int cwAdd)
+{
+    if(cw < 0 || cw + cwAdd > cwMax)
+    {
+        return -1;
+    }
+    while(cwAdd--)
+    {
+        pwWave[cw++] = dwVal;
+    }
+    return cw;
+}
+
+/***	SPIDMA_Finish
+**
+**	Parameters:
+**		none
+**
+**	Return Value:
+**		none
+**
+**	Description:
+**		This function decodes the captured words of the current transaction and calls its completion function.
+**
+*/
+void SPIDMA_Finish()
+{
+    SPI_XFER *pXfer = pXferDma;
+#if !SPIDMA_HOST
+    Xil_DCacheInvalidateRange((UINTPTR)rgwCapture, cwCurrent * sizeof(uint32_t));
+#endif
+    SPIDMA_Decode(pXfer, rgwCapture);
+    pXferDma = 0;
+    if(pfnDmaDone)
+    {
+        pfnDmaDone(pXfer);
+    }
+}
+
+#if !SPIDMA_HOST
+/***	SPIDMA_DoneHandler
+**
+**	Parameters:
+**		unsigned int Channel    - the DMA channel
+**		XDmaPs_Cmd *DmaCmd      - the DMA command
+**		void *CallbackRef       - not used
+**
+**	Return Value:
+**		none
+**
+**	Description:
+**		This function is called by the DMA driver from the interrupt context when a channel is done.
+**      When both the output and the capture channels are done, it finishes the transaction.
+**
+*/
+void SPIDMA_DoneHandler(unsigned int Channel, XDmaPs_Cmd *DmaCmd, void *CallbackRef)
+{
+    if(++cntChannelsDone == 2)
+    {
+        SPIDMA_Finish();
+    }
+}
+#endif
+
+#endif /* SPIDMA_ENABLE || SPIDMA_HOST */
+
+/* *****************************************************************************
+ End of File
+ */
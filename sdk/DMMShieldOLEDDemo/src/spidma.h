@@ -0,0 +1,91 @@
+/* ************************************************************************** */
+/** Descriptive File Name
+
+  @Company
+ Digilent
+
+  @File Name
+    spidma.h
+
+  @Description
+        This file contains the declarations for the SPIDMA module functions.
+        The SPIDMA functions are defined in spidma.c source file.
+        Define SPIDMA_HOST as 1 to build the compile / decode functions and the DMA stand-in on a host computer,
+        without the Xilinx drivers.
+
+ */
+/* ************************************************************************** */
+
+#ifndef _SPIDMA_H    /* Guard against multiple inclusion */
+#define _SPIDMA_H
+
+#include "stdint.h"
+#include "spi.h"
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Constants                                                         */
+/* ************************************************************************** */
+#ifndef SPIDMA_HOST
+#define SPIDMA_HOST             0
+#endif
+
+// SPIDMA_ENABLE 1 - the asynchronous SPI engine plays the transactions through DMA
+// SPIDMA_ENABLE 0 - it toggles the pins from the fast tick
+// The two DMA channels are not paced, so the capture of MISO is not guaranteed to follow the output words:
+// the DMA playback is disabled by default, until it is validated on the hardware. When it is disabled, the SPIDMA module
+// (and its two SPIDMA_MAXWORDS buffers) and the DMA paths of the SPI and DMM modules are not built.
+#ifndef SPIDMA_ENABLE
+#define SPIDMA_ENABLE           0
+#endif
+
+#define SPIDMA_BEAT_NS          100     // approximate duration of one DMA write to the AXI GPIO data register (ns)
+#define SPIDMA_WORDS_PER_PHASE  16      // number of GPIO words (DMA beats) of one clock phase
+#define SPIDMA_WORDS_PER_CSTICK (SPI_ASYNC_TICKUS * 1000 / SPIDMA_BEAT_NS)    // number of GPIO words of one chip select setup / hold tick
+#define SPIDMA_MAXBYTES         32      // maximum number of data bytes of a transaction
+#define SPIDMA_MAXCSTICKS       16      // maximum chip select setup / hold ticks of a transaction
+#define SPIDMA_MAXWORDS         (2 * SPIDMA_MAXCSTICKS * SPIDMA_WORDS_PER_CSTICK + \
+                                 2 * (16 + 1 + 8 * SPIDMA_MAXBYTES) * SPIDMA_WORDS_PER_PHASE + 1)
+
+#if !SPIDMA_HOST
+#include "xparameters.h"
+#define SPIDMA_DEVICE_ID        XPAR_XDMAPS_1_DEVICE_ID
+#define SPIDMA_DONE_INTR_OUT    XPAR_XDMAPS_0_DONE_INTR_0
+#define SPIDMA_DONE_INTR_IN     XPAR_XDMAPS_0_DONE_INTR_1
+#define SPIDMA_FAULT_INTR       XPAR_XDMAPS_0_FAULT_INTR
+#define SPIDMA_CHANNEL_OUT      0       // plays the GPIO words to the output data register
+#define SPIDMA_CHANNEL_IN       1       // captures the input data register (MISO)
+#define SPIDMA_GPIO_OUT_ADDR    (XPAR_GPIO_0_BASEADDR + 0x0)    // AXI GPIO channel 1 data register
+#define SPIDMA_GPIO_IN_ADDR     (XPAR_GPIO_0_BASEADDR + 0x8)    // AXI GPIO channel 2 data register
+#endif
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Data Types
+// *****************************************************************************
+// *****************************************************************************
+typedef void (*SPIDMA_DONEFN)(SPI_XFER *pXfer);
+
+#if SPIDMA_HOST
+// pin model of the host stand-in: receives each output word, returns the input data register value (MISO)
+typedef uint32_t (*SPIDMA_HOSTPINFN)(uint32_t dwOut);
+#endif
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Interface Functions
+// *****************************************************************************
+// *****************************************************************************
+uint8_t SPIDMA_Init();
+int SPIDMA_Compile(SPI_XFER *pXfer, uint32_t dwBase, uint32_t *pwWave, int cwMax);
+void SPIDMA_Decode(SPI_XFER *pXfer, const uint32_t *pwCapture);
+uint8_t SPIDMA_Start(SPI_XFER *pXfer, uint32_t dwBase, SPIDMA_DONEFN pfnDone);
+#if SPIDMA_HOST
+void SPIDMA_HostSetPins(SPIDMA_HOSTPINFN pfnPins);
+#endif
+
+#endif /* _SPIDMA_H */
+
+/* *****************************************************************************
+ End of File
+ */
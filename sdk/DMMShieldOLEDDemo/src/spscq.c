@@ -0,0 +1,162 @@
+/* ************************************************************************** */
+/** Descriptive File Name
+
+  @Company
+    Digilent
+
+  @File Name
+    spscq.c
+
+  @Description
+        This file groups the functions that implement the SPSCQ module.
+        The module implements a lock free single producer single consumer queue of acquired values.
+        It is used to pass the values acquired on one core to the other core, through a queue placed in shared memory.
+        The producer only writes the head index and the consumer only writes the tail index, so no lock is needed.
+        A memory barrier orders the item accesses and the index updates, the shared memory must be non cacheable
+        or coherent for both cores.
+        Only one core (or thread) may call SPSCQ_Push, and only one core (or thread) may call SPSCQ_Pop and SPSCQ_Flush.
+        The module does not depend on other modules, define SPSCQ_HOST to build it on a host computer.
+
+ */
+/* ************************************************************************** */
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Included Files                                                    */
+/* ************************************************************************** */
+#include "stdint.h"
+#include "spscq.h"
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+// Section: Interface Functions                                               */
+/* ************************************************************************** */
+/* ************************************************************************** */
+
+/***	SPSCQ_Init
+**
+**	Parameters:
+**		SPSCQ *pQueue       - the queue
+**
+**	Return Value:
+**		none
+**
+**	Description:
+**		This function initializes the queue as empty.
+**      It must be called before any of the producer or consumer starts using the queue.
+**            
+*/
+void SPSCQ_Init(SPSCQ *pQueue)
+{
+    pQueue->dwHead = 0;
+    pQueue->dwTail = 0;
+    SPSCQ_Barrier();
+}
+
+/***	SPSCQ_Push
+**
+**	Parameters:
+**		SPSCQ *pQueue               - the queue
+**      const SPSCQ_SAMPLE *pSample - the item to be added
+**
+**	Return Value:
+**		1 if the item was added.
+**		0 if the queue is full, the item is not added.
+**
+**	Description:
+**		This function adds an item in the queue. It is called by the producer.
+**      The item is copied before the head index is published, so the consumer never sees a partially written item.
+**      The function never waits.
+**            
+*/
+uint8_t SPSCQ_Push(SPSCQ *pQueue, const SPSCQ_SAMPLE *pSample)
+{
+    uint32_t dwHead = pQueue->dwHead;
+    if(dwHead - pQueue->dwTail >= SPSCQ_SIZE)
+    {
+        // full
+        return 0;
+    }
+    // the tail must be read before the slot is overwritten
+    SPSCQ_Barrier();
+    pQueue->rgItems[dwHead & (SPSCQ_SIZE - 1)] = *pSample;
+    // the item must be written before the head is published
+    SPSCQ_Barrier();
+    pQueue->dwHead = dwHead + 1;
+    return 1;
+}
+
+/***	SPSCQ_Pop
+**
+**	Parameters:
+**		SPSCQ *pQueue           - the queue
+**      SPSCQ_SAMPLE *pSample   - pointer to a variable to get the item
+**
+**	Return Value:
+**		1 if an item was extracted.
+**		0 if the queue is empty.
+**
+**	Description:
+**		This function extracts the oldest item from the queue. It is called by the consumer.
+**      The slot is released to the producer only after the item was copied.
+**      The function never waits.
+**            
+*/
+uint8_t SPSCQ_Pop(SPSCQ *pQueue, SPSCQ_SAMPLE *pSample)
+{
+    uint32_t dwTail = pQueue->dwTail;
+    if(pQueue->dwHead == dwTail)
+    {
+        // empty
+        return 0;
+    }
+    // the head must be read before the item
+    SPSCQ_Barrier();
+    *pSample = pQueue->rgItems[dwTail & (SPSCQ_SIZE - 1)];
+    // the item must be read before the slot is released
+    SPSCQ_Barrier();
+    pQueue->dwTail = dwTail + 1;
+    return 1;
+}
+
+/***	SPSCQ_Count
+**
+**	Parameters:
+**		SPSCQ *pQueue       - the queue
+**
+**	Return Value:
+**		uint32_t
+**          the number of items in the queue
+**
+**	Description:
+**		This function returns the number of items in the queue.
+**      When called concurrently with the other side, the value may already be outdated when it's returned.
+**            
+*/
+uint32_t SPSCQ_Count(SPSCQ *pQueue)
+{
+    return pQueue->dwHead - pQueue->dwTail;
+}
+
+/***	SPSCQ_Flush
+**
+**	Parameters:
+**		SPSCQ *pQueue       - the queue
+**
+**	Return Value:
+**		none
+**
+**	Description:
+**		This function discards all the items in the queue. It is called by the consumer.
+**            
+*/
+void SPSCQ_Flush(SPSCQ *pQueue)
+{
+    uint32_t dwHead = pQueue->dwHead;
+    SPSCQ_Barrier();
+    pQueue->dwTail = dwHead;
+}
+
+/* *****************************************************************************
+ End of File
+ */
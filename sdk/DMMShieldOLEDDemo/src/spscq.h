@@ -0,0 +1,79 @@
+/* ************************************************************************** */
+/** Descriptive File Name
+
+  @Company
+ Digilent
+
+  @File Name
+    spscq.h
+
+  @Description
+        This file contains the declarations for the SPSCQ module functions.
+        The SPSCQ functions are defined in spscq.c source file.
+
+ */
+/* ************************************************************************** */
+
+#ifndef _SPSCQ_H    /* Guard against multiple inclusion */
+#define _SPSCQ_H
+
+#include "stdint.h"
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Constants                                                         */
+/* ************************************************************************** */
+#define SPSCQ_SIZE          256     // number of queue items, must be a power of 2
+#define SPSCQ_CACHELINE     32      // Cortex-A9 cache line size, used to keep the producer and consumer indexes apart
+
+// Memory barrier between the data accesses and the index update.
+// Define SPSCQ_HOST to build the module on a host computer (for example with threads).
+#ifdef SPSCQ_HOST
+#define SPSCQ_Barrier()     __sync_synchronize()
+#else
+#define SPSCQ_Barrier()     __asm__ __volatile__("dmb" : : : "memory")
+#endif
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Data Types
+// *****************************************************************************
+// *****************************************************************************
+
+// one acquired value
+typedef struct _SPSCQ_SAMPLE{
+    double dVal;            // the value returned by DMM_DGetValue
+    uint32_t dwSeq;         // sample counter, allows the consumer to detect lost samples
+    int16_t idxScale;       // the scale used for the acquisition
+    uint8_t bErr;           // the error code returned by DMM_DGetValue
+    uint8_t fRaw;           // 1 if the calibration was not applied
+    float fPeakMin;         // the peak values returned by DMM_GetPeaks, NAN when the peak detection is disabled
+    float fPeakMax;
+} SPSCQ_SAMPLE;
+
+// single producer single consumer queue
+// dwHead is written only by the producer, dwTail only by the consumer. Both are free running counters.
+typedef struct _SPSCQ{
+    volatile uint32_t dwHead;
+    uint8_t rgPadHead[SPSCQ_CACHELINE - sizeof(uint32_t)];
+    volatile uint32_t dwTail;
+    uint8_t rgPadTail[SPSCQ_CACHELINE - sizeof(uint32_t)];
+    SPSCQ_SAMPLE rgItems[SPSCQ_SIZE];
+} SPSCQ;
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Interface Functions
+// *****************************************************************************
+// *****************************************************************************
+void SPSCQ_Init(SPSCQ *pQueue);
+uint8_t SPSCQ_Push(SPSCQ *pQueue, const SPSCQ_SAMPLE *pSample);
+uint8_t SPSCQ_Pop(SPSCQ *pQueue, SPSCQ_SAMPLE *pSample);
+uint32_t SPSCQ_Count(SPSCQ *pQueue);
+void SPSCQ_Flush(SPSCQ *pQueue);
+
+#endif /* _SPSCQ_H */
+
+/* *****************************************************************************
+ End of File
+ */
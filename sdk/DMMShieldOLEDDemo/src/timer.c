@@ -0,0 +1,288 @@
+/* ************************************************************************** */
+/** Descriptive File Name
+
+  @Company
+    Digilent
+
+  @File Name
+    timer.c
+
+  @Description
+        This file groups the functions that implement the TIMER module.
+        The module uses the Cortex-A9 private timer (SCU timer) to generate a TIMER_TICK_MS periodic interrupt,
+        which maintains the milliseconds counter used by the SCHED module for wakeups and deadlines.
+        The timer interrupt is connected to the interrupt controller initialized by the UART module,
+        so TIMER_Init must be called after UART_Init.
+        The module also provides a fast tick of a few microseconds, generated by the private watchdog used in timer mode.
+        The fast tick calls a function from the interrupt context and runs only between TIMER_StartFastTick and
+        TIMER_StopFastTick, so that it loads the processor only while its user (the asynchronous SPI engine) has work.
+        The module uses errors defined in the ERRORS module.
+
+ */
+/* ************************************************************************** */
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Included Files                                                    */
+/* ************************************************************************** */
+#include "stdint.h"
+#include "xscutimer.h"
+#include "xscuwdt.h"
+#include "xscugic.h"
+#include "timer.h"
+#include "errors.h"
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+// Section: Local functions prototypes                                        */
+/* ************************************************************************** */
+/* ************************************************************************** */
+void TIMER_Handler(void *CallBackRef);
+void TIMER_FastHandler(void *CallBackRef);
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Global Variables                                                  */
+/* ************************************************************************** */
+/* ************************************************************************** */
+extern XScuGic InterruptController;    // defined in uart.c
+
+XScuTimer TimerInstance;    /* Instance of the private timer */
+volatile uint32_t dwTimerMs = 0;    // milliseconds since TIMER_Init
+TIMER_TICKFN pfnMsTick = 0;         // function called on each timer tick, 0 if none
+
+XScuWdt FastTimerInstance;          /* Instance of the private watchdog, used in timer mode */
+uint32_t dwFastLoadVal;             // load value of the fast tick
+TIMER_TICKFN pfnFastTick = 0;       // function called on each fast tick
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+// Section: Interface Functions                                               */
+/* ************************************************************************** */
+/* ************************************************************************** */
+
+/***	TIMER_Init
+**
+**	Parameters:
+**		none
+**
+**	Return Value:
+**		uint8_t
+**          ERRVAL_SUCCESS              0       // success
+**          ERRVAL_DMM_GENERICERROR     0xEF    // the private timer cannot be initialized
+**
+**	Description:
+**		This function initializes the private timer to generate an interrupt every TIMER_TICK_MS milliseconds,
+**      connects the interrupt handler to the interrupt controller and starts the timer.
+**      The interrupt controller must be already initialized by UART_Init.
+**
+*/
+uint8_t TIMER_Init()
+{
+    XScuTimer_Config *pConfig = XScuTimer_LookupConfig(TIMER_DEVICE_ID);
+    if(!pConfig || XScuTimer_CfgInitialize(&TimerInstance, pConfig, pConfig->BaseAddr) != XST_SUCCESS)
+    {
+        return ERRVAL_DMM_GENERICERROR;
+    }
+    if(XScuGic_Connect(&InterruptController, TIMER_INT_IRQ_ID, (Xil_ExceptionHandler)TIMER_Handler, (void *)&TimerInstance) != XST_SUCCESS)
+    {
+        return ERRVAL_DMM_GENERICERROR;
+    }
+    XScuGic_Enable(&InterruptController, TIMER_INT_IRQ_ID);
+
+    dwTimerMs = 0;
+    XScuTimer_EnableAutoReload(&TimerInstance);
+    XScuTimer_LoadTimer(&TimerInstance, TIMER_LOAD_VAL);
+    XScuTimer_EnableInterrupt(&TimerInstance);
+    XScuTimer_Start(&TimerInstance);
+    return ERRVAL_SUCCESS;
+}
+
+/***	TIMER_SetMsTick
+**
+**	Parameters:
+**		TIMER_TICKFN pfnTick    - the function called from the timer interrupt every TIMER_TICK_MS milliseconds, 0 to remove it
+**
+**	Return Value:
+**		none
+**
+**	Description:
+**		This function sets the function called on each timer tick, after the milliseconds counter is incremented.
+**      The function runs in an interrupt context, so it must be short and must not wait.
+**
+*/
+void TIMER_SetMsTick(TIMER_TICKFN pfnTick)
+{
+    pfnMsTick = pfnTick;
+}
+
+/***	TIMER_GetMs
+**
+**	Parameters:
+**		none
+**
+**	Return Value:
+**		uint32_t    - the number of milliseconds since TIMER_Init (wraps around after about 49 days)
+**
+**	Description:
+**		This function returns the milliseconds counter maintained by the timer interrupt.
+**
+*/
+uint32_t TIMER_GetMs()
+{
+    return dwTimerMs;
+}
+
+/***	TIMER_GetUs
+**
+**	Parameters:
+**		none
+**
+**	Return Value:
+**		uint32_t    - the number of microseconds since TIMER_Init (wraps around after about 71 minutes)
+**
+**	Description:
+**		This function returns the time since TIMER_Init with microseconds resolution,
+**      combining the milliseconds counter with the current value of the private timer counter.
+**      It is used to measure the run time of the scheduler tasks.
+**
+*/
+uint32_t TIMER_GetUs()
+{
+    uint32_t dwMs, dwCnt;
+    // read again if the timer interrupt occurred between the two reads
+    do
+    {
+        dwMs = dwTimerMs;
+        dwCnt = XScuTimer_GetCounterValue(&TimerInstance);
+    } while(dwMs != dwTimerMs);
+    // the counter decrements from TIMER_LOAD_VAL to 0
+    return dwMs * 1000 + (TIMER_LOAD_VAL - dwCnt) / (TIMER_CLK_HZ / 1000000);
+}
+
+/***	TIMER_InitFastTick
+**
+**	Parameters:
+**		uint32_t dwPeriodUs     - the fast tick period (us)
+**		TIMER_TICKFN pfnTick    - the function called on each fast tick, from the interrupt context
+**
+**	Return Value:
+**		uint8_t
+**          ERRVAL_SUCCESS              0       // success
+**          ERRVAL_DMM_GENERICERROR     0xEF    // the private watchdog cannot be initialized
+**
+**	Description:
+**		This function initializes the private watchdog in timer mode, with auto reload and interrupt,
+**      and connects its interrupt handler to the interrupt controller. The fast tick is not started.
+**      The interrupt controller must be already initialized by UART_Init.
+**
+*/
+uint8_t TIMER_InitFastTick(uint32_t dwPeriodUs, TIMER_TICKFN pfnTick)
+{
+    XScuWdt_Config *pConfig = XScuWdt_LookupConfig(TIMER_FAST_DEVICE_ID);
+    if(!pConfig || !pfnTick || !dwPeriodUs || XScuWdt_CfgInitialize(&FastTimerInstance, pConfig, pConfig->BaseAddr) != XST_SUCCESS)
+    {
+        return ERRVAL_DMM_GENERICERROR;
+    }
+    XScuWdt_Stop(&FastTimerInstance);
+    XScuWdt_SetTimerMode(&FastTimerInstance);
+    if(XScuGic_Connect(&InterruptController, TIMER_FAST_INT_IRQ_ID, (Xil_ExceptionHandler)TIMER_FastHandler, (void *)&FastTimerInstance) != XST_SUCCESS)
+    {
+        return ERRVAL_DMM_GENERICERROR;
+    }
+    XScuGic_Enable(&InterruptController, TIMER_FAST_INT_IRQ_ID);
+
+    pfnFastTick = pfnTick;
+    dwFastLoadVal = (TIMER_CLK_HZ / 1000000) * dwPeriodUs - 1;
+    XScuWdt_SetControlReg(&FastTimerInstance, XScuWdt_GetControlReg(&FastTimerInstance) |
+            XSCUWDT_CONTROL_AUTO_RELOAD_MASK | XSCUWDT_CONTROL_IT_ENABLE_MASK);
+    return ERRVAL_SUCCESS;
+}
+
+/***	TIMER_StartFastTick
+**
+**	Parameters:
+**		none
+**
+**	Return Value:
+**		none
+**
+**	Description:
+**		This function starts the fast tick. The first tick occurs one period later.
+**      It can be called from an interrupt context.
+**
+*/
+void TIMER_StartFastTick()
+{
+    XScuWdt_LoadWdt(&FastTimerInstance, dwFastLoadVal);
+    XScuWdt_Start(&FastTimerInstance);
+}
+
+/***	TIMER_StopFastTick
+**
+**	Parameters:
+**		none
+**
+**	Return Value:
+**		none
+**
+**	Description:
+**		This function stops the fast tick. It is normally called by the tick function itself, when it has no more work.
+**
+*/
+void TIMER_StopFastTick()
+{
+    XScuWdt_Stop(&FastTimerInstance);
+}
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+// Section: Local Functions                                                   */
+/* ************************************************************************** */
+/* ************************************************************************** */
+
+/***	TIMER_Handler
+**
+**	Parameters:
+**		void *CallBackRef   - pointer to the private timer instance
+**
+**	Return Value:
+**		none
+**
+**	Description:
+**		This function is the private timer interrupt handler. It is called from an interrupt context.
+**      It clears the interrupt, increments the milliseconds counter and calls the tick function set by TIMER_SetMsTick.
+**
+*/
+void TIMER_Handler(void *CallBackRef)
+{
+    XScuTimer_ClearInterruptStatus((XScuTimer *)CallBackRef);
+    dwTimerMs += TIMER_TICK_MS;
+    if(pfnMsTick)
+    {
+        pfnMsTick();
+    }
+}
+
+/***	TIMER_FastHandler
+**
+**	Parameters:
+**		void *CallBackRef   - pointer to the private watchdog instance
+**
+**	Return Value:
+**		none
+**
+**	Description:
+**		This function is the private watchdog (timer mode) interrupt handler. It is called from an interrupt context.
+**      It clears the interrupt and calls the fast tick function.
+**
+*/
+void TIMER_FastHandler(void *CallBackRef)
+{
+    XScuWdt_WriteReg(((XScuWdt *)CallBackRef)->Config.BaseAddr, XSCUWDT_ISR_OFFSET, XSCUWDT_ISR_EVENT_FLAG_MASK);
+    pfnFastTick();
+}
+
+/* *****************************************************************************
+ End of File
+ */
@@ -0,0 +1,61 @@
+/* ************************************************************************** */
+/** Descriptive File Name
+
+  @Company
+ Digilent
+
+  @File Name
+    timer.h
+
+  @Description
+        This file contains the declarations for the TIMER module functions.
+        The TIMER functions are defined in timer.c source file.
+
+ */
+/* ************************************************************************** */
+
+#ifndef _TIMER_H    /* Guard against multiple inclusion */
+#define _TIMER_H
+
+#include "stdint.h"
+#include "xparameters.h"
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Constants                                                         */
+/* ************************************************************************** */
+#define TIMER_DEVICE_ID         XPAR_XSCUTIMER_0_DEVICE_ID
+#define TIMER_INT_IRQ_ID        XPAR_SCUTIMER_INTR
+#define TIMER_CLK_HZ            (XPAR_PS7_CORTEXA9_0_CPU_CLK_FREQ_HZ / 2)  // the private timer runs at half the CPU clock
+#define TIMER_TICK_MS           1                                           // period of the timer interrupt (ms)
+#define TIMER_LOAD_VAL          (TIMER_CLK_HZ / 1000 * TIMER_TICK_MS - 1)
+
+// fast tick, generated by the private watchdog used in timer mode (same clock as the private timer)
+#define TIMER_FAST_DEVICE_ID    XPAR_XSCUWDT_0_DEVICE_ID
+#define TIMER_FAST_INT_IRQ_ID   XPAR_SCUWDT_INTR
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Data Types
+// *****************************************************************************
+// *****************************************************************************
+typedef void (*TIMER_TICKFN)();
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Interface Functions
+// *****************************************************************************
+// *****************************************************************************
+uint8_t TIMER_Init();
+void TIMER_SetMsTick(TIMER_TICKFN pfnTick);
+uint32_t TIMER_GetMs();
+uint32_t TIMER_GetUs();
+uint8_t TIMER_InitFastTick(uint32_t dwPeriodUs, TIMER_TICKFN pfnTick);
+void TIMER_StartFastTick();
+void TIMER_StopFastTick();
+
+#endif /* _TIMER_H */
+
+/* *****************************************************************************
+ End of File
+ */
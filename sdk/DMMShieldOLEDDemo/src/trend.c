@@ -0,0 +1,340 @@
+/* ************************************************************************** */
+/** Descriptive File Name
+
+  @Company
+    Digilent
+
+  @File Name
+    trend.c
+
+  @Description
+        This file groups the functions that implement the TREND module, the trend graph of the PmodOLED.
+        The module keeps the last TREND_SAMPLES readings of the current scale and plots them as a sparkline,
+        one column per reading, the newest reading in the last column. The vertical axis is scaled automatically.
+        When readings were added since the previous drawing and the vertical axis did not change, the graph is
+        scrolled by the number of new readings and only the new columns are drawn: a single new reading is scrolled
+        by the display controller (OLEDDISP_ScrollLeft), several readings are scrolled in the frame buffer.
+        Otherwise (vertical axis changed, a whole graph of new readings) the whole graph is redrawn in the frame buffer.
+        The display layer sends the changed columns.
+
+ */
+/* ************************************************************************** */
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Included Files                                                    */
+/* ************************************************************************** */
+#include <string.h>
+#include <math.h>
+#include "stdint.h"
+#include "oleddisp.h"
+#include "trend.h"
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+// Section: Local functions prototypes                                        */
+/* ************************************************************************** */
+/* ************************************************************************** */
+uint8_t TREND_UpdateRange();
+double TREND_GetSample(int idxAge);
+void TREND_DrawColumn(uint8_t *pbFrame, int idxPage, int cPages, int x, double dVal, double dPrev);
+int TREND_GetY(double dVal, int cPages);
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Global Variables                                                  */
+/* ************************************************************************** */
+/* ************************************************************************** */
+// circular buffer of readings, NAN for the readings out of range; it also keeps the reading before the oldest plotted one,
+// to which the first column is connected
+static double rgdSamples[TREND_SAMPLES + 1];
+static int idxNewest = TREND_SAMPLES;       // position of the newest reading
+static int cSamples = 0;                    // number of readings in the buffer
+static int idxTrendScale = -1;              // scale of the readings
+static int cNewSamples = 0;                 // number of readings added since the previous drawing
+
+// vertical axis
+static uint8_t fRangeValid = 0;
+static double dRangeLo, dRangeHi;
+
+// drawn graph
+static uint8_t fDrawn = 0;
+static int idxPageDrawn, cPagesDrawn;
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+// Section: Interface Functions                                               */
+/* ************************************************************************** */
+/* ************************************************************************** */
+
+/***	TREND_Reset
+**
+**	Parameters:
+**		none
+**
+**	Return Value:
+**		none
+**
+**	Description:
+**		This function removes all the readings. The next drawing clears the graph.
+**
+*/
+void TREND_Reset()
+{
+    cSamples = 0;
+    cNewSamples = 0;
+    fRangeValid = 0;
+    fDrawn = 0;
+}
+
+/***	TREND_AddSample
+**
+**	Parameters:
+**		double dVal     - the reading, in the base unit
+**		int idxScale    - the scale of the reading
+**
+**	Return Value:
+**		none
+**
+**	Description:
+**		This function adds a reading to the trend. If the scale is not the scale of the previous readings, they are removed first.
+**      A reading out of range (infinite) is kept as a gap of the graph.
+**
+*/
+void TREND_AddSample(double dVal, int idxScale)
+{
+    if(idxScale != idxTrendScale)
+    {
+        TREND_Reset();
+        idxTrendScale = idxScale;
+    }
+    idxNewest = (idxNewest + 1) % (TREND_SAMPLES + 1);
+    rgdSamples[idxNewest] = isinf(dVal) ? NAN : dVal;
+    if(cSamples < TREND_SAMPLES + 1)
+    {
+        cSamples++;
+    }
+    cNewSamples++;
+}
+
+/***	TREND_Draw
+**
+**	Parameters:
+**		uint8_t *pbFrame    - the PmodOLED driver frame buffer
+**		int idxPage         - the first page of the graph
+**		int cPages          - the number of pages of the graph
+**
+**	Return Value:
+**		int     - the number of new columns drawn after scrolling the graph, 0 if the whole graph was drawn, -1 if nothing changed
+**
+**	Description:
+**		This function draws the trend graph in the frame buffer, the newest reading in the last column.
+**      If fewer than TREND_SAMPLES readings were added since the previous drawing and the vertical axis is unchanged,
+**      the graph is scrolled by the number of new readings and only their columns are drawn:
+**      - one new reading: it requests the one column scroll of the graph pages and draws the new reading in the first column,
+**        which the next flush moves to the last column.
+**      - several new readings, or the scroll is refused: it moves the columns of the graph pages left in the frame buffer
+**        and draws the new readings in the last columns.
+**      Otherwise (vertical axis changed, TREND_SAMPLES or more new readings) it redraws all the columns.
+**      The frame buffer must be flushed after each call.
+**
+*/
+int TREND_Draw(uint8_t *pbFrame, int idxPage, int cPages)
+{
+    int idxAge, y;
+    uint8_t fRangeChanged;
+    uint8_t *pbPage;
+    if(fDrawn && idxPage == idxPageDrawn && cPages == cPagesDrawn && !cNewSamples)
+    {
+        return -1;
+    }
+    fRangeChanged = TREND_UpdateRange();
+    if(fDrawn && idxPage == idxPageDrawn && cPages == cPagesDrawn && cNewSamples < TREND_SAMPLES && !fRangeChanged)
+    {
+        if(cNewSamples == 1 && OLEDDISP_ScrollLeft(idxPage, idxPage + cPages - 1))
+        {
+            TREND_DrawColumn(pbFrame, idxPage, cPages, 0, TREND_GetSample(0), TREND_GetSample(1));
+        }
+        else
+        {
+            for(y = 0; y < cPages; y++)
+            {
+                pbPage = pbFrame + (idxPage + y) * ccolOledMax;
+                memmove(pbPage, pbPage + cNewSamples, TREND_SAMPLES - cNewSamples);
+            }
+            for(idxAge = 0; idxAge < cNewSamples; idxAge++)
+            {
+                TREND_DrawColumn(pbFrame, idxPage, cPages, TREND_SAMPLES - 1 - idxAge, TREND_GetSample(idxAge), TREND_GetSample(idxAge + 1));
+            }
+        }
+        idxAge = cNewSamples;
+        cNewSamples = 0;
+        return idxAge;
+    }
+    for(idxAge = 0; idxAge < TREND_SAMPLES; idxAge++)
+    {
+        TREND_DrawColumn(pbFrame, idxPage, cPages, TREND_SAMPLES - 1 - idxAge, TREND_GetSample(idxAge), TREND_GetSample(idxAge + 1));
+    }
+    fDrawn = 1;
+    idxPageDrawn = idxPage;
+    cPagesDrawn = cPages;
+    cNewSamples = 0;
+    return 0;
+}
+
+/***	TREND_Invalidate
+**
+**	Parameters:
+**		none
+**
+**	Return Value:
+**		none
+**
+**	Description:
+**		This function requests the redrawing of the whole graph by the next TREND_Draw.
+**      It must be called when the graph pages of the frame buffer are changed by other functions.
+**
+*/
+void TREND_Invalidate()
+{
+    fDrawn = 0;
+}
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+// Section: Local Functions                                                   */
+/* ************************************************************************** */
+/* ************************************************************************** */
+
+/***	TREND_UpdateRange
+**
+**	Parameters:
+**		none
+**
+**	Return Value:
+**		uint8_t     - 1 if the vertical axis changed, 0 otherwise
+**
+**	Description:
+**		This function scales the vertical axis. The axis is kept while it contains all the readings and their range
+**      is not TREND_SHRINK times smaller than the axis, so that most new readings do not require redrawing the graph.
+**      Otherwise the axis is set to the readings range, extended by TREND_MARGIN on both sides.
+**
+*/
+uint8_t TREND_UpdateRange()
+{
+    int idxAge;
+    double dVal, dMin = INFINITY, dMax = -INFINITY, dMargin;
+    for(idxAge = 0; idxAge < cSamples && idxAge < TREND_SAMPLES; idxAge++)
+    {
+        dVal = TREND_GetSample(idxAge);
+        if(!isnan(dVal))
+        {
+            dMin = (dVal < dMin) ? dVal : dMin;
+            dMax = (dVal > dMax) ? dVal : dMax;
+        }
+    }
+    if(dMin > dMax)
+    {
+        // no reading in range
+        return 0;
+    }
+    if(fRangeValid && dMin >= dRangeLo && dMax <= dRangeHi && (dMax - dMin) * TREND_SHRINK >= (dRangeHi - dRangeLo))
+    {
+        return 0;
+    }
+    dMargin = (dMax - dMin) * TREND_MARGIN;
+    if(dMargin <= 0)
+    {
+        // constant readings, plotted in the middle
+        dMargin = (dMax != 0) ? fabs(dMax) * TREND_MARGIN : 1e-9;
+    }
+    dRangeLo = dMin - dMargin;
+    dRangeHi = dMax + dMargin;
+    fRangeValid = 1;
+    return 1;
+}
+
+/***	TREND_GetSample
+**
+**	Parameters:
+**		int idxAge      - the age of the reading: 0 for the newest reading, 1 for the previous one, ...
+**
+**	Return Value:
+**		double  - the reading, NAN if there is no such reading or it is out of range
+**
+**	Description:
+**		This function returns a reading from the circular buffer.
+**
+*/
+double TREND_GetSample(int idxAge)
+{
+    if(idxAge >= cSamples)
+    {
+        return NAN;
+    }
+    return rgdSamples[(idxNewest - idxAge + TREND_SAMPLES + 1) % (TREND_SAMPLES + 1)];
+}
+
+/***	TREND_DrawColumn
+**
+**	Parameters:
+**		uint8_t *pbFrame    - the frame buffer
+**		int idxPage         - the first page of the graph
+**		int cPages          - the number of pages of the graph
+**		int x               - the column
+**		double dVal         - the reading plotted in the column
+**		double dPrev        - the previous reading
+**
+**	Return Value:
+**		none
+**
+**	Description:
+**		This function draws one column of the sparkline: a vertical segment from the previous reading to the reading,
+**      so that consecutive readings are connected. The column is left empty for a missing reading.
+**
+*/
+void TREND_DrawColumn(uint8_t *pbFrame, int idxPage, int cPages, int x, double dVal, double dPrev)
+{
+    int y, yPrev, yTop, yBottom;
+    for(y = 0; y < cPages; y++)
+    {
+        pbFrame[(idxPage + y) * ccolOledMax + x] = 0;
+    }
+    if(isnan(dVal) || !fRangeValid)
+    {
+        return;
+    }
+    y = TREND_GetY(dVal, cPages);
+    yPrev = isnan(dPrev) ? y : TREND_GetY(dPrev, cPages);
+    yTop = (y < yPrev) ? y : yPrev;
+    yBottom = (y < yPrev) ? yPrev : y;
+    for(y = yTop; y <= yBottom; y++)
+    {
+        pbFrame[(idxPage + y / 8) * ccolOledMax + x] |= 1 << (y % 8);
+    }
+}
+
+/***	TREND_GetY
+**
+**	Parameters:
+**		double dVal     - the reading
+**		int cPages      - the number of pages of the graph
+**
+**	Return Value:
+**		int     - the pixel row of the reading in the graph, 0 for the top row
+**
+**	Description:
+**		This function converts a reading to a pixel row, according to the vertical axis.
+**
+*/
+int TREND_GetY(double dVal, int cPages)
+{
+    int cRows = cPages * 8;
+    int y = (int)lround((dVal - dRangeLo) / (dRangeHi - dRangeLo) * (cRows - 1));
+    y = (y < 0) ? 0 : ((y >= cRows) ? cRows - 1 : y);
+    return cRows - 1 - y;
+}
+
+/* *****************************************************************************
+ End of File
+ */
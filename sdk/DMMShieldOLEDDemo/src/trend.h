@@ -0,0 +1,45 @@
+/* ************************************************************************** */
+/** Descriptive File Name
+
+  @Company
+ Digilent
+
+  @File Name
+    trend.h
+
+  @Description
+        This file contains the declarations for the TREND module functions.
+        The TREND functions are defined in trend.c source file.
+
+ */
+/* ************************************************************************** */
+
+#ifndef _TREND_H    /* Guard against multiple inclusion */
+#define _TREND_H
+
+#include "stdint.h"
+#include "PmodOLED.h"
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Constants                                                         */
+/* ************************************************************************** */
+#define TREND_SAMPLES           ccolOledMax     // number of readings plotted, one per column
+#define TREND_MARGIN            0.1             // margin added above and below the readings range, relative to the range
+#define TREND_SHRINK            4               // the vertical axis is recomputed when the readings range is this times smaller
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Interface Functions
+// *****************************************************************************
+// *****************************************************************************
+void TREND_Reset();
+void TREND_AddSample(double dVal, int idxScale);
+int TREND_Draw(uint8_t *pbFrame, int idxPage, int cPages);
+void TREND_Invalidate();
+
+#endif /* _TREND_H */
+
+/* *****************************************************************************
+ End of File
+ */
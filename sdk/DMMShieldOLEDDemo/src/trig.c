@@ -0,0 +1,343 @@
+/* ************************************************************************** */
+/** Descriptive File Name
+
+  @Company
+    Digilent
+
+  @File Name
+    trig.c
+
+  @Description
+        This file groups the functions that implement the TRIG module, the trigger engine of the repeated acquisition.
+        The acquired values are passed one by one to TRIG_AddSample, which keeps the last TRIG_MAXSAMPLES values
+        in a ring buffer and checks the trigger condition: level, rising or falling edge, window or overload.
+        When the condition is met, the values before the trigger (pre-trigger) are already in the ring buffer,
+        and the engine acquires the post-trigger values. The capture is then frozen until it is reported and the engine is rearmed,
+        so the host only receives the values around the events instead of the complete stream.
+        After arming, no trigger is accepted until the pre-trigger values and the holdoff values are acquired.
+        The trigger is evaluated for each value, the engine never waits and does not access the hardware.
+        The module uses errors defined in the ERRORS module.
+
+ */
+/* ************************************************************************** */
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Included Files                                                    */
+/* ************************************************************************** */
+#include <math.h>
+#include "stdint.h"
+#include "trig.h"
+#include "errors.h"
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+// Section: Local functions prototypes                                        */
+/* ************************************************************************** */
+/* ************************************************************************** */
+uint8_t TRIG_CheckCondition(double dVal);
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Global Variables                                                  */
+/* ************************************************************************** */
+/* ************************************************************************** */
+static TRIG_CFG trigCfg = {TRIG_TYPE_RISING, 0, 0, 16, 48, 0};
+
+static double rgdRing[TRIG_MAXSAMPLES];     // ring buffer of the last acquired values
+static int idxNext = 0;                     // position of the next value in the ring buffer
+static int idxCaptureStart;                 // position of the first captured value (the oldest pre-trigger value)
+static int cAcquired;                       // number of values acquired since the engine was (re)armed, saturated
+static int cPostLeft;                       // number of post-trigger values still to be acquired
+static double dPrev = NAN;                  // previous value, used by the edge triggers
+static int idxTrigScale = -1;               // scale of the values in the ring buffer
+static uint8_t bState = TRIG_STATE_IDLE;
+static uint32_t cntTriggers = 0;            // number of captures since TRIG_Arm
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+// Section: Interface Functions                                               */
+/* ************************************************************************** */
+/* ************************************************************************** */
+
+/***	TRIG_SetConfig
+**
+**	Parameters:
+**		const TRIG_CFG *pCfg    - the trigger configuration
+**
+**	Return Value:
+**		uint8_t
+**          ERRVAL_SUCCESS                  0       // success
+**          ERRVAL_TRIG_CONFIG              0xE5    // wrong trigger configuration
+**
+**	Description:
+**		This function checks and sets the trigger configuration. The pre-trigger and post-trigger values must fit
+**      in the ring buffer (TRIG_MAXSAMPLES), at least one post-trigger value (the trigger value) is captured,
+**      and the window low level must be below its high level.
+**      The engine is disarmed, it must be armed again by TRIG_Arm.
+**
+*/
+uint8_t TRIG_SetConfig(const TRIG_CFG *pCfg)
+{
+    if(pCfg->bType > TRIG_TYPE_OVERLOAD || pCfg->cPre < 0 || pCfg->cPost < 1 || pCfg->cPre + pCfg->cPost > TRIG_MAXSAMPLES ||
+        pCfg->cHoldoff < 0 || isnan(pCfg->dLevel) || (pCfg->bType == TRIG_TYPE_WINDOW && !(pCfg->dLevel < pCfg->dLevelHi)))
+    {
+        return ERRVAL_TRIG_CONFIG;
+    }
+    trigCfg = *pCfg;
+    TRIG_Disarm();
+    return ERRVAL_SUCCESS;
+}
+
+/***	TRIG_GetConfig
+**
+**	Parameters:
+**		none
+**
+**	Return Value:
+**		const TRIG_CFG *    - the current trigger configuration
+**
+**	Description:
+**		This function returns the trigger configuration set by TRIG_SetConfig.
+**
+*/
+const TRIG_CFG *TRIG_GetConfig()
+{
+    return &trigCfg;
+}
+
+/***	TRIG_Arm
+**
+**	Parameters:
+**		none
+**
+**	Return Value:
+**		none
+**
+**	Description:
+**		This function arms the trigger engine and clears the number of captures.
+**      The trigger is accepted after the pre-trigger values and the holdoff values are acquired.
+**
+*/
+void TRIG_Arm()
+{
+    cntTriggers = 0;
+    TRIG_Rearm();
+}
+
+/***	TRIG_Rearm
+**
+**	Parameters:
+**		none
+**
+**	Return Value:
+**		none
+**
+**	Description:
+**		This function arms the trigger engine again, after the capture was reported.
+**      The values acquired while the capture was frozen were not kept, so the ring buffer is refilled:
+**      the trigger is accepted after the pre-trigger values and the holdoff values are acquired again.
+**
+*/
+void TRIG_Rearm()
+{
+    cAcquired = 0;
+    dPrev = NAN;
+    bState = (trigCfg.cPre || trigCfg.cHoldoff) ? TRIG_STATE_HOLDOFF: TRIG_STATE_ARMED;
+}
+
+/***	TRIG_Disarm
+**
+**	Parameters:
+**		none
+**
+**	Return Value:
+**		none
+**
+**	Description:
+**		This function stops the trigger engine, the values are ignored until TRIG_Arm is called.
+**
+*/
+void TRIG_Disarm()
+{
+    bState = TRIG_STATE_IDLE;
+}
+
+/***	TRIG_GetState
+**
+**	Parameters:
+**		none
+**
+**	Return Value:
+**		uint8_t     - the trigger engine state, TRIG_STATE_ value
+**
+**	Description:
+**		This function returns the state of the trigger engine.
+**
+*/
+uint8_t TRIG_GetState()
+{
+    return bState;
+}
+
+/***	TRIG_AddSample
+**
+**	Parameters:
+**		double dVal     - the acquired value, in the base unit, infinite when out of the scale range
+**		int idxScale    - the scale of the value
+**
+**	Return Value:
+**		uint8_t     - 1 if the value completed the capture, 0 otherwise
+**
+**	Description:
+**		This function passes an acquired value to the trigger engine. It is ignored when the engine is idle
+**      or the capture is complete (frozen). Otherwise it is stored in the ring buffer and:
+**      - in the holdoff state, the engine is armed when the pre-trigger values and the holdoff values are acquired.
+**      - in the armed state, the trigger condition is checked. When it is met, the capture starts cPre values before this one.
+**      - in the post-trigger state, the capture is complete when cPost values (including the trigger value) are acquired.
+**      If the scale changes, the values of the previous scale are discarded and the engine is rearmed.
+**
+*/
+uint8_t TRIG_AddSample(double dVal, int idxScale)
+{
+    int idxVal;
+    if(bState == TRIG_STATE_IDLE || bState == TRIG_STATE_DONE)
+    {
+        return 0;
+    }
+    if(idxScale != idxTrigScale)
+    {
+        idxTrigScale = idxScale;
+        TRIG_Rearm();
+    }
+    idxVal = idxNext;
+    rgdRing[idxVal] = dVal;
+    idxNext = (idxNext + 1) % TRIG_MAXSAMPLES;
+    if(cAcquired < TRIG_MAXSAMPLES)
+    {
+        cAcquired++;
+    }
+    switch(bState)
+    {
+        case TRIG_STATE_HOLDOFF:
+            if(cAcquired >= trigCfg.cPre && cAcquired >= trigCfg.cHoldoff)
+            {
+                bState = TRIG_STATE_ARMED;
+            }
+            break;
+        case TRIG_STATE_ARMED:
+            if(TRIG_CheckCondition(dVal))
+            {
+                cntTriggers++;
+                idxCaptureStart = (idxVal - trigCfg.cPre + TRIG_MAXSAMPLES) % TRIG_MAXSAMPLES;
+                cPostLeft = trigCfg.cPost - 1;
+                bState = cPostLeft ? TRIG_STATE_POST: TRIG_STATE_DONE;
+            }
+            break;
+        case TRIG_STATE_POST:
+            if(!--cPostLeft)
+            {
+                bState = TRIG_STATE_DONE;
+            }
+            break;
+    }
+    dPrev = dVal;
+    return (bState == TRIG_STATE_DONE);
+}
+
+/***	TRIG_GetCntCaptured
+**
+**	Parameters:
+**		none
+**
+**	Return Value:
+**		int     - the number of captured values, 0 if the capture is not complete
+**
+**	Description:
+**		This function returns the number of values of the complete capture: cPre + cPost.
+**      The trigger value is the value with the index cPre.
+**
+*/
+int TRIG_GetCntCaptured()
+{
+    return (bState == TRIG_STATE_DONE) ? trigCfg.cPre + trigCfg.cPost: 0;
+}
+
+/***	TRIG_GetCaptured
+**
+**	Parameters:
+**		int idx     - the index of the value in the capture, 0 for the oldest value
+**
+**	Return Value:
+**		double  - the captured value, NAN if the index is not valid
+**
+**	Description:
+**		This function returns a value of the complete capture, read from the ring buffer.
+**
+*/
+double TRIG_GetCaptured(int idx)
+{
+    if(idx < 0 || idx >= TRIG_GetCntCaptured())
+    {
+        return NAN;
+    }
+    return rgdRing[(idxCaptureStart + idx) % TRIG_MAXSAMPLES];
+}
+
+/***	TRIG_GetCntTriggers
+**
+**	Parameters:
+**		none
+**
+**	Return Value:
+**		uint32_t    - the number of triggers since TRIG_Arm
+**
+**	Description:
+**		This function returns the number of times the trigger condition was met since the engine was armed.
+**
+*/
+uint32_t TRIG_GetCntTriggers()
+{
+    return cntTriggers;
+}
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+// Section: Local Functions                                                   */
+/* ************************************************************************** */
+/* ************************************************************************** */
+
+/***	TRIG_CheckCondition
+**
+**	Parameters:
+**		double dVal     - the acquired value
+**
+**	Return Value:
+**		uint8_t     - 1 if the value meets the trigger condition
+**
+**	Description:
+**		This function checks the trigger condition for the acquired value. The edge triggers compare it with the previous value,
+**      they are never met by the first value after arming. An out of range value (infinite) is above or below all the levels.
+**
+*/
+uint8_t TRIG_CheckCondition(double dVal)
+{
+    switch(trigCfg.bType)
+    {
+        case TRIG_TYPE_LEVEL:
+            return (dVal >= trigCfg.dLevel);
+        case TRIG_TYPE_RISING:
+            return (dPrev < trigCfg.dLevel && dVal >= trigCfg.dLevel);
+        case TRIG_TYPE_FALLING:
+            return (dPrev > trigCfg.dLevel && dVal <= trigCfg.dLevel);
+        case TRIG_TYPE_WINDOW:
+            return (dVal < trigCfg.dLevel || dVal > trigCfg.dLevelHi);
+        case TRIG_TYPE_OVERLOAD:
+            return isinf(dVal) ? 1: 0;
+    }
+    return 0;
+}
+
+/* *****************************************************************************
+ End of File
+ */
@@ -0,0 +1,78 @@
+/* ************************************************************************** */
+/** Descriptive File Name
+
+  @Company
+ Digilent
+
+  @File Name
+    trig.h
+
+  @Description
+        This file contains the declarations for the TRIG module functions.
+        The TRIG functions are defined in trig.c source file.
+
+ */
+/* ************************************************************************** */
+
+#ifndef _TRIG_H    /* Guard against multiple inclusion */
+#define _TRIG_H
+
+#include "stdint.h"
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Constants                                                         */
+/* ************************************************************************** */
+#define TRIG_MAXSAMPLES         256     // size of the ring buffer: the maximum number of values of a capture (pre-trigger and post-trigger)
+
+// trigger types
+#define TRIG_TYPE_LEVEL         0       // the value is at or above the level
+#define TRIG_TYPE_RISING        1       // the value crosses the level upwards
+#define TRIG_TYPE_FALLING       2       // the value crosses the level downwards
+#define TRIG_TYPE_WINDOW        3       // the value leaves the window between the low level and the high level
+#define TRIG_TYPE_OVERLOAD      4       // the value is out of the scale range (infinite)
+
+// trigger engine states
+#define TRIG_STATE_IDLE         0       // not armed, the values are ignored
+#define TRIG_STATE_HOLDOFF      1       // armed, the pre-trigger values and the holdoff values are acquired, no trigger is accepted
+#define TRIG_STATE_ARMED        2       // waiting for the trigger condition
+#define TRIG_STATE_POST         3       // triggered, the post-trigger values are acquired
+#define TRIG_STATE_DONE         4       // the capture is complete, the values are frozen until TRIG_Rearm
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Data Types
+// *****************************************************************************
+// *****************************************************************************
+
+// trigger configuration
+typedef struct _TRIG_CFG{
+    uint8_t bType;          // TRIG_TYPE_ value
+    double dLevel;          // level of the level and edge triggers, low level of the window trigger (base unit)
+    double dLevelHi;        // high level of the window trigger (base unit)
+    int cPre;               // number of values captured before the trigger value
+    int cPost;              // number of values captured from the trigger value, at least 1
+    int cHoldoff;           // number of values acquired after arming, during which no trigger is accepted
+} TRIG_CFG;
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Interface Functions
+// *****************************************************************************
+// *****************************************************************************
+uint8_t TRIG_SetConfig(const TRIG_CFG *pCfg);
+const TRIG_CFG *TRIG_GetConfig();
+void TRIG_Arm();
+void TRIG_Rearm();
+void TRIG_Disarm();
+uint8_t TRIG_GetState();
+uint8_t TRIG_AddSample(double dVal, int idxScale);
+int TRIG_GetCntCaptured();
+double TRIG_GetCaptured(int idx);
+uint32_t TRIG_GetCntTriggers();
+
+#endif /* _TRIG_H */
+
+/* *****************************************************************************
+ End of File
+ */
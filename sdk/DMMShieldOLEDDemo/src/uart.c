@@ -48,6 +48,7 @@
 
 // global variables, to communicate between interrupt handler and other
 #define RCV_BUFFER_SIZE	100
+#define TX_BUFFER_SIZE	2048	// size of the transmit ring buffer used in asynchronous mode, power of 2
 
 /* ************************************************************************** */
 /* Section: Global Variables                                                  */
@@ -65,11 +66,24 @@ static u8 RecvBuffer[RCV_BUFFER_SIZE];	/* Buffer for Receiving Data */
 volatile int TotalReceivedCount = 0;
 volatile int TotalErrorCount;
 
+/*
+ * Transmit ring buffer, used in asynchronous mode (UART_SetTxAsync).
+ * dwTxHead and dwTxTail are free running indexes, cbTxInFlight characters starting at dwTxTail
+ * are handed to the driver, which sends them from the interrupt handler and signals fTxDone.
+ */
+static char TxBuffer[TX_BUFFER_SIZE];
+static u32 dwTxHead = 0;
+static u32 dwTxTail = 0;
+static u32 cbTxInFlight = 0;
+static volatile u8 fTxDone = 0;
+static u8 fTxAsync = 0;
+
 /* ************************************************************************** */
 // Section: Local Functions Prototypes                                        */
 /* ************************************************************************** */
 
 void UART_SendBlock(XUartPs* UartInst, char const* rgbBuffer, u32 cbRequested);
+void UART_EnqueueBlock(char const* rgbBuffer, u32 cbRequested);
 XStatus UART_ConfigureUARTPS(XUartPs *UartInstPtr, INTC *IntcInstPtr, u32 dwBaudRate);
 static int UART_SetupInterruptSystem(INTC *IntcInstancePtr,
 				XUartPs *UartInstancePtr,
@@ -120,12 +134,83 @@ u8 UART_Init(u32 dwBaudRate)
 **
 **	Description:
 **		This function transmits all the characters from a zero terminated string over UART1. The terminator character is not sent.
-**
+**		In asynchronous mode (see UART_SetTxAsync) the characters are copied in the transmit ring buffer and the function
+**		returns without waiting, the transmission is performed by UART_TxTask.
 **
 */
 void UART_PutString(char szData[])
 {
-	UART_SendBlock(&UartPs, szData, strlen(szData));
+	if(fTxAsync)
+	{
+		UART_EnqueueBlock(szData, strlen(szData));
+	}
+	else
+	{
+		UART_SendBlock(&UartPs, szData, strlen(szData));
+	}
+}
+
+/***	UART_SetTxAsync
+**
+**	Parameters:
+**		u8 fAsync	- 1 to use the transmit ring buffer, 0 to send the characters directly
+**
+**	Return Value:
+**		none
+**
+**	Description:
+**		This function selects the transmit mode of UART_PutString.
+**		When leaving the asynchronous mode, the function waits until the ring buffer is transmitted.
+**
+*/
+void UART_SetTxAsync(u8 fAsync)
+{
+	if(!fAsync)
+	{
+		while(dwTxHead != dwTxTail)
+		{
+			UART_TxTask();
+		}
+	}
+	fTxAsync = fAsync;
+}
+
+/***	UART_TxTask
+**
+**	Parameters:
+**		none
+**
+**	Return Value:
+**		none
+**
+**	Description:
+**		This function advances the asynchronous transmission, without blocking.
+**		When the driver has sent the previous block, the block is released from the ring buffer and
+**		the next contiguous block of the ring buffer is handed to the driver, which sends it from the interrupt handler.
+**		It is called periodically by the scheduler (SCHED module).
+**
+*/
+void UART_TxTask()
+{
+	u32 idxTail, cbBlock;
+	if(cbTxInFlight && fTxDone)
+	{
+		dwTxTail += cbTxInFlight;
+		cbTxInFlight = 0;
+	}
+	if(!cbTxInFlight && dwTxHead != dwTxTail)
+	{
+		idxTail = dwTxTail & (TX_BUFFER_SIZE - 1);
+		cbBlock = dwTxHead - dwTxTail;
+		if(cbBlock > TX_BUFFER_SIZE - idxTail)
+		{
+			// send up to the end of the buffer, the rest is sent with the next block
+			cbBlock = TX_BUFFER_SIZE - idxTail;
+		}
+		cbTxInFlight = cbBlock;
+		fTxDone = 0;
+		XUartPs_Send(&UartPs, (u8*)&TxBuffer[idxTail], cbBlock);
+	}
 }
 
 /***	UART_GetString
@@ -296,6 +381,36 @@ void UART_SendBlock(UART_DRIVER* UartInst, char const* rgbBuffer, u32 cbRequeste
 	} while (cbRequested > 0);
 }
 
+/***	UART_EnqueueBlock
+**
+**	Parameters:
+**		char const* rgbBuffer	- pointer to a char buffer containing characters to be sent
+**		u32 cbRequested     	- number of characters to send
+**
+**	Return Value:
+**          none
+**
+**	Description:
+**		This function copies the characters in the transmit ring buffer.
+**		If the ring buffer is full, the function calls UART_TxTask until there is enough space.
+**
+*/
+void UART_EnqueueBlock(char const* rgbBuffer, u32 cbRequested)
+{
+	while(cbRequested > 0)
+	{
+		if(dwTxHead - dwTxTail == TX_BUFFER_SIZE)
+		{
+			// ring buffer full, wait for the transmission to progress
+			UART_TxTask();
+			continue;
+		}
+		TxBuffer[dwTxHead & (TX_BUFFER_SIZE - 1)] = *rgbBuffer++;
+		dwTxHead++;
+		cbRequested--;
+	}
+}
+
 /*****************************************************************************/
 
 /***	UART_SetupInterruptSystem
@@ -384,11 +499,16 @@ static int UART_SetupInterruptSystem(INTC *IntcInstancePtr,
 ** 		This function is the handler which performs processing to handle data events
 **		from the device.  It is called from an interrupt context. so the amount of
 ** 		processing should be minimal.
-** 		Basically it deals with receive events, filling TotalReceivedCount with the number of received bytes
+** 		Basically it deals with receive events, filling TotalReceivedCount with the number of received bytes.
+** 		It also signals the end of the asynchronous transmission of a block, by setting fTxDone.
 **
 */
 void UART_Handler(void *CallBackRef, u32 Event, unsigned int EventData)
 {
+	/* All of the data has been sent */
+	if (Event == XUARTPS_EVENT_SENT_DATA) {
+		fTxDone = 1;
+	}
 
 	/* All of the data has been received */
 	if (Event == XUARTPS_EVENT_RECV_DATA) {
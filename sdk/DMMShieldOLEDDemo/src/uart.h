@@ -39,6 +39,8 @@ u8 UART_Init(u32 dwBaudRate);
 
 int UART_GetString(char* pchBuff, int cchBuff);
 void UART_PutString(char szData[]);
+void UART_SetTxAsync(u8 fAsync);
+void UART_TxTask();
 #define UART_PutString1(x,...) 	{ xil_printf(x,##__VA_ARGS__); print("\r\n"); }
 
 #ifdef __cplusplus
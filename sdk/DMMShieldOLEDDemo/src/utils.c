@@ -8,7 +8,7 @@
     uart.c
 
   @Description
-        This file groups the functions that implement some of the utilities functions, like delay.
+        This file groups the functions that implement some of the utilities functions, like delay and checksums.
         utils.h file needs to be included in the files where those functions are used.
 
 
@@ -107,6 +107,133 @@ unsigned char GetBufferChecksum(unsigned char *pBuf, int len)
 }
 
 
+/* ------------------------------------------------------------ */
+/***    GetBufferCrc8
+**
+**	Synopsis:
+**		GetBufferCrc8(*pBuf, len)
+**
+**	Parameters:
+**		pBuf - buffer for which the CRC is computed
+**      len - buffer length on which the CRC is computed
+**
+**	Return Values:
+**      returns the CRC-8 (CRC8_POLY polynomial, initial value 0) of the specified pBuf, on the specified len
+**
+**	Errors:
+**		none
+**
+**	Description:
+**		This function computes the CRC-8 of the buffer. Unlike the additive checksum of GetBufferChecksum, it detects 
+**      all the error bursts up to 8 bits and the swapped or compensating bytes.
+**      The CRC is table-driven: the 4 tables (CRC of each byte value followed by 0 to 3 zero bytes) are computed on the first call, 
+**      then the buffer is processed 4 bytes per step (slice-by-4), the remaining bytes one per step.
+**
+*/
+unsigned char GetBufferCrc8(unsigned char *pBuf, int len)
+{
+    static unsigned char rgbCrcTable[4][256];
+    static unsigned char fTableInit = 0;
+    unsigned char crc = 0;
+    int i, j;
+    if(!fTableInit)
+    {
+        for(i = 0; i < 256; i++)
+        {
+            crc = i;
+            for(j = 0; j < 8; j++)
+            {
+                crc = (crc & 0x80) ? (crc << 1) ^ CRC8_POLY : (crc << 1);
+            }
+            rgbCrcTable[0][i] = crc;
+        }
+        for(i = 0; i < 256; i++)
+        {
+            for(j = 1; j < 4; j++)
+            {
+                // one more zero byte
+                rgbCrcTable[j][i] = rgbCrcTable[0][rgbCrcTable[j - 1][i]];
+            }
+        }
+        fTableInit = 1;
+        crc = 0;
+    }
+    for(i = 0; i + 4 <= len; i += 4)
+    {
+        crc = rgbCrcTable[3][crc ^ pBuf[i]] ^ rgbCrcTable[2][pBuf[i + 1]] ^ 
+              rgbCrcTable[1][pBuf[i + 2]] ^ rgbCrcTable[0][pBuf[i + 3]];
+    }
+    for(; i < len; i++)
+    {
+        crc = rgbCrcTable[0][crc ^ pBuf[i]];
+    }
+    return crc;
+}
+
+/* ------------------------------------------------------------ */
+/***    GetBufferCrc16
+**
+**	Synopsis:
+**		GetBufferCrc16(crc, *pBuf, len)
+**
+**	Parameters:
+**		crc - initial value: CRC16_INIT, or the CRC of the previous buffer to extend it
+**		pBuf - buffer for which the CRC is computed
+**      len - buffer length on which the CRC is computed
+**
+**	Return Values:
+**      returns the CRC-16 (CRC16_POLY polynomial) of the specified pBuf, on the specified len
+**
+**	Errors:
+**		none
+**
+**	Description:
+**		This function computes the CRC-16/CCITT of the buffer. It detects all the error bursts up to 16 bits, 
+**      and the other errors of a calibration record with a probability of 1 - 1/65536 (1 - 1/256 for GetBufferCrc8).
+**      The CRC of several buffers is computed by passing the CRC of the previous buffer as initial value.
+**      Like GetBufferCrc8, the CRC is table-driven and processes the buffer 4 bytes per step (slice-by-4).
+**
+*/
+unsigned short GetBufferCrc16(unsigned short crc, unsigned char *pBuf, int len)
+{
+    static unsigned short rgwCrcTable[4][256];
+    static unsigned char fTableInit = 0;
+    unsigned short w;
+    int i, j;
+    if(!fTableInit)
+    {
+        for(i = 0; i < 256; i++)
+        {
+            w = i << 8;
+            for(j = 0; j < 8; j++)
+            {
+                w = (w & 0x8000) ? (w << 1) ^ CRC16_POLY : (w << 1);
+            }
+            rgwCrcTable[0][i] = w;
+        }
+        for(i = 0; i < 256; i++)
+        {
+            for(j = 1; j < 4; j++)
+            {
+                // one more zero byte
+                w = rgwCrcTable[j - 1][i];
+                rgwCrcTable[j][i] = (w << 8) ^ rgwCrcTable[0][w >> 8];
+            }
+        }
+        fTableInit = 1;
+    }
+    for(i = 0; i + 4 <= len; i += 4)
+    {
+        crc = rgwCrcTable[3][(crc >> 8) ^ pBuf[i]] ^ rgwCrcTable[2][(crc & 0xFF) ^ pBuf[i + 1]] ^ 
+              rgwCrcTable[1][pBuf[i + 2]] ^ rgwCrcTable[0][pBuf[i + 3]];
+    }
+    for(; i < len; i++)
+    {
+        crc = (crc << 8) ^ rgwCrcTable[0][(crc >> 8) ^ pBuf[i]];
+    }
+    return crc;
+}
+
 /* *****************************************************************************
  End of File
  */
@@ -27,9 +27,14 @@
 
 void DelayAprox10Us( unsigned int tusDelay );
 unsigned char GetBufferChecksum(unsigned char *pBuf, int len);
+unsigned char GetBufferCrc8(unsigned char *pBuf, int len);
+unsigned short GetBufferCrc16(unsigned short crc, unsigned char *pBuf, int len);
 
 
 /************************** Constant Definitions *****************************/
+#define CRC8_POLY   0x07    // CRC-8 generator polynomial x^8 + x^2 + x + 1, initial value 0, MSB first
+#define CRC16_POLY  0x1021  // CRC-16/CCITT generator polynomial x^16 + x^12 + x^5 + 1, MSB first
+#define CRC16_INIT  0xFFFF  // CRC-16 initial value
 
 
 /***************** Macros (Inline Functions) Definitions *********************/
@@ -0,0 +1,258 @@
+/* ************************************************************************** */
+/** Descriptive File Name
+
+  @Company
+    Digilent
+
+  @File Name
+    xadc.c
+
+  @Description
+        This file groups the functions that implement the XADC module, the die temperature of the Zynq.
+        The XADC sequencer runs in its default mode after power up, converting the on-chip sensors continuously,
+        so the temperature register always holds a recent value. The register is read through the PS-XADC interface FIFOs
+        without waiting: XADC_Tick queues the read command, and a following XADC_Tick collects the answer.
+        The readings are filtered, and XADC_Tick reports when the filtered temperature moved by XADC_TEMP_STEP,
+        so that the users recompute their temperature dependent coefficients only then.
+        XADC_Tick is meant to be called periodically by a low rate task, never from the acquisition of the values.
+        When XADC_HOST is 1 the XADC is replaced by a stand-in returning the temperature set by XADC_HostSetTemp,
+        so that the temperature compensation can be checked on a host computer.
+        The module uses errors defined in the ERRORS module.
+
+ */
+/* ************************************************************************** */
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Included Files                                                    */
+/* ************************************************************************** */
+#include <math.h>
+#include "stdint.h"
+#include "xadc.h"
+#include "errors.h"
+#if !XADC_HOST
+#include "xadcps.h"
+#endif
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+// Section: Local functions prototypes                                        */
+/* ************************************************************************** */
+/* ************************************************************************** */
+uint8_t XADC_ReadStart();
+uint8_t XADC_ReadStep(double *pdTemp);
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Global Variables                                                  */
+/* ************************************************************************** */
+/* ************************************************************************** */
+static uint8_t fXadcInit = 0;           // XADC_Init succeeded
+static uint8_t fReadIssued = 0;         // the read command is queued, its answer was not collected yet
+static int cntReadTicks;                // number of XADC_Tick calls since the read command was queued
+static double dTempFiltered = NAN;      // filtered die temperature (Celsius), NAN until the first reading
+static double dTempReported = NAN;      // filtered die temperature when XADC_Tick last reported a change
+
+#if XADC_HOST
+static double dTempHost = 25.0;         // temperature returned by the stand-in
+#else
+static XAdcPs XAdcInstance;
+static int cwReadAnswer;                // number of words collected from the read FIFO for the queued command
+#endif
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+// Section: Interface Functions                                               */
+/* ************************************************************************** */
+/* ************************************************************************** */
+
+/***	XADC_Init
+**
+**	Parameters:
+**		none
+**
+**	Return Value:
+**		uint8_t
+**          ERRVAL_SUCCESS              0       // success
+**          ERRVAL_DMM_GENERICERROR     0xEF    // the XADC cannot be initialized
+**
+**	Description:
+**		This function initializes the PS-XADC interface. The XADC sequencer keeps its default mode,
+**      which converts the die temperature continuously.
+**      The temperature is unknown (NAN) until the first reading is collected by XADC_Tick.
+**      The host build has nothing to initialize.
+**
+*/
+uint8_t XADC_Init()
+{
+#if !XADC_HOST
+    XAdcPs_Config *pConfig = XAdcPs_LookupConfig(XADC_DEVICE_ID);
+    if(!pConfig || XAdcPs_CfgInitialize(&XAdcInstance, pConfig, pConfig->BaseAddress) != XST_SUCCESS)
+    {
+        return ERRVAL_DMM_GENERICERROR;
+    }
+#endif
+    fReadIssued = 0;
+    dTempFiltered = NAN;
+    dTempReported = NAN;
+    fXadcInit = 1;
+    return ERRVAL_SUCCESS;
+}
+
+/***	XADC_Tick
+**
+**	Parameters:
+**		none
+**
+**	Return Value:
+**		uint8_t     - 1 if the filtered temperature changed by at least XADC_TEMP_STEP since the last reported change
+**                    (or it is the first reading), 0 otherwise
+**
+**	Description:
+**		This function performs one step of the temperature reading, it never waits for the XADC.
+**      If no read is in progress, it queues the read of the temperature register. Otherwise it collects the answer,
+**      converts it to Celsius and adds it to the filtered temperature. If the answer does not come within
+**      XADC_CNTTICKSTIMEOUT calls, the read is queued again.
+**      It is called periodically by the temperature task, the temperature changes slowly.
+**
+*/
+uint8_t XADC_Tick()
+{
+    double dTemp;
+    if(!fXadcInit)
+    {
+        return 0;
+    }
+    if(!fReadIssued)
+    {
+        fReadIssued = XADC_ReadStart();
+        cntReadTicks = 0;
+        return 0;
+    }
+    if(!XADC_ReadStep(&dTemp))
+    {
+        if(++cntReadTicks >= XADC_CNTTICKSTIMEOUT)
+        {
+            fReadIssued = 0;
+        }
+        return 0;
+    }
+    fReadIssued = 0;
+    dTempFiltered = isnan(dTempFiltered) ? dTemp: dTempFiltered + (dTemp - dTempFiltered) / XADC_FILTER;
+    if(isnan(dTempReported) || fabs(dTempFiltered - dTempReported) >= XADC_TEMP_STEP)
+    {
+        dTempReported = dTempFiltered;
+        return 1;
+    }
+    return 0;
+}
+
+/***	XADC_GetTemp
+**
+**	Parameters:
+**		none
+**
+**	Return Value:
+**		double  - the filtered die temperature (Celsius), NAN if no reading was collected yet
+**
+**	Description:
+**		This function returns the filtered die temperature, as maintained by XADC_Tick.
+**
+*/
+double XADC_GetTemp()
+{
+    return dTempFiltered;
+}
+
+#if XADC_HOST
+/***	XADC_HostSetTemp
+**
+**	Parameters:
+**		double dTemp    - the die temperature (Celsius) returned by the stand-in
+**
+**	Return Value:
+**		none
+**
+**	Description:
+**		This function sets the temperature returned by the following readings of the host stand-in.
+**
+*/
+void XADC_HostSetTemp(double dTemp)
+{
+    dTempHost = dTemp;
+}
+#endif
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+// Section: Local Functions                                                   */
+/* ************************************************************************** */
+/* ************************************************************************** */
+
+/***	XADC_ReadStart
+**
+**	Parameters:
+**		none
+**
+**	Return Value:
+**		uint8_t     - 1 if the read command was queued
+**
+**	Description:
+**		This function discards the words left in the read FIFO, then queues the read command of the temperature register twice:
+**      the PS-XADC interface returns the data of a command while it shifts the next one, so the second answer holds the register.
+**      The answer of the second command is discarded by the next XADC_ReadStart.
+**
+*/
+uint8_t XADC_ReadStart()
+{
+#if !XADC_HOST
+    uint32_t dwBase = XAdcInstance.Config.BaseAddress;
+    while(!(XAdcPs_ReadReg(dwBase, XADCPS_MSTS_OFFSET) & XADCPS_MSTS_DFIFOE_MASK))
+    {
+        XAdcPs_ReadReg(dwBase, XADCPS_RDFIFO_OFFSET);
+    }
+    cwReadAnswer = 0;
+    XAdcPs_WriteReg(dwBase, XADCPS_CMDFIFO_OFFSET, XAdcPs_FormatWriteData(XADCPS_TEMP_OFFSET, 0, 0));
+    XAdcPs_WriteReg(dwBase, XADCPS_CMDFIFO_OFFSET, XAdcPs_FormatWriteData(XADCPS_TEMP_OFFSET, 0, 0));
+#endif
+    return 1;
+}
+
+/***	XADC_ReadStep
+**
+**	Parameters:
+**		double *pdTemp  - pointer to receive the temperature (Celsius) when the function returns 1
+**
+**	Return Value:
+**		uint8_t     - 1 if the answer of the read command was collected, 0 if it is not available yet
+**
+**	Description:
+**		This function collects the words available in the read FIFO, without waiting. The second word
+**      is the temperature register, it is converted to Celsius.
+**
+*/
+uint8_t XADC_ReadStep(double *pdTemp)
+{
+#if XADC_HOST
+    *pdTemp = dTempHost;
+    return 1;
+#else
+    uint32_t dwBase = XAdcInstance.Config.BaseAddress;
+    uint32_t dwData = 0;
+    while(cwReadAnswer < 2 && !(XAdcPs_ReadReg(dwBase, XADCPS_MSTS_OFFSET) & XADCPS_MSTS_DFIFOE_MASK))
+    {
+        dwData = XAdcPs_ReadReg(dwBase, XADCPS_RDFIFO_OFFSET);
+        cwReadAnswer++;
+    }
+    if(cwReadAnswer < 2)
+    {
+        return 0;
+    }
+    *pdTemp = XAdcPs_RawToTemperature(dwData & 0xFFFF);
+    return 1;
+#endif
+}
+
+/* *****************************************************************************
+ End of File
+ */
@@ -0,0 +1,57 @@
+/* ************************************************************************** */
+/** Descriptive File Name
+
+  @Company
+ Digilent
+
+  @File Name
+    xadc.h
+
+  @Description
+        This file contains the declarations for the XADC module functions.
+        The XADC functions are defined in xadc.c source file.
+        Define XADC_HOST as 1 to build the module on a host computer, without the Xilinx drivers:
+        the die temperature is then set by XADC_HostSetTemp.
+
+ */
+/* ************************************************************************** */
+
+#ifndef _XADC_H    /* Guard against multiple inclusion */
+#define _XADC_H
+
+#include "stdint.h"
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Constants                                                         */
+/* ************************************************************************** */
+#ifndef XADC_HOST
+#define XADC_HOST               0
+#endif
+
+#if !XADC_HOST
+#include "xparameters.h"
+#define XADC_DEVICE_ID          XPAR_XADCPS_0_DEVICE_ID
+#endif
+
+#define XADC_FILTER             8       // weight of the temperature filter: each reading moves the temperature by 1/XADC_FILTER of the difference
+#define XADC_TEMP_STEP          0.25    // minimum change of the filtered temperature reported by XADC_Tick (Celsius)
+#define XADC_CNTTICKSTIMEOUT    4       // number of XADC_Tick calls waiting for the temperature register before the read is issued again
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Interface Functions
+// *****************************************************************************
+// *****************************************************************************
+uint8_t XADC_Init();
+uint8_t XADC_Tick();
+double XADC_GetTemp();
+#if XADC_HOST
+void XADC_HostSetTemp(double dTemp);
+#endif
+
+#endif /* _XADC_H */
+
+/* *****************************************************************************
+ End of File
+ */